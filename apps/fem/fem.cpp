@@ -56,6 +56,9 @@ int main(int argc, char **argv)
   Set points;
   Set springs(points, points);
 
+  // The vertex positions are copied to the mesh in bulk after each step
+  FieldView<double,3> xView = x.view();
+
   // Take 100 time steps
   for (int i = 1; i <= 100; ++i) {
     std::cout << "timestep " << i << std::endl;
@@ -65,13 +68,7 @@ int main(int argc, char **argv)
     timestep.mapArgs();   // Move data back to this memory space
 
     // Copy the x field to the mesh and save it to an obj file
-    int vi = 0;
-    for (auto &vert : points) {
-      for(int ii = 0; ii < 3; ii++){
-        mesh.v[vi][ii] = x.get(vert)(ii);
-      }
-      vi++;
-    }
+    xView.copyTo(mesh.v[0].data());
     mesh.updateSurfVert();
     mesh.saveTetObj(std::to_string(i)+".obj");
   }
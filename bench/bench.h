@@ -0,0 +1,102 @@
+#ifndef SIMIT_BENCH_H
+#define SIMIT_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+
+namespace simit {
+namespace bench {
+
+/// The tetrahedral mesh benchmarks run on unless they are given another one.
+inline std::string defaultMesh() {
+  return std::string(APPS_DIR) + "/data/tet-dragon/dragon40k";
+}
+
+/// The tetrahedral meshes shipped with the apps, smallest first.
+inline std::vector<std::string> meshes() {
+  return {std::string(APPS_DIR) + "/data/tet-bunny/bunny.1", defaultMesh()};
+}
+
+/// A BCSR matrix with the sparsity of a FEM stiffness matrix: one block row
+/// per mesh vertex, with a block for every vertex that shares a tetrahedron
+/// with it.
+struct StiffnessMatrix {
+  int rows = 0;
+  int blockSize = 0;
+  std::vector<int> rowptr;
+  std::vector<int> colidx;
+  std::vector<double> vals;
+
+  int nnzBlocks() const {return rowptr.back();}
+};
+
+/// Build the stiffness matrix of the tetrahedral mesh with the given .node/.ele
+/// prefix, with symmetric and diagonally dominant values. Returns false if the
+/// mesh could not be loaded.
+inline bool loadStiffnessMatrix(const std::string& prefix, int blockSize,
+                                StiffnessMatrix* matrix) {
+  MeshVol mesh;
+  if (mesh.loadTet(prefix + ".node", prefix + ".ele") < 0 || mesh.v.empty()) {
+    return false;
+  }
+
+  std::vector<std::set<int>> neighbors(mesh.v.size());
+  for (const std::vector<int>& tet : mesh.e) {
+    for (int u : tet) {
+      neighbors[u].insert(tet.begin(), tet.end());
+    }
+  }
+
+  const int blockElems = blockSize*blockSize;
+  matrix->rows = mesh.v.size();
+  matrix->blockSize = blockSize;
+  matrix->rowptr.assign(1, 0);
+  matrix->colidx.clear();
+  matrix->vals.clear();
+  for (int i = 0; i < matrix->rows; ++i) {
+    for (int j : neighbors[i]) {
+      matrix->colidx.push_back(j);
+      for (int b = 0; b < blockElems; ++b) {
+        bool diagonal = (i == j) && (b / blockSize == b % blockSize);
+        matrix->vals.push_back(diagonal ? 2.0*neighbors[i].size() : -0.5);
+      }
+    }
+    matrix->rowptr.push_back(matrix->colidx.size());
+  }
+  return true;
+}
+
+/// Returns the mean time of `reps` runs of `f`, in milliseconds, after one
+/// untimed warm-up run.
+template <typename F>
+double time(int reps, F f) {
+  f();
+  auto begin = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < reps; ++i) {
+    f();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double,std::milli>(end - begin).count() / reps;
+}
+
+inline void printTime(const std::string& name, double ms,
+                      double baselineMs = 0.0) {
+  std::cout << "  " << std::left << std::setw(36) << name << std::right
+            << std::fixed << std::setprecision(3) << std::setw(10) << ms
+            << " ms";
+  if (baselineMs > 0.0) {
+    std::cout << std::setprecision(2) << std::setw(8) << baselineMs/ms << "x";
+  }
+  std::cout << std::endl;
+}
+
+}}
+
+#endif
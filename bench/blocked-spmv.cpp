@@ -0,0 +1,206 @@
+/// Measures the sparse matrix-vector products Simit generates for the
+/// stiffness matrices of tetrahedral meshes, with 1x1, 2x2, 3x3 and 4x4
+/// blocks, against a generic BCSR kernel whose block size is only known at
+/// runtime.
+///
+/// Usage: blocked-spmv [repetitions] [mesh-prefix...]
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "bench.h"
+#include "graph.h"
+#include "program.h"
+
+using namespace std;
+using namespace simit;
+
+/// The reference kernel: BCSR SpMV with runtime block sizes.
+static void spmvGeneric(const bench::StiffnessMatrix& A, const double* x,
+                        double* y) {
+  const int bs = A.blockSize;
+  for (int i=0; i<A.rows; ++i) {
+    for (int bi=0; bi<bs; ++bi) {
+      y[i*bs+bi] = 0.0;
+    }
+    for (int ij=A.rowptr[i]; ij<A.rowptr[i+1]; ++ij) {
+      const int j = A.colidx[ij];
+      for (int bi=0; bi<bs; ++bi) {
+        for (int bj=0; bj<bs; ++bj) {
+          y[i*bs+bi] += A.vals[(ij*bs+bi)*bs+bj] * x[j*bs+bj];
+        }
+      }
+    }
+  }
+}
+
+/// A Simit program that assembles the stiffness matrix of `tets` with
+/// blockSize x blockSize blocks and multiplies it with `verts.x` `products`
+/// times.
+static string spmvProgram(int blockSize, int products) {
+  string vectorType = (blockSize == 1)
+      ? "float"
+      : "vector[" + to_string(blockSize) + "](float)";
+  string blockType = (blockSize == 1)
+      ? "float"
+      : "tensor[" + to_string(blockSize) + "," + to_string(blockSize) +
+        "](float)";
+
+  // Diagonal blocks get a larger diagonal than off-diagonal ones
+  auto block = [blockSize](double diagonal, double offDiagonal) {
+    if (blockSize == 1) {
+      return to_string(diagonal);
+    }
+    stringstream ss;
+    ss << "[";
+    for (int i=0; i<blockSize; ++i) {
+      for (int j=0; j<blockSize; ++j) {
+        ss << ((i == j) ? diagonal : offDiagonal)
+           << ((j < blockSize-1) ? ", " : "");
+      }
+      ss << ((i < blockSize-1) ? "; " : "]");
+    }
+    return ss.str();
+  };
+
+  stringstream program;
+  program
+      << "element Vertex\n"
+      << "  x : " << vectorType << ";\n"
+      << "  y : " << vectorType << ";\n"
+      << "end\n"
+      << "element Tet\n"
+      << "end\n"
+      << "extern verts : set{Vertex};\n"
+      << "extern tets : set{Tet}(verts,verts,verts,verts);\n"
+      << "func asm(t : Tet, v : (Vertex*4))\n"
+      << "    -> (A : tensor[verts,verts](" << blockType << "))\n"
+      << "  for i in 0:4\n"
+      << "    for j in 0:4\n"
+      << "      if i == j\n"
+      << "        A(v(i),v(j)) = " << block(8.0, 0.5) << ";\n"
+      << "      else\n"
+      << "        A(v(i),v(j)) = " << block(-0.5, 0.0) << ";\n"
+      << "      end\n"
+      << "    end\n"
+      << "  end\n"
+      << "end\n"
+      << "export func main()\n"
+      << "  A = map asm to tets reduce +;\n"
+      << "  for k in 0:" << products << "\n"
+      << "    verts.y = A*verts.x;\n"
+      << "  end\n"
+      << "end\n";
+  return program.str();
+}
+
+/// Returns the mean time of a Simit SpMV, by subtracting the time of a
+/// program that only assembles the matrix from one that also multiplies it
+/// `products` times.
+static double timeSimitSpMV(Set* verts, Set* tets, int blockSize,
+                            int products, int reps) {
+  double time[2];
+  int numProducts[2] = {0, products};
+  for (int p=0; p<2; ++p) {
+    Program program;
+    if (program.loadString(spmvProgram(blockSize, numProducts[p])) != 0) {
+      cerr << program.getDiagnostics() << endl;
+      exit(1);
+    }
+    Function func = program.compile("main");
+    func.bind("verts", verts);
+    func.bind("tets", tets);
+    func.init();
+    time[p] = bench::time(reps, [&func]() {func.runSafe();});
+  }
+  return (time[1] - time[0]) / products;
+}
+
+/// The vertex fields of a block size: scalars for 1x1 blocks, and vectors of
+/// the block size otherwise.
+template <int BlockSize>
+struct VertexField {
+  typedef FieldRef<double,BlockSize> Type;
+  static Type add(Set* verts, const string& name) {
+    return verts->addField<double,BlockSize>(name);
+  }
+  static void fill(Type field, ElementRef vert, double value) {
+    for (int b=0; b<BlockSize; ++b) {
+      field(vert)(b) = value;
+    }
+  }
+};
+template <>
+struct VertexField<1> {
+  typedef FieldRef<double> Type;
+  static Type add(Set* verts, const string& name) {
+    return verts->addField<double>(name);
+  }
+  static void fill(Type field, ElementRef vert, double value) {
+    field(vert) = value;
+  }
+};
+
+template <int BlockSize>
+static void benchBlockSize(const string& mesh, int reps) {
+  MeshVol meshVol;
+  meshVol.loadTet(mesh + ".node", mesh + ".ele");
+
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  auto x = VertexField<BlockSize>::add(&verts, "x");
+  VertexField<BlockSize>::add(&verts, "y");
+  vector<ElementRef> vertRefs;
+  for (size_t i=0; i<meshVol.v.size(); ++i) {
+    ElementRef vert = verts.add();
+    VertexField<BlockSize>::fill(x, vert, 1.0);
+    vertRefs.push_back(vert);
+  }
+  for (const vector<int>& tet : meshVol.e) {
+    tets.add(vertRefs[tet[0]], vertRefs[tet[1]],
+             vertRefs[tet[2]], vertRefs[tet[3]]);
+  }
+
+  bench::StiffnessMatrix A;
+  bench::loadStiffnessMatrix(mesh, BlockSize, &A);
+  vector<double> xs(A.rows*BlockSize, 1.0);
+  vector<double> ys(A.rows*BlockSize);
+  double generic = bench::time(reps, [&]() {
+    spmvGeneric(A, xs.data(), ys.data());
+  });
+
+  const int products = 20;
+  double simit = timeSimitSpMV(&verts, &tets, BlockSize, products, reps);
+
+  cout << BlockSize << "x" << BlockSize << " blocks ("
+       << A.nnzBlocks() << " blocks)" << endl;
+  bench::printTime("generic BCSR kernel", generic);
+  bench::printTime("simit", simit, generic);
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 10;
+  vector<string> meshes;
+  for (int i=2; i<argc; ++i) {
+    meshes.push_back(argv[i]);
+  }
+  if (meshes.empty()) {
+    meshes = bench::meshes();
+  }
+
+  simit::init("cpu", sizeof(double));
+  for (const string& mesh : meshes) {
+    bench::StiffnessMatrix A;
+    if (!bench::loadStiffnessMatrix(mesh, 1, &A)) {
+      cerr << "Could not load mesh " << mesh << endl;
+      return 1;
+    }
+    cout << "Stiffness matrix of " << mesh << ": " << A.rows
+         << " block rows" << endl;
+    benchBlockSize<1>(mesh, reps);
+    benchBlockSize<2>(mesh, reps);
+    benchBlockSize<3>(mesh, reps);
+    benchBlockSize<4>(mesh, reps);
+  }
+  return 0;
+}
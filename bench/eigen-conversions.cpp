@@ -0,0 +1,90 @@
+/// Compares the conversion of Simit BCSR matrices to the Eigen matrices that
+/// the solver intrinsics operate on, through triplets as the runtime used to,
+/// and by filling the Eigen arrays directly.
+///
+/// Usage: eigen-conversions [mesh-prefix] [repetitions]
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "runtime.h"
+
+using namespace std;
+using namespace simit;
+
+#ifdef EIGEN
+/// The triplet-based conversion that csr2eigen replaced.
+template <typename Float, int Major>
+Eigen::SparseMatrix<Float,Major>
+csr2eigenTriplets(int n, int m, const int* rowptr, const int* colidx,
+                  int nn, int mm, const Float* vals) {
+  int nnz = rowptr[n/nn];
+  std::vector<Eigen::Triplet<Float>> tripletList;
+  tripletList.reserve(nnz*nn*mm);
+  for (int i=0; i<n/nn; ++i) {
+    for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+      int j = colidx[ij];
+      for (int bi=0; bi<nn; bi++) {
+        for (int bj=0; bj<mm; bj++) {
+          tripletList.push_back(Eigen::Triplet<Float>(i*nn+bi, j*mm+bj,
+                                                      vals[ij*nn*mm+bi*mm+bj]));
+        }
+      }
+    }
+  }
+  Eigen::SparseMatrix<Float> mat(n, m);
+  mat.setFromTriplets(tripletList.begin(), tripletList.end());
+  mat.makeCompressed();
+  return mat;
+}
+
+template <int Major>
+static void benchConversion(const string& name,
+                            const bench::StiffnessMatrix& A, int reps) {
+  const int n = A.rows * A.blockSize;
+  const int bs = A.blockSize;
+  double nnz = 0.0;
+
+  double triplets = bench::time(reps, [&]() {
+    auto mat = csr2eigenTriplets<double,Major>(n, n, A.rowptr.data(),
+                                               A.colidx.data(), bs, bs,
+                                               A.vals.data());
+    nnz += mat.nonZeros();
+  });
+  double direct = bench::time(reps, [&]() {
+    auto mat = csr2eigen<double,Major>(n, n, A.rowptr.data(), A.colidx.data(),
+                                       bs, bs, A.vals.data());
+    nnz -= mat.nonZeros();
+  });
+  if (nnz != 0.0) {
+    cerr << "conversions disagree on the number of non-zeros" << endl;
+    exit(1);
+  }
+
+  cout << name << endl;
+  bench::printTime("triplets", triplets);
+  bench::printTime("direct", direct, triplets);
+}
+#endif
+
+int main(int argc, const char* argv[]) {
+#ifdef EIGEN
+  string mesh = (argc > 1) ? argv[1] : bench::defaultMesh();
+  int reps = (argc > 2) ? atoi(argv[2]) : 10;
+
+  bench::StiffnessMatrix A;
+  if (!bench::loadStiffnessMatrix(mesh, 3, &A)) {
+    cerr << "Could not load mesh " << mesh << endl;
+    return 1;
+  }
+  cout << "Stiffness matrix of " << mesh << ": " << A.rows << " block rows, "
+       << A.nnzBlocks() << " 3x3 blocks" << endl;
+
+  benchConversion<Eigen::ColMajor>("csr2eigen (column-major)", A, reps);
+  benchConversion<Eigen::RowMajor>("csr2eigen (row-major)", A, reps);
+  return 0;
+#else
+  cerr << "eigen-conversions requires that Simit was built with Eigen" << endl;
+  return 1;
+#endif
+}
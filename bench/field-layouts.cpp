@@ -0,0 +1,158 @@
+/// Measures the effect of set field layouts on the loops Simit generates for
+/// them, on the fields of the FEM and spring apps: the 3x3 `B` matrices of the
+/// tetrahedra of a mesh, and the `x` and `v` vectors of its vertices. Each
+/// kernel walks the raw field buffers the way the lowered map loops do for an
+/// AoS, SoA and AoSoA layout.
+///
+/// Usage: field-layouts [repetitions] [copies] [mesh-prefix]
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "bench.h"
+#include "graph.h"
+
+using namespace std;
+using namespace simit;
+
+static const int LANE_WIDTH = 8;
+
+static vector<FieldLayout> layouts() {
+  return {FieldLayout::aos(), FieldLayout::soa(),
+          FieldLayout::aosoa(LANE_WIDTH)};
+}
+
+/// The spring integration step `x = x + h*v`, which touches every component.
+template <int N>
+static void integrate(const FieldLayout& layout, int size, double h,
+                      double* x, const double* v) {
+  switch (layout.getKind()) {
+    case FieldLayout::AoS:
+      for (int e=0; e<size; ++e) {
+        for (int c=0; c<N; ++c) {
+          x[e*N+c] += h * v[e*N+c];
+        }
+      }
+      break;
+    case FieldLayout::SoA:
+      for (int c=0; c<N; ++c) {
+        for (int e=0; e<size; ++e) {
+          x[c*size+e] += h * v[c*size+e];
+        }
+      }
+      break;
+    case FieldLayout::AoSoA:
+      for (int t=0; t<size; t+=LANE_WIDTH) {
+        for (int c=0; c<N; ++c) {
+          for (int l=0; l<LANE_WIDTH; ++l) {
+            x[t*N + c*LANE_WIDTH + l] += h * v[t*N + c*LANE_WIDTH + l];
+          }
+        }
+      }
+      break;
+  }
+}
+
+/// The trace of each tet's `B`, which touches one component in three.
+static void trace(const FieldLayout& layout, int size, const double* B,
+                  double* tr) {
+  switch (layout.getKind()) {
+    case FieldLayout::AoS:
+      for (int e=0; e<size; ++e) {
+        tr[e] = B[e*9] + B[e*9+4] + B[e*9+8];
+      }
+      break;
+    case FieldLayout::SoA:
+      for (int e=0; e<size; ++e) {
+        tr[e] = B[e] + B[4*size+e] + B[8*size+e];
+      }
+      break;
+    case FieldLayout::AoSoA:
+      for (int t=0; t<size; t+=LANE_WIDTH) {
+        for (int l=0; l<LANE_WIDTH; ++l) {
+          tr[t+l] = B[t*9+l] + B[t*9 + 4*LANE_WIDTH+l] +
+                    B[t*9 + 8*LANE_WIDTH+l];
+        }
+      }
+      break;
+  }
+}
+
+/// Fill a vector field through its FieldRef, so every layout holds the same
+/// tensors.
+template <int N>
+static FieldRef<double,N> addVectorField(Set* set, const string& name,
+                                         const FieldLayout& layout) {
+  FieldRef<double,N> field = set->addField<double,N>(name, layout);
+  int i = 0;
+  for (ElementRef elem : *set) {
+    for (int c=0; c<N; ++c) {
+      field(elem)(c) = (i % 17) * 0.25 + c;
+    }
+    ++i;
+  }
+  return field;
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int copies = (argc > 2) ? atoi(argv[2]) : 10;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  MeshVol mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  const int numVerts = mesh.v.size() * copies;
+  const int numTets = mesh.e.size() * copies;
+  cout << numVerts << " vertices, " << numTets << " tets" << endl;
+
+  // Both sets are shrunk to their size, so that the kernels below can stride
+  // SoA components by the number of elements
+  cout << "springs: x = x + h*v" << endl;
+  double baseline = 0.0;
+  for (const FieldLayout& layout : layouts()) {
+    Set verts;
+    verts.addMany(numVerts);
+    addVectorField<3>(&verts, "x", layout);
+    addVectorField<3>(&verts, "v", layout);
+    verts.shrinkToFit();
+    double* x = (double*)verts.getFieldData("x");
+    const double* v = (const double*)verts.getFieldData("v");
+
+    double ms = bench::time(reps, [&]() {
+      integrate<3>(layout, numVerts, 0.01, x, v);
+    });
+    stringstream name;
+    name << layout;
+    bench::printTime(name.str(), ms, baseline);
+    if (baseline == 0.0) {
+      baseline = ms;
+    }
+  }
+
+  cout << "fem: trace(B)" << endl;
+  baseline = 0.0;
+  vector<double> tr(numTets + LANE_WIDTH);
+  for (const FieldLayout& layout : layouts()) {
+    Set tets;
+    tets.addMany(numTets);
+    // B is stored like a vector[9](float) field, which has the same layouts
+    // as a tensor[3,3](float) one
+    addVectorField<9>(&tets, "B", layout);
+    tets.shrinkToFit();
+    const double* B = (const double*)tets.getFieldData("B");
+
+    double ms = bench::time(reps, [&]() {
+      trace(layout, numTets, B, tr.data());
+    });
+    stringstream name;
+    name << layout;
+    bench::printTime(name.str(), ms, baseline);
+    if (baseline == 0.0) {
+      baseline = ms;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+/// Compares copying the vertex positions of a mesh out of a set, and back in,
+/// through per-element FieldRef accesses, the way the apps save their meshes
+/// every time step, with copying them through a field view, for each field
+/// layout.
+///
+/// Usage: field-views [repetitions] [copies] [mesh-prefix]
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "bench.h"
+#include "graph.h"
+
+using namespace std;
+using namespace simit;
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int copies = (argc > 2) ? atoi(argv[2]) : 10;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  MeshVol mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  const int numVerts = mesh.v.size() * copies;
+  cout << numVerts << " vertices" << endl;
+
+  vector<double> positions;
+  positions.reserve(numVerts * 3);
+  for (int c=0; c<copies; ++c) {
+    for (const array<double,3>& v : mesh.v) {
+      positions.insert(positions.end(), v.begin(), v.end());
+    }
+  }
+  vector<double> out(positions.size());
+
+  for (const FieldLayout& layout : {FieldLayout::aos(), FieldLayout::soa(),
+                                    FieldLayout::aosoa(8)}) {
+    stringstream name;
+    name << layout;
+    cout << name.str() << endl;
+
+    Set verts;
+    verts.addMany(numVerts);
+    FieldRef<double,3> x = verts.addField<double,3>("x", layout);
+    FieldView<double,3> xView = x.view();
+
+    double get = bench::time(reps, [&]() {
+      int i = 0;
+      for (ElementRef vert : verts) {
+        for (int c=0; c<3; ++c) {
+          out[i*3+c] = x.get(vert)(c);
+        }
+        ++i;
+      }
+    });
+    bench::printTime("FieldRef::get", get);
+    bench::printTime("FieldView::copyTo", bench::time(reps, [&]() {
+      xView.copyTo(out.data());
+    }), get);
+
+    double set = bench::time(reps, [&]() {
+      int i = 0;
+      for (ElementRef vert : verts) {
+        x.set(vert, {positions[i*3], positions[i*3+1], positions[i*3+2]});
+        ++i;
+      }
+    });
+    bench::printTime("FieldRef::set", set);
+    bench::printTime("FieldView::copyFrom", bench::time(reps, [&]() {
+      xView.copyFrom(positions.data());
+    }), set);
+  }
+  return 0;
+}
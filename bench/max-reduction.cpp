@@ -0,0 +1,90 @@
+/// Measures a max-norm reduction over a large float field, compiled for the
+/// "cpu" and the "cpu-parallel" backends, against a host loop over the raw
+/// field buffer. The reduction streams the field once, so its speed is reported
+/// as memory bandwidth.
+///
+/// Usage: max-reduction [repetitions] [elements]
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "backend/backend.h"
+#include "environment.h"
+#include "function.h"
+#include "graph.h"
+#include "ir.h"
+#include "util/thread_pool.h"
+
+using namespace std;
+using namespace simit;
+
+/// Compile `m = max(abs(V.x))`, which stores the result in `V.m[0]`.
+static simit::Function compileMaxNorm(const string& backendName) {
+  using namespace simit::ir;
+  ir::Type vertexType = ElementType::make("Vertex",
+                                          {ir::Field("x", ir::Float),
+                                           ir::Field("m", ir::Float)});
+  Var V("V", UnstructuredSetType::make(vertexType, {}));
+  Var i("i", ir::Int);
+  Var x("x", ir::Float);
+  Var m("m", ir::Float);
+  Stmt body = Block::make({
+    VarDecl::make(x),
+    AssignStmt::make(x, Load::make(FieldRead::make(V, "x"), i)),
+    IfThenElse::make(Lt::make(x, 0.0), AssignStmt::make(x, -x)),
+    AssignStmt::make(m, x, CompoundOperator::Max)
+  });
+  Stmt maxNorm = Block::make({
+    VarDecl::make(m),
+    AssignStmt::make(m, 0.0),
+    For::make(i, ForDomain(IndexSet(V)), body),
+    Store::make(FieldRead::make(V, "m"), 0, m)
+  });
+
+  Environment env;
+  env.addExtern(V);
+  backend::Backend backend(backendName);
+  return backend.compile(maxNorm, env);
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int size = (argc > 2) ? atoi(argv[2]) : 10000000;
+
+  Set verts;
+  verts.addMany(size);
+  verts.addField<double>("x");
+  FieldRef<double> m = verts.addField<double>("m");
+  double* xData = (double*)verts.getFieldData("x");
+  for (int n = 0; n < size; ++n) {
+    xData[n] = sin(0.001*n) * (n % 101);
+  }
+  cout << size << " elements, "
+       << util::ThreadPool::getInstance().getNumThreads() << " threads"
+       << endl;
+
+  double maxNorm = 0.0;
+  double host = bench::time(reps, [&]() {
+    maxNorm = 0.0;
+    for (int n = 0; n < size; ++n) {
+      maxNorm = max(maxNorm, fabs(xData[n]));
+    }
+  });
+  bench::printTime("host", host);
+
+  const double gigabytes = size * sizeof(double) / 1e9;
+  for (const string& backendName : {"cpu", "cpu-parallel"}) {
+    simit::Function function = compileMaxNorm(backendName);
+    function.bind("V", &verts);
+    double ms = bench::time(reps, [&]() {function.runSafe();});
+    bench::printTime(backendName, ms, host);
+    cout << "    " << gigabytes / (ms/1000) << " GB/s" << endl;
+    if (m(*verts.begin()) != maxNorm) {
+      cerr << backendName << " computed " << m(*verts.begin())
+           << " instead of " << maxNorm << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+/// Compares loading TetGen meshes with the stream parser of MeshVol and with
+/// the parallel FlatMesh loader, and then building their sets. The mesh is
+/// replicated `copies` times into temporary files to reach the sizes of large
+/// simulations.
+///
+/// Usage: mesh-loading [repetitions] [copies] [mesh-prefix]
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "flat_mesh.h"
+#include "graph.h"
+#include "util/thread_pool.h"
+
+using namespace std;
+using namespace simit;
+
+/// Write `copies` copies of the mesh to TetGen files with the given prefix.
+static void writeTetGen(const FlatMesh& mesh, int copies,
+                        const string& prefix) {
+  ofstream node(prefix + ".node");
+  node << mesh.numVertices*copies << "  3  0  0\n" << setprecision(17);
+  for (int c=0; c<copies; ++c) {
+    for (int i=0; i<mesh.numVertices; ++i) {
+      node << c*mesh.numVertices + i << "  " << mesh.vertices[i*3] << "  "
+           << mesh.vertices[i*3+1] << "  " << mesh.vertices[i*3+2] << "\n";
+    }
+  }
+
+  ofstream ele(prefix + ".ele");
+  const int n = mesh.verticesPerElement;
+  ele << mesh.numElements*copies << "  " << n << "  0\n";
+  for (int c=0; c<copies; ++c) {
+    for (int i=0; i<mesh.numElements; ++i) {
+      ele << c*mesh.numElements + i;
+      for (int j=0; j<n; ++j) {
+        ele << "  " << c*mesh.numVertices + mesh.elements[i*n+j];
+      }
+      ele << "\n";
+    }
+  }
+}
+
+static void loadMeshVol(const string& prefix) {
+  MeshVol mesh;
+  mesh.loadTet(prefix + ".node", prefix + ".ele");
+
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  FieldRef<double,3> x = verts.addField<double,3>("x");
+  vector<ElementRef> vertRefs;
+  for (const array<double,3>& v : mesh.v) {
+    ElementRef vert = verts.add();
+    x.set(vert, {v[0], v[1], v[2]});
+    vertRefs.push_back(vert);
+  }
+  for (const vector<int>& tet : mesh.e) {
+    tets.add(vertRefs[tet[0]], vertRefs[tet[1]],
+             vertRefs[tet[2]], vertRefs[tet[3]]);
+  }
+}
+
+static void loadFlatMesh(const string& prefix) {
+  FlatMesh mesh;
+  mesh.loadTet(prefix + ".node", prefix + ".ele");
+
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  verts.adopt(mesh.numVertices);
+  verts.adoptField<double,3>("x", mesh.vertices.data());
+  tets.adopt(mesh.numElements, mesh.elements.data());
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 5;
+  int copies = (argc > 2) ? atoi(argv[2]) : 10;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  FlatMesh mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  const string prefix = "/tmp/simit-mesh-loading";
+  writeTetGen(mesh, copies, prefix);
+  cout << mesh.numVertices*copies << " vertices, "
+       << mesh.numElements*copies << " tets, "
+       << util::ThreadPool::getInstance().getNumThreads() << " threads"
+       << endl;
+
+  double stream = bench::time(reps, [&]() {loadMeshVol(prefix);});
+  bench::printTime("MeshVol::loadTet + add", stream);
+  bench::printTime("FlatMesh::loadTet + adopt",
+                   bench::time(reps, [&]() {loadFlatMesh(prefix);}), stream);
+
+  remove((prefix + ".node").c_str());
+  remove((prefix + ".ele").c_str());
+  return 0;
+}
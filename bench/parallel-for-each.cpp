@@ -0,0 +1,91 @@
+/// Compares computing the rest volumes of the tetrahedra of a mesh on the host
+/// with a sequential loop over the tet set and with parallelForEach, using a
+/// static and a dynamic schedule.
+///
+/// Usage: parallel-for-each [repetitions] [copies] [mesh-prefix]
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "graph.h"
+#include "util/thread_pool.h"
+
+using namespace std;
+using namespace simit;
+
+static double volume(const double* x, const int* tet) {
+  const double* a = x + tet[0]*3;
+  double u[3], v[3], w[3];
+  for (int c=0; c<3; ++c) {
+    u[c] = x[tet[1]*3+c] - a[c];
+    v[c] = x[tet[2]*3+c] - a[c];
+    w[c] = x[tet[3]*3+c] - a[c];
+  }
+  return fabs(u[0]*(v[1]*w[2] - v[2]*w[1]) - u[1]*(v[0]*w[2] - v[2]*w[0]) +
+              u[2]*(v[0]*w[1] - v[1]*w[0])) / 6.0;
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int copies = (argc > 2) ? atoi(argv[2]) : 10;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  MeshVol mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  const int numVerts = mesh.v.size();
+  vector<double> positions;
+  vector<int> endpoints;
+  for (int c=0; c<copies; ++c) {
+    for (const array<double,3>& v : mesh.v) {
+      positions.insert(positions.end(), v.begin(), v.end());
+    }
+    for (const vector<int>& tet : mesh.e) {
+      for (int vert : tet) {
+        endpoints.push_back(c*numVerts + vert);
+      }
+    }
+  }
+  verts.addMany(numVerts*copies);
+  FieldRef<double,3> x = verts.addField<double,3>("x");
+  x.view().copyFrom(positions.data());
+  tets.addMany(mesh.e.size()*copies, endpoints.data());
+  FieldRef<double> W = tets.addField<double>("W");
+  cout << tets.getSize() << " tets, "
+       << util::ThreadPool::getInstance().getNumThreads() << " threads"
+       << endl;
+
+  const double* xData = (const double*)verts.getFieldData("x");
+  auto body = [&](const Set::ElementRange& range) {
+    const int* tet = range.getEndpointsData();
+    for (ElementRef elem : range) {
+      W(elem) = volume(xData, tet);
+      tet += 4;
+    }
+  };
+
+  double sequential = bench::time(reps, [&]() {
+    for (ElementRef tet : tets) {
+      int vs[4];
+      int i = 0;
+      for (ElementRef vert : tets.getEndpoints(tet)) {
+        vs[i++] = vert.getIdent();
+      }
+      W(tet) = volume(xData, vs);
+    }
+  });
+  bench::printTime("sequential", sequential);
+  bench::printTime("parallelForEach static", bench::time(reps, [&]() {
+    parallelForEach(tets, body);
+  }), sequential);
+  bench::printTime("parallelForEach dynamic", bench::time(reps, [&]() {
+    parallelForEach(tets, body, Schedule::Dynamic);
+  }), sequential);
+  return 0;
+}
@@ -0,0 +1,84 @@
+/// Compares rebuilding the vertex-tet-vertex path index of a stiffness matrix
+/// with extending it, after contact springs between random vertices are
+/// appended to the tet set the way contact simulations add them every step.
+///
+/// Usage: path-index-extend [repetitions] [contacts] [mesh-prefix]
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "graph.h"
+#include "path_expressions.h"
+#include "path_indices.h"
+
+using namespace std;
+using namespace simit;
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 5;
+  int contacts = (argc > 2) ? atoi(argv[2]) : 200;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  MeshVol mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  cout << mesh.v.size() << " vertices, " << mesh.e.size() << " tets, "
+       << contacts << " contacts" << endl;
+
+  pe::Var vi("vi", pe::Set("V"));
+  pe::Var e("e", pe::Set("E"));
+  pe::Var vj("vj", pe::Set("V"));
+  pe::PathExpression ve = pe::Link::make(vi, e, pe::Link::ve);
+  pe::PathExpression ev = pe::Link::make(e, vj, pe::Link::ev);
+  pe::PathExpression vev = pe::And::make({vi,vj}, {{pe::QuantifiedVar::Exist,e}},
+                                         ve, ev);
+
+  vector<int> endpoints;
+  for (const vector<int>& tet : mesh.e) {
+    endpoints.insert(endpoints.end(), tet.begin(), tet.end());
+  }
+  vector<int> contactEndpoints;
+  srand(0);
+  for (int i=0; i<contacts*4; ++i) {
+    contactEndpoints.push_back(rand() % mesh.v.size());
+  }
+
+  // Each run starts from the mesh without contacts
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  verts.addMany(mesh.v.size());
+  auto run = [&](bool extend) {
+    Set contactTets(verts,verts,verts,verts);
+    contactTets.addMany(mesh.e.size(), endpoints.data());
+    pe::PathIndexBuilder builder;
+    builder.bind("V", &verts);
+    builder.bind("E", &contactTets);
+    builder.buildSegmented(vev, 0);
+
+    auto begin = chrono::high_resolution_clock::now();
+    contactTets.addMany(contacts, contactEndpoints.data());
+    if (extend) {
+      builder.extend({{"E", (int)mesh.e.size()}});
+    }
+    else {
+      builder = pe::PathIndexBuilder();
+      builder.bind("V", &verts);
+      builder.bind("E", &contactTets);
+    }
+    builder.buildSegmented(vev, 0).numNeighbors();
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double,milli>(end - begin).count();
+  };
+
+  double rebuild = 0.0;
+  double extend = 0.0;
+  for (int i=0; i<reps; ++i) {
+    rebuild += run(false) / reps;
+    extend += run(true) / reps;
+  }
+  bench::printTime("rebuild", rebuild);
+  bench::printTime("extend", extend, rebuild);
+  return 0;
+}
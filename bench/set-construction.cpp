@@ -0,0 +1,105 @@
+/// Compares ways of loading a tetrahedral mesh into Simit sets: adding the
+/// elements one at a time, with and without reserving capacity first, adding
+/// them in bulk with addMany, and adopting the caller's buffers. The mesh is
+/// replicated `copies` times to reach the sizes of large simulations.
+///
+/// Usage: set-construction [repetitions] [copies] [mesh-prefix]
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "bench.h"
+#include "flat_mesh.h"
+#include "graph.h"
+
+using namespace std;
+using namespace simit;
+
+/// Replicate the mesh `copies` times.
+static FlatMesh replicate(const FlatMesh& mesh, int copies) {
+  FlatMesh copy;
+  copy.numVertices = mesh.numVertices * copies;
+  copy.numElements = mesh.numElements * copies;
+  copy.verticesPerElement = mesh.verticesPerElement;
+  copy.vertices.reserve(copy.numVertices*3);
+  copy.elements.reserve(copy.numElements*mesh.verticesPerElement);
+  for (int c=0; c<copies; ++c) {
+    copy.vertices.insert(copy.vertices.end(), mesh.vertices.begin(),
+                         mesh.vertices.end());
+    for (int v : mesh.elements) {
+      copy.elements.push_back(c*mesh.numVertices + v);
+    }
+  }
+  return copy;
+}
+
+/// Add the mesh one element at a time, optionally reserving capacity first.
+static void addElements(const FlatMesh& mesh, bool reserve) {
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  FieldRef<double,3> x = verts.addField<double,3>("x");
+  if (reserve) {
+    verts.reserve(mesh.numVertices);
+    tets.reserve(mesh.numElements);
+  }
+
+  vector<ElementRef> vertRefs;
+  vertRefs.reserve(mesh.numVertices);
+  for (int i=0; i<mesh.numVertices; ++i) {
+    ElementRef vert = verts.add();
+    x.set(vert, {mesh.vertices[i*3], mesh.vertices[i*3+1], mesh.vertices[i*3+2]});
+    vertRefs.push_back(vert);
+  }
+  for (int i=0; i<mesh.numElements; ++i) {
+    const int* tet = &mesh.elements[i*4];
+    tets.add(vertRefs[tet[0]], vertRefs[tet[1]],
+             vertRefs[tet[2]], vertRefs[tet[3]]);
+  }
+}
+
+/// Add the mesh with one addMany call per set.
+static void addMany(const FlatMesh& mesh) {
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  verts.addField<double,3>("x");
+  verts.addMany(mesh.numVertices);
+  memcpy(verts.getFieldData("x"), mesh.vertices.data(),
+         mesh.vertices.size()*sizeof(double));
+  tets.addMany(mesh.numElements, mesh.elements.data());
+}
+
+/// Build the sets on top of the mesh arrays.
+static void adopt(FlatMesh* mesh) {
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  verts.adopt(mesh->numVertices);
+  verts.adoptField<double,3>("x", mesh->vertices.data());
+  tets.adopt(mesh->numElements, mesh->elements.data());
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 10;
+  int copies = (argc > 2) ? atoi(argv[2]) : 1;
+  string meshPrefix = (argc > 3) ? argv[3] : bench::defaultMesh();
+
+  FlatMesh loaded;
+  if (loaded.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  FlatMesh mesh = replicate(loaded, copies);
+  cout << mesh.numVertices << " vertices, " << mesh.numElements << " tets" << endl;
+
+  double incremental = bench::time(reps, [&]() {addElements(mesh, false);});
+  bench::printTime("add", incremental);
+  bench::printTime("reserve + add",
+                   bench::time(reps, [&]() {addElements(mesh, true);}),
+                   incremental);
+  bench::printTime("addMany",
+                   bench::time(reps, [&]() {addMany(mesh);}),
+                   incremental);
+  bench::printTime("adopt",
+                   bench::time(reps, [&]() {adopt(&mesh);}),
+                   incremental);
+  return 0;
+}
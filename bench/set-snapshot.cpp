@@ -0,0 +1,81 @@
+/// Compares building the sets of a tetrahedral mesh from its .node/.ele text
+/// files with opening them from a snapshot, and measures how long writing the
+/// snapshot, which is how simulations are checkpointed, takes.
+///
+/// Usage: set-snapshot [repetitions] [mesh-prefix] [snapshot-path]
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "graph.h"
+#include "set_snapshot.h"
+
+using namespace std;
+using namespace simit;
+
+/// Build the vertex and tet sets of a mesh, with vertex positions.
+static void buildSets(const MeshVol& mesh, Set* verts, Set* tets) {
+  verts->addMany(mesh.v.size());
+  FieldRef<double,3> x = verts->addField<double,3>("x");
+  for (ElementRef vert : *verts) {
+    const array<double,3>& v = mesh.v[vert.getIdent()];
+    x.set(vert, {v[0], v[1], v[2]});
+  }
+  vector<int> endpoints;
+  endpoints.reserve(mesh.e.size() * 4);
+  for (const vector<int>& tet : mesh.e) {
+    endpoints.insert(endpoints.end(), tet.begin(), tet.end());
+  }
+  tets->addMany(mesh.e.size(), endpoints.data());
+}
+
+/// Sum the vertex positions of the tets, so that the sets' data is read.
+static double touch(Set* verts, Set* tets) {
+  FieldRef<double,3> x = verts->getField<double,3>("x");
+  double sum = 0.0;
+  for (ElementRef tet : *tets) {
+    for (ElementRef vert : tets->getEndpoints(tet)) {
+      sum += x(vert)(0);
+    }
+  }
+  return sum;
+}
+
+int main(int argc, const char* argv[]) {
+  int reps = (argc > 1) ? atoi(argv[1]) : 10;
+  string meshPrefix = (argc > 2) ? argv[2] : bench::defaultMesh();
+  string path = (argc > 3) ? argv[3] : "/tmp/simit-bench-snapshot";
+
+  MeshVol mesh;
+  if (mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele") < 0) {
+    cerr << "Could not load mesh " << meshPrefix << endl;
+    return 1;
+  }
+  cout << mesh.v.size() << " vertices, " << mesh.e.size() << " tets" << endl;
+
+  volatile double sum = 0.0;
+  double text = bench::time(reps, [&]() {
+    MeshVol mesh;
+    mesh.loadTet(meshPrefix + ".node", meshPrefix + ".ele");
+    Set verts;
+    Set tets(verts,verts,verts,verts);
+    buildSets(mesh, &verts, &tets);
+    sum = sum + touch(&verts, &tets);
+  });
+  bench::printTime("load .node/.ele", text);
+
+  Set verts;
+  Set tets(verts,verts,verts,verts);
+  buildSets(mesh, &verts, &tets);
+  bench::printTime("write snapshot", bench::time(reps, [&]() {
+    writeSnapshot(path, {{"verts",&verts}, {"tets",&tets}});
+  }));
+  bench::printTime("open snapshot", bench::time(reps, [&]() {
+    SetSnapshot snapshot(path);
+    sum = sum + touch(snapshot.getSet("verts"), snapshot.getSet("tets"));
+  }), text);
+
+  remove(path.c_str());
+  return 0;
+}
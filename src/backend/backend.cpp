@@ -21,6 +21,9 @@ BackendImpl* getBackendImpl(const std::string &type) {
   if (type == "cpu") {
     return new backend::LLVMBackend();
   }
+  if (type == "cpu-parallel") {
+    return new backend::LLVMBackend(true);
+  }
 #ifdef GPU
   if (type == "gpu") {
     return new backend::GPUBackend();
@@ -49,8 +49,6 @@ public:
 
   // TODO Should these really be an extension to the bind interface?
   //      Per-argument updates/copies.
-  //      Don't always write in a new pointer (requires re-JIT), just alert to
-  //      updates in pointed-to data.
   virtual void mapArgs() {}
   virtual void unmapArgs(bool updated=true) {}
 
@@ -61,6 +59,15 @@ public:
   /// Print the function as machine assembly code to the stream.
   virtual void printMachine(std::ostream &os) const = 0;
 
+  /// Print how much memory the function's temporaries take up to the stream.
+  virtual void printMemoryReport(std::ostream &os) const {}
+
+  /// Returns the current and the peak number of bytes held by the function's
+  /// memory arena, and the number of allocations it served by reusing blocks.
+  virtual size_t getCurrentMemoryUsage() const {return 0;}
+  virtual size_t getPeakMemoryUsage() const {return 0;}
+  virtual size_t getNumReused() const {return 0;}
+
   bool hasArg(std::string arg) const;
   const std::vector<std::string>& getArgs() const;
   const ir::Type& getArgType(std::string arg) const;
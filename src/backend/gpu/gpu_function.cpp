@@ -502,9 +502,11 @@ llvm::Value *GPUFunction::pushArg(std::string name, ir::Type& argType, Actual* a
 
     llvm::StructType *llvmSetType = llvmType(setType);
     std::vector<llvm::Constant*> setData;
-    // Set size
+    // Set size and capacity, which is the size since the device copies of
+    // the fields only hold the set's elements
     if (setType->isa<ir::UnstructuredSetType>()) {
       setData.push_back(llvmInt(pushedData.setSize));
+      setData.push_back(llvmInt(pushedData.setSize));
     }
     else if (setType->isa<ir::LatticeLinkSetType>()) {
       setData.push_back(llvmPtr(LLVM_INT_PTR, reinterpret_cast<void*>(
@@ -807,10 +809,13 @@ GPUFunction::init() {
       
       vector<uint8_t> setData;
       if (setType->isa<ir::UnstructuredSetType>()) {
-        // setSize
-        int idx = setData.size();
-        setData.resize(setData.size() + sizeof(int));
-        memcpy(setData.data()+idx, (uint8_t*)(&pushedData.setSize), sizeof(int));
+        // setSize and capacity
+        for (int i=0; i < 2; ++i) {
+          int idx = setData.size();
+          setData.resize(setData.size() + sizeof(int));
+          memcpy(setData.data()+idx, (uint8_t*)(&pushedData.setSize),
+                 sizeof(int));
+        }
       }
       else if (setType->isa<ir::LatticeLinkSetType>()) {
         // setSizes
@@ -26,12 +26,14 @@
 #include "llvm_codegen.h"
 #include "llvm_util.h"
 #include "llvm_data_layouts.h"
+#include "llvm_object_cache.h"
 
 #include "macros.h"
 #include "types.h"
 #include "func.h"
 #include "ir.h"
 #include "intrinsics.h"
+#include "ir_codegen.h"
 #include "ir_printer.h"
 #include "ir_queries.h"
 #include "ir_transforms.h"
@@ -41,6 +43,7 @@
 #include "llvm_function.h"
 #include "macros.h"
 #include "path_expressions.h"
+#include "var_replace_rewriter.h"
 #include "util/collections.h"
 
 using namespace std;
@@ -52,6 +55,7 @@ namespace backend {
 const std::string VAL_SUFFIX(".val");
 const std::string PTR_SUFFIX(".ptr");
 const std::string LEN_SUFFIX(".len");
+const std::string COLORING_SUFFIX(".coloring");
 
 // class LLVMBackend
 bool LLVMBackend::llvmInitialized = false;
@@ -62,7 +66,9 @@ shared_ptr<llvm::EngineBuilder> createEngineBuilder(llvm::Module *module) {
   return engineBuilder;
 }
 
-LLVMBackend::LLVMBackend() : builder(new LLVMIRBuilder(LLVM_CTX)) {
+LLVMBackend::LLVMBackend(bool parallel)
+    : parallel(parallel), inParallelLoop(false),
+      builder(new LLVMIRBuilder(LLVM_CTX)) {
   if (!llvmInitialized) {
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
@@ -73,42 +79,6 @@ LLVMBackend::LLVMBackend() : builder(new LLVMIRBuilder(LLVM_CTX)) {
 
 LLVMBackend::~LLVMBackend() {}
 
-// TODO: Remove this function, once the old init system has been removed
-Func LLVMBackend::makeSystemTensorsGlobal(Func func) {
-  class MakeSystemTensorsGlobalRewriter : public ir::IRRewriter {
-  public:
-    MakeSystemTensorsGlobalRewriter() {}
-
-  private:
-    Environment environment;
-
-    void visit(const Func* f) {
-      environment = f->getEnvironment();
-
-      Stmt body = rewrite(f->getBody());
-      if (body != f->getBody()) {
-        func = Func(f->getName(), f->getArguments(), f->getResults(), body,
-                    environment);
-        func.setStorage(f->getStorage());
-      }
-      else {
-        func = *f;
-      }
-    }
-
-    void visit(const VarDecl* op) {
-      const Var& var = op->var;
-      if (isSystemTensorType(var.getType()) && environment.hasTensorIndex(var)){
-        environment.addTemporary(var);
-      }
-      else {
-        stmt = op;
-      }
-    }
-  };
-  return MakeSystemTensorsGlobalRewriter().rewrite(func);
-}
-
 Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
   this->module = new llvm::Module("simit", LLVM_CTX);
 
@@ -123,7 +93,7 @@ Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
 
   // This backend stores dense tensors and sparse tensors with path expressions
   // as globals.
-  func = makeSystemTensorsGlobal(func);
+  func = makeBufferedSystemTensorsGlobal(func);
 
   this->environment = &func.getEnvironment();
   emitGlobals(*this->environment);
@@ -153,10 +123,52 @@ Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
       symtable.insert(global.first, compile(global.second));
     }
 
+    // Find the set loops that will run in parallel
+    parallelLoops.clear();
+    if (parallel) {
+      class FindParallelLoops : public IRVisitor {
+      public:
+        FindParallelLoops(const Storage& storage, const Environment* env,
+                          map<const ir::For*,LoopParallelism>* loops)
+            : storage(storage), env(env), loops(loops) {}
+      private:
+        const Storage& storage;
+        const Environment* env;
+        map<const ir::For*,LoopParallelism>* loops;
+        using IRVisitor::visit;
+        void visit(const ir::For* op) {
+          LoopParallelism parallelism = getLoopParallelism(op, env);
+          if (parallelism.isParallel() && hasDensePrivates(parallelism)) {
+            loops->insert({op, parallelism});
+          }
+          else {
+            IRVisitor::visit(op);
+          }
+        }
+        // We can only give each thread its own copy of dense tensors
+        bool hasDensePrivates(const LoopParallelism& parallelism) {
+          for (const Var& var : parallelism.getPrivateVars()) {
+            if (!isScalar(var.getType()) &&
+                (!storage.hasStorage(var) ||
+                 storage.getStorage(var).getKind() != TensorStorage::Dense)) {
+              return false;
+            }
+          }
+          return true;
+        }
+      };
+      FindParallelLoops findParallelLoops(this->storage, this->environment,
+                                          &parallelLoops);
+      f.getBody().accept(&findParallelLoops);
+    }
+
     // LLVM does not de-allocate any stack memory until a function returns, so
     // we must make sure to not allocate stack memory inside a loop. To do this
-    // we move all the var decls to the front of the function body
-    Stmt body = moveVarDeclsToFront(f.getBody());
+    // we move all the var decls to the front of the function body. Parallel
+    // loops keep theirs, since they are declared in the outlined loop function.
+    Stmt body = moveVarDeclsToFront(f.getBody(), [this](const ir::For* loop) {
+      return util::contains(parallelLoops, loop);
+    });
 
     compile(body);
     builder->CreateRetVoid();
@@ -165,15 +177,16 @@ Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
   }
   iassert(llvmFunc);
 
-  // Declare malloc and free if necessary
+  // Declare malloc and free if necessary. Buffers are allocated with the
+  // runtime's allocator, so that they come from the function's memory arena.
   llvm::FunctionType *m =
-      llvm::FunctionType::get(LLVM_INT8_PTR, {LLVM_INT}, false);
-  llvm::Function *malloc =
-      llvm::cast<llvm::Function>(module->getOrInsertFunction("malloc", m));
+      llvm::FunctionType::get(LLVM_INT8_PTR, {LLVM_INT64}, false);
+  llvm::Function *malloc = llvm::cast<llvm::Function>(
+      module->getOrInsertFunction("simit_malloc", m));
   llvm::FunctionType *f =
       llvm::FunctionType::get(LLVM_VOID, {LLVM_INT8_PTR}, false);
-  llvm::Function *free =
-      llvm::cast<llvm::Function>(module->getOrInsertFunction("free", f));
+  llvm::Function *free = llvm::cast<llvm::Function>(
+      module->getOrInsertFunction("simit_free", f));
 
   // Create initialization function
   emitEmptyFunction(func.getName()+"_init", func.getArguments(),
@@ -190,6 +203,7 @@ Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
     llvm::Value *len= emitComputeLen(ttype,this->storage.getStorage(bufferVar));
     unsigned compSize = ttype->getComponentType().bytes();
     llvm::Value *size = builder->CreateMul(len, llvmInt(compSize));
+    size = builder->CreateZExt(size, LLVM_INT64);
     llvm::Value *mem = builder->CreateCall(malloc, size);
 
     mem = builder->CreateCast(llvm::Instruction::CastOps::BitCast, mem, ltype);
@@ -219,32 +233,44 @@ Function* LLVMBackend::compile(ir::Func func, const ir::Storage& storage) {
 
   auto engineBuilder = createEngineBuilder(module);
 
+  // If the machine code of an identical module is cached, then MCJIT loads it
+  // instead of compiling the module, so we need not optimize it either.
+  bool cached = false;
+  if (LLVMObjectCache::isEnabled() && LLVMObjectCache::isCacheable(*module)) {
+    string material = LLVMObjectCache::getKeyMaterial(*module);
+    string key = LLVMObjectCache::getKey(material);
+    module->setModuleIdentifier(key);
+    cached = LLVMObjectCache::getInstance().lookup(key, material);
+  }
+
 #ifndef SIMIT_DEBUG
-  // Run LLVM optimization passes on the function
-  // We use the built-in PassManagerBuilder to build
-  // the set of passes that are similar to clang's -O3
-  llvm::legacy::FunctionPassManager fpm(module);
-  llvm::legacy::PassManager mpm;
-  llvm::PassManagerBuilder pmBuilder;
-  
-  pmBuilder.OptLevel = 3;
+  if (!cached) {
+    // Run LLVM optimization passes on the function
+    // We use the built-in PassManagerBuilder to build
+    // the set of passes that are similar to clang's -O3
+    llvm::legacy::FunctionPassManager fpm(module);
+    llvm::legacy::PassManager mpm;
+    llvm::PassManagerBuilder pmBuilder;
 
-  pmBuilder.BBVectorize = 1;
-  pmBuilder.LoopVectorize = 1;
-//  pmBuilder.LoadCombine = 1;
-  pmBuilder.SLPVectorize = 1;
+    pmBuilder.OptLevel = 3;
 
-  llvm::DataLayout dataLayout(module);
-  module->setDataLayout(dataLayout);
+    pmBuilder.BBVectorize = 1;
+    pmBuilder.LoopVectorize = 1;
+//    pmBuilder.LoadCombine = 1;
+    pmBuilder.SLPVectorize = 1;
 
-  pmBuilder.populateFunctionPassManager(fpm);
-  pmBuilder.populateModulePassManager(mpm);
+    llvm::DataLayout dataLayout(module);
+    module->setDataLayout(dataLayout);
 
-  fpm.doInitialization();
-  fpm.run(*llvmFunc);
-  fpm.doFinalization();
-  
-  mpm.run(*module);
+    pmBuilder.populateFunctionPassManager(fpm);
+    pmBuilder.populateModulePassManager(mpm);
+
+    fpm.doInitialization();
+    fpm.run(*llvmFunc);
+    fpm.doFinalization();
+
+    mpm.run(*module);
+  }
 #endif
 
   return new LLVMFunction(func, storage, llvmFunc, module, engineBuilder);
@@ -292,9 +318,9 @@ void LLVMBackend::compile(const ir::Literal& literal) {
     }
   }
   else {
-    // TODO: This should become a reference to a global literal
-    // (unify with GPUBackend).
-    val = llvmPtr(literal);
+    // Tensor literals live in the module rather than at their host address,
+    // so that the module's machine code can be cached across processes
+    val = emitGlobalLiteral(literal);
   }
   iassert(val);
 }
@@ -366,6 +392,9 @@ void LLVMBackend::compile(const ir::IndexRead& indexRead) {
       iassert(indexRead.edgeSet.type().isGridSet());
       val = layout->getSize(indexRead.index);
       break;
+    case ir::IndexRead::Capacity:
+      val = layout->getCapacity();
+      break;
     default:
       unreachable;
   }
@@ -640,8 +669,15 @@ void LLVMBackend::compile(const ir::VarDecl& varDecl) {
     else {
       auto tensorStorage = storage.getStorage(varDecl.var);
 
+      // Dense tensors that are private to a parallel loop are kept on the
+      // stack of the outlined loop function, so that every thread has its own
+      if (inParallelLoop && tensorStorage.getKind() == TensorStorage::Dense) {
+        llvm::Value *len = emitComputeLen(type.toTensor(), tensorStorage);
+        llvmVar = builder->CreateAlloca(
+            llvmType(type.toTensor()->getComponentType()), len, var.getName());
+      }
       // Sparse matrices with path expressions are stored globally
-      if (tensorStorage.getKind() != TensorStorage::Indexed ||
+      else if (tensorStorage.getKind() != TensorStorage::Indexed ||
           tensorStorage.getTensorIndex().getPathExpression().defined()) {
         llvmVar = makeGlobalTensor(varDecl.var);
       }
@@ -682,10 +718,65 @@ void LLVMBackend::compile(const ir::AssignStmt& assignStmt) {
       emitAssign(assignStmt.var, Add::make(assignStmt.var, assignStmt.value));
       return;
     }
+    case ir::CompoundOperator::Mul: {
+      emitAssign(assignStmt.var, Mul::make(assignStmt.var, assignStmt.value));
+      return;
+    }
+    case ir::CompoundOperator::Max:
+    case ir::CompoundOperator::Min: {
+      const Var& var = assignStmt.var;
+      iassert(isScalar(var.getType()));
+      llvm::Value *value = emitCompoundOperation(assignStmt.cop, var,
+                                                 assignStmt.value);
+      llvm::Value *varPtr = symtable.get(var);
+      // Globals are stored as pointer-pointers so we must load them
+      if (util::contains(globals, var)) {
+        varPtr = builder->CreateLoad(varPtr, var.getName());
+      }
+      builder->CreateStore(value, varPtr);
+      return;
+    }
     default: ierror << "Unknown compound operator type";
   }
 }
 
+llvm::Value *LLVMBackend::emitCompoundOperation(CompoundOperator cop,
+                                                const Expr& a, const Expr& b) {
+  switch (cop) {
+    case CompoundOperator::None:
+      return compile(b);
+    case CompoundOperator::Add:
+      return compile(Add::make(a, b));
+    case CompoundOperator::Sub:
+      return compile(Sub::make(a, b));
+    case CompoundOperator::Mul:
+      return compile(Mul::make(a, b));
+    case CompoundOperator::Max:
+    case CompoundOperator::Min: {
+      iassert(isScalar(a.type()) && isScalar(b.type()));
+      llvm::Value *aVal = compile(a);
+      llvm::Value *bVal = compile(b);
+      bool max = (cop == CompoundOperator::Max);
+      llvm::Value *keepA = nullptr;
+      switch (a.type().toTensor()->getComponentType().kind) {
+        case ScalarType::Float:
+          keepA = max ? llvmCreateFCmpOGT(builder.get(), aVal, bVal)
+                      : llvmCreateFCmpOLT(builder.get(), aVal, bVal);
+          break;
+        case ScalarType::Int:
+          keepA = max ? llvmCreateICmpSGT(builder.get(), aVal, bVal)
+                      : llvmCreateICmpSLT(builder.get(), aVal, bVal);
+          break;
+        default:
+          not_supported_yet << cop << " of " << a.type();
+      }
+      return llvmCreateSelect(builder.get(), keepA, aVal, bVal);
+    }
+  }
+  unreachable;
+  return nullptr;
+}
+
 std::vector<llvm::Value*>
 LLVMBackend::emitArgument(ir::Expr argument, bool excludeStaticTypes) {
   std::vector<llvm::Value*> argumentValues;
@@ -827,6 +918,19 @@ LLVMBackend::emitResult(ir::Var result, bool excludeStaticTypes,
       }
       resultValues.push_back(compile(result));
     }
+    // Scalars are returned through a pointer to their stack slot
+    else if (isScalar(type)) {
+      if (!symtable.contains(result)) {
+        ScalarType stype = tensorType->getComponentType();
+        symtable.insert(result, builder->CreateAlloca(llvmType(stype), nullptr,
+                                                      result.getName()));
+      }
+      llvm::Value* resultPtr = symtable.get(result);
+      if (util::contains(globals, result)) {
+        resultPtr = builder->CreateLoad(resultPtr, result.getName());
+      }
+      resultValues.push_back(resultPtr);
+    }
   }
   else if (type.isOpaque()) {
     resultValues.push_back(compile(result));
@@ -952,10 +1056,13 @@ void LLVMBackend::emitIntrinsicCall(const ir::CallStmt& callStmt) {
   else if (callStmt.callee == ir::intrinsics::free()) {
     auto arg = args[args.size()-1];
     arg = builder->CreateCast(llvm::Instruction::CastOps::BitCast, arg, LLVM_INT8_PTR);
-    call = emitCall("free", {arg}, LLVM_VOID);
+    call = emitCall("simit_free", {arg}, LLVM_VOID);
   }
   else if (callStmt.callee == ir::intrinsics::malloc()) {
-    call = emitCall("malloc", args, LLVM_INT8_PTR);
+    // Allocate from the function's memory arena, with the signature the init
+    // function declares simit_malloc with
+    auto size = builder->CreateZExt(args[0], LLVM_INT64);
+    call = emitCall("simit_malloc", {size}, LLVM_INT8_PTR);
   }
   else if (callStmt.callee == ir::intrinsics::strcmp()) {
     call = emitCall("strcmp", args, LLVM_INT);
@@ -1073,23 +1180,8 @@ void LLVMBackend::compile(const ir::CallStmt& callStmt) {
 void LLVMBackend::compile(const ir::Store& store) {
   llvm::Value *buffer = compile(store.buffer);
   llvm::Value *index = compile(store.index);
-  llvm::Value *value;
-  switch (store.cop) {
-    case CompoundOperator::None: {
-      value = compile(store.value);
-      break;
-    }
-    case CompoundOperator::Add: {
-      value = compile(Add::make(Load::make(store.buffer, store.index),
-                                store.value));
-      break;
-    }
-    case CompoundOperator::Sub: {
-      value = compile(Sub::make(Load::make(store.buffer, store.index),
-                                store.value));
-      break;
-    }
-  }
+  llvm::Value *value = emitCompoundOperation(
+      store.cop, Load::make(store.buffer, store.index), store.value);
   iassert(value != nullptr);
 
   string locName = string(buffer->getName()) + PTR_SUFFIX;
@@ -1153,6 +1245,9 @@ void LLVMBackend::compile(const ir::FieldWrite& fieldWrite) {
                                      fieldWrite.value));
         break;
       }
+      default:
+        not_supported_yet << "compound " << fieldWrite.cop
+                          << " writes of whole fields";
     }
     iassert(valuePtr != nullptr);
 
@@ -1206,47 +1301,12 @@ void LLVMBackend::compile(const ir::IfThenElse& ifThenElse) {
 }
 
 void LLVMBackend::compile(const ir::ForRange& forLoop) {
-  std::string iName = forLoop.var.getName();
-  
-  llvm::Function *llvmFunc = builder->GetInsertBlock()->getParent();
-  
-  // Loop Header
-  llvm::BasicBlock *entryBlock = builder->GetInsertBlock();
-
   llvm::Value *rangeStart = compile(forLoop.start);
   llvm::Value *rangeEnd = compile(forLoop.end);
-
-  llvm::BasicBlock *loopBodyStart =
-    llvm::BasicBlock::Create(LLVM_CTX, iName+"_loop_body", llvmFunc);
-  llvm::BasicBlock *loopEnd = llvm::BasicBlock::Create(LLVM_CTX,
-                                                       iName+"_loop_end",
-                                                       llvmFunc);
-  llvm::Value *firstCmp = llvmCreateICmpSLT(builder.get(), rangeStart, rangeEnd);
-  builder->CreateCondBr(firstCmp, loopBodyStart, loopEnd);
-  builder->SetInsertPoint(loopBodyStart);
-
-  llvm::PHINode *i = llvmCreatePHI(builder.get(), LLVM_INT32, 2, iName);
-  i->addIncoming(rangeStart, entryBlock);
-
-  // Loop Body
-  symtable.insert(forLoop.var, i);
-  compile(forLoop.body);
-
-  // Loop Footer
-  llvm::BasicBlock *loopBodyEnd = builder->GetInsertBlock();
-  llvm::Value *i_nxt = builder->CreateAdd(i, builder->getInt32(1),
-                                          iName+"_nxt", false, true);
-  i->addIncoming(i_nxt, loopBodyEnd);
-
-  llvm::Value *exitCond = llvmCreateICmpSLT(builder.get(), i_nxt, rangeEnd,
-                                            iName+"_cmp");
-  builder->CreateCondBr(exitCond, loopBodyStart, loopEnd);
-  builder->SetInsertPoint(loopEnd);
-
+  emitLoop(forLoop.var, rangeStart, rangeEnd, forLoop.body);
 }
 
 void LLVMBackend::compile(const ir::For& forLoop) {
-  std::string iName = forLoop.var.getName();
   ForDomain domain = forLoop.domain;
 
   llvm::Value *iNum = nullptr;
@@ -1274,35 +1334,11 @@ void LLVMBackend::compile(const ir::For& forLoop) {
   }
   iassert(iNum);
 
-  llvm::Function *llvmFunc = builder->GetInsertBlock()->getParent();
-
-  // Loop Header
-  llvm::BasicBlock *entryBlock = builder->GetInsertBlock();
-
-  llvm::BasicBlock *loopBodyStart =
-      llvm::BasicBlock::Create(LLVM_CTX, iName+"_loop_body", llvmFunc);
-  llvm::BasicBlock *loopEnd = llvm::BasicBlock::Create(LLVM_CTX,
-                                                       iName+"_loop_end", llvmFunc);
-  llvm::Value *firstCmp = llvmCreateICmpSLT(builder.get(), llvmInt(0), iNum);
-  builder->CreateCondBr(firstCmp, loopBodyStart, loopEnd);
-  builder->SetInsertPoint(loopBodyStart);
-
-  llvm::PHINode *i = llvmCreatePHI(builder.get(), LLVM_INT32, 2, iName);
-  i->addIncoming(builder->getInt32(0), entryBlock);
-
-  // Loop Body
-  symtable.insert(forLoop.var, i);
-  compile(forLoop.body);
-
-  // Loop Footer
-  llvm::BasicBlock *loopBodyEnd = builder->GetInsertBlock();
-  llvm::Value *i_nxt = builder->CreateAdd(i, builder->getInt32(1),
-                                          iName+"_nxt", false, true);
-  i->addIncoming(i_nxt, loopBodyEnd);
-
-  llvm::Value *exitCond = llvmCreateICmpSLT(builder.get(), i_nxt, iNum, iName+"_cmp");
-  builder->CreateCondBr(exitCond, loopBodyStart, loopEnd);
-  builder->SetInsertPoint(loopEnd);
+  if (util::contains(parallelLoops, &forLoop)) {
+    emitParallelFor(forLoop, iNum);
+    return;
+  }
+  emitLoop(forLoop.var, llvmInt(0), iNum, forLoop.body);
 }
 
 void LLVMBackend::compile(const ir::While& whileLoop) {
@@ -1562,6 +1598,22 @@ llvm::Constant *LLVMBackend::emitGlobalString(const std::string& str) {
   return llvm::ConstantExpr::getGetElementPtr(nullptr, strGlobal, idx);
 }
 
+llvm::Constant *LLVMBackend::emitGlobalLiteral(const ir::Literal& literal) {
+  iassert(literal.type.isTensor());
+  llvm::ArrayRef<uint8_t> data((const uint8_t*)literal.data, literal.size);
+  llvm::Constant* dataValue = llvm::ConstantDataArray::get(LLVM_CTX, data);
+
+  // Literals are not marked constant, since they may be passed to functions
+  // that take mutable tensor arguments
+  llvm::GlobalVariable* literalGlobal =
+      new llvm::GlobalVariable(*module, dataValue->getType(), false,
+                               llvm::GlobalValue::PrivateLinkage, dataValue,
+                               "_literal");
+  literalGlobal->setAlignment(8);
+  return llvm::ConstantExpr::getPointerCast(
+      literalGlobal, llvmType(*literal.type.toTensor()));
+}
+
 llvm::Function *LLVMBackend::emitEmptyFunction(const string &name,
                                                const vector<ir::Var> &arguments,
                                                const vector<ir::Var> &results,
@@ -1672,6 +1724,13 @@ void LLVMBackend::emitGlobals(const ir::Environment& env, bool packed) {
                        globalAddrspace(), packed);
       this->symtable.insert(colidx, colidxPtr);
       this->globals.insert(colidx);
+
+      const Var& locs  = tensorIndex.getLocationsArray();
+      llvm::GlobalVariable* locsPtr =
+          createGlobal(module, locs, llvm::GlobalValue::ExternalLinkage,
+                       globalAddrspace(), packed);
+      this->symtable.insert(locs, locsPtr);
+      this->globals.insert(locs);
     }
   }
 }
@@ -1747,6 +1806,195 @@ void LLVMBackend::emitAssign(Var var, const Expr& value) {
   }
 }
 
+void LLVMBackend::emitLoop(const ir::Var& var, llvm::Value *begin,
+                           llvm::Value *end, const ir::Stmt& body,
+                           llvm::Value *indices) {
+  std::string iName = var.getName();
+
+  llvm::Function *llvmFunc = builder->GetInsertBlock()->getParent();
+
+  // Loop Header
+  llvm::BasicBlock *entryBlock = builder->GetInsertBlock();
+
+  llvm::BasicBlock *loopBodyStart =
+    llvm::BasicBlock::Create(LLVM_CTX, iName+"_loop_body", llvmFunc);
+  llvm::BasicBlock *loopEnd = llvm::BasicBlock::Create(LLVM_CTX,
+                                                       iName+"_loop_end",
+                                                       llvmFunc);
+  llvm::Value *firstCmp = llvmCreateICmpSLT(builder.get(), begin, end);
+  builder->CreateCondBr(firstCmp, loopBodyStart, loopEnd);
+  builder->SetInsertPoint(loopBodyStart);
+
+  llvm::PHINode *i = llvmCreatePHI(builder.get(), LLVM_INT32, 2, iName);
+  i->addIncoming(begin, entryBlock);
+
+  // Loop Body
+  if (indices) {
+    llvm::Value *indexPtr = llvmCreateInBoundsGEP(builder.get(), indices, i);
+    symtable.insert(var, builder->CreateLoad(indexPtr, iName+"_idx"));
+  }
+  else {
+    symtable.insert(var, i);
+  }
+  compile(body);
+
+  // Loop Footer
+  llvm::BasicBlock *loopBodyEnd = builder->GetInsertBlock();
+  llvm::Value *i_nxt = builder->CreateAdd(i, builder->getInt32(1),
+                                          iName+"_nxt", false, true);
+  i->addIncoming(i_nxt, loopBodyEnd);
+
+  llvm::Value *exitCond = llvmCreateICmpSLT(builder.get(), i_nxt, end,
+                                            iName+"_cmp");
+  builder->CreateCondBr(exitCond, loopBodyStart, loopEnd);
+  builder->SetInsertPoint(loopEnd);
+}
+
+void LLVMBackend::emitParallelFor(const ir::For& forLoop,
+                                  llvm::Value *numIterations) {
+  std::string iName = forLoop.var.getName();
+  llvm::Function *llvmFunc = builder->GetInsertBlock()->getParent();
+  bool colored =
+      parallelLoops.at(&forLoop).getKind() == LoopParallelism::Colored;
+
+  // The outlined loop function receives the values it uses from the enclosing
+  // function through an environment struct. Constants (including globals) can
+  // be used directly.
+  vector<pair<Var,llvm::Value*>> captures;
+  std::set<Var> captured;
+  for (auto &scope : symtable) {
+    for (auto &symbol : scope) {
+      // Inner scopes come first and shadow outer ones
+      if (!captured.insert(symbol.first).second ||
+          llvm::isa<llvm::Constant>(symbol.second)) {
+        continue;
+      }
+      captures.push_back(symbol);
+    }
+  }
+
+  vector<llvm::Type*> captureTypes;
+  for (auto &capture : captures) {
+    captureTypes.push_back(capture.second->getType());
+  }
+  llvm::StructType *envType = llvm::StructType::get(LLVM_CTX, captureTypes);
+
+  // Allocate the environment in the entry block, so that we do not grow the
+  // stack if the parallel loop is nested inside a serial loop
+  llvm::BasicBlock &entryBlock = llvmFunc->getEntryBlock();
+  LLVMIRBuilder entryBuilder(&entryBlock, entryBlock.begin());
+  llvm::Value *env = entryBuilder.CreateAlloca(envType, nullptr, iName+"_env");
+  for (size_t i = 0; i < captures.size(); ++i) {
+    builder->CreateStore(captures[i].second,
+                         builder->CreateStructGEP(envType, env, i));
+  }
+
+  // Emit the loop function: void (i8 *env, i32 begin, i32 end), or for colored
+  // loops void (i8 *env, i32 *elements, i32 begin, i32 end)
+  vector<llvm::Type*> loopArgTypes = {LLVM_INT8_PTR};
+  if (colored) {
+    loopArgTypes.push_back(LLVM_INT32_PTR);
+  }
+  loopArgTypes.push_back(LLVM_INT32);
+  loopArgTypes.push_back(LLVM_INT32);
+  llvm::FunctionType *loopFuncType =
+      llvm::FunctionType::get(LLVM_VOID, loopArgTypes, false);
+  llvm::Function *loopFunc =
+      llvm::Function::Create(loopFuncType, llvm::Function::InternalLinkage,
+                             llvmFunc->getName() + "." + iName + "_loop",
+                             module);
+  loopFunc->setDoesNotThrow();
+
+  llvm::BasicBlock *callBlock = builder->GetInsertBlock();
+  builder->SetInsertPoint(llvm::BasicBlock::Create(LLVM_CTX,"entry",loopFunc));
+
+  auto argIt = loopFunc->arg_begin();
+  llvm::Value *envArg = &(*argIt++);
+  llvm::Value *elements = colored ? &(*argIt++) : nullptr;
+  llvm::Value *begin  = &(*argIt++);
+  llvm::Value *end    = &(*argIt++);
+
+  symtable.scope();
+  llvm::Value *envPtr = builder->CreateBitCast(envArg,envType->getPointerTo());
+  for (size_t i = 0; i < captures.size(); ++i) {
+    llvm::Value *capturePtr = builder->CreateStructGEP(envType, envPtr, i);
+    symtable.insert(captures[i].first,
+                    builder->CreateLoad(capturePtr,
+                                        captures[i].second->getName()));
+  }
+
+  // The loop reduces into partials of its reduction variables, which are
+  // private to the call of the loop function
+  Stmt loopBody = forLoop.body;
+  vector<pair<Var,Var>> partials;
+  const map<Var,ReductionOperator>& reductionVars =
+      parallelLoops.at(&forLoop).getReductionVars();
+  for (auto &reductionVar : reductionVars) {
+    const Var& var = reductionVar.first;
+    Var partial(var.getName() + "_partial", var.getType());
+    loopBody = replaceVar(loopBody, var, partial);
+    partials.push_back({var, partial});
+  }
+
+  // Declare the loop's private variables at the top of the loop function, so
+  // that every thread gets its own copies
+  bool wasInParallelLoop = inParallelLoop;
+  inParallelLoop = true;
+  std::pair<Stmt,vector<Stmt>> body = removeVarDecls(loopBody);
+  for (auto &varDecl : body.second) {
+    compile(varDecl);
+  }
+  for (auto &partial : partials) {
+    ReductionOperator rop = reductionVars.at(partial.first);
+    compile(VarDecl::make(partial.second));
+    compile(AssignStmt::make(partial.second,
+        getIdentityVal(partial.second.getType().toTensor(), rop)));
+  }
+  emitLoop(forLoop.var, begin, end, body.first, elements);
+  inParallelLoop = wasInParallelLoop;
+
+  // Combine the partials with the shared reduction variables, one thread at a
+  // time. Each thread runs one call of the loop function, so this happens
+  // once per thread rather than once per iteration.
+  if (partials.size() > 0) {
+    emitCall("simitReductionLock", {});
+    for (auto &partial : partials) {
+      ReductionOperator rop = reductionVars.at(partial.first);
+      compile(AssignStmt::make(partial.first, partial.second,
+                               getCompoundOperator(rop)));
+    }
+    emitCall("simitReductionUnlock", {});
+  }
+
+  builder->CreateRetVoid();
+  symtable.unscope();
+
+  // Run the loop function on the thread pool
+  builder->SetInsertPoint(callBlock);
+  llvm::Value *envPtrArg = builder->CreateBitCast(env, LLVM_INT8_PTR);
+  if (colored) {
+    // The runtime colors the loop set's elements, using a handle that is
+    // stored in a global when the function is initialized
+    iassert(isa<VarExpr>(forLoop.domain.indexSet.getSet()));
+    std::string setName =
+        to<VarExpr>(forLoop.domain.indexSet.getSet())->var.getName();
+    std::string coloringName = setName + COLORING_SUFFIX;
+    llvm::GlobalVariable *coloring = module->getNamedGlobal(coloringName);
+    if (coloring == nullptr) {
+      coloring = new llvm::GlobalVariable(*module, LLVM_INT8_PTR, false,
+                                          llvm::GlobalValue::ExternalLinkage,
+                                          llvm::ConstantPointerNull::get(
+                                              LLVM_INT8_PTR),
+                                          coloringName);
+    }
+    emitCall("simitParallelForColored",
+             {builder->CreateLoad(coloring), loopFunc, envPtrArg});
+  }
+  else {
+    emitCall("simitParallelFor", {numIterations, loopFunc, envPtrArg});
+  }
+}
+
 void LLVMBackend::emitMemCpy(llvm::Value *dst, llvm::Value *src,
                              llvm::Value *size, unsigned align) {
   builder->CreateMemCpy(dst, src, size, align);
@@ -12,6 +12,7 @@
 
 #include "storage.h"
 #include "var.h"
+#include "parallel_loops.h"
 #include "backend/backend_visitor.h"
 #include "util/scopedmap.h"
 
@@ -39,13 +40,17 @@ namespace backend {
 extern const std::string VAL_SUFFIX;
 extern const std::string PTR_SUFFIX;
 extern const std::string LEN_SUFFIX;
+extern const std::string COLORING_SUFFIX;
 
 std::shared_ptr<llvm::EngineBuilder> createEngineBuilder(llvm::Module *module);
 
 /// Code generator that uses LLVM to compile Simit IR.
 class LLVMBackend : public BackendImpl, protected BackendVisitor<llvm::Value*> {
 public:
-  LLVMBackend();
+  /// Create an LLVM backend. If `parallel` is true, then set loops whose
+  /// iterations are independent, or conflict only through shared endpoints,
+  /// are outlined and run on the thread pool.
+  LLVMBackend(bool parallel=false);
   virtual ~LLVMBackend();
 
 protected:
@@ -58,6 +63,15 @@ protected:
 
   std::set<ir::Var> globals;
   ir::Storage storage;
+
+  /// Whether to run independent set loops on multiple threads.
+  bool parallel;
+
+  /// The loops of the function being compiled that run in parallel.
+  std::map<const ir::For*, ir::LoopParallelism> parallelLoops;
+
+  /// True while compiling the body of an outlined parallel loop.
+  bool inParallelLoop;
   const ir::Environment* environment;
 
   llvm::Module *module;
@@ -128,6 +142,10 @@ protected:
   /// Build a global string and return a constant pointer to it
   llvm::Constant *emitGlobalString(const std::string& str);
 
+  /// Build a global that holds the data of a tensor literal and return a
+  /// constant pointer to it
+  llvm::Constant *emitGlobalLiteral(const ir::Literal& literal);
+
   /// Gets a reference to a named built-in
   llvm::Function* getBuiltIn(std::string name,
                              llvm::Type *retTy,
@@ -144,6 +162,23 @@ protected:
 
   void emitAssign(ir::Var var, const ir::Expr& value);
 
+  /// Emit the value that compound assigning `b` to `a` with `cop` writes,
+  /// e.g. `a + b` for Add and the larger of the two for Max.
+  llvm::Value *emitCompoundOperation(ir::CompoundOperator cop,
+                                     const ir::Expr& a, const ir::Expr& b);
+
+  /// Emit a loop that runs `body` for `var` in [begin, end). If `indices` is
+  /// given, `var` instead takes the values indices[begin:end].
+  void emitLoop(const ir::Var& var, llvm::Value *begin, llvm::Value *end,
+                const ir::Stmt& body, llvm::Value *indices=nullptr);
+
+  /// Outline the body of `forLoop` into a function that runs a range of
+  /// iterations, and emit a call that runs its `numIterations` iterations on
+  /// the thread pool. Colored loops run one color at a time. Every call of the
+  /// loop function reduces into its own partials of the loop's reduction
+  /// variables, and combines them with the shared variables when it returns.
+  void emitParallelFor(const ir::For& forLoop, llvm::Value *numIterations);
+
   /// Produce LLVM globals for everything in `env` and store in `globals`
   /// and in `symtable` appropriately.
   virtual void emitGlobals(const ir::Environment& env, bool packed=true);
@@ -192,9 +227,6 @@ protected:
   /// Emit a call to an intrinsic
   void emitIntrinsicCall(const ir::CallStmt& callStmt);
 
-  // TODO: Remove this function, once the old init system has been removed
-  ir::Func makeSystemTensorsGlobal(ir::Func func);
-
 private:
   static bool llvmInitialized;
 };
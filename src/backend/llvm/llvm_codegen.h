@@ -65,6 +65,9 @@ llvm::Value *llvmCreateICmpSLE(LLVMIRBuilder *builder, llvm::Value*,
                                llvm::Value *, const llvm::Twine &name = "");
 llvm::PHINode *llvmCreatePHI(LLVMIRBuilder *builder, llvm::Type *, unsigned,
                              const llvm::Twine &name = "");
+llvm::Value *llvmCreateSelect(LLVMIRBuilder *builder, llvm::Value *cond,
+                              llvm::Value *a, llvm::Value *b,
+                              const llvm::Twine &name = "");
 
 llvm::ConstantInt* llvmInt(long long int val, unsigned bits=32);
 llvm::ConstantInt* llvmUInt(long long unsigned int val, unsigned bits=32);
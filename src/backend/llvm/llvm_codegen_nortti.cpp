@@ -100,4 +100,9 @@ PHINode *llvmCreatePHI(LLVMIRBuilder *builder, Type *ty, unsigned num,
   return builder->CreatePHI(ty, num, name);
 }
 
+Value *llvmCreateSelect(LLVMIRBuilder *builder, Value *cond, Value *a,
+                        Value *b, const Twine &name) {
+  return builder->CreateSelect(cond, a, b, name);
+}
+
 }}
@@ -22,9 +22,14 @@ llvm::Value* UnstructuredSetLayout::getTotalSize() {
   return llvmCreateExtractValue(builder, value, {0}, util::toString(set)+".size()");
 }
 
+llvm::Value* UnstructuredSetLayout::getCapacity() {
+  return llvmCreateExtractValue(builder, value, {1},
+                                util::toString(set)+".capacity()");
+}
+
 int UnstructuredSetLayout::getFieldsOffset() {
-  // Must skip size
-  return 1;
+  // Must skip size, capacity
+  return 2;
 }
 
 llvm::Value* UnstructuredSetLayout::makeSet(Set *actual, ir::Type type) {
@@ -35,8 +40,9 @@ llvm::Value* UnstructuredSetLayout::makeSet(Set *actual, ir::Type type) {
   llvm::StructType *llvmSetType = llvmType(*setType);
   vector<llvm::Constant*> setData;
 
-  // Set size
+  // Set size and capacity
   setData.push_back(llvmInt(actual->getSize()));
+  setData.push_back(llvmInt(actual->getCapacity()));
   // Fields
   for (auto &field : setType->elementType.toElement()->fields) {
     assert(field.type.isTensor());
@@ -53,9 +59,10 @@ void UnstructuredSetLayout::writeSet(
 
   const ir::SetType *setType = type.toSet();
 
-  // Set size
+  // Set size and capacity
   ((int*)externPtr)[0] = actual->getSize();
-  void **externPtrCast = (void**)(((int*)externPtr)+1);
+  ((int*)externPtr)[1] = actual->getCapacity();
+  void **externPtrCast = (void**)(((int*)externPtr)+2);
   // Fields
   for (auto &field : setType->elementType.toElement()->fields) {
     assert(field.type.isTensor());
@@ -65,12 +72,12 @@ void UnstructuredSetLayout::writeSet(
 }
 
 llvm::Value* UnstructuredEdgeSetLayout::getEpsArray() {
-  return llvmCreateExtractValue(builder, value, {1}, util::toString(set)+".eps()");
+  return llvmCreateExtractValue(builder, value, {2}, util::toString(set)+".eps()");
 }
 
 int UnstructuredEdgeSetLayout::getFieldsOffset() {
-  // Must skip size, eps
-  return 2;
+  // Must skip size, capacity, eps
+  return 3;
 }
 
 llvm::Value* UnstructuredEdgeSetLayout::makeSet(Set *actual, ir::Type type) {
@@ -80,8 +87,9 @@ llvm::Value* UnstructuredEdgeSetLayout::makeSet(Set *actual, ir::Type type) {
   llvm::StructType *llvmSetType = llvmType(*setType);
   vector<llvm::Constant*> setData;
 
-  // Set size
+  // Set size and capacity
   setData.push_back(llvmInt(actual->getSize()));
+  setData.push_back(llvmInt(actual->getCapacity()));
 
   // Endpoints index
   setData.push_back(llvmPtr(LLVM_INT_PTR, actual->getEndpointsData()));
@@ -101,15 +109,16 @@ void UnstructuredEdgeSetLayout::writeSet(Set *actual, ir::Type type,
 
   const ir::SetType *setType = type.toSet();
 
-  // Set size
+  // Set size and capacity
   ((int*)externPtr)[0] = actual->getSize();
-  int **externPtrCast = (int**)(((int*)externPtr)+1);
+  ((int*)externPtr)[1] = actual->getCapacity();
+  int **externPtrCast = (int**)(((int*)externPtr)+2);
 
   // Endpoints index
   externPtrCast[0] = actual->getEndpointsData();
 
   // Fields
-  void **externPtrFieldCast = (void**)(externPtrCast+3);
+  void **externPtrFieldCast = (void**)(externPtrCast+1);
   for (auto &field : setType->elementType.toElement()->fields) {
     iassert(field.type.isTensor());
     *externPtrFieldCast = actual->getFieldData(field.name);
@@ -165,9 +174,10 @@ llvm::Value* GridSetLayout::makeSet(Set *actual, ir::Type type) {
       << " required";
   setData.push_back(llvmPtr(LLVM_INT_PTR, dimensions.data()));
     
-  // CSR data: only set if kIndexlessStencils is false, otherwise
-  // we set these to NULL.
-  if (kIndexlessStencils) {
+  // CSR data: only set if kIndexlessStencils is false and the grid stores its
+  // endpoints, otherwise we set these to NULL. Compiled code indexes grids
+  // through their dimensions, so implicit grids need no endpoints.
+  if (kIndexlessStencils || actual->hasImplicitEdges()) {
     // NULL pointers for endpoints
     setData.push_back(llvmPtr(LLVM_INT_PTR, NULL));
   }
@@ -195,9 +205,9 @@ void GridSetLayout::writeSet(Set *actual, ir::Type type, void *externPtr) {
   const vector<int> &dimensions = actual->getDimensions();
   ((const int**)externPtrCast)[0] = dimensions.data();
     
-  // CSR data: only set if kIndexlessStencils is false, otherwise
-  // we set these to NULL.
-  if (kIndexlessStencils) {
+  // CSR data: only set if kIndexlessStencils is false and the grid stores its
+  // endpoints, otherwise we set these to NULL.
+  if (kIndexlessStencils || actual->hasImplicitEdges()) {
     // Three NULL pointers for endpoints, nbrs_start, and nbrs
     externPtrCast[1] = NULL;
     externPtrCast[2] = NULL;
@@ -241,9 +251,23 @@ std::shared_ptr<SetLayout> getSetLayout(
   }
 }
 
+/// Check that the fields of `actual` have the layouts `type` declares.
+static void checkFieldLayouts(Set *actual, const ir::Type& type) {
+  for (auto &field : type.toSet()->elementType.toElement()->fields) {
+    if (ir::isScalar(field.type)) {
+      continue;
+    }
+    FieldLayout layout = actual->getFieldLayout(field.name);
+    uassert(layout == field.layout)
+        << "Field " << field.name << " of " << actual->getName() << " is "
+        << layout << ", but the program declares it " << field.layout;
+  }
+}
+
 /// Build llvm set struct from runtime Set object
 llvm::Value* makeSet(Set *actual, ir::Type type) {
   iassert(type.isSet());
+  checkFieldLayouts(actual, type);
   if (type.isUnstructuredSet()) {
     if (type.toUnstructuredSet()->getCardinality() == 0) {
       return UnstructuredSetLayout::makeSet(actual, type);
@@ -264,6 +288,7 @@ llvm::Value* makeSet(Set *actual, ir::Type type) {
 /// Write set pointers to extern pointer structure
 void writeSet(Set *actual, ir::Type type, void *externPtr) {
   iassert(type.isSet());
+  checkFieldLayouts(actual, type);
   if (type.isUnstructuredSet()) {
     if (type.toUnstructuredSet()->getCardinality() == 0) {
       return UnstructuredSetLayout::writeSet(actual, type, externPtr);
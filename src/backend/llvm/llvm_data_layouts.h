@@ -27,6 +27,8 @@ public:
   virtual llvm::Value* getSize(unsigned i) = 0;
   /// Get the total number of elements in the set
   virtual llvm::Value* getTotalSize() = 0;
+  /// Get the number of elements the set's field arrays have room for
+  virtual llvm::Value* getCapacity() = 0;
   /// Get the endpoints array
   virtual llvm::Value* getEpsArray() = 0;
   /// Get the offset to the fields pointers
@@ -34,11 +36,12 @@ public:
 };
 
 /// Unstructured set layout (cardinality 0):
-/// <size> <f1> <f2> ...
+/// <size> <capacity> <f1> <f2> ...
 class UnstructuredSetLayout : public SetLayout {
 public:
   virtual llvm::Value* getSize(unsigned i);
   virtual llvm::Value* getTotalSize();
+  virtual llvm::Value* getCapacity();
 
   inline virtual llvm::Value* getEpsArray() {unreachable; return nullptr;}
 
@@ -59,7 +62,7 @@ private:
 
 
 /// Unstructured edge set layout:
-/// <size> <eps_ptr> <nbrs_start_ptr> <nbrs_ptr> <f1> <f2> ...
+/// <size> <capacity> <eps_ptr> <f1> <f2> ...
 class UnstructuredEdgeSetLayout : public UnstructuredSetLayout {
 public:
   virtual llvm::Value* getEpsArray();
@@ -87,6 +90,8 @@ class GridSetLayout : public SetLayout {
 public:
   virtual llvm::Value* getSize(unsigned i);
   virtual llvm::Value* getTotalSize();
+  /// Grid edge sets are allocated to their size
+  inline virtual llvm::Value* getCapacity() {return getTotalSize();}
   virtual llvm::Value* getEpsArray();
   virtual int getFieldsOffset();
 
@@ -1,5 +1,7 @@
 #include "llvm_function.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -15,8 +17,11 @@
 #include "llvm_types.h"
 #include "llvm_codegen.h"
 #include "llvm_data_layouts.h"
+#include "llvm_backend.h"
+#include "llvm_object_cache.h"
 
 #include "backend/actual.h"
+#include "factorizations.h"
 #include "graph.h"
 #include "tensor_index.h"
 #include "path_indices.h"
@@ -38,7 +43,7 @@ LLVMFunction::LLVMFunction(ir::Func func, const ir::Storage &storage,
                            bool skipEEInit)
     : Function(func), initialized(false), llvmFunc(llvmFunc), module(module),
       harnessModule(new llvm::Module("simit_harness", LLVM_CTX)),
-      storage(storage),
+      storage(storage), temporaryArena(nullptr), temporaryArenaSize(0),
       engineBuilder(engineBuilder),
       harnessEngineBuilder(new llvm::EngineBuilder(
           std::unique_ptr<llvm::Module>(harnessModule))),
@@ -56,6 +61,9 @@ LLVMFunction::LLVMFunction(ir::Func func, const ir::Storage &storage,
   engineBuilder->setErrorStr(&errStr);
   this->executionEngine.reset(engineBuilder->create());
   iassert((bool)this->executionEngine) << errStr;
+  if (LLVMObjectCache::isEnabled()) {
+    executionEngine->setObjectCache(&LLVMObjectCache::getInstance());
+  }
   harnessEngineBuilder->setErrorStr(&errStr);
   this->harnessExecEngine.reset(harnessEngineBuilder->create());
   iassert((bool)this->harnessExecEngine) << errStr;
@@ -92,6 +100,9 @@ LLVMFunction::LLVMFunction(ir::Func func, const ir::Storage &storage,
     temporaryPtrs.insert({tmp.getName(), tmpPtr});
   }
 
+  // Temporaries that are never live at the same time can share memory
+  temporaryLiveRanges = getLiveRanges(func.getBody(), env.getTemporaries());
+
   // Initialize global tensorIndex ptrs
   for (const TensorIndex& tensorIndex : env.getTensorIndices()) {
     uint64_t addr;
@@ -109,6 +120,16 @@ LLVMFunction::LLVMFunction(ir::Func func, const ir::Storage &storage,
 
       const pe::PathExpression& pexpr = tensorIndex.getPathExpression();
       tensorIndexPtrs.insert({pexpr, {rowptrPtr, colidxPtr}});
+
+      // Only build location tables the compiled assemblies read
+      const Var& locs = tensorIndex.getLocationsArray();
+      llvm::GlobalVariable* locsGlobal = module->getNamedGlobal(locs.getName());
+      if (locsGlobal != nullptr && !locsGlobal->use_empty()) {
+        addr = executionEngine->getGlobalValueAddress(locs.getName());
+        const int** locsPtr = (const int**)addr;
+        *locsPtr = nullptr;
+        locationTablePtrs.insert({pexpr, locsPtr});
+      }
     }
     else if (tensorIndex.getKind() == TensorIndex::Sten) {
       // No need to build in-memory structures
@@ -121,12 +142,22 @@ LLVMFunction::LLVMFunction(ir::Func func, const ir::Storage &storage,
 
 LLVMFunction::~LLVMFunction() {
   if (deinit) {
+    util::MemoryArena::Activation activation(&memory);
     deinit();
   }
+  for (auto& ptrPair : tensorIndexPtrs) {
+    if (*ptrPair.second.first != nullptr) {
+      const int* rowptr = (const int*)*ptrPair.second.first;
+      FactorizationCache::getInstance().evict(rowptr);
+    }
+  }
   for (auto& tmpPtr : temporaryPtrs) {
-    free(*tmpPtr.second);
+    if (util::contains(temporarySizes, tmpPtr.first)) {
+      memory.release(*tmpPtr.second);
+    }
     *tmpPtr.second = nullptr;
   }
+  memory.release(temporaryArena);
 }
 
 void LLVMFunction::bind(const std::string& name, simit::Set* set) {
@@ -148,7 +179,7 @@ void LLVMFunction::bind(const std::string& name, simit::Set* set) {
       not_supported_yet;
     }
     arguments[name] = std::unique_ptr<Actual>(new SetActual(set));
-    initialized = false;
+    initialized = initialized && rebindSet(name, set);
   }
   else {
     globals[name] = std::unique_ptr<Actual>(new SetActual(set));
@@ -176,6 +207,7 @@ void LLVMFunction::bind(const std::string& name, simit::Set* set) {
     iassert(util::contains(externPtrs, name) && externPtrs.at(name).size()==1);
     void *externPtr = externPtrs.at(name)[0];
     writeSet(set, globalType, externPtr);
+    bindColoring(name, set);
   }
 }
 
@@ -183,7 +215,14 @@ void LLVMFunction::bind(const std::string& name, void* data) {
   iassert(hasBindable(name));
   if (hasArg(name)) {
     arguments[name] = std::unique_ptr<Actual>(new TensorActual(data));
-    initialized = false;
+    // Tensor shapes only depend on set sizes, so we can always just point the
+    // harness to the new data
+    if (initialized && util::contains(argumentSlots, name)) {
+      *(void**)argumentSlots.at(name).addr = data;
+    }
+    else {
+      initialized = false;
+    }
   }
   else if (hasGlobal(name)) {
     globals[name] = std::unique_ptr<Actual>(new TensorActual(data));
@@ -210,6 +249,52 @@ void LLVMFunction::bind(const std::string& name, TensorData& tensorData) {
   }
 }
 
+LLVMFunction::SetTopology LLVMFunction::SetTopology::get(const Set* set) {
+  SetTopology topology;
+  topology.version = set->getTopologyVersion();
+  topology.size = set->getSize();
+  topology.endpoints = set->getEndpointsData();
+  if (set->getKind() == Set::Grid) {
+    topology.dimensions = set->getDimensions();
+  }
+  return topology;
+}
+
+bool LLVMFunction::SetTopology::fits(const Set* set) const {
+  if (set->getSize() != size) {
+    return false;
+  }
+  if (set->getKind() == Set::Grid) {
+    return set->getDimensions() == dimensions;
+  }
+
+  // Sets that share an endpoints array, such as sets that adopted the same
+  // array, have the same topology without having to compare the endpoints
+  return set->getCardinality() == 0 ||
+         set->getTopologyVersion() == version ||
+         set->getEndpointsData() == endpoints;
+}
+
+bool LLVMFunction::rebindSet(const std::string& name, simit::Set* set) {
+  if (!util::contains(argumentSlots, name)) {
+    return false;
+  }
+  ArgumentSlot& slot = argumentSlots.at(name);
+  if (!slot.topology.fits(set)) {
+    return false;
+  }
+
+  // The path indices and temporaries built from the old set also fit the new
+  // one, so only the set's pointers in the harness' copy have to change
+  llvm::Value* llvmSet = makeSet(set, getArgType(name));
+  harnessExecEngine->InitializeMemory(llvm::cast<llvm::Constant>(llvmSet),
+                                      slot.addr);
+  if (bindColoring(name, set)) {
+    set->getColoring();
+  }
+  return true;
+}
+
 size_t LLVMFunction::size(const ir::IndexDomain& dimension) {
   size_t result = 1;
   for (const ir::IndexSet& indexSet : dimension.getIndexSets()) {
@@ -244,77 +329,106 @@ size_t LLVMFunction::size(const ir::IndexDomain& dimension) {
 }
 
 Function::FuncType LLVMFunction::init() {
-  pe::PathIndexBuilder piBuilder;
+  util::MemoryArena::Activation activation(&memory);
+
+  // The path indices built by an earlier initialization are extended if the
+  // sets have only had elements appended to them since, as when contacts are
+  // added to a mesh, and are otherwise rebuilt
+  map<string, SetTopology> topologies;
+  map<string, int> grownSets;
+  bool rebuild = (piBuilder == nullptr);
+  for (auto* actuals : {&arguments, &globals}) {
+    for (auto& pair : *actuals) {
+      string name = pair.first;
+      Actual* actual = pair.second.get();
+      if (!isa<SetActual>(actual)) {
+        continue;
+      }
+      const Set* set = to<SetActual>(actual)->getSet();
+      const SetTopology& topology = topologies[name] = SetTopology::get(set);
+      if (rebuild || !util::contains(indexedTopologies, name)) {
+        rebuild = true;
+        continue;
+      }
 
-  for (auto& pair : arguments) {
-    string name = pair.first;
-    Actual* actual = pair.second.get();
-    if (isa<SetActual>(actual)) {
-      Set* set = to<SetActual>(actual)->getSet();
-      piBuilder.bind(name,set);
+      // Versions are only kept by appends, and no two sets share one
+      const SetTopology& indexedTopology = indexedTopologies.at(name);
+      if (topology.version != indexedTopology.version) {
+        rebuild = true;
+      }
+      else if (topology.size != indexedTopology.size) {
+        iassert(set->getKind() == Set::Unstructured &&
+                topology.size > indexedTopology.size);
+        grownSets[name] = indexedTopology.size;
+      }
     }
   }
+  if (rebuild) {
+    piBuilder.reset(new pe::PathIndexBuilder());
+    grownSets.clear();
+  }
+  indexedTopologies = topologies;
+
+  // Bind global sets too, since the indices of gather maps over extern sets
+  // are built from them
+  for (auto* actuals : {&arguments, &globals}) {
+    for (auto& pair : *actuals) {
+      string name = pair.first;
+      Actual* actual = pair.second.get();
+      if (isa<SetActual>(actual)) {
+        Set* set = to<SetActual>(actual)->getSet();
+        piBuilder->bind(name,set);
+      }
+    }
+  }
+  if (!grownSets.empty()) {
+    piBuilder->extend(grownSets);
+  }
 
   const Environment& environment = getEnvironment();
 
   // Initialize indices
-  initIndices(piBuilder, environment);
+  initIndices(*piBuilder, environment);
+
+  // Color the edge sets of parallel loops that scatter into their endpoints.
+  // Sets cache their coloring, so this only recolors sets whose topology has
+  // changed since they were last colored.
+  for (auto* actuals : {&arguments, &globals}) {
+    for (auto& pair : *actuals) {
+      Actual* actual = pair.second.get();
+      if (isa<SetActual>(actual)) {
+        Set* set = to<SetActual>(actual)->getSet();
+        if (bindColoring(pair.first, set)) {
+          set->getColoring();
+        }
+      }
+    }
+  }
 
-  // Allocate memory for temporaries
+  // Allocate memory for temporaries. Those that are not live at the same time
+  // share slabs of the temporary arena, and the others get their own buffers.
+  map<Var,size_t> sharedSizes;
   for (const Var& tmp : environment.getTemporaries()) {
     iassert(util::contains(temporaryPtrs, tmp.getName()));
-    const Type& type = tmp.getType();
-
-    if (type.isTensor()) {
-      const ir::TensorType* tensorType = type.toTensor();
-      unsigned order = tensorType->order();
-      iassert(order <= 2) << "Higher-order tensors not supported";
-
-      if (order == 1) {
-        // Vectors are currently always dense
-        IndexDomain vecDimension = tensorType->getDimensions()[0];
-        Type blockType = tensorType->getBlockType();
-        size_t blockSize = blockType.toTensor()->size();
-        size_t componentSize = tensorType->getComponentType().bytes();
-        *temporaryPtrs.at(tmp.getName()) =
-            calloc(size(vecDimension) *blockSize, componentSize);
-      }
-      else if (order == 2) {
-        Type blockType = tensorType->getBlockType();
-        size_t blockSize = blockType.toTensor()->size();
-        size_t componentSize = tensorType->getComponentType().bytes();
-        iassert(environment.hasTensorIndex(tmp))
-            << "No tensor index for: " << tmp;
-        const TensorIndex& ti = environment.getTensorIndex(tmp);
-
-        if (ti.getKind() == TensorIndex::PExpr) {
-          const pe::PathExpression& pexpr = ti.getPathExpression();
-          iassert(util::contains(pathIndices, pexpr));
-          size_t matSize = pathIndices.at(pexpr).numNeighbors() *
-              blockSize * componentSize;
-          *temporaryPtrs.at(tmp.getName()) = malloc(matSize);
-        }
-        else if (ti.getKind() == TensorIndex::Sten) {
-          auto iss = tensorType->getOuterDimensions();
-          iassert(iss.size() == 2);
-          iassert(iss[0] == iss[1])
-              << "Stencil tensor index must be for a homogeneous matrix";
-          size_t gridSize = size(iss[0]);
-          const StencilLayout& stencil = ti.getStencilLayout();
-          size_t stensize = stencil.getLayout().size();
-          size_t matSize = stensize * gridSize * blockSize * componentSize;
-          *temporaryPtrs.at(tmp.getName()) = malloc(matSize);
-        }
-        else {
-          not_supported_yet;
-        }
-      }
+    bool zero = false;
+    size_t size = getTemporarySize(tmp, &zero);
+    if (util::contains(temporaryLiveRanges, tmp)) {
+      sharedSizes[tmp] = size;
     }
     else {
-      unreachable << "don't know how to initialize temporary "
-                  << util::quote(tmp);
+      allocTemporary(tmp.getName(), size, zero);
     }
   }
+  temporaryAssignment = assignBuffers(temporaryLiveRanges, sharedSizes);
+  if (temporaryArenaSize < temporaryAssignment.arenaSize) {
+    memory.release(temporaryArena);
+    temporaryArena = memory.allocate(temporaryAssignment.arenaSize);
+    temporaryArenaSize = temporaryAssignment.arenaSize;
+  }
+  for (auto& offset : temporaryAssignment.offsets) {
+    *temporaryPtrs.at(offset.first.getName()) =
+        (char*)temporaryArena + offset.second;
+  }
 
   // Compile a harness void function without arguments that calls the simit
   // llvm function with pointers to the arguments.
@@ -361,16 +475,24 @@ Function::FuncType LLVMFunction::init() {
           result = makeSet(actual->getSet(), type);
         }
 
+        // Scalars passed by value are loaded through the pointer by the
+        // harness, so that they are read when the function is called.
         void visit(TensorActual* actual) {
           const ir::TensorType* tensorType = type.toTensor();
           void* tensorData = actual->getData();
-          result = (llvmFormal->getType()->isPointerTy())
-                   ? llvmPtr(*tensorType, tensorData)
-                   : llvmVal(*tensorType, tensorData);
+          result = llvmPtr(*tensorType, tensorData);
         }
       };
       llvm::Value* llvmActual = InitActual().init(actual, type, llvmFormal);
-      args.push_back(llvmActual);
+
+      // The harness reads the actual from a global, so that binding a new
+      // actual of the same shape only has to overwrite the global
+      llvm::Constant* slotInit = llvm::cast<llvm::Constant>(llvmActual);
+      llvm::GlobalVariable* slot =
+          new llvm::GlobalVariable(*harnessModule, slotInit->getType(), false,
+                                   llvm::GlobalValue::ExternalLinkage,
+                                   slotInit, formal + ".arg");
+      args.push_back(slot);
     }
 
     const std::string initFuncName = string(llvmFunc->getName())+"_init";
@@ -401,6 +523,21 @@ Function::FuncType LLVMFunction::init() {
     // Finalize harness module
     harnessExecEngine->finalizeObject();
 
+    // Record where the harness reads each actual from
+    argumentSlots.clear();
+    for (size_t i = 0; i < formals.size(); ++i) {
+      llvm::GlobalVariable* slot = llvm::cast<llvm::GlobalVariable>(args[i]);
+      ArgumentSlot argumentSlot;
+      argumentSlot.addr =
+          (void*)harnessExecEngine->getGlobalValueAddress(slot->getName());
+      Actual* actual = arguments.at(formals[i]).get();
+      if (isa<SetActual>(actual)) {
+        Set* set = to<SetActual>(actual)->getSet();
+        argumentSlot.topology = SetTopology::get(set);
+      }
+      argumentSlots.insert({formals[i], argumentSlot});
+    }
+
     // Fetch hard addresses from ExecutionEngine
     // call init()
     getGlobalFunc(initHarness, harnessExecEngine.get())();
@@ -413,7 +550,16 @@ Function::FuncType LLVMFunction::init() {
     iassert(!llvm::verifyModule(*harnessModule))
         << "LLVM harness module does not pass verification";
   }
-  return func;
+
+  // Runtime calls allocate their results from the function's arena, so that
+  // the buffers freed by one run are reused by the next. Buffers of sizes the
+  // run did not ask for are not likely to be asked for again, so they are
+  // freed to keep the arena from growing with every new size.
+  return [this, func]() {
+    util::MemoryArena::Activation activation(&memory);
+    func();
+    memory.trimUnused();
+  };
 }
 
 void LLVMFunction::print(std::ostream &os) const {
@@ -423,6 +569,24 @@ void LLVMFunction::print(std::ostream &os) const {
   os << rsos.str();
 }
 
+void LLVMFunction::printMemoryReport(std::ostream &os) const {
+  size_t ownSize = 0;
+  for (auto& temporarySize : temporarySizes) {
+    ownSize += temporarySize.second;
+  }
+  os << "temporaries: " << temporaryPtrs.size() << endl;
+  os << "  own buffers:    " << temporarySizes.size() << " temporaries, "
+     << ownSize << " bytes" << endl;
+  os << "  shared arena:   " << temporaryAssignment.offsets.size()
+     << " temporaries, " << temporaryAssignment.arenaSize << " bytes" << endl;
+  os << "  bytes saved:    " << temporaryAssignment.getBytesSaved() << endl;
+  os << "memory arena:" << endl;
+  os << "  current usage:  " << memory.getCurrentUsage() << " bytes" << endl;
+  os << "  peak usage:     " << memory.getPeakUsage() << " bytes" << endl;
+  os << "  pooled:         " << memory.getPooledBytes() << " bytes" << endl;
+  os << "  reused blocks:  " << memory.getNumReused() << endl;
+}
+
 void LLVMFunction::printMachine(std::ostream &os) const {
   // TODO: Make printMachine write to os, instead of stderr
   llvm::TargetMachine *target = engineBuilder->selectTarget();
@@ -432,6 +596,93 @@ void LLVMFunction::printMachine(std::ostream &os) const {
   target->Options.PrintMachineCode = false;
 }
 
+/// Build the location table of the tensor index with path expression `pexpr`
+/// and segmented path index `pidx` (see TensorIndex::getLocationsArray). Each
+/// location is found with a binary search of the sorted neighbors of a row, so
+/// the locations of the non-zeros assembled by an edge are read from the table
+/// rather than searched for every time the edge set is mapped over.
+///
+/// If `table` was built from `pidx` before it was extended, when its rows
+/// started at `oldCoords`, only the locations of the appended edges and of the
+/// rows that gained neighbors are searched for, and the other locations are
+/// moved by the neighbors inserted before their rows. Returns false iff the
+/// index and the edge set have not changed since, and the table was kept.
+static bool buildLocationTable(const pe::PathExpression& pexpr,
+                               const pe::SegmentedPathIndex* pidx,
+                               const pe::PathIndexBuilder& piBuilder,
+                               const vector<uint32_t>* oldCoords,
+                               vector<int>* table) {
+  pe::Set edgeSetVar = pe::getEdgeSet(pexpr);
+  iassert(edgeSetVar.defined());
+  const Set* edgeSet = piBuilder.getBinding(edgeSetVar);
+  iassert(edgeSet != nullptr && edgeSet->isHomogeneous())
+      << "location tables require homogeneous edge sets";
+
+  const int cardinality = edgeSet->getCardinality();
+  const int* endpoints = edgeSet->getEndpointsData();
+  const uint32_t* coords = pidx->getCoordData();
+  const uint32_t* sinks = pidx->getSinkData();
+
+  auto loc = [coords, sinks](int row, int sink) {
+    const uint32_t* begin = sinks + coords[row];
+    const uint32_t* end = sinks + coords[row+1];
+    const uint32_t* it = lower_bound(begin, end, (uint32_t)sink);
+    iassert(it != end && *it == (uint32_t)sink)
+        << "edge is not in the tensor index";
+    return (int)(it - sinks);
+  };
+
+  // ve indices map each edge endpoint to the edge, while vv indices map each
+  // pair of edge endpoints to each other
+  const bool isVE = pe::isa<pe::Link>(pexpr);
+  iassert(!isVE || pe::to<pe::Link>(pexpr)->getType() == pe::Link::ve);
+  const int rowLocs = isVE ? 1 : cardinality;
+  auto search = [&](int e, int i, int* locs) {
+    const int* eps = &endpoints[e * cardinality];
+    if (isVE) {
+      locs[0] = loc(eps[i], e);
+      return;
+    }
+    for (int j = 0; j < cardinality; ++j) {
+      locs[j] = loc(eps[i], eps[j]);
+    }
+  };
+
+  int numIndexed = 0;
+  if (oldCoords != nullptr) {
+    const vector<uint32_t>& old = *oldCoords;
+    numIndexed = table->size() / (cardinality * rowLocs);
+    unsigned numRows = pidx->numElements();
+    if (numIndexed == edgeSet->getSize() && old.size() == numRows+1 &&
+        old.back() == coords[numRows]) {
+      return false;
+    }
+    for (int e = 0; e < numIndexed; ++e) {
+      for (int i = 0; i < cardinality; ++i) {
+        int row = endpoints[e * cardinality + i];
+        int* locs = &(*table)[(e * cardinality + i) * rowLocs];
+        if (coords[row+1] - coords[row] != old[row+1] - old[row]) {
+          search(e, i, locs);
+        }
+        else if (coords[row] != old[row]) {
+          int shift = coords[row] - old[row];
+          for (int j = 0; j < rowLocs; ++j) {
+            locs[j] += shift;
+          }
+        }
+      }
+    }
+  }
+
+  table->resize(edgeSet->getSize() * cardinality * rowLocs);
+  for (int e = numIndexed; e < edgeSet->getSize(); ++e) {
+    for (int i = 0; i < cardinality; ++i) {
+      search(e, i, &(*table)[(e * cardinality + i) * rowLocs]);
+    }
+  }
+  return true;
+}
+
 void LLVMFunction::initIndices(pe::PathIndexBuilder& piBuilder,
                                const Environment& environment) {
   // Initialize indices
@@ -439,14 +690,35 @@ void LLVMFunction::initIndices(pe::PathIndexBuilder& piBuilder,
     if (tensorIndex.getKind() == TensorIndex::PExpr) {
       pe::PathExpression pexpr = tensorIndex.getPathExpression();
       pe::PathIndex pidx = piBuilder.buildSegmented(pexpr, 0);
-      pathIndices.insert({pexpr, pidx});
 
+      // Factorizations of matrices stored in the index are only dropped if the
+      // index was rebuilt, so that they are reused across re-initializations
       pair<const uint32_t**,const uint32_t**> ptrPair=tensorIndexPtrs.at(pexpr);
+      const uint32_t* coords = isa<pe::SegmentedPathIndex>(pidx)
+          ? to<pe::SegmentedPathIndex>(pidx)->getCoordData() : nullptr;
+      if (*ptrPair.first != nullptr && *ptrPair.first != coords) {
+        FactorizationCache::getInstance().evict((const int*)*ptrPair.first);
+      }
+      pathIndices[pexpr] = pidx;
 
       if (isa<pe::SegmentedPathIndex>(pidx)) {
         const pe::SegmentedPathIndex* spidx = to<pe::SegmentedPathIndex>(pidx);
         *ptrPair.first = spidx->getCoordData();
         *ptrPair.second = spidx->getSinkData();
+
+        if (util::contains(locationTablePtrs, pexpr)) {
+          // Tables built from this index before it was extended are updated
+          LocationTable& table = locationTables[pexpr];
+          bool built = (table.pathIndex == pidx);
+          if (buildLocationTable(pexpr, spidx, piBuilder,
+                                 built ? &table.coords : nullptr,
+                                 &table.locs)) {
+            const uint32_t* coords = spidx->getCoordData();
+            table.pathIndex = pidx;
+            table.coords.assign(coords, coords + spidx->numElements()+1);
+          }
+          *locationTablePtrs.at(pexpr) = table.locs.data();
+        }
       }
       else {
         not_supported_yet<<"Doesn't know how to initialize this pathindex type";
@@ -461,6 +733,80 @@ void LLVMFunction::initIndices(pe::PathIndexBuilder& piBuilder,
   }
 }
 
+bool LLVMFunction::bindColoring(const std::string& name, simit::Set* set) {
+  llvm::GlobalVariable* coloring =
+      module->getNamedGlobal(name + COLORING_SUFFIX);
+  if (coloring == nullptr) {
+    return false;
+  }
+  iassert(executionEngine);
+  uint64_t addr = executionEngine->getGlobalValueAddress(coloring->getName());
+  *(void**)addr = set;
+  return true;
+}
+
+size_t LLVMFunction::getTemporarySize(const Var& tmp, bool* zero) {
+  const Type& type = tmp.getType();
+  if (!type.isTensor()) {
+    unreachable << "don't know how to initialize temporary "
+                << util::quote(tmp);
+  }
+
+  const ir::TensorType* tensorType = type.toTensor();
+  unsigned order = tensorType->order();
+  iassert(order <= 2) << "Higher-order tensors not supported";
+
+  Type blockType = tensorType->getBlockType();
+  size_t blockSize = blockType.toTensor()->size();
+  size_t componentSize = tensorType->getComponentType().bytes();
+  *zero = false;
+  if (order == 1) {
+    // Vectors are currently always dense
+    IndexDomain vecDimension = tensorType->getDimensions()[0];
+    *zero = true;
+    return size(vecDimension) * blockSize * componentSize;
+  }
+  else if (order == 2) {
+    const Environment& environment = getEnvironment();
+    iassert(environment.hasTensorIndex(tmp))
+        << "No tensor index for: " << tmp;
+    const TensorIndex& ti = environment.getTensorIndex(tmp);
+
+    if (ti.getKind() == TensorIndex::PExpr) {
+      const pe::PathExpression& pexpr = ti.getPathExpression();
+      iassert(util::contains(pathIndices, pexpr));
+      return pathIndices.at(pexpr).numNeighbors() * blockSize * componentSize;
+    }
+    else if (ti.getKind() == TensorIndex::Sten) {
+      auto iss = tensorType->getOuterDimensions();
+      iassert(iss.size() == 2);
+      iassert(iss[0] == iss[1])
+          << "Stencil tensor index must be for a homogeneous matrix";
+      size_t gridSize = size(iss[0]);
+      const StencilLayout& stencil = ti.getStencilLayout();
+      size_t stensize = stencil.getLayout().size();
+      return stensize * gridSize * blockSize * componentSize;
+    }
+    else {
+      not_supported_yet;
+    }
+  }
+  return 0;
+}
+
+void LLVMFunction::allocTemporary(const std::string& name, size_t size,
+                                  bool zero) {
+  void** tmpPtr = temporaryPtrs.at(name);
+  if (*tmpPtr == nullptr || temporarySizes[name] < size) {
+    memory.release(*tmpPtr);
+    *tmpPtr = memory.allocate(size);
+    temporarySizes[name] = size;
+  }
+  if (zero) {
+    memset(*tmpPtr, 0, size);
+  }
+}
+
 llvm::Function* LLVMFunction::createHarness(
     const std::string &name,
     const llvm::SmallVector<llvm::Value*,8> &args,
@@ -482,7 +828,20 @@ llvm::Function* LLVMFunction::createHarness(
   llvm::Function *harness = createPrototype(
       harnessName, {}, {}, harnessModule, true);
   auto entry = llvm::BasicBlock::Create(LLVM_CTX, "entry", harness);
-  llvm::CallInst *call = llvm::CallInst::Create(llvmFuncProto, args, "", entry);
+
+  // Load the actuals from their slots
+  llvm::SmallVector<llvm::Value*,8> actuals;
+  for (size_t i = 0; i < args.size(); ++i) {
+    llvm::Value* actual = new llvm::LoadInst(args[i], "", entry);
+    if (actual->getType() != argTypes[i]) {
+      // Scalars passed by value are stored by reference
+      iassert(actual->getType()->getPointerElementType() == argTypes[i]);
+      actual = new llvm::LoadInst(actual, "", entry);
+    }
+    actuals.push_back(actual);
+  }
+  llvm::CallInst *call = llvm::CallInst::Create(llvmFuncProto, actuals, "",
+                                                entry);
   call->setCallingConv(llvmFunc->getCallingConv());
   llvm::ReturnInst::Create(harnessModule->getContext(), entry);
   return harness;
@@ -10,9 +10,12 @@
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 
 #include "backend/backend_function.h"
+#include "buffer_assignment.h"
 #include "ir.h"
+#include "path_indices.h"
 #include "storage.h"
 #include "tensor_data.h"
+#include "util/memory_arena.h"
 
 namespace llvm {
 class ExecutionEngine;
@@ -49,6 +52,19 @@ class LLVMFunction : public backend::Function {
 
   virtual void print(std::ostream &os) const;
   virtual void printMachine(std::ostream &os) const;
+  virtual void printMemoryReport(std::ostream &os) const;
+
+  virtual size_t getCurrentMemoryUsage() const {
+    return memory.getCurrentUsage();
+  }
+
+  virtual size_t getPeakMemoryUsage() const {
+    return memory.getPeakUsage();
+  }
+
+  virtual size_t getNumReused() const {
+    return memory.getNumReused();
+  }
 
  protected:
   /// Get the number of elements in the index domains.
@@ -57,6 +73,23 @@ class LLVMFunction : public backend::Function {
   void initIndices(pe::PathIndexBuilder& piBuilder,
                    const ir::Environment& environment);
 
+  /// Point the harness to `set`, which is bound to argument `name`, if it has
+  /// the same topology as the set the function was initialized with. Returns
+  /// true iff the function can run without being re-initialized.
+  bool rebindSet(const std::string& name, simit::Set* set);
+
+  /// Point the coloring handle of the set with the given name, if the function
+  /// has parallel loops that need one, to `set`. Returns true iff it has one.
+  bool bindColoring(const std::string& name, simit::Set* set);
+
+  /// Point temporary `name` to a buffer of at least `size` bytes, reusing its
+  /// buffer if it is large enough. The buffers of vectors are zeroed.
+  void allocTemporary(const std::string& name, size_t size, bool zero);
+
+  /// Returns the size in bytes of the buffer of temporary `tmp`, and whether
+  /// the buffer must be zeroed.
+  size_t getTemporarySize(const ir::Var& tmp, bool* zero);
+
   bool initialized;
 
   llvm::Function*                        llvmFunc;
@@ -76,8 +109,65 @@ class LLVMFunction : public backend::Function {
            std::pair<const uint32_t**,const uint32_t**>> tensorIndexPtrs;
   std::map<pe::PathExpression, pe::PathIndex>            pathIndices;
 
-  /// Temporaries
+  /// The topology version (see Set::getTopologyVersion), size, endpoints
+  /// array and grid dimensions of a set.
+  struct SetTopology {
+    unsigned long version;
+    int size;
+    const int* endpoints;
+    std::vector<int> dimensions;
+
+    /// Get the topology of `set`.
+    static SetTopology get(const simit::Set* set);
+
+    /// True iff path indices and temporaries built from a set with this
+    /// topology also fit `set`.
+    bool fits(const simit::Set* set) const;
+  };
+
+  /// The builder of the path indices, which is kept between initializations
+  /// so that indices can be extended rather than rebuilt when elements are
+  /// appended to the bound sets, and the topology of the sets the indices
+  /// were last built from.
+  std::unique_ptr<pe::PathIndexBuilder>                  piBuilder;
+  std::map<std::string, SetTopology>                     indexedTopologies;
+
+  /// An assembly location table, and the path index and row offsets it was
+  /// built from, so that only the locations of new edges and of edges whose
+  /// rows gained neighbors are searched for when the index is extended.
+  struct LocationTable {
+    std::vector<int> locs;
+    pe::PathIndex pathIndex;
+    std::vector<uint32_t> coords;
+  };
+
+  /// Assembly location tables of the tensor indices the function reads them
+  /// from (see TensorIndex::getLocationsArray).
+  std::map<pe::PathExpression, const int**>              locationTablePtrs;
+  std::map<pe::PathExpression, LocationTable>            locationTables;
+
+  /// The arena that owns the temporaries, the buffers the function allocates
+  /// when it is initialized, and the sparse results of runtime calls.
+  util::MemoryArena memory;
+
+  /// Temporaries, and the sizes of the buffers of those that have their own
   std::map<std::string, void**> temporaryPtrs;
+  std::map<std::string, size_t> temporarySizes;
+
+  /// The live ranges of the temporaries that share slabs of the temporary
+  /// arena with others, and their current assignment to slabs.
+  std::map<ir::Var, ir::LiveRange> temporaryLiveRanges;
+  ir::BufferAssignment              temporaryAssignment;
+  void*                             temporaryArena;
+  size_t                            temporaryArenaSize;
+
+  /// The harness globals the arguments are read from, and the topology of the
+  /// sets that were bound when the harness was built.
+  struct ArgumentSlot {
+    void* addr;
+    SetTopology topology;
+  };
+  std::map<std::string, ArgumentSlot> argumentSlots;
 
  private:
   std::shared_ptr<llvm::EngineBuilder>   engineBuilder;
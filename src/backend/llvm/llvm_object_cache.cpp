@@ -0,0 +1,265 @@
+#include "llvm_object_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "error.h"
+#include "ir.h"
+
+using namespace std;
+
+namespace simit {
+extern std::string kCacheDir;
+extern size_t kCacheMaxBytes;
+
+namespace backend {
+
+static const string OBJECT_SUFFIX = ".o";
+
+/// Cached files start with this header, followed by the size of the key
+/// material, a newline, the key material and the object.
+static const string OBJECT_HEADER = "simit-object ";
+
+static string getPath(const string& key) {
+  return kCacheDir + "/" + key + OBJECT_SUFFIX;
+}
+
+/// 64-bit FNV-1a hash.
+static uint64_t hash(const string& str) {
+  uint64_t h = 14695981039346656037ull;
+  for (char c : str) {
+    h ^= (unsigned char)c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/// True iff `constant` is, or is computed from, an integer cast to a pointer.
+static bool isHostAddress(const llvm::Constant* constant,
+                          set<const llvm::Constant*>* visited) {
+  if (llvm::isa<llvm::GlobalValue>(constant) ||
+      !visited->insert(constant).second) {
+    return false;
+  }
+  if (llvm::isa<llvm::ConstantExpr>(constant) &&
+      llvm::cast<llvm::ConstantExpr>(constant)->getOpcode() ==
+          llvm::Instruction::IntToPtr) {
+    return true;
+  }
+  for (const llvm::Use& operand : constant->operands()) {
+    if (llvm::isa<llvm::Constant>(operand.get()) &&
+        isHostAddress(llvm::cast<llvm::Constant>(operand.get()), visited)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+LLVMObjectCache& LLVMObjectCache::getInstance() {
+  static LLVMObjectCache cache;
+  return cache;
+}
+
+bool LLVMObjectCache::isEnabled() {
+  return !kCacheDir.empty();
+}
+
+bool LLVMObjectCache::isCacheable(const llvm::Module& module) {
+  set<const llvm::Constant*> visited;
+  for (const llvm::GlobalVariable& global : module.globals()) {
+    if (global.hasInitializer() &&
+        isHostAddress(global.getInitializer(), &visited)) {
+      return false;
+    }
+  }
+  for (const llvm::Function& function : module) {
+    for (const llvm::BasicBlock& block : function) {
+      for (const llvm::Instruction& instruction : block) {
+        for (const llvm::Use& operand : instruction.operands()) {
+          if (llvm::isa<llvm::Constant>(operand.get()) &&
+              isHostAddress(llvm::cast<llvm::Constant>(operand.get()),
+                            &visited)) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+string LLVMObjectCache::getKeyMaterial(const llvm::Module& module) {
+  string material;
+  llvm::raw_string_ostream os(material);
+  module.print(os, nullptr);
+  os << "\n" << llvm::sys::getHostCPUName()
+     << "\nllvm " << LLVM_MAJOR_VERSION << "." << LLVM_MINOR_VERSION
+     << "\nfloat " << ir::ScalarType::floatBytes;
+#ifdef SIMIT_DEBUG
+  os << "\ndebug";
+#endif
+  os.flush();
+  return material;
+}
+
+string LLVMObjectCache::getKey(const string& material) {
+  stringstream key;
+  key << std::hex << hash(material) << "-" << std::dec << material.size();
+  return key.str();
+}
+
+bool LLVMObjectCache::lookup(const string& key, const string& material) {
+  iassert(isEnabled());
+  auto file = llvm::MemoryBuffer::getFile(getPath(key));
+
+  // The object is only valid if it was stored with the same key material,
+  // since different modules can hash to the same key
+  std::unique_ptr<llvm::MemoryBuffer> object;
+  if (file) {
+    llvm::StringRef contents = file.get()->getBuffer();
+    stringstream header;
+    header << OBJECT_HEADER << material.size() << "\n";
+    const size_t headerSize = header.str().size();
+    if (contents.startswith(header.str()) &&
+        contents.size() > headerSize + material.size() &&
+        contents.substr(headerSize, material.size()) == material) {
+      object = llvm::MemoryBuffer::getMemBufferCopy(
+          contents.substr(headerSize + material.size()), key);
+    }
+  }
+
+  lock_guard<std::mutex> lock(mutex);
+  if (!object) {
+    ++stats.misses;
+    missing[key] = material;
+    return false;
+  }
+  ++stats.hits;
+  loaded[key] = std::move(object);
+
+  // Mark the object as recently used
+  utime(getPath(key).c_str(), nullptr);
+  return true;
+}
+
+void LLVMObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                           llvm::MemoryBufferRef object) {
+  const string key = module->getModuleIdentifier();
+  string material;
+  {
+    lock_guard<std::mutex> lock(mutex);
+    auto it = missing.find(key);
+    if (it == missing.end()) {
+      return;
+    }
+    material = std::move(it->second);
+    missing.erase(it);
+  }
+  const string path = getPath(key);
+
+  // Write to a private file first, so that concurrent processes never load a
+  // partially written object
+  stringstream tmpPath;
+  tmpPath << path << "." << getpid() << ".tmp";
+  {
+    ofstream file(tmpPath.str(), ios::binary);
+    file << OBJECT_HEADER << material.size() << "\n" << material;
+    if (!file.write(object.getBufferStart(), object.getBufferSize())) {
+      remove(tmpPath.str().c_str());
+      return;
+    }
+  }
+  if (rename(tmpPath.str().c_str(), path.c_str()) != 0) {
+    remove(tmpPath.str().c_str());
+    return;
+  }
+
+  lock_guard<std::mutex> lock(mutex);
+  evict();
+}
+
+std::unique_ptr<llvm::MemoryBuffer>
+LLVMObjectCache::getObject(const llvm::Module* module) {
+  lock_guard<std::mutex> lock(mutex);
+  auto it = loaded.find(module->getModuleIdentifier());
+  if (it == loaded.end()) {
+    return nullptr;
+  }
+  std::unique_ptr<llvm::MemoryBuffer> object = std::move(it->second);
+  loaded.erase(it);
+  return object;
+}
+
+LLVMObjectCache::Stats LLVMObjectCache::getStats() const {
+  lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+void LLVMObjectCache::resetStats() {
+  lock_guard<std::mutex> lock(mutex);
+  stats = Stats();
+}
+
+void LLVMObjectCache::evict() {
+  struct Entry {
+    string path;
+    size_t size;
+    time_t lastUsed;
+  };
+  vector<Entry> entries;
+  size_t totalSize = 0;
+
+  DIR* dir = opendir(kCacheDir.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  while (struct dirent* ent = readdir(dir)) {
+    string name = ent->d_name;
+    if (name.size() <= OBJECT_SUFFIX.size() ||
+        name.compare(name.size()-OBJECT_SUFFIX.size(), OBJECT_SUFFIX.size(),
+                     OBJECT_SUFFIX) != 0) {
+      continue;
+    }
+    string path = kCacheDir + "/" + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      entries.push_back({path, (size_t)st.st_size, st.st_mtime});
+      totalSize += st.st_size;
+    }
+  }
+  closedir(dir);
+
+  if (totalSize <= kCacheMaxBytes) {
+    return;
+  }
+  sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.lastUsed < b.lastUsed;
+  });
+  for (const Entry& entry : entries) {
+    if (totalSize <= kCacheMaxBytes) {
+      break;
+    }
+    if (remove(entry.path.c_str()) == 0) {
+      totalSize -= entry.size;
+      ++stats.evictions;
+    }
+  }
+}
+
+}}
@@ -0,0 +1,92 @@
+#ifndef SIMIT_LLVM_OBJECT_CACHE_H
+#define SIMIT_LLVM_OBJECT_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+
+namespace llvm {
+class Module;
+class MemoryBuffer;
+}
+
+namespace simit {
+namespace backend {
+
+/// A persistent cache of the machine code MCJIT emits for compiled functions.
+/// Objects are stored in the directory given by `Settings::cacheDir`, under a
+/// key that hashes the unoptimized LLVM module together with the target it is
+/// compiled for. Each object is stored with the full key material, which is
+/// compared on lookup, so a hash collision is a miss rather than a wrong
+/// object. When the directory grows beyond `Settings::cacheMaxBytes`, the least
+/// recently used objects are evicted.
+///
+/// A hit only saves the LLVM optimization passes and MCJIT's machine code
+/// generation. Parsing, lowering and emitting the LLVM module still run on
+/// every compile, since the key is computed from the emitted module.
+///
+/// Modules that refer to host addresses (inttoptr constants) are not cached,
+/// since the addresses are not valid in other processes and differ between
+/// runs of the same process.
+class LLVMObjectCache : public llvm::ObjectCache {
+public:
+  struct Stats {
+    unsigned hits = 0;
+    unsigned misses = 0;
+    unsigned evictions = 0;
+  };
+
+  /// Returns the cache shared by all LLVM backends.
+  static LLVMObjectCache& getInstance();
+
+  /// True iff a cache directory has been configured.
+  static bool isEnabled();
+
+  /// True iff the machine code of `module` can be cached, which is not the
+  /// case if it refers to host addresses.
+  static bool isCacheable(const llvm::Module& module);
+
+  /// Returns the key material of the machine code `module` compiles to, that
+  /// is the module's text and the target it is compiled for.
+  static std::string getKeyMaterial(const llvm::Module& module);
+
+  /// Returns the key objects with the given key material are stored under.
+  static std::string getKey(const std::string& material);
+
+  /// Look up the object with the given key. If it is cached with the same key
+  /// material, it is loaded and handed to MCJIT when it compiles the module
+  /// with identifier `key`, and lookup returns true. Otherwise the object is
+  /// stored with `material` when MCJIT compiles the module. Objects of modules
+  /// whose keys were not looked up are never stored.
+  bool lookup(const std::string& key, const std::string& material);
+
+  virtual void notifyObjectCompiled(const llvm::Module* module,
+                                    llvm::MemoryBufferRef object);
+
+  virtual std::unique_ptr<llvm::MemoryBuffer>
+  getObject(const llvm::Module* module);
+
+  Stats getStats() const;
+  void resetStats();
+
+private:
+  mutable std::mutex mutex;
+  Stats stats;
+
+  /// Objects found by `lookup` that MCJIT has not yet asked for.
+  std::map<std::string, std::unique_ptr<llvm::MemoryBuffer>> loaded;
+
+  /// Key material of the keys not found by `lookup`, whose objects MCJIT has
+  /// not yet compiled.
+  std::map<std::string, std::string> missing;
+
+  /// Remove the least recently used objects until the cache fits its budget.
+  void evict();
+};
+
+}}
+
+#endif
@@ -83,7 +83,8 @@ llvm::StructType *llvmType(const ir::UnstructuredSetType& setType,
   const ElementType *elemType = setType.elementType.toElement();
   vector<llvm::Type*> llvmFieldTypes;
 
-  // Set size
+  // Set size and capacity
+  llvmFieldTypes.push_back(LLVM_INT);
   llvmFieldTypes.push_back(LLVM_INT);
 
   // Edge indices (if the set is an edge set)
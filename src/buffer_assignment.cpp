@@ -0,0 +1,333 @@
+#include "buffer_assignment.h"
+
+#include <algorithm>
+#include <set>
+
+#include "ir_visitor.h"
+#include "util/collections.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+std::ostream& operator<<(std::ostream& os, const LiveRange& range) {
+  return os << "[" << range.begin << ", " << range.end << "]";
+}
+
+static bool isIntLiteral(const Expr& expr, int value) {
+  return isa<Literal>(expr) && isInt(expr.type()) &&
+         to<Literal>(expr)->getIntVal(0) == value;
+}
+
+/// True iff `index` is `loopVar`, possibly blocked by one (`(i*1)+0`).
+static bool isLoopIndex(const Expr& index, const Var& loopVar) {
+  if (isa<VarExpr>(index)) {
+    return to<VarExpr>(index)->var == loopVar;
+  }
+  else if (isa<Add>(index) && isIntLiteral(to<Add>(index)->b, 0)) {
+    return isLoopIndex(to<Add>(index)->a, loopVar);
+  }
+  else if (isa<Mul>(index) && isIntLiteral(to<Mul>(index)->b, 1)) {
+    return isLoopIndex(to<Mul>(index)->a, loopVar);
+  }
+  return false;
+}
+
+/// True iff `a` and `b` are the same set, which may be given by different
+/// expressions of the same variable.
+static bool isSameSet(const IndexSet& a, const IndexSet& b) {
+  if (a == b) {
+    return true;
+  }
+  return a.getKind() == IndexSet::Set && b.getKind() == IndexSet::Set &&
+         isa<VarExpr>(a.getSet()) && isa<VarExpr>(b.getSet()) &&
+         to<VarExpr>(a.getSet())->var == to<VarExpr>(b.getSet())->var;
+}
+
+/// True iff every reference to `var` in `stmt` loads or stores the element of
+/// the current iteration of the loop over `loopVar`.
+static bool onlyAccessesLoopElement(const Stmt& stmt, const Var& var,
+                                    const Var& loopVar) {
+  class OnlyAccessesLoopElement : public IRVisitor {
+  public:
+    bool only = true;
+    OnlyAccessesLoopElement(const Var& var, const Var& loopVar)
+        : var(var), loopVar(loopVar) {}
+  private:
+    const Var& var;
+    const Var& loopVar;
+    using IRVisitor::visit;
+    bool accesses(const Expr& buffer, const Expr& index) {
+      if (!isa<VarExpr>(buffer) || to<VarExpr>(buffer)->var != var) {
+        return false;
+      }
+      only = only && isLoopIndex(index, loopVar);
+      return true;
+    }
+    void visit(const VarExpr* op) {
+      only = only && op->var != var;
+    }
+    void visit(const Load* op) {
+      if (!accesses(op->buffer, op->index)) {
+        op->buffer.accept(this);
+      }
+      op->index.accept(this);
+    }
+    void visit(const Store* op) {
+      if (!accesses(op->buffer, op->index)) {
+        op->buffer.accept(this);
+      }
+      op->index.accept(this);
+      op->value.accept(this);
+    }
+  };
+  OnlyAccessesLoopElement visitor(var, loopVar);
+  stmt.accept(&visitor);
+  return visitor.only;
+}
+
+/// Adds the stores that run unconditionally in every iteration of `stmt`, the
+/// body of a loop, to `stores`.
+static void getStraightLineStores(const Stmt& stmt,
+                                  vector<const Store*>* stores) {
+  if (isa<Block>(stmt)) {
+    getStraightLineStores(to<Block>(stmt)->first, stores);
+    if (to<Block>(stmt)->rest.defined()) {
+      getStraightLineStores(to<Block>(stmt)->rest, stores);
+    }
+  }
+  else if (isa<Scope>(stmt)) {
+    getStraightLineStores(to<Scope>(stmt)->scopedStmt, stores);
+  }
+  else if (isa<Comment>(stmt) && to<Comment>(stmt)->commentedStmt.defined()) {
+    getStraightLineStores(to<Comment>(stmt)->commentedStmt, stores);
+  }
+  else if (isa<Store>(stmt)) {
+    stores->push_back(to<Store>(stmt));
+  }
+}
+
+class LiveRangeAnalysis : public IRVisitor {
+public:
+  LiveRangeAnalysis(const vector<Var>& temporaries)
+      : temporaries(temporaries.begin(), temporaries.end()),
+        position(0), conditional(0) {}
+
+  map<Var,LiveRange> analyze(Stmt body) {
+    body.accept(this);
+
+    map<Var,LiveRange> liveRanges;
+    for (auto& range : ranges) {
+      const Var& var = range.first;
+      if (!firstIsDefinition.at(var)) {
+        continue;
+      }
+      LiveRange liveRange = range.second;
+      if (util::contains(outermostLoops, var)) {
+        for (int loop : outermostLoops.at(var)) {
+          liveRange.begin = min(liveRange.begin, loopRanges[loop].begin);
+          liveRange.end = max(liveRange.end, loopRanges[loop].end);
+        }
+      }
+      liveRanges[var] = liveRange;
+    }
+
+    // Temporaries that are never referenced are never live
+    for (const Var& var : temporaries) {
+      if (!util::contains(ranges, var)) {
+        liveRanges[var] = LiveRange();
+      }
+    }
+    return liveRanges;
+  }
+
+private:
+  set<Var> temporaries;
+  int position;
+
+  /// Number of enclosing statements that may not execute.
+  int conditional;
+
+  map<Var,LiveRange> ranges;
+  map<Var,bool> firstIsDefinition;
+
+  /// The stores of the enclosing set loops that write every element of a
+  /// temporary vector over the set, one per iteration.
+  set<const Store*> fullStores;
+
+  /// The positions spanned by each loop, and the outermost loops each
+  /// temporary is referenced in.
+  vector<LiveRange> loopRanges;
+  vector<int> loopStack;
+  map<Var,set<int>> outermostLoops;
+
+  void reference(const Var& var, bool definition) {
+    if (!util::contains(temporaries, var)) {
+      return;
+    }
+    int pos = position++;
+    if (!util::contains(ranges, var)) {
+      ranges[var] = LiveRange(pos, pos);
+      firstIsDefinition[var] = definition && conditional == 0;
+    }
+    ranges[var].end = pos;
+    if (!loopStack.empty()) {
+      outermostLoops[var].insert(loopStack.front());
+    }
+  }
+
+  template <typename Loop>
+  void visitLoop(const Loop* op) {
+    int loop = loopRanges.size();
+    loopRanges.push_back(LiveRange(position++, 0));
+    loopStack.push_back(loop);
+    IRVisitor::visit(op);
+    loopStack.pop_back();
+    loopRanges[loop].end = position++;
+  }
+
+  using IRVisitor::visit;
+
+  void visit(const VarExpr* op) {
+    reference(op->var, false);
+  }
+
+  void visit(const AssignStmt* op) {
+    op->value.accept(this);
+    reference(op->var, op->cop == CompoundOperator::None);
+  }
+
+  void visit(const CallStmt* op) {
+    for (const Expr& actual : op->actuals) {
+      actual.accept(this);
+    }
+    for (const Var& result : op->results) {
+      reference(result, true);
+    }
+  }
+
+  void visit(const Store* op) {
+    op->index.accept(this);
+    op->value.accept(this);
+    if (isa<VarExpr>(op->buffer)) {
+      reference(to<VarExpr>(op->buffer)->var, util::contains(fullStores, op));
+    }
+    else {
+      op->buffer.accept(this);
+    }
+  }
+
+  /// A loop over a set that stores to every element of a vector over the set,
+  /// and only reads the elements it stored, defines the vector.
+  void visit(const For* op) {
+    vector<const Store*> stores;
+    if (op->domain.kind == ForDomain::IndexSet) {
+      getStraightLineStores(op->body, &stores);
+    }
+    vector<const Store*> loopFullStores;
+    for (const Store* store : stores) {
+      if (!isa<VarExpr>(store->buffer) ||
+          store->cop != CompoundOperator::None ||
+          !isLoopIndex(store->index, op->var)) {
+        continue;
+      }
+      const Var& var = to<VarExpr>(store->buffer)->var;
+      if (!util::contains(temporaries, var)) {
+        continue;
+      }
+      const TensorType* type = var.getType().toTensor();
+      if (type->order() != 1 || !isScalar(type->getBlockType()) ||
+          !isSameSet(type->getOuterDimensions()[0], op->domain.indexSet) ||
+          !onlyAccessesLoopElement(op->body, var, op->var)) {
+        continue;
+      }
+      loopFullStores.push_back(store);
+    }
+    fullStores.insert(loopFullStores.begin(), loopFullStores.end());
+    visitLoop(op);
+    for (const Store* store : loopFullStores) {
+      fullStores.erase(store);
+    }
+  }
+
+  void visit(const ForRange* op) {
+    visitLoop(op);
+  }
+
+  void visit(const While* op) {
+    visitLoop(op);
+  }
+
+  void visit(const IfThenElse* op) {
+    ++conditional;
+    IRVisitor::visit(op);
+    --conditional;
+  }
+};
+
+std::map<Var,LiveRange> getLiveRanges(Stmt body,
+                                      const std::vector<Var>& temporaries) {
+  return LiveRangeAnalysis(temporaries).analyze(body);
+}
+
+static size_t align(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+BufferAssignment assignBuffers(const std::map<Var,LiveRange>& liveRanges,
+                               const std::map<Var,size_t>& sizes,
+                               size_t alignment) {
+  // Place the largest temporaries first, so that a slab is as large as the
+  // first temporary placed in it
+  vector<Var> vars;
+  for (auto& liveRange : liveRanges) {
+    vars.push_back(liveRange.first);
+  }
+  stable_sort(vars.begin(), vars.end(), [&sizes](const Var& a, const Var& b) {
+    return sizes.at(a) > sizes.at(b);
+  });
+
+  struct Slab {
+    size_t size;
+    vector<LiveRange> liveRanges;
+  };
+  vector<Slab> slabs;
+  map<Var,int> slabOf;
+  BufferAssignment assignment;
+  for (const Var& var : vars) {
+    const LiveRange& liveRange = liveRanges.at(var);
+    size_t size = align(sizes.at(var), alignment);
+    assignment.bufferSize += size;
+
+    int slab = -1;
+    for (size_t s = 0; s < slabs.size() && slab < 0; ++s) {
+      bool overlaps = false;
+      for (const LiveRange& other : slabs[s].liveRanges) {
+        overlaps = overlaps || liveRange.overlaps(other);
+      }
+      if (!overlaps) {
+        slab = s;
+      }
+    }
+    if (slab < 0) {
+      slab = slabs.size();
+      slabs.push_back(Slab());
+      slabs.back().size = size;
+    }
+    slabs[slab].liveRanges.push_back(liveRange);
+    slabOf[var] = slab;
+  }
+
+  vector<size_t> slabOffsets;
+  for (const Slab& slab : slabs) {
+    slabOffsets.push_back(assignment.arenaSize);
+    assignment.arenaSize += slab.size;
+  }
+  for (auto& slab : slabOf) {
+    assignment.offsets[slab.first] = slabOffsets[slab.second];
+  }
+  return assignment;
+}
+
+}}
@@ -0,0 +1,71 @@
+#ifndef SIMIT_BUFFER_ASSIGNMENT_H
+#define SIMIT_BUFFER_ASSIGNMENT_H
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "ir.h"
+
+namespace simit {
+namespace ir {
+
+/// The part of a function body over which a temporary holds a value, given as
+/// the first and last of the body's variable references (in program order)
+/// that it spans. A temporary that is referenced inside a loop is live for the
+/// whole loop, since later iterations may read what earlier ones wrote.
+struct LiveRange {
+  int begin;
+  int end;
+
+  LiveRange() : begin(0), end(-1) {}
+  LiveRange(int begin, int end) : begin(begin), end(end) {}
+
+  bool isEmpty() const {return end < begin;}
+
+  bool overlaps(const LiveRange& other) const {
+    return !isEmpty() && !other.isEmpty() &&
+           begin <= other.end && other.begin <= end;
+  }
+};
+
+std::ostream& operator<<(std::ostream&, const LiveRange&);
+
+/// Returns the live ranges of the `temporaries` of `body` whose buffers may be
+/// shared with other temporaries. A temporary may share its buffer if it is
+/// fully written before it is first read, and outside of conditionals. It is
+/// fully written by an assignment (including a `x = 0` memset), as a call
+/// result, or by a loop over a set that stores every element of a vector over
+/// the set and only reads the elements it stored. The others may rely on their
+/// buffers being zeroed when the function is initialized, and are left out.
+std::map<Var,LiveRange> getLiveRanges(Stmt body,
+                                      const std::vector<Var>& temporaries);
+
+/// An assignment of temporaries to slabs of a single arena, where temporaries
+/// whose live ranges do not overlap share a slab.
+struct BufferAssignment {
+  /// The size of the arena in bytes.
+  size_t arenaSize;
+
+  /// The sum of the sizes of the temporaries, which is what they would take
+  /// up with a buffer each.
+  size_t bufferSize;
+
+  /// The offset of each temporary's slab in the arena.
+  std::map<Var,size_t> offsets;
+
+  BufferAssignment() : arenaSize(0), bufferSize(0) {}
+
+  size_t getBytesSaved() const {return bufferSize - arenaSize;}
+};
+
+/// Pack the temporaries with the given live ranges and sizes in bytes into an
+/// arena. Slabs start at multiples of `alignment` bytes.
+BufferAssignment assignBuffers(const std::map<Var,LiveRange>& liveRanges,
+                               const std::map<Var,size_t>& sizes,
+                               size_t alignment=64);
+
+}}
+
+#endif
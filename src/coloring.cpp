@@ -0,0 +1,90 @@
+#include "coloring.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "graph.h"
+
+using namespace std;
+
+namespace simit {
+
+// class SetColoring
+SetColoring::SetColoring(const Set& set) {
+  const int numElements = set.getSize();
+  const int cardinality = set.getCardinality();
+  const int* endpoints = set.getEndpointsData();
+
+  // Implicit grid edge sets compute their endpoints, so gather them here
+  vector<int> gridEndpoints;
+  if (set.hasImplicitEdges()) {
+    gridEndpoints.reserve(numElements*cardinality);
+    for (ElementRef edge : set) {
+      for (ElementRef endpoint : set.getEndpoints(edge)) {
+        gridEndpoints.push_back(endpoint.getIdent());
+      }
+    }
+    endpoints = gridEndpoints.data();
+  }
+
+  int numEndpoints = 0;
+  for (int i = 0; i < numElements*cardinality; ++i) {
+    numEndpoints = max(numEndpoints, endpoints[i]+1);
+  }
+
+  // Assign colors 64 at a time, tracking the colors taken by the elements
+  // incident to each endpoint in a bit mask. Elements that find all 64 colors
+  // taken are deferred to the next round.
+  vector<int> colors(numElements);
+  vector<uint64_t> taken(numEndpoints);
+  vector<int> uncolored(numElements);
+  for (int e = 0; e < numElements; ++e) {
+    uncolored[e] = e;
+  }
+
+  int numColors = 0;
+  while (uncolored.size() > 0) {
+    fill(taken.begin(), taken.end(), 0);
+    vector<int> deferred;
+    int roundColors = 0;
+    for (int e : uncolored) {
+      const int* eps = &endpoints[e*cardinality];
+      uint64_t mask = 0;
+      for (int i = 0; i < cardinality; ++i) {
+        mask |= taken[eps[i]];
+      }
+      if (~mask == 0) {
+        deferred.push_back(e);
+        continue;
+      }
+
+      int color = 0;
+      while (mask & (uint64_t(1) << color)) {
+        ++color;
+      }
+      for (int i = 0; i < cardinality; ++i) {
+        taken[eps[i]] |= uint64_t(1) << color;
+      }
+      colors[e] = numColors + color;
+      roundColors = max(roundColors, color+1);
+    }
+    numColors += roundColors;
+    uncolored.swap(deferred);
+  }
+
+  // Group the elements by color
+  colorOffsets.resize(numColors+1, 0);
+  for (int e = 0; e < numElements; ++e) {
+    ++colorOffsets[colors[e]+1];
+  }
+  for (int c = 0; c < numColors; ++c) {
+    colorOffsets[c+1] += colorOffsets[c];
+  }
+  elements.resize(numElements);
+  vector<int> next(colorOffsets.begin(), colorOffsets.end()-1);
+  for (int e = 0; e < numElements; ++e) {
+    elements[next[colors[e]]++] = e;
+  }
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef SIMIT_COLORING_H
+#define SIMIT_COLORING_H
+
+#include <vector>
+
+namespace simit {
+class Set;
+
+/// A partition of the elements of an edge set into colors, such that no two
+/// elements of the same color share an endpoint. The elements of one color can
+/// therefore scatter into their endpoints' locations concurrently.
+class SetColoring {
+public:
+  /// Color the elements of `set` with a greedy first-fit coloring.
+  explicit SetColoring(const Set& set);
+
+  /// Returns the number of colors.
+  int getNumColors() const {return colorOffsets.size()-1;}
+
+  /// Returns the number of elements with the given color.
+  int getColorSize(int color) const {
+    return colorOffsets[color+1] - colorOffsets[color];
+  }
+
+  /// Returns the elements with the given color, in ascending order.
+  const int* getColor(int color) const {
+    return elements.data() + colorOffsets[color];
+  }
+
+private:
+  std::vector<int> colorOffsets;
+  std::vector<int> elements;
+};
+
+}
+
+#endif
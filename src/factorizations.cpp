@@ -0,0 +1,76 @@
+#include "factorizations.h"
+
+#include "error.h"
+
+using namespace std;
+
+namespace simit {
+
+const size_t FactorizationCache::MAX_IDLE;
+
+FactorizationCache& FactorizationCache::getInstance() {
+  static FactorizationCache cache;
+  return cache;
+}
+
+bool FactorizationCache::release(const void* solver) {
+  lock_guard<std::mutex> lock(mutex);
+  for (auto& entry : entries) {
+    if (entry->getSolver() == solver) {
+      iassert(entry->inUse) << "solver released twice";
+      entry->inUse = false;
+      trim();
+      return true;
+    }
+  }
+  return false;
+}
+
+void FactorizationCache::evict(const int* rowptr) {
+  lock_guard<std::mutex> lock(mutex);
+  entries.remove_if([rowptr](const unique_ptr<Entry>& entry) {
+    return entry->key == rowptr && !entry->inUse;
+  });
+
+  // Solvers that are still in use keep their factorization until they are
+  // released, but must never be matched against a new array at this address
+  for (auto& entry : entries) {
+    if (entry->key == rowptr) {
+      entry->key = nullptr;
+    }
+  }
+}
+
+FactorizationCache::Stats FactorizationCache::getStats() const {
+  lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+void FactorizationCache::resetStats() {
+  lock_guard<std::mutex> lock(mutex);
+  stats = Stats();
+}
+
+void FactorizationCache::trim() {
+  size_t numIdle = 0;
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (!(*it)->inUse && ++numIdle > MAX_IDLE) {
+      it = entries.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+bool FactorizationCache::Entry::hasPattern(int n, int m, const int* rowptr,
+                                           const int* colidx,
+                                           int nn, int mm) const {
+  if (n != this->n || m != this->m || nn != this->nn || mm != this->mm) {
+    return false;
+  }
+  return equal(this->rowptr.begin(), this->rowptr.end(), rowptr) &&
+         equal(this->colidx.begin(), this->colidx.end(), colidx);
+}
+
+}
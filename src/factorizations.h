@@ -0,0 +1,184 @@
+#ifndef SIMIT_FACTORIZATIONS_H
+#define SIMIT_FACTORIZATIONS_H
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef EIGEN
+#include <Eigen/Sparse>
+#endif
+
+namespace simit {
+
+/// A cache of the sparse factorizations computed by the `chol` and `lu`
+/// intrinsics. The symbolic analysis and fill-reducing ordering of a matrix
+/// only depend on its sparsity pattern, which is given by the tensor index the
+/// matrix is assembled into and is usually the same every time a function runs.
+/// Factorizations are therefore kept when their solvers are freed, keyed by the
+/// index's rowptr array, and factorizing another matrix with the same pattern
+/// only redoes the numeric factorization.
+class FactorizationCache {
+public:
+  struct Stats {
+    /// Factorizations that analyzed the pattern of the matrix
+    unsigned analyzed = 0;
+    /// Factorizations that reused the analysis of an earlier factorization
+    unsigned reused = 0;
+  };
+
+  /// The maximum number of factorizations kept while their solvers are free.
+  static const size_t MAX_IDLE = 8;
+
+  /// Returns the cache shared by all functions.
+  static FactorizationCache& getInstance();
+
+#ifdef EIGEN
+  /// Factorize the BCSR matrix given by `rowptr`, `colidx` and `vals`, with
+  /// `nn`x`mm` blocks, using a `Solver` that has analyzed its pattern if one
+  /// is cached. The solver must be returned with `release`.
+  template <typename Solver, typename Float>
+  Solver* factorize(int n, int m, const int* rowptr, const int* colidx,
+                    int nn, int mm, const Float* vals);
+#endif
+
+  /// Return a solver obtained from `factorize` to the cache. Returns false if
+  /// the solver did not come from the cache.
+  bool release(const void* solver);
+
+  /// Drop the cached factorizations of matrices with the given rowptr array.
+  /// Must be called before the array is freed.
+  void evict(const int* rowptr);
+
+  Stats getStats() const;
+  void resetStats();
+
+private:
+  struct Entry {
+    virtual ~Entry() {}
+    virtual const void* getSolver() const = 0;
+
+    const int* key;
+    int n, m, nn, mm;
+    std::vector<int> rowptr;
+    std::vector<int> colidx;
+    bool inUse = true;
+
+    bool hasPattern(int n, int m, const int* rowptr, const int* colidx,
+                    int nn, int mm) const;
+  };
+
+#ifdef EIGEN
+  template <typename Solver, typename Float>
+  struct SolverEntry : public Entry {
+    Eigen::SparseMatrix<Float,Eigen::ColMajor> matrix;
+    /// The location in `matrix` of each BCSR value
+    std::vector<int> valueLocs;
+    Solver solver;
+
+    const void* getSolver() const {return &solver;}
+  };
+#endif
+
+  mutable std::mutex mutex;
+  Stats stats;
+
+  /// Cached factorizations, most recently used first.
+  std::list<std::unique_ptr<Entry>> entries;
+
+  /// Free the least recently used idle factorizations beyond MAX_IDLE.
+  void trim();
+};
+
+
+#ifdef EIGEN
+template <typename Solver, typename Float>
+Solver* FactorizationCache::factorize(int n, int m, const int* rowptr,
+                                      const int* colidx, int nn, int mm,
+                                      const Float* vals) {
+  typedef SolverEntry<Solver,Float> SolverEntryType;
+
+  SolverEntryType* entry = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      SolverEntryType* cached = dynamic_cast<SolverEntryType*>(it->get());
+      if (cached != nullptr && !cached->inUse && cached->key == rowptr &&
+          cached->hasPattern(n, m, rowptr, colidx, nn, mm)) {
+        cached->inUse = true;
+        entries.splice(entries.begin(), entries, it);
+        entry = cached;
+        ++stats.reused;
+        break;
+      }
+    }
+  }
+
+  if (entry == nullptr) {
+    std::unique_ptr<SolverEntryType> newEntry(new SolverEntryType);
+    const int rows = n/nn;
+    const int nnz = rowptr[rows];
+    newEntry->key = rowptr;
+    newEntry->n = n;
+    newEntry->m = m;
+    newEntry->nn = nn;
+    newEntry->mm = mm;
+    newEntry->rowptr.assign(rowptr, rowptr + rows + 1);
+    newEntry->colidx.assign(colidx, colidx + nnz);
+
+    // Build the pattern of the matrix once, and record where each BCSR value
+    // goes in it so that later factorizations can copy values in place
+    std::vector<Eigen::Triplet<Float>> triplets;
+    triplets.reserve(nnz*nn*mm);
+    for (int i=0; i<rows; ++i) {
+      for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+        for (int bi=0; bi<nn; ++bi) {
+          for (int bj=0; bj<mm; ++bj) {
+            triplets.push_back(Eigen::Triplet<Float>(i*nn+bi,
+                                                     colidx[ij]*mm+bj, 0));
+          }
+        }
+      }
+    }
+    Eigen::SparseMatrix<Float,Eigen::ColMajor>& matrix = newEntry->matrix;
+    matrix.resize(n, m);
+    matrix.setFromTriplets(triplets.begin(), triplets.end());
+    matrix.makeCompressed();
+
+    const int* outer = matrix.outerIndexPtr();
+    const int* inner = matrix.innerIndexPtr();
+    newEntry->valueLocs.resize(nnz*nn*mm);
+    for (int i=0; i<rows; ++i) {
+      for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+        for (int bi=0; bi<nn; ++bi) {
+          for (int bj=0; bj<mm; ++bj) {
+            int col = colidx[ij]*mm+bj;
+            const int* loc = std::lower_bound(inner + outer[col],
+                                              inner + outer[col+1], i*nn+bi);
+            newEntry->valueLocs[ij*nn*mm + bi*mm + bj] = loc - inner;
+          }
+        }
+      }
+    }
+    newEntry->solver.analyzePattern(matrix);
+
+    entry = newEntry.get();
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_front(std::move(newEntry));
+    ++stats.analyzed;
+  }
+
+  Float* values = entry->matrix.valuePtr();
+  for (size_t i=0; i<entry->valueLocs.size(); ++i) {
+    values[entry->valueLocs[i]] = vals[i];
+  }
+  entry->solver.factorize(entry->matrix);
+  return &entry->solver;
+}
+#endif
+
+}
+
+#endif
@@ -9,15 +9,14 @@
 namespace simit {
 namespace ffi {
 
-extern "C" inline
-void* simit_malloc(std::size_t size) {
-  return malloc(size);
-}
+/// Allocate memory that compiled Simit code may free, from the memory arena of
+/// the running function if there is one (see util::MemoryArena).
+extern "C"
+void* simit_malloc(std::size_t size);
 
-extern "C" inline
-void simit_free(void* ptr) {
-  return free(ptr);
-}
+/// Free memory allocated with `simit_malloc` or `malloc`.
+extern "C"
+void simit_free(void* ptr);
 
 /// Converts a Simit blocked matrix into a CSR matrix.
 template <typename Float>
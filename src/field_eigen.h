@@ -0,0 +1,65 @@
+#ifndef SIMIT_FIELD_EIGEN_H
+#define SIMIT_FIELD_EIGEN_H
+
+#include <Eigen/Core>
+
+#include "graph.h"
+
+namespace simit {
+
+/// An Eigen matrix with a row per element of a field and a column per
+/// component of the elements' tensors. Column vectors must be column-major.
+template <typename T, int... dimensions>
+using FieldMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, util::product<dimensions...>::value,
+                  util::product<dimensions...>::value == 1 ? Eigen::ColMajor
+                                                           : Eigen::RowMajor>;
+
+/// An Eigen map of the tensors of a field, with the layout of a FieldMatrix.
+template <typename T, int... dimensions>
+using FieldMap = Eigen::Map<FieldMatrix<T,dimensions...>, Eigen::Unaligned,
+                            Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic>>;
+
+template <typename T, int... dimensions>
+using ConstFieldMap =
+    Eigen::Map<const FieldMatrix<T,dimensions...>, Eigen::Unaligned,
+               Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic>>;
+
+namespace internal {
+template <typename T, int... dimensions>
+Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic>
+eigenStride(const FieldView<T,dimensions...>& view) {
+  uassert(view.getBlockSize() == 1 ||
+          view.getLayout().getKind() != FieldLayout::AoSoA)
+      << "the tensors of AoSoA fields are tiled and cannot be mapped";
+  if (view.getBlockSize() == 1) {
+    // Column-major: the outer stride is between columns, of which there is one
+    return Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic>(view.getExtent(),
+                                                        view.getElementStride());
+  }
+  // Row-major: the outer stride is between rows, that is between elements
+  return Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic>(
+      view.getElementStride(), view.getComponentStride());
+}
+}
+
+/// Map the tensors of a field view into an Eigen matrix, without copying
+/// them. Unlike the view, the map is invalidated when the set grows.
+template <typename T, int... dimensions>
+FieldMap<T,dimensions...> eigenMap(FieldView<T,dimensions...>& view) {
+  return FieldMap<T,dimensions...>(view.getPointer(), view.getExtent(),
+                                   view.getBlockSize(),
+                                   internal::eigenStride(view));
+}
+
+template <typename T, int... dimensions>
+ConstFieldMap<T,dimensions...>
+eigenMap(const FieldView<T,dimensions...>& view) {
+  return ConstFieldMap<T,dimensions...>(view.getPointer(), view.getExtent(),
+                                        view.getBlockSize(),
+                                        internal::eigenStride(view));
+}
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef SIMIT_FIELD_LAYOUT_H
+#define SIMIT_FIELD_LAYOUT_H
+
+#include <cstddef>
+#include <ostream>
+
+#include "error.h"
+
+namespace simit {
+
+/// The memory layout of the tensors of a set field.
+///
+/// - AoS (the default) stores the tensor of each element contiguously.
+/// - SoA stores each tensor component in its own array, with one entry per
+///   element of the set.
+/// - AoSoA groups the elements into tiles of `laneWidth` elements and stores
+///   each component of a tile's elements contiguously.
+///
+/// Scalar fields are laid out the same way in all three layouts.
+class FieldLayout {
+public:
+  enum Kind {AoS, SoA, AoSoA};
+
+  FieldLayout() : kind(AoS), laneWidth(1) {}
+
+  static FieldLayout aos() {return FieldLayout(AoS, 1);}
+  static FieldLayout soa() {return FieldLayout(SoA, 1);}
+  static FieldLayout aosoa(int laneWidth) {
+    uassert(laneWidth > 0) << "AoSoA lane widths must be positive";
+    return FieldLayout(AoSoA, laneWidth);
+  }
+
+  Kind getKind() const {return kind;}
+  int getLaneWidth() const {return laneWidth;}
+
+  /// Number of element slots a field buffer with room for `capacity` elements
+  /// must have. AoSoA buffers are rounded up to whole tiles.
+  size_t getNumSlots(size_t capacity) const {
+    return (kind == AoSoA) ? (capacity + laneWidth-1) / laneWidth * laneWidth
+                           : capacity;
+  }
+
+  /// The offset, in components, of the first component of `element`'s tensor,
+  /// where tensors have `blockSize` components.
+  size_t getOffset(size_t element, size_t blockSize) const {
+    switch (kind) {
+      case AoS:
+        return element * blockSize;
+      case SoA:
+        return element;
+      case AoSoA:
+        return element/laneWidth * laneWidth*blockSize + element%laneWidth;
+    }
+    unreachable;
+    return 0;
+  }
+
+  /// The distance, in components, between consecutive components of an
+  /// element's tensor in a buffer with room for `capacity` elements.
+  size_t getStride(size_t capacity) const {
+    switch (kind) {
+      case AoS:
+        return 1;
+      case SoA:
+        return capacity;
+      case AoSoA:
+        return laneWidth;
+    }
+    unreachable;
+    return 0;
+  }
+
+  friend bool operator==(const FieldLayout& l, const FieldLayout& r) {
+    return l.kind == r.kind && l.laneWidth == r.laneWidth;
+  }
+
+  friend bool operator!=(const FieldLayout& l, const FieldLayout& r) {
+    return !(l == r);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const FieldLayout& layout) {
+    switch (layout.kind) {
+      case AoS:
+        return os << "aos";
+      case SoA:
+        return os << "soa";
+      case AoSoA:
+        return os << "aosoa(" << layout.laneWidth << ")";
+    }
+    return os;
+  }
+
+private:
+  FieldLayout(Kind kind, int laneWidth) : kind(kind), laneWidth(laneWidth) {}
+
+  Kind kind;
+  int laneWidth;
+};
+
+}
+#endif
@@ -0,0 +1,584 @@
+#include "flat_mesh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util/thread_pool.h"
+
+using namespace std;
+
+namespace simit {
+
+/// Files are split into chunks of at least this many bytes, so that small
+/// files are parsed by one thread.
+static const size_t MIN_CHUNK_SIZE = 1 << 16;
+
+/// A read-only mapping of a whole file.
+class MappedFile {
+public:
+  explicit MappedFile(const string& path)
+      : data(nullptr), size(0), valid(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0) {
+      size = status.st_size;
+      valid = true;
+      if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+          valid = false;
+        }
+        else {
+          madvise(mapping, size, MADV_SEQUENTIAL);
+          data = (const char*)mapping;
+        }
+      }
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data != nullptr) {
+      munmap((void*)data, size);
+    }
+  }
+
+  const char* getData() const {return data;}
+  size_t getSize() const {return size;}
+  bool isValid() const {return valid;}
+
+private:
+  const char* data;
+  size_t size;
+  bool valid;
+
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+};
+
+static int openMappedFile(const string& path, const MappedFile& file) {
+  if (!file.isValid()) {
+    std::cerr << "Cannot read " << path << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+static inline bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+  while (p < end && isBlank(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+static inline const char* findLineEnd(const char* p, const char* end) {
+  const char* newline = (const char*)memchr(p, '\n', end - p);
+  return (newline != nullptr) ? newline : end;
+}
+
+/// True iff a token ends at `p`. Returns `p` if so and nullptr otherwise, and
+/// passes through nullptr, so that it can be chained with the parsers.
+static inline const char* endOfToken(const char* p, const char* end) {
+  return (p != nullptr && (p == end || isBlank(*p))) ? p : nullptr;
+}
+
+/// Parse the integer after the blanks at `p`. Returns the position after it,
+/// or nullptr if there is no integer.
+static const char* parseInt(const char* p, const char* end, int* value) {
+  p = skipBlanks(p, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  const char* digits = p;
+  long long result = 0;
+  while (p < end && isDigit(*p)) {
+    result = result*10 + (*p - '0');
+    if (result > INT_MAX) {
+      return nullptr;
+    }
+    ++p;
+  }
+  if (p == digits) {
+    return nullptr;
+  }
+  *value = (int)(negative ? -result : result);
+  return p;
+}
+
+/// Parse the floating point number after the blanks at `p`. Returns the
+/// position after it, or nullptr if there is no number.
+///
+/// Numbers whose decimal mantissa and power of ten are both exactly
+/// representable as doubles are converted with one correctly rounded
+/// multiplication or division. The rest are converted with strtod, so the
+/// results are the same as those of the stream loaders.
+static const char* parseDouble(const char* p, const char* end, double* value) {
+  static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const uint64_t maxExactMantissa = (uint64_t)1 << 53;
+  const int maxMantissaDigits = 19;
+
+  p = skipBlanks(p, end);
+  const char* begin = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int mantissaDigits = 0;
+  int exponent = 0;
+  bool exact = true;
+  bool hasDigits = false;
+  for (; p < end && isDigit(*p); ++p) {
+    hasDigits = true;
+    if (mantissaDigits < maxMantissaDigits) {
+      mantissa = mantissa*10 + (*p - '0');
+      mantissaDigits += (mantissa != 0);
+    }
+    else {
+      exponent++;
+      exact &= (*p == '0');
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && isDigit(*p); ++p) {
+      hasDigits = true;
+      if (mantissaDigits < maxMantissaDigits) {
+        mantissa = mantissa*10 + (*p - '0');
+        mantissaDigits += (mantissa != 0);
+        exponent--;
+      }
+      else {
+        exact &= (*p == '0');
+      }
+    }
+  }
+  if (hasDigits && p < end && (*p == 'e' || *p == 'E')) {
+    int exponentValue;
+    const char* exponentEnd = parseInt(p+1, end, &exponentValue);
+    if (exponentEnd == nullptr || isBlank(p[1]) ||
+        abs(exponentValue) > 1000) {
+      exact = false;
+    }
+    else {
+      exponent += exponentValue;
+      p = exponentEnd;
+    }
+  }
+
+  if (hasDigits && exact && mantissa <= maxExactMantissa &&
+      exponent >= -22 && exponent <= 22) {
+    double result = (double)mantissa;
+    result = (exponent < 0) ? result / powersOfTen[-exponent]
+                            : result * powersOfTen[exponent];
+    *value = negative ? -result : result;
+    return p;
+  }
+
+  // Fall back to strtod, on a copy of the token since the file is not
+  // null-terminated
+  char token[128];
+  const char* tokenEnd = begin;
+  while (tokenEnd < end && !isBlank(*tokenEnd)) {
+    ++tokenEnd;
+  }
+  size_t tokenSize = tokenEnd - begin;
+  if (tokenSize == 0 || tokenSize >= sizeof(token)) {
+    return nullptr;
+  }
+  memcpy(token, begin, tokenSize);
+  token[tokenSize] = '\0';
+  char* stop;
+  *value = strtod(token, &stop);
+  return (stop == token) ? nullptr : begin + (stop - token);
+}
+
+/// True iff the line holds data, rather than being blank or a comment.
+static inline bool isDataLine(const char* line, const char* lineEnd) {
+  line = skipBlanks(line, lineEnd);
+  return line < lineEnd && *line != '#';
+}
+
+/// Call `f(line, lineEnd)` on the data lines of [begin, end), until it returns
+/// false.
+template <typename F>
+static void forEachDataLine(const char* begin, const char* end, F f) {
+  const char* line = begin;
+  while (line < end) {
+    const char* lineEnd = findLineEnd(line, end);
+    if (isDataLine(line, lineEnd) && !f(line, lineEnd)) {
+      return;
+    }
+    line = lineEnd + 1;
+  }
+}
+
+/// Parse the first data line of [begin, end) as a header of `n` integers.
+/// Returns the position after the header line, or nullptr if it is malformed.
+static const char* parseHeader(const char* begin, const char* end, int n,
+                               int* values) {
+  const char* next = nullptr;
+  forEachDataLine(begin, end, [&](const char* line, const char* lineEnd) {
+    const char* p = line;
+    for (int i=0; i < n && p != nullptr; ++i) {
+      p = endOfToken(parseInt(p, lineEnd, &values[i]), lineEnd);
+    }
+    if (p != nullptr) {
+      next = (lineEnd < end) ? lineEnd + 1 : end;
+    }
+    return false;
+  });
+  return next;
+}
+
+/// The number of records of two kinds the lines of a chunk hold, or the
+/// position of the first records of a chunk.
+struct RecordCounts {
+  long first = 0;
+  long second = 0;
+};
+
+/// Parse the data lines of [begin, end) in two parallel passes over chunks of
+/// whole lines. The first pass calls `count(line, lineEnd, counts)` to add the
+/// records of each line to its chunk's counts. The totals are then passed to
+/// `allocate`, and the second pass calls `parse(line, lineEnd, cursor)` to
+/// parse the records of each line, where `cursor` holds the position of the
+/// line's first records and must be advanced past them. Returns false if
+/// `allocate` or any call to `parse` returns false.
+template <typename Count, typename Allocate, typename Parse>
+static bool parseLines(const char* begin, const char* end, Count count,
+                       Allocate allocate, Parse parse) {
+  util::ThreadPool& pool = util::ThreadPool::getInstance();
+  size_t size = end - begin;
+  size_t numChunks = max((size_t)1, min((size_t)pool.getNumThreads()*4,
+                                        size / MIN_CHUNK_SIZE));
+
+  // Chunks start at the beginning of a line
+  vector<const char*> chunks(1, begin);
+  for (size_t c=1; c < numChunks; ++c) {
+    const char* p = max(begin + size*c/numChunks, chunks.back());
+    p = findLineEnd(p, end);
+    chunks.push_back((p < end) ? p + 1 : end);
+  }
+  chunks.push_back(end);
+
+  vector<RecordCounts> offsets(numChunks + 1);
+  pool.parallelFor(numChunks, [&](int chunkBegin, int chunkEnd) {
+    for (int c=chunkBegin; c < chunkEnd; ++c) {
+      RecordCounts counts;
+      forEachDataLine(chunks[c], chunks[c+1],
+                      [&](const char* line, const char* lineEnd) {
+        count(line, lineEnd, &counts);
+        return true;
+      });
+      offsets[c+1] = counts;
+    }
+  });
+  for (size_t c=1; c <= numChunks; ++c) {
+    offsets[c].first += offsets[c-1].first;
+    offsets[c].second += offsets[c-1].second;
+  }
+  if (!allocate(offsets[numChunks])) {
+    return false;
+  }
+
+  atomic<bool> failed(false);
+  pool.parallelFor(numChunks, [&](int chunkBegin, int chunkEnd) {
+    for (int c=chunkBegin; c < chunkEnd && !failed; ++c) {
+      RecordCounts cursor = offsets[c];
+      forEachDataLine(chunks[c], chunks[c+1],
+                      [&](const char* line, const char* lineEnd) {
+        if (!parse(line, lineEnd, &cursor)) {
+          failed = true;
+        }
+        return !failed;
+      });
+    }
+  });
+  return !failed;
+}
+
+/// Parse the records of a TetGen file: lines with an index followed by
+/// `numValues` values parsed by `parseValue(p, lineEnd, record, i)`. Lines
+/// beyond the `numRecords` the header announced are ignored.
+template <typename ParseValue>
+static bool parseTetGenRecords(const char* begin, const char* end,
+                               long numRecords, int numValues,
+                               const char* fileKind, ParseValue parseValue) {
+  auto count = [](const char*, const char*, RecordCounts* counts) {
+    counts->first++;
+  };
+  auto allocate = [&](const RecordCounts& total) {
+    if (total.first < numRecords) {
+      std::cerr << "The TetGen " << fileKind << " file has " << total.first
+                << " records, but its header announces " << numRecords
+                << std::endl;
+      return false;
+    }
+    return true;
+  };
+  auto parse = [&](const char* line, const char* lineEnd,
+                   RecordCounts* cursor) {
+    long record = cursor->first++;
+    if (record >= numRecords) {
+      return true;
+    }
+    int index;
+    const char* p = endOfToken(parseInt(line, lineEnd, &index), lineEnd);
+    for (int i=0; i < numValues && p != nullptr; ++i) {
+      p = endOfToken(parseValue(p, lineEnd, record, i), lineEnd);
+    }
+    if (p == nullptr) {
+      std::cerr << "Malformed record " << record << " in the TetGen "
+                << fileKind << " file" << std::endl;
+      return false;
+    }
+    return true;
+  };
+  return parseLines(begin, end, count, allocate, parse);
+}
+
+/// Parse the vertex indices of TetGen elements or edges, which are numbered
+/// from `firstNode`.
+static bool parseTetGenIndices(const char* begin, const char* end,
+                               long numRecords, int numIndices, int firstNode,
+                               int numVertices, const char* fileKind,
+                               int* indices) {
+  return parseTetGenRecords(begin, end, numRecords, numIndices, fileKind,
+      [=](const char* p, const char* lineEnd, long record, int i) {
+        int vertex;
+        p = parseInt(p, lineEnd, &vertex);
+        vertex -= firstNode;
+        if (p == nullptr || vertex < 0 || vertex >= numVertices) {
+          return (const char*)nullptr;
+        }
+        indices[record*numIndices + i] = vertex;
+        return p;
+      });
+}
+
+int FlatMesh::loadTet(const string& nodeFile, const string& eleFile) {
+  MappedFile node(nodeFile);
+  MappedFile ele(eleFile);
+  if (openMappedFile(nodeFile, node) < 0 || openMappedFile(eleFile, ele) < 0) {
+    return -1;
+  }
+  return loadTet(node.getData(), node.getSize(), ele.getData(), ele.getSize());
+}
+
+int FlatMesh::loadTet(const char* node, size_t nodeSize,
+                      const char* ele, size_t eleSize) {
+  // Load the vertices
+  const char* nodeEnd = node + nodeSize;
+  int nodeHeader[2];
+  const char* nodeData = parseHeader(node, nodeEnd, 2, nodeHeader);
+  if (nodeData == nullptr || nodeHeader[0] < 0 || nodeHeader[1] != 3) {
+    std::cerr << "Invalid TetGen .node header" << std::endl;
+    return -1;
+  }
+  numVertices = nodeHeader[0];
+  vertices.resize(numVertices * 3);
+
+  // TetGen numbers nodes from zero or one, as given by the first node
+  firstNode = 0;
+  forEachDataLine(nodeData, nodeEnd, [this](const char* line,
+                                            const char* lineEnd) {
+    parseInt(line, lineEnd, &firstNode);
+    return false;
+  });
+
+  double* vertexData = vertices.data();
+  if (!parseTetGenRecords(nodeData, nodeEnd, numVertices, 3, ".node",
+          [=](const char* p, const char* lineEnd, long record, int i) {
+            return parseDouble(p, lineEnd, &vertexData[record*3 + i]);
+          })) {
+    return -1;
+  }
+
+  // Load the elements
+  const char* eleEnd = ele + eleSize;
+  int eleHeader[2];
+  const char* eleData = parseHeader(ele, eleEnd, 2, eleHeader);
+  if (eleData == nullptr || eleHeader[0] < 0 || eleHeader[1] <= 0) {
+    std::cerr << "Invalid TetGen .ele header" << std::endl;
+    return -1;
+  }
+  numElements = eleHeader[0];
+  verticesPerElement = eleHeader[1];
+  elements.resize((size_t)numElements * verticesPerElement);
+  if (!parseTetGenIndices(eleData, eleEnd, numElements, verticesPerElement,
+                          firstNode, numVertices, ".ele", elements.data())) {
+    return -1;
+  }
+  return 0;
+}
+
+int FlatMesh::loadTetEdge(const string& edgeFile) {
+  MappedFile edge(edgeFile);
+  if (openMappedFile(edgeFile, edge) < 0) {
+    return -1;
+  }
+  return loadTetEdge(edge.getData(), edge.getSize());
+}
+
+int FlatMesh::loadTetEdge(const char* edge, size_t edgeSize) {
+  const char* edgeEnd = edge + edgeSize;
+  int edgeHeader[1];
+  const char* edgeData = parseHeader(edge, edgeEnd, 1, edgeHeader);
+  if (edgeData == nullptr || edgeHeader[0] < 0) {
+    std::cerr << "Invalid TetGen .edge header" << std::endl;
+    return -1;
+  }
+  numEdges = edgeHeader[0];
+  edges.resize((size_t)numEdges * 2);
+  if (!parseTetGenIndices(edgeData, edgeEnd, numEdges, 2, firstNode,
+                          numVertices, ".edge", edges.data())) {
+    return -1;
+  }
+  return 0;
+}
+
+/// If the line is an OBJ statement with the keyword `keyword`, return the
+/// position after the keyword, and otherwise nullptr.
+static const char* objStatement(const char* line, const char* lineEnd,
+                                char keyword) {
+  line = skipBlanks(line, lineEnd);
+  return (lineEnd - line >= 2 && line[0] == keyword && isBlank(line[1]))
+         ? line + 2 : nullptr;
+}
+
+/// Return the next vertex token of an OBJ face after `p`, or nullptr.
+static const char* nextObjToken(const char* p, const char* lineEnd) {
+  p = skipBlanks(p, lineEnd);
+  return (p < lineEnd) ? p : nullptr;
+}
+
+int FlatMesh::loadObj(const string& objFile) {
+  MappedFile obj(objFile);
+  if (openMappedFile(objFile, obj) < 0) {
+    return -1;
+  }
+  return loadObj(obj.getData(), obj.getSize());
+}
+
+int FlatMesh::loadObj(const char* obj, size_t objSize) {
+  // The first records are vertices and the second are triangles
+  auto count = [](const char* line, const char* lineEnd,
+                  RecordCounts* counts) {
+    const char* p;
+    if (objStatement(line, lineEnd, 'v') != nullptr) {
+      counts->first++;
+    }
+    else if ((p = objStatement(line, lineEnd, 'f')) != nullptr) {
+      int faceVertices = 0;
+      while ((p = nextObjToken(p, lineEnd)) != nullptr) {
+        faceVertices++;
+        while (p < lineEnd && !isBlank(*p)) {
+          ++p;
+        }
+      }
+      counts->second += max(0, faceVertices - 2);
+    }
+  };
+
+  auto allocate = [this](const RecordCounts& total) {
+    if (total.first > INT_MAX || total.second > INT_MAX) {
+      std::cerr << "The OBJ file has too many vertices or faces" << std::endl;
+      return false;
+    }
+    numVertices = total.first;
+    numElements = total.second;
+    verticesPerElement = 3;
+    vertices.resize((size_t)numVertices * 3);
+    elements.resize((size_t)numElements * 3);
+    return true;
+  };
+
+  auto parse = [this](const char* line, const char* lineEnd,
+                      RecordCounts* cursor) {
+    const char* p;
+    if ((p = objStatement(line, lineEnd, 'v')) != nullptr) {
+      double* vertex = &vertices[cursor->first*3];
+      for (int i=0; i < 3 && p != nullptr; ++i) {
+        p = endOfToken(parseDouble(p, lineEnd, &vertex[i]), lineEnd);
+      }
+      cursor->first++;
+      if (p == nullptr) {
+        std::cerr << "Malformed OBJ vertex " << cursor->first << std::endl;
+        return false;
+      }
+    }
+    else if ((p = objStatement(line, lineEnd, 'f')) != nullptr) {
+      // Split the polygon into a fan of triangles around its first vertex.
+      // Negative indices are relative to the vertices defined so far.
+      int first = -1;
+      int previous = -1;
+      int faceVertices = 0;
+      while ((p = nextObjToken(p, lineEnd)) != nullptr) {
+        int index;
+        p = parseInt(p, lineEnd, &index);
+        if (p == nullptr || index == 0) {
+          std::cerr << "Malformed OBJ face" << std::endl;
+          return false;
+        }
+        int vertex = (index > 0) ? index - 1 : (int)cursor->first + index;
+        if (vertex < 0 || vertex >= numVertices) {
+          std::cerr << "OBJ face vertex " << index << " out of range"
+                    << std::endl;
+          return false;
+        }
+        // Skip the texture coordinates and normals
+        while (p < lineEnd && !isBlank(*p)) {
+          ++p;
+        }
+
+        if (faceVertices == 0) {
+          first = vertex;
+        }
+        else if (faceVertices >= 2) {
+          int* triangle = &elements[cursor->second*3];
+          triangle[0] = first;
+          triangle[1] = previous;
+          triangle[2] = vertex;
+          cursor->second++;
+        }
+        previous = vertex;
+        faceVertices++;
+      }
+    }
+    return true;
+  };
+
+  numEdges = 0;
+  edges.clear();
+  return parseLines(obj, obj + objSize, count, allocate, parse) ? 0 : -1;
+}
+
+}
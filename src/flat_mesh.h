@@ -0,0 +1,50 @@
+#ifndef SIMIT_FLAT_MESH_H
+#define SIMIT_FLAT_MESH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace simit {
+
+/// A mesh stored in the flat arrays that Set::addMany and Set::adopt take:
+/// three coordinates per vertex, `verticesPerElement` vertex indices per
+/// element and two vertex indices per edge. Vertex indices start at zero.
+///
+/// The loaders map the mesh files into memory, split them into chunks of
+/// whole lines and parse the chunks in parallel on the thread pool, without
+/// building per-element intermediates. Like the Mesh and MeshVol loaders they
+/// return -1, and report the problem to stderr, if loading fails.
+struct FlatMesh {
+  int numVertices = 0;
+  int numElements = 0;
+  int verticesPerElement = 0;
+  int numEdges = 0;
+
+  std::vector<double> vertices;
+  std::vector<int> elements;
+  std::vector<int> edges;
+
+  /// Load the vertices and elements of TetGen .node and .ele files. Element
+  /// and edge indices are made zero-based if the nodes are numbered from one.
+  int loadTet(const std::string& nodeFile, const std::string& eleFile);
+  int loadTet(const char* node, size_t nodeSize,
+              const char* ele, size_t eleSize);
+
+  /// Load the edges of a TetGen .edge file of the mesh's .node file.
+  int loadTetEdge(const std::string& edgeFile);
+  int loadTetEdge(const char* edge, size_t edgeSize);
+
+  /// Load the vertices and faces of an OBJ file as triangles. Polygons are
+  /// split into fans of triangles.
+  int loadObj(const std::string& objFile);
+  int loadObj(const char* obj, size_t objSize);
+
+private:
+  /// The number nodes are numbered from in the .node file
+  int firstNode = 0;
+};
+
+}
+
+#endif
@@ -192,6 +192,7 @@ void GridSetType::copy(FIRNode::Ptr node) {
   SetType::copy(setType);
   underlyingPointSet = setType->underlyingPointSet->clone<Endpoint>();
   dimensions = setType->dimensions;
+  boundary = setType->boundary;
 }
 
 FIRNode::Ptr GridSetType::cloneNode() {
@@ -306,6 +307,12 @@ FIRNode::Ptr IdentDecl::cloneNode() {
   return node;
 }
 
+void FieldDecl::copy(FIRNode::Ptr node) {
+  const auto fieldDecl = to<FieldDecl>(node);
+  IdentDecl::copy(fieldDecl);
+  layout = fieldDecl->layout;
+}
+
 FIRNode::Ptr FieldDecl::cloneNode() {
   const auto node = std::make_shared<FieldDecl>();
   node->copy(shared_from_this());
@@ -286,6 +286,7 @@ protected:
 struct GridSetType : public SetType {
   Endpoint::Ptr underlyingPointSet;
   size_t        dimensions;
+  ir::GridSetType::Boundary boundary = ir::GridSetType::Periodic;
   
   typedef std::shared_ptr<GridSetType> Ptr;
   
@@ -443,6 +444,8 @@ protected:
 };
 
 struct FieldDecl : public IdentDecl {
+  FieldLayout layout;
+
   typedef std::shared_ptr<FieldDecl> Ptr;
   
   virtual void accept(FIRVisitor *visitor) {
@@ -453,6 +456,8 @@ struct FieldDecl : public IdentDecl {
   virtual unsigned getColEnd() { return FIRNode::getColEnd(); }
 
 protected:
+  virtual void copy(FIRNode::Ptr);
+
   virtual FIRNode::Ptr cloneNode(); 
 };
 
@@ -787,7 +792,7 @@ protected:
 };
 
 struct MapExpr : public Expr {
-  enum class ReductionOp {NONE, SUM};
+  enum class ReductionOp {NONE, SUM, PRODUCT, MAX, MIN};
   
   Identifier::Ptr            func;
   std::vector<IndexSet::Ptr> genericArgs;
@@ -270,6 +270,22 @@ std::vector<FuncDecl::Ptr> createIntrinsics() {
                {opaqueType, nmMatrixType},
                {kmMatrixType},
                {N, M, K});
+  addIntrinsic(&intrinsics,
+               ir::intrinsics::pcg().getName(),
+               {nnMatrixType, nVectorType, nVectorType,
+                makeTensorType(ScalarType::Type::FLOAT),
+                makeTensorType(ScalarType::Type::INT)},
+               {nVectorType, makeTensorType(ScalarType::Type::INT),
+                makeTensorType(ScalarType::Type::FLOAT)},
+               {N});
+  addIntrinsic(&intrinsics,
+               ir::intrinsics::iccg().getName(),
+               {nnMatrixType, nVectorType, nVectorType,
+                makeTensorType(ScalarType::Type::FLOAT),
+                makeTensorType(ScalarType::Type::INT)},
+               {nVectorType, makeTensorType(ScalarType::Type::INT),
+                makeTensorType(ScalarType::Type::FLOAT)},
+               {N});
 
   // Complex numbers
   addScalarIntrinsic(&intrinsics,
@@ -78,6 +78,9 @@ void FIRPrinter::visit(GridSetType::Ptr type) {
   oss << "}[" << type->dimensions << "](";
   type->underlyingPointSet->accept(this);
   oss << ")";
+  if (type->boundary == ir::GridSetType::Ghost) {
+    oss << " ghost";
+  }
 }
 
 void FIRPrinter::visit(TupleElement::Ptr elem) {
@@ -175,6 +178,9 @@ void FIRPrinter::visit(IdentDecl::Ptr decl) {
 
 void FIRPrinter::visit(FieldDecl::Ptr decl) {
   printIdentDecl(decl);
+  if (decl->layout != FieldLayout()) {
+    oss << " " << decl->layout;
+  }
   oss << ";";
 }
 
@@ -791,6 +797,15 @@ void FIRPrinter::printMapOrApply(MapExpr::Ptr expr, const bool isApply) {
       case MapExpr::ReductionOp::SUM:
         oss << "+";
         break;
+      case MapExpr::ReductionOp::PRODUCT:
+        oss << "*";
+        break;
+      case MapExpr::ReductionOp::MAX:
+        oss << "max";
+        break;
+      case MapExpr::ReductionOp::MIN:
+        oss << "min";
+        break;
       default:
         unreachable;
         break;
@@ -54,7 +54,7 @@ void IREmitter::visit(GridSetType::Ptr type) {
   const ir::Type elementType = emitType(type->element);
   const ir::Expr underlyingPointSet = emitExpr(type->underlyingPointSet);
   retType = ir::GridSetType::make(
-      elementType, underlyingPointSet, type->dimensions);
+      elementType, underlyingPointSet, type->dimensions, type->boundary);
 }
 
 void IREmitter::visit(TupleElement::Ptr elem) {
@@ -395,6 +395,15 @@ void IREmitter::visit(MapExpr::Ptr expr) {
     case MapExpr::ReductionOp::SUM:
       reduction = ir::ReductionOperator::Sum;
       break;
+    case MapExpr::ReductionOp::PRODUCT:
+      reduction = ir::ReductionOperator::Product;
+      break;
+    case MapExpr::ReductionOp::MAX:
+      reduction = ir::ReductionOperator::Max;
+      break;
+    case MapExpr::ReductionOp::MIN:
+      reduction = ir::ReductionOperator::Min;
+      break;
     default:
       not_supported_yet;
       break;
@@ -985,7 +994,8 @@ ir::Field IREmitter::emitField(FieldDecl::Ptr ptr) {
   retField = ir::Field("", ir::Type());
 
   ptr->accept(this);
-  const ir::Field ret = retField;
+  ir::Field ret = retField;
+  ret.layout = ptr->layout;
 
   retField = tmpField;
   return ret;
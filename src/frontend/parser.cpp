@@ -101,13 +101,17 @@ std::vector<fir::FieldDecl::Ptr> Parser::parseFieldDeclList() {
   return fields;
 }
 
-// field_decl: tensor_decl ';'
+// field_decl: tensor_decl [field_layout] ';'
 fir::FieldDecl::Ptr Parser::parseFieldDecl() {
   auto fieldDecl = std::make_shared<fir::FieldDecl>();
 
   const auto tensorDecl = parseTensorDecl();
   fieldDecl->name = tensorDecl->name;
   fieldDecl->type = tensorDecl->type;
+
+  if (peek().type == Token::Type::IDENT) {
+    fieldDecl->layout = parseFieldLayout();
+  }
   
   const Token endToken = consume(Token::Type::SEMICOL);
   fieldDecl->setEndLoc(endToken);
@@ -115,6 +119,30 @@ fir::FieldDecl::Ptr Parser::parseFieldDecl() {
   return fieldDecl;
 }
 
+// field_layout: 'aos' | 'soa' | 'aosoa' '(' INT_LITERAL ')'
+FieldLayout Parser::parseFieldLayout() {
+  const Token layoutToken = consume(Token::Type::IDENT);
+
+  if (layoutToken.str == "aos") {
+    return FieldLayout::aos();
+  } else if (layoutToken.str == "soa") {
+    return FieldLayout::soa();
+  } else if (layoutToken.str == "aosoa") {
+    consume(Token::Type::LP);
+    const Token laneWidthToken = peek();
+    const int laneWidth = consume(Token::Type::INT_LITERAL).num;
+    if (laneWidth <= 0) {
+      reportError(laneWidthToken, "a positive lane width");
+      throw SyntaxError();
+    }
+    consume(Token::Type::RP);
+    return FieldLayout::aosoa(laneWidth);
+  }
+
+  reportError(layoutToken, "a field layout (aos, soa or aosoa)");
+  throw SyntaxError();
+}
+
 // extern_func_or_decl: extern_decl | extern_func_decl
 fir::FIRNode::Ptr Parser::parseExternFuncOrDecl() {
   auto tokenAfterExtern = peek(1);
@@ -764,7 +792,8 @@ fir::Expr::Ptr Parser::parseExpr() {
 }
 
 // map_expr: 'map' ident ['<' endpoints '>'] ['(' [expr_params] ')'] 
-//           'to' set_index_set ['through' set_index_set] ['reduce' '+']
+//           'to' set_index_set ['through' set_index_set] 
+//           ['reduce' reduction_op]
 fir::MapExpr::Ptr Parser::parseMapExpr() {
   const Token mapToken = consume(Token::Type::MAP);
   const fir::Identifier::Ptr func = parseIdent();
@@ -800,10 +829,10 @@ fir::MapExpr::Ptr Parser::parseMapExpr() {
     mapExpr->partialActuals = partialActuals;
     mapExpr->target = target;
     mapExpr->through = through;
-    mapExpr->op = fir::MapExpr::ReductionOp::SUM;
 
-    const Token plusToken = consume(Token::Type::PLUS);
-    mapExpr->setEndLoc(plusToken);
+    const Token opToken = peek();
+    mapExpr->op = parseReductionOp();
+    mapExpr->setEndLoc(opToken);
 
     return mapExpr;
   }
@@ -820,6 +849,27 @@ fir::MapExpr::Ptr Parser::parseMapExpr() {
   return mapExpr;
 }
 
+// reduction_op: '+' | '*' | 'max' | 'min'
+fir::MapExpr::ReductionOp Parser::parseReductionOp() {
+  if (tryConsume(Token::Type::PLUS)) {
+    return fir::MapExpr::ReductionOp::SUM;
+  } else if (tryConsume(Token::Type::STAR)) {
+    return fir::MapExpr::ReductionOp::PRODUCT;
+  } else if (peek().type == Token::Type::IDENT) {
+    const Token opToken = peek();
+    if (opToken.str == "max") {
+      consume(Token::Type::IDENT);
+      return fir::MapExpr::ReductionOp::MAX;
+    } else if (opToken.str == "min") {
+      consume(Token::Type::IDENT);
+      return fir::MapExpr::ReductionOp::MIN;
+    }
+  }
+
+  reportError(peek(), "a reduction operator (+, *, max or min)");
+  throw SyntaxError();
+}
+
 // or_expr: and_expr {'or' and_expr}
 fir::Expr::Ptr Parser::parseOrExpr() {
   fir::Expr::Ptr expr = parseAndExpr(); 
@@ -1407,6 +1457,7 @@ fir::SetType::Ptr Parser::parseUnstructuredSetType() {
 }
 
 // grid_set_type: 'grid' '[' INT_LITERAL ']' '{' element_type '}' '(' IDENT ')'
+//                [grid_boundary]
 fir::SetType::Ptr Parser::parseGridSetType() {
   auto setType = std::make_shared<fir::GridSetType>();
 
@@ -1430,9 +1481,29 @@ fir::SetType::Ptr Parser::parseGridSetType() {
   const Token endToken = consume(Token::Type::RP);
   setType->setEndLoc(endToken);
 
+  if (peek().type == Token::Type::IDENT) {
+    const Token boundaryToken = peek();
+    setType->boundary = parseGridBoundary();
+    setType->setEndLoc(boundaryToken);
+  }
+
   return setType;
 }
 
+// grid_boundary: 'periodic' | 'ghost'
+ir::GridSetType::Boundary Parser::parseGridBoundary() {
+  const Token boundaryToken = consume(Token::Type::IDENT);
+
+  if (boundaryToken.str == "periodic") {
+    return ir::GridSetType::Periodic;
+  } else if (boundaryToken.str == "ghost") {
+    return ir::GridSetType::Ghost;
+  }
+
+  reportError(boundaryToken, "a grid boundary (periodic or ghost)");
+  throw SyntaxError();
+}
+
 // endpoints: endpoint {',' endpoint}
 std::vector<fir::Endpoint::Ptr> Parser::parseEndpoints() {
   std::vector<fir::Endpoint::Ptr> endpoints;
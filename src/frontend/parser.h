@@ -35,6 +35,7 @@ private:
   fir::ElementTypeDecl::Ptr           parseElementTypeDecl();
   std::vector<fir::FieldDecl::Ptr>    parseFieldDeclList();
   fir::FieldDecl::Ptr                 parseFieldDecl();
+  FieldLayout                         parseFieldLayout();
   fir::FIRNode::Ptr                   parseExternFuncOrDecl();
   fir::ExternDecl::Ptr                parseExternDecl();
   fir::FuncDecl::Ptr                  parseExternFuncDecl();
@@ -61,6 +62,7 @@ private:
   fir::ExprStmt::Ptr                  parseExprOrAssignStmt();
   fir::Expr::Ptr                      parseExpr();
   fir::MapExpr::Ptr                   parseMapExpr();
+  fir::MapExpr::ReductionOp           parseReductionOp();
   fir::Expr::Ptr                      parseOrExpr();
   fir::Expr::Ptr                      parseAndExpr();
   fir::Expr::Ptr                      parseXorExpr();
@@ -88,6 +90,7 @@ private:
   fir::ElementType::Ptr               parseElementType();
   fir::SetType::Ptr                   parseUnstructuredSetType();
   fir::SetType::Ptr                   parseGridSetType();
+  ir::GridSetType::Boundary           parseGridBoundary();
   std::vector<fir::Endpoint::Ptr>     parseEndpoints();
   fir::Endpoint::Ptr                  parseEndpoint();
   fir::TupleElement::Ptr              parseTupleElement();
@@ -2547,7 +2547,8 @@ bool TypeChecker::Environment::compareIndexSets(IndexSet::Ptr l,
       auto lLatType = to<GridSetType>(lType);
       auto rLatType = to<GridSetType>(rType);
 
-      if (lLatType->dimensions != rLatType->dimensions) {
+      if (lLatType->dimensions != rLatType->dimensions ||
+          lLatType->boundary != rLatType->boundary) {
         return false;
       }
 
@@ -2652,7 +2653,8 @@ bool TypeChecker::Environment::compareTypes(Type::Ptr l, Type::Ptr r,
       const auto ltype = to<GridSetType>(lgentype);
       const auto rtype = to<GridSetType>(rgentype);
 
-      if (ltype->dimensions != rtype->dimensions) {
+      if (ltype->dimensions != rtype->dimensions ||
+          ltype->boundary != rtype->boundary) {
         return false;
       }
 
@@ -118,6 +118,11 @@ void Function::init() {
   funcPtr = impl->init();
 }
 
+bool Function::isInitialized() const {
+  uassert(defined()) << "undefined function";
+  return impl->isInitialized();
+}
+
 void Function::runSafe() {
   uassert(defined()) << "undefined function";
   if (!impl->isInitialized()) {
@@ -150,6 +155,24 @@ void Function::printMachine(std::ostream& os) const {
   }
 }
 
+void Function::printMemoryReport(std::ostream& os) const {
+  if (defined()) {
+    impl->printMemoryReport(os);
+  }
+}
+
+size_t Function::getCurrentMemoryUsage() const {
+  return defined() ? impl->getCurrentMemoryUsage() : 0;
+}
+
+size_t Function::getPeakMemoryUsage() const {
+  return defined() ? impl->getPeakMemoryUsage() : 0;
+}
+
+size_t Function::getNumReused() const {
+  return defined() ? impl->getNumReused() : 0;
+}
+
 std::ostream& operator<<(std::ostream& os, const Function& f) {
   f.print(os);
   return os;
@@ -27,6 +27,10 @@ class Function;
 /// If you call the function using `runSafe` (recommended for testing) you don't
 /// need to call `init`, `mapArgs` or `unmapArgs` as they will be called
 /// automatically.
+///
+/// Rebinding a tensor argument, or a set argument with the same size and
+/// endpoints as the set it replaces, does not require a new call to `init`, so
+/// e.g. double-buffered state can be swapped between calls to `run` cheaply.
 class Function {
 public:
   Function();
@@ -62,6 +66,9 @@ public:
   /// automatically as needed.
   void init();
 
+  /// True iff the function has been initialized with its bound arguments.
+  bool isInitialized() const;
+
   /// Run the function. Make sure to bind arguments and map arguments, and to
   /// init the function before calling this method. Also make sure to map/unmap
   /// arguments if you need to access them between calls to run.
@@ -87,6 +94,22 @@ public:
   /// Print the function to the stream as machine assembly code.
   void printMachine(std::ostream& os) const;
 
+  /// Print how much memory the function's temporaries take up to the stream.
+  /// The function must have been initialized.
+  void printMemoryReport(std::ostream& os) const;
+
+  /// Returns the number of bytes the function's memory arena currently holds
+  /// for temporaries and the results of runtime calls.
+  size_t getCurrentMemoryUsage() const;
+
+  /// Returns the largest number of bytes the function's memory arena has held
+  /// at the same time.
+  size_t getPeakMemoryUsage() const;
+
+  /// Returns the number of allocations the function's memory arena served with
+  /// blocks released by earlier runs, rather than with new memory.
+  size_t getNumReused() const;
+
 private:
   std::shared_ptr<backend::Function> impl;
 
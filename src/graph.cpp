@@ -1,31 +1,415 @@
 #include "graph.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 
+#include "coloring.h"
+#include "util/thread_pool.h"
+
 using namespace std;
 
 namespace simit {
 
+Set::Set(const char *name, Set& points, std::vector<int> dims,
+         GridEdges edges) : Set(std::string(name), Grid) {
+  uassert(dims.size() > 0)
+      << "Grid Edge Set constructor takes an optional name followed by "
+      << "the underlying point set and a vector of integer dimension sizes";
+  uassert(points.getSize() == 0)
+      << "Grid Edge Set constructor must be passed an empty underlying "
+      << "point set, which it will then proceed to initialize.";
+  this->endpointSets = {&points, &points};
+  this->dimensions = dims;
+  this->underlyingPointSet = &points;
+
+  int totalPoints = 1;
+  for (int d : dims) {
+    uassert(d > 0) << "Grid dimensions must be positive";
+    totalPoints *= d;
+  }
+
+  // Pad the underlying set to have N_1 x N_2 x ... N_d elements. The points
+  // and the N_1 x N_2 x ... N_d x d edges are in canonical order, so grid
+  // points and edges are found from their coordinates.
+  points.addMany(totalPoints);
+  numElements = totalPoints * dims.size();
+  capacity = numElements;
+
+  if (edges == Materialized) {
+    endpoints = (int*)malloc(sizeof(int) * capacity * getCardinality());
+    for (int e=0; e < numElements; ++e) {
+      endpoints[e*2]   = getGridEndpoint(e, 0);
+      endpoints[e*2+1] = getGridEndpoint(e, 1);
+    }
+  }
+}
+
 Set::~Set() {
   for (auto f: fields) {
     delete f;
   }
-  free(endpoints);
-  free(gridPoints);
-  free(gridEdges);
+  if (ownsEndpoints) {
+    free(endpoints);
+  }
+  delete coloring;
+}
+
+const SetColoring& Set::getColoring() const {
+  std::lock_guard<std::mutex> lock(coloringMutex);
+  if (coloring == nullptr) {
+    coloring = new SetColoring(*this);
+  }
+  return *coloring;
+}
+
+void Set::invalidateColoring() {
+  std::lock_guard<std::mutex> lock(coloringMutex);
+  delete coloring;
+  coloring = nullptr;
+}
+
+void Set::changeTopology() {
+  invalidateColoring();
+  topologyVersion = newTopologyVersion();
+}
+
+unsigned long Set::newTopologyVersion() {
+  static std::atomic<unsigned long> nextVersion(0);
+  return nextVersion++;
+}
+
+/// Resize a buffer from `oldCapacity` to `newCapacity` slots of `slotSize`
+/// bytes, zeroing the new slots. Buffers the set does not own are copied into
+/// one it owns when they grow, and kept as they are when they shrink.
+static void* resizeBuffer(void* data, bool* owned, size_t slotSize,
+                          int oldCapacity, int newCapacity) {
+  size_t oldSize = oldCapacity * slotSize;
+  size_t newSize = newCapacity * slotSize;
+  if (*owned) {
+    data = realloc(data, newSize);
+  }
+  else if (newSize > oldSize) {
+    void* copy = malloc(newSize);
+    memcpy(copy, data, oldSize);
+    data = copy;
+    *owned = true;
+  }
+  if (newSize > oldSize) {
+    memset((char*)data + oldSize, 0, newSize - oldSize);
+  }
+  return data;
+}
+
+/// Copy the first `size` entries of each component array of an SoA buffer
+/// whose arrays have length `oldCapacity` into a new buffer whose arrays have
+/// length `newCapacity`.
+static void* resizeSoABuffer(const void* data, size_t componentSize,
+                             size_t numComponents, int size,
+                             int oldCapacity, int newCapacity) {
+  char* resized = (char*)calloc(newCapacity*numComponents, componentSize);
+  for (size_t c=0; c < numComponents; ++c) {
+    memcpy(resized + c*newCapacity*componentSize,
+           (const char*)data + c*oldCapacity*componentSize,
+           size*componentSize);
+  }
+  return resized;
+}
+
+void Set::reserve(int n) {
+  if (n > capacity) {
+    setCapacity(n);
+  }
+}
+
+ElementRef Set::addMany(int count, const int* endpoints) {
+  uassert(count >= 0) << "Cannot add a negative number of elements";
+  uassert(kind != Grid) << "Element addition disallowed for grid edge sets";
+  uassert((getCardinality() > 0) == (endpoints != nullptr))
+      << "Edge sets must, and other sets must not, pass the endpoints of the "
+      << "elements they add";
+  checkEndpoints(count, endpoints);
+
+  if (numElements + count > capacity) {
+    increaseCapacity(numElements + count);
+  }
+  int cardinality = getCardinality();
+  if (cardinality > 0) {
+    memcpy(this->endpoints + numElements*cardinality, endpoints,
+           count*cardinality*sizeof(int));
+  }
+  ElementRef first(numElements);
+  numElements += count;
+  invalidateColoring();
+  return first;
+}
+
+void Set::adopt(int count, int* endpoints) {
+  uassert(count >= 0) << "Cannot adopt a negative number of elements";
+  uassert(kind != Grid) << "Element addition disallowed for grid edge sets";
+  uassert(numElements == 0) << "Only empty sets can adopt elements";
+  uassert((getCardinality() > 0) == (endpoints != nullptr))
+      << "Edge sets must, and other sets must not, pass the endpoints of the "
+      << "elements they adopt";
+  checkEndpoints(count, endpoints);
+
+  if (getCardinality() > 0) {
+    if (ownsEndpoints) {
+      free(this->endpoints);
+    }
+    this->endpoints = endpoints;
+    ownsEndpoints = false;
+  }
+
+  // The set is empty, so the fields have no data to keep
+  for (FieldData* f : fields) {
+    setFieldData(f, calloc(f->getNumSlots(count), f->sizeOfType), true);
+  }
+  capacity = count;
+  numElements = count;
+  changeTopology();
+}
+
+void Set::increaseCapacity(int n) {
+  setCapacity(max(n, max(2*capacity, (int)initialCapacity)));
+}
+
+void Set::shrinkToFit() {
+  if (capacity > numElements) {
+    setCapacity(numElements);
+  }
+}
+
+void Set::setCapacity(int newCapacity) {
+  iassert(newCapacity >= numElements);
+  if (newCapacity == capacity) {
+    return;
+  }
+  if (getCardinality() > 0 && !hasImplicitEdges()) {
+    endpoints = (int*)resizeBuffer(endpoints, &ownsEndpoints,
+                                   getCardinality()*sizeof(int),
+                                   capacity, newCapacity);
+  }
+  for (FieldData* f : fields) {
+    // The component arrays of SoA fields are as long as the capacity, so
+    // their buffers are rebuilt
+    if (f->layout.getKind() == FieldLayout::SoA && f->type->getSize() > 1) {
+      size_t size = componentSize(f->type->getComponentType());
+      setFieldData(f, resizeSoABuffer(f->data, size, f->type->getSize(),
+                                      numElements, capacity, newCapacity),
+                   true);
+      continue;
+    }
+
+    bool owned = f->ownsData;
+    void* data = resizeBuffer(f->data, &owned, f->sizeOfType,
+                              f->getNumSlots(capacity),
+                              f->getNumSlots(newCapacity));
+    if (data != f->data) {
+      // setFieldData must not free the old buffer, which was either
+      // reallocated or is owned by the caller
+      f->ownsData = false;
+      setFieldData(f, data, owned);
+    }
+  }
+  capacity = newCapacity;
+}
+
+void Set::setFieldData(FieldData* field, void* data, bool owned) {
+  if (field->ownsData) {
+    free(field->data);
+  }
+  field->data = data;
+  field->ownsData = owned;
+  for (FieldRefBase *fieldRef : field->fieldReferences) {
+    fieldRef->data = data;
+  }
+}
+
+int Set::getGridEndpoint(int edge, int endpointNum) const {
+  iassert(kind == Grid) << "Only grid edge sets compute their endpoints";
+  // Edge p*d + dir links point p to its successor in direction dir, assuming
+  // periodic boundary conditions
+  const int ndims = dimensions.size();
+  const int point = edge / ndims;
+  if (endpointNum == 0) {
+    return point;
+  }
+  const int dir = edge % ndims;
+  int stride = 1;
+  for (int i=0; i < dir; ++i) {
+    stride *= dimensions[i];
+  }
+  const int coord = (point / stride) % dimensions[dir];
+  return (coord == dimensions[dir]-1) ? point - coord*stride : point + stride;
+}
+
+void Set::checkEndpoints(int count, const int* endpoints) const {
+  int cardinality = getCardinality();
+  if (cardinality == 0) {
+    return;
+  }
+  vector<int> sizes;
+  for (const Set* endpointSet : endpointSets) {
+    sizes.push_back(endpointSet->getSize());
+  }
+  // Only report errors out of line, to keep the check at memory speed
+  for (int i=0; i < count; ++i) {
+    for (int which=0; which < cardinality; ++which) {
+      int ep = endpoints[i*cardinality + which];
+      if (ep < 0 || ep >= sizes[which]) {
+        uerror << "Invalid member of set (" << endpointSets[which]->getName()
+               << ") in endpoint " << which << " of element " << i
+               << " (" << ep << " < " << sizes[which] << ")";
+      }
+    }
+  }
+}
+
+void Set::moveElements(int from, int to, int count) {
+  if (count == 0 || from == to) {
+    return;
+  }
+  int cardinality = getCardinality();
+  if (cardinality > 0) {
+    memmove(endpoints + to*cardinality, endpoints + from*cardinality,
+            count*cardinality*sizeof(int));
+  }
+  for (FieldData* f : fields) {
+    char* data = (char*)f->data;
+    size_t blockSize = f->type->getSize();
+    size_t componentBytes = componentSize(f->type->getComponentType());
+    if (f->layout.getKind() == FieldLayout::AoS || blockSize == 1) {
+      memmove(data + to*f->sizeOfType, data + from*f->sizeOfType,
+              count*f->sizeOfType);
+    }
+    else if (f->layout.getKind() == FieldLayout::SoA) {
+      for (size_t c=0; c < blockSize; ++c) {
+        memmove(data + (c*capacity + to)*componentBytes,
+                data + (c*capacity + from)*componentBytes,
+                count*componentBytes);
+      }
+    }
+    else {
+      // Moving element by element in increasing order never overwrites an
+      // element that has yet to move, since `to` < `from` if they overlap
+      size_t stride = f->layout.getStride(capacity);
+      for (int i=0; i < count; ++i) {
+        size_t src = f->layout.getOffset(from + i, blockSize);
+        size_t dst = f->layout.getOffset(to + i, blockSize);
+        for (size_t c=0; c < blockSize; ++c) {
+          memcpy(data + (dst + c*stride)*componentBytes,
+                 data + (src + c*stride)*componentBytes, componentBytes);
+        }
+      }
+    }
+  }
+}
+
+void Set::remove(ElementRef element) {
+  uassert(kind != Grid) << "Element removal disallowed for grid edge sets";
+  uassert(element.ident >= 0 && element.ident < numElements)
+      << "Invalid member of set (" << getName() << ") in remove ("
+      << element.ident << " < " << numElements << ")";
+  int last = numElements-1;
+  moveElements(last, element.ident, 1);
+  if (element.ident < (int)removedElements.size()) {
+    removedElements[element.ident] = isMarkedRemoved(ElementRef(last));
+  }
+  if ((int)removedElements.size() > last) {
+    removedElements.resize(last);
+  }
+  numElements--;
+  changeTopology();
 }
 
-void Set::increaseCapacity() {
-  for (auto f : fields) {
-    int typeSize = f->sizeOfType;
-    f->data = realloc(f->data, (capacity+capacityIncrement) * typeSize);
-    memset((char*)(f->data)+capacity*typeSize, 0, capacityIncrement*typeSize);
+void Set::markRemoved(ElementRef element) {
+  uassert(kind != Grid) << "Element removal disallowed for grid edge sets";
+  uassert(element.ident >= 0 && element.ident < numElements)
+      << "Invalid member of set (" << getName() << ") in markRemoved ("
+      << element.ident << " < " << numElements << ")";
+  if ((int)removedElements.size() <= element.ident) {
+    removedElements.resize(numElements, false);
+  }
+  removedElements[element.ident] = true;
+}
+
+vector<int> Set::compact(const vector<Set*>& dependents) {
+  vector<int> remap(numElements);
+  int newSize = 0;
+  for (int i=0; i < numElements; ++i) {
+    remap[i] = isMarkedRemoved(ElementRef(i)) ? -1 : newSize++;
+  }
+
+  // The endpoints of the dependents that refer to this set
+  vector<vector<int>> dependentEndpoints(dependents.size());
+  for (size_t d=0; d < dependents.size(); ++d) {
+    const Set* dependent = dependents[d];
+    for (int which=0; which < dependent->getCardinality(); ++which) {
+      if (dependent->endpointSets[which] == this) {
+        dependentEndpoints[d].push_back(which);
+      }
+    }
+    uassert(dependent->kind != Grid || dependentEndpoints[d].empty())
+        << "Cannot remove the points of grid edge set "
+        << dependent->getName();
+  }
+  if (newSize == numElements) {
+    removedElements.clear();
+    return remap;
+  }
 
-    for (FieldRefBase *fieldRef : f->fieldReferences) {
-      fieldRef->data = f->data;
+  // Check the dependents before changing anything, reporting errors out of
+  // line to keep the check at memory speed
+  for (size_t d=0; d < dependents.size(); ++d) {
+    const Set* dependent = dependents[d];
+    const int cardinality = dependent->getCardinality();
+    for (int e=0; e < dependent->getSize(); ++e) {
+      for (int which : dependentEndpoints[d]) {
+        int ep = dependent->endpoints[e*cardinality + which];
+        if (remap[ep] < 0) {
+          uerror << "Element " << e << " of set (" << dependent->getName()
+                 << ") refers to removed element " << ep << " of set ("
+                 << getName() << ")";
+        }
+      }
     }
   }
-  capacity += capacityIncrement;
+
+  // Move each run of remaining elements down in one go
+  int i = 0;
+  while (i < numElements) {
+    while (i < numElements && remap[i] < 0) {
+      ++i;
+    }
+    int runBegin = i;
+    while (i < numElements && remap[i] >= 0) {
+      ++i;
+    }
+    if (i > runBegin) {
+      moveElements(runBegin, remap[runBegin], i - runBegin);
+    }
+  }
+  numElements = newSize;
+  removedElements.clear();
+  changeTopology();
+
+  for (size_t d=0; d < dependents.size(); ++d) {
+    Set* dependent = dependents[d];
+    if (dependentEndpoints[d].empty()) {
+      continue;
+    }
+    const int cardinality = dependent->getCardinality();
+    for (int e=0; e < dependent->getSize(); ++e) {
+      for (int which : dependentEndpoints[d]) {
+        int& ep = dependent->endpoints[e*cardinality + which];
+        ep = remap[ep];
+      }
+    }
+    dependent->changeTopology();
+  }
+  return remap;
 }
 
 
@@ -114,4 +498,24 @@ Box createBox(Set *vertices, Set *edges,
   return Box(numX, numY, numZ, points, coords2edges);
 }
 
+void parallelForEach(const Set& set,
+                     const std::function<void(const Set::ElementRange&)>& body,
+                     Schedule schedule, int chunkSize) {
+  util::ThreadPool& pool = util::ThreadPool::getInstance();
+  auto rangeBody = [&set,&body](int begin, int end) {
+    body(Set::ElementRange(&set, begin, end));
+  };
+  switch (schedule) {
+    case Schedule::Static:
+      pool.parallelFor(set.getSize(), rangeBody);
+      break;
+    case Schedule::Dynamic:
+      if (chunkSize == 0) {
+        chunkSize = set.getSize() / (pool.getNumThreads() * 8);
+      }
+      pool.parallelFor(set.getSize(), chunkSize, rangeBody);
+      break;
+  }
+}
+
 } // namespace simit
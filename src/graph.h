@@ -1,16 +1,20 @@
 #ifndef SIMIT_GRAPH_H
 #define SIMIT_GRAPH_H
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <functional>
 #include <vector>
 #include <string>
 #include <map>
+#include <mutex>
 #include <set>
 #include <ostream>
 
 #include "tensor_type.h"
 #include "error.h"
+#include "field_layout.h"
 #include "types.h"
 #include "util/variadic.h"
 #include "interfaces/comparable.h"
@@ -20,8 +24,12 @@ namespace simit {
 class Function;
 
 class Set;
+class SetSnapshot;
+class SetColoring;
 class FieldRefBase;
+template <typename T, int... dimensions> class FieldRefBaseParameterized;
 template <typename T, int... dimensions> class FieldRef;
+template <typename T, int... dimensions> class FieldView;
 template <typename T, int... dimensions> class TensorRef;
 
 namespace internal {
@@ -83,9 +91,16 @@ private:
   friend class internal::VertexToEdgeIndex;
   friend class internal::NeighborIndex;
   friend class pe::SetEndpointPathIndex;
+  friend class SetSnapshot;
 };
 
 
+/// How parallelForEach divides a set's elements between threads. Static
+/// schedules give each thread one contiguous range of elements. Dynamic
+/// schedules hand out ranges of a fixed number of elements to threads as they
+/// finish earlier ones, which balances bodies whose cost varies by element.
+enum class Schedule {Static, Dynamic};
+
 /// Base class for Sets. Sets are used to represent collections within C++, and
 /// can be passed as bound inputs to Simit programs.
 class Set {
@@ -117,59 +132,21 @@ public:
   /// Construct an edge set with one endpoint.
   Set(const Set& endpoint) : Set("", endpoint) {}
 
-  /// GRID EDGE SET constructors
-  Set(const char *name, Set& points, std::vector<int> dims)
-      : Set(std::string(name), Grid) {
-    uassert(dims.size() > 0)
-        << "Grid Edge Set constructor takes an optional name followed by "
-        << "the underlying point set and a vector of integer dimension sizes";
-    uassert(points.getSize() == 0)
-        << "Grid Edge Set constructor must be passed an empty underlying "
-        << "point set, which it will then proceed to initialize.";
-    this->endpointSets = {&points, &points};
-    this->endpoints    = (int*)calloc(sizeof(int), capacity * getCardinality());
-    this->dimensions = dims;
-    this->underlyingPointSet = &points;
-
-    int totalPoints = 1;
-    std::vector<int> cumDims;
-    for (int d : dims) {
-      totalPoints *= d;
-      cumDims.push_back(totalPoints);
-    }
+  /// How grid edge sets store their topology. Materialized grids store the
+  /// endpoints of their edges, like other edge sets. Implicit grids store only
+  /// their dimensions and compute the endpoints when they are asked for, so
+  /// that large grids do not hold topology that compiled code never reads.
+  enum GridEdges {Materialized, Implicit};
 
-    this->gridPoints = (ElementRef*)calloc(sizeof(ElementRef), totalPoints);
-    this->gridEdges = (ElementRef*)calloc(
-        sizeof(ElementRef), totalPoints*dims.size());
-    
-    std::vector<int> indices(dims.size());
-    // Pad underlying set to have N_1 x N_2 x ... N_d elements, storing their
-    // references in gridPoints.
-    int count = 0;
-    util::variableLoop(dims.begin(), dims.end(),
-                       indices.begin(), indices.end(), [&](){
-        this->gridPoints[count] = points.add();
-        count++;
-      });
-
-    // Generate N_1 x N_2 x ... N_d x d elements for this set, linking the
-    // underlying points in a grid structure, and store their references in
-    // the canonically ordered gridEdges.
-    count = 0;
-    dims.push_back(dims.size()); // dimension index runs outermost
-    indices.push_back(0);
-    util::variableLoop(dims.begin(), dims.end(),
-                       indices.begin(), indices.end(), [&](){
-        int off = cumDims[indices.back()];
-        // Assumes periodic boundary conditions
-        this->gridEdges[count] = add(
-            this->gridPoints[count%totalPoints],
-            this->gridPoints[(count+off)%totalPoints]);
-        count++;
-      });
-  }
-
-  Set(Set& points, std::vector<int> dims) : Set("", points, dims) {}
+  /// GRID EDGE SET constructors. Edges link each point to the next point in
+  /// each dimension, wrapping around the grid. Programs that declare a grid
+  /// `ghost` treat its outermost layer of points as boundary values, and maps
+  /// through it never reach the wrapping edges.
+  Set(const char *name, Set& points, std::vector<int> dims,
+      GridEdges edges=Materialized);
+
+  Set(Set& points, std::vector<int> dims, GridEdges edges=Materialized)
+      : Set("", points, dims, edges) {}
 
   ~Set();
 
@@ -177,6 +154,13 @@ public:
   /// Return the number of elements in the Set
   inline int getSize() const { return numElements; }
 
+  /// Return the number of elements the Set has room for. SoA fields store
+  /// each tensor component in an array of this length.
+  inline int getCapacity() const { return capacity; }
+
+  /// Release the room for elements beyond the set's size.
+  void shrinkToFit();
+
   /// Returns the dimensions for a grid edge set
   inline const std::vector<int>& getDimensions() const {
     uassert(kind == Grid)
@@ -187,6 +171,12 @@ public:
   /// Return the kind of the Set
   inline Kind getKind() const { return kind; }
 
+  /// Return true if the set is a grid edge set that computes the endpoints of
+  /// its edges instead of storing them.
+  inline bool hasImplicitEdges() const {
+    return kind == Grid && endpoints == nullptr;
+  }
+
   /// Return the number of endpoints of the elements in the set.  Non-edge sets
   /// have cardinality 0.
   inline int getCardinality() const { return endpointSets.size(); }
@@ -207,7 +197,7 @@ public:
     uassert(index >= 0 && index < totalSize)
         << "Coordinates must not be negative and must fall within the "
         << "grid dimensions";
-    return gridPoints[index];
+    return ElementRef(index);
   }
 
   /// Return the grid edge at the given location and direction.
@@ -230,7 +220,7 @@ public:
     uassert(index >= 0 && index < totalSize)
         << "Coordinates must not be negative and must fall within the "
         << "grid dimensions";
-    return gridEdges[index];
+    return ElementRef(index);
   }
 
   inline std::vector<int> getGridPointCoords(ElementRef elt) const {
@@ -251,12 +241,16 @@ public:
   /// component type and dimension sizes of the tensors.  For example, define a
   /// field of 2x3 matrices containing doubles as follows:
   /// Field<double,2,3> matrix = addField<double,2,3>("mat");
+  /// The field's memory layout must match the layout declared in the element
+  /// type of the Simit programs the set is bound to.
   template <typename T, int... dimensions>
-  FieldRef<T, dimensions...> addField(const std::string &name) {
+  FieldRef<T, dimensions...> addField(const std::string &name,
+                                      FieldLayout layout=FieldLayout()) {
     FieldData::TensorType *type =
         new FieldData::TensorType(typeOf<T>(), {dimensions...});
-    FieldData *fieldData = new FieldData(name, type, this);
-    fieldData->data = calloc(capacity, fieldData->sizeOfType);
+    FieldData *fieldData = new FieldData(name, type, layout, this);
+    fieldData->data = calloc(fieldData->getNumSlots(capacity),
+                             fieldData->sizeOfType);
     fields.push_back(fieldData);
     fieldNames[name] = fields.size()-1;
     return FieldRef<T, dimensions...>(fieldData);
@@ -293,57 +287,69 @@ public:
   ElementRef add(Endpoints... endpoints) {
     iassert(sizeof...(endpoints) == getCardinality()) <<"Wrong number of \
       endpoints.";
+    uassert(kind != Grid) << "Element addition disallowed for grid edge sets";
     if (numElements > capacity-1) {
-      increaseEdgeCapacity();
+      increaseCapacity(numElements+1);
     }
     addEndpoints(0, endpoints...);
-
-    if (numElements > capacity-1) {
-      increaseCapacity();
-    }
+    invalidateColoring();
     return ElementRef(numElements++);
   }
 
-  /// Remove an element from the Set
-  void remove(ElementRef element) {
-    uassert(kind != Grid)
-        << "Element removal disallowed for grid edge sets";
-    for (auto f : fields){
-      switch (f->type->getComponentType()) {
-        case ComponentType::Float: {
-          float* data = (float*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-        case ComponentType::Double: {
-          double* data = (double*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-        case ComponentType::Int: {
-          int* data = (int*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-        case ComponentType::Boolean: {
-          bool* data = (bool*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-        case ComponentType::FloatComplex: {
-          float_complex* data = (float_complex*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-        case ComponentType::DoubleComplex: {
-          double_complex* data = (double_complex*)f->data;
-          data[element.ident] = data[numElements-1];
-          break;
-        }
-      }
-    }
-    numElements--;
-  }
+  /// Reserve room for at least `n` elements, so that adding elements up to
+  /// that size does not reallocate the endpoints or the fields.
+  void reserve(int n);
+
+  /// Add `count` elements at once and return the handle of the first one. The
+  /// new elements have consecutive handles. Edge sets must pass the endpoints
+  /// of the new elements, laid out as in getEndpointsData(), and other sets
+  /// must not.
+  ElementRef addMany(int count, const int* endpoints=nullptr);
+
+  /// Make the empty set hold `count` elements whose endpoints are stored in the
+  /// caller-owned `endpoints` buffer, laid out as in getEndpointsData(). The
+  /// buffer is used without copying and must outlive the set, unless the set
+  /// grows, at which point it is copied. Non-edge sets pass no endpoints.
+  void adopt(int count, int* endpoints=nullptr);
+
+  /// Add a field whose data is the caller-owned buffer `data`, which holds one
+  /// tensor for every element of the set in the given layout (rounded up to
+  /// whole tiles for AoSoA). As with adopt(), the buffer is used without
+  /// copying and must outlive the set, unless the set grows.
+  template <typename T, int... dimensions>
+  FieldRef<T, dimensions...> adoptField(const std::string &name, T* data,
+                                        FieldLayout layout=FieldLayout()) {
+    // The buffer only has room for the current elements
+    setCapacity(numElements);
+    FieldRef<T, dimensions...> field =
+        addField<T, dimensions...>(name, layout);
+    setFieldData(fields[fieldNames.at(name)], data, false);
+    return field;
+  }
+
+  /// Remove an element from the Set by moving the last element into its
+  /// place. The moved element's handle changes, and edge sets that refer to it
+  /// are not updated, so use markRemoved and compact to remove elements that
+  /// edges may refer to.
+  void remove(ElementRef element);
+
+  /// Mark an element for removal by the next call to compact. The element
+  /// stays in the set, with the same handle, until then.
+  void markRemoved(ElementRef element);
+
+  /// True iff the element is marked for removal.
+  bool isMarkedRemoved(ElementRef element) const {
+    return element.ident < (int)removedElements.size() &&
+           removedElements[element.ident];
+  }
+
+  /// Remove the elements marked for removal in one pass over the set, moving
+  /// the remaining elements down so that they keep their order. Returns a
+  /// remap from the old handles to the new ones, where removed elements map to
+  /// -1. The endpoints of the edge sets in `dependents` that refer to this set
+  /// are rewritten with the remap; none of their edges may refer to a removed
+  /// element, so edges must be removed before their endpoints.
+  std::vector<int> compact(const std::vector<Set*>& dependents={});
 
   /// Iterator that iterates over the elements in a Set
   ///
@@ -403,6 +409,38 @@ public:
   /// Create an ElementIterator for terminating iteration over this Set
   ElementIterator end() const { return ElementIterator(this, getSize()); }
 
+  /// A contiguous range of a set's elements, handed to parallelForEach bodies.
+  class ElementRange {
+  public:
+    ElementIterator begin() const { return ElementIterator(set, first); }
+    ElementIterator end() const { return ElementIterator(set, last); }
+
+    /// Return the number of elements in the range.
+    int getSize() const { return last - first; }
+
+    /// Return the endpoints of the range's edges, laid out as in
+    /// Set::getEndpointsData() from the range's first edge on, or nullptr if
+    /// the set is not an edge set or is an implicit grid.
+    const int *getEndpointsData() const {
+      if (set->getCardinality() == 0 || set->getEndpointsData() == nullptr) {
+        return nullptr;
+      }
+      return set->getEndpointsData() + first*set->getCardinality();
+    }
+
+  private:
+    const Set *set;
+    int first;
+    int last;
+
+    ElementRange(const Set *set, int first, int last)
+        : set(set), first(first), last(last) {}
+
+    friend void parallelForEach(const Set&,
+                                const std::function<void(const ElementRange&)>&,
+                                Schedule, int);
+  };
+
   /// Get the endpoint set at the given location.
   const Set *getEndpointSet(int loc) const {
     return endpointSets[loc];
@@ -425,6 +463,9 @@ public:
 
   /// Get an endpoint of an edge
   ElementRef getEndpoint(ElementRef edge, int endpointNum) const {
+    if (endpoints == nullptr) {
+      return ElementRef(getGridEndpoint(edge.ident, endpointNum));
+    }
     return ElementRef(endpoints[edge.ident*getCardinality() + endpointNum]);
   }
   
@@ -451,12 +492,11 @@ public:
       const ElementRef* operator->() const {return &retElem;}
 
       Iterator& operator++() {
-        const int cardinality = set->getCardinality();
         endpointNum++;
         if (endpointNum > set->getCardinality()-1)
           retElem.ident = -1;   // return invalid element
         else
-          retElem.ident = set->endpoints[curElem.ident*cardinality+endpointNum];
+          retElem = set->getEndpoint(curElem, endpointNum);
         return *this;
       }
 
@@ -466,7 +506,7 @@ public:
         if (endpointNum > cardinality-1)
           retElem.ident = -1;   // return invalid element
         else
-          retElem.ident = set->endpoints[curElem.ident*cardinality+endpointNum];
+          retElem = set->getEndpoint(curElem, endpointNum);
         return *this;
       }
 
@@ -523,8 +563,28 @@ public:
     return fields[fieldNames.at(fieldName)]->data;
   }
 
+  /// Get the memory layout of the field `fieldName`.
+  FieldLayout getFieldLayout(const std::string &fieldName) const {
+    uassert(fieldNames.find(fieldName) != fieldNames.end())
+        << "The Set has no field " << fieldName;
+    return fields[fieldNames.at(fieldName)]->layout;
+  }
+
   /// Get an array containing, for each edge in a set, the elements it connects.
+  /// Implicit grid edge sets have no such array and return nullptr.
   int *getEndpointsData() { return endpoints; }
+  const int *getEndpointsData() const { return endpoints; }
+
+  /// Get a partition of the elements into colors such that no two elements of
+  /// the same color share an endpoint. The coloring is computed on first use
+  /// and kept until the set's topology changes. It is safe to call from
+  /// functions that run concurrently over the same set.
+  const SetColoring& getColoring() const;
+
+  /// Get a number that identifies the set's topology. Appending elements keeps
+  /// the number, while any other change to the elements or their endpoints
+  /// replaces it by a number that no set has had before.
+  unsigned long getTopologyVersion() const { return topologyVersion; }
 
   void setName(const std::string &name) { this->name = name; }
   std::string getName() const { return name; }
@@ -564,13 +624,17 @@ public:
       size_t size;
     };
 
-    FieldData(const std::string &name, const TensorType *type, Set *set)
-        : name(name), type(type), set(set), data(nullptr) {
+    FieldData(const std::string &name, const TensorType *type,
+              FieldLayout layout, Set *set)
+        : name(name), type(type), layout(layout), set(set), data(nullptr),
+          ownsData(true) {
       sizeOfType = componentSize(type->getComponentType()) * type->getSize();
     }
 
     ~FieldData() {
-      free(data);
+      if (ownsData) {
+        free(data);
+      }
       delete type;
     }
 
@@ -579,12 +643,24 @@ public:
     const TensorType *type;
     size_t sizeOfType;
 
+    /// The memory layout of the field's tensors
+    FieldLayout layout;
+
+    /// Number of tensors the buffer must have room for to hold `capacity`
+    /// elements
+    size_t getNumSlots(size_t capacity) const {
+      return layout.getNumSlots(capacity);
+    }
+
     // The Set this field is a member of. Used for printing, etc.
     Set *set;
 
     /// Buffer for the field data
     void* data;
 
+    /// False if the buffer was adopted from the caller
+    bool ownsData;
+
     /// Field references so that we can update their data pointers if we realloc
     /// field data. Avoids two loads on field get/set.
     std::set<FieldRefBase*> fieldReferences;
@@ -595,8 +671,9 @@ public:
     FieldData& operator=(const FieldData& f);
   };
 
-  // Added getters for reordering
-  inline int* getEndpointsPtr() { return endpoints; }
+  // Added getters for reordering. Callers may rewrite the endpoints, so the
+  // cached coloring is dropped.
+  inline int* getEndpointsPtr() { changeTopology(); return endpoints; }
   inline int getFieldIndex(std::string name) { return fieldNames[name]; } inline 
     std::vector<FieldData*>& getFields() { return fields; } inline std::string 
     getSpatialFieldName() const { return spatialFieldName; }
@@ -607,8 +684,9 @@ private:
   // Private constructor for delegation
   Set(const std::string &name, Kind kind)
       : kind(kind), name(name), numElements(0), endpoints(nullptr),
-        gridPoints(nullptr), gridEdges(nullptr),
-        capacity(capacityIncrement), neighbors(nullptr) {}
+        underlyingPointSet(nullptr), ownsEndpoints(true),
+        capacity(initialCapacity), neighbors(nullptr), coloring(nullptr),
+        topologyVersion(newTopologyVersion()) {}
 
   // Set data
   Kind kind;
@@ -621,21 +699,51 @@ private:
   // Grid edge set data
   std::vector<int> dimensions;               // the grid dimensions
   const Set* underlyingPointSet;             // the underlying point set
-  ElementRef* gridPoints;                    // ordered refs to grid points
-  ElementRef* gridEdges;                     // ordered refs to grid edges
 
+  bool ownsEndpoints;                        // false if adopted from the caller
   int capacity;                              // current capacity of the set
-  static const int capacityIncrement = 1024; // increment for capacity increases
+  static const int initialCapacity = 1024;   // capacity of new sets
 
   mutable internal::NeighborIndex *neighbors;// neighbor index (lazily created)
+  mutable SetColoring *coloring;             // element coloring (lazily created)
+  mutable std::mutex coloringMutex;          // guards the lazy coloring build
+  unsigned long topologyVersion;             // kept by appends only
   std::map<std::string, int> fieldNames;     // name to field lookups
   std::vector<FieldData*> fields;            // fields of elements in the set
+  std::vector<bool> removedElements;         // elements marked for removal
 
   /// disable copy
   Set& operator=(const Set& s);
 
-  /// increase capacity of all fields
-  void increaseCapacity();
+  /// grow the capacity of the endpoints and all fields geometrically, to at
+  /// least `n` elements
+  void increaseCapacity(int n);
+
+  /// resize the endpoints and all fields to hold `newCapacity` elements
+  void setCapacity(int newCapacity);
+
+  /// replace the buffer of a field and update its field references
+  void setFieldData(FieldData *field, void *data, bool owned);
+
+  /// move the endpoints and tensors of `count` consecutive elements from
+  /// `from` to `to`, where the ranges may overlap if `to` < `from`
+  void moveElements(int from, int to, int count);
+
+  /// compute an endpoint of a grid edge from the grid dimensions
+  int getGridEndpoint(int edge, int endpointNum) const;
+
+  /// check that `endpoints` holds valid endpoints for `count` elements
+  void checkEndpoints(int count, const int *endpoints) const;
+
+  /// drop the cached coloring after the topology has changed
+  void invalidateColoring();
+
+  /// drop the cached coloring and take a new topology version after a change
+  /// other than appending elements
+  void changeTopology();
+
+  /// get a topology version that no set has had before
+  static unsigned long newTopologyVersion();
 
   /// helpers for constructing endpoint sets
   template <typename F, typename ...T> std::vector<const Set*>
@@ -651,11 +759,6 @@ private:
   std::vector<const Set*>
   epsMaker(std::vector<const Set*> sofar) {return sofar;}
 
-  void increaseEdgeCapacity() {
-    size_t newSize = (capacity+capacityIncrement)*getCardinality()*sizeof(int);
-    endpoints = (int*)realloc(endpoints, newSize);
-  }
-
   // helper for adding edges
   template <typename F, typename ...T>
   void addEndpoints(int which, F f, T ... eps) {
@@ -704,8 +807,10 @@ private:
       }
       FieldData::TensorType *type =
           new FieldData::TensorType(ctype, dims);
-      FieldData *fieldData = new FieldData(field.name, type, this);
-      fieldData->data = calloc(capacity, fieldData->sizeOfType);
+      FieldData *fieldData = new FieldData(field.name, type, field.layout,
+                                           this);
+      fieldData->data = calloc(fieldData->getNumSlots(capacity),
+                               fieldData->sizeOfType);
       fields.push_back(fieldData);
       fieldNames[field.name] = fields.size()-1;
     }
@@ -744,8 +849,21 @@ private:
 
   friend FieldRefBase;
   friend simit::Function;
+  friend SetSnapshot;
+  friend void writeSnapshot(const std::string&,
+                            const std::map<std::string, const Set*>&);
 };
 
+/// Call `body` on disjoint, contiguous ranges that cover the elements of `set`
+/// on the thread pool that runs compiled code, and block until all ranges have
+/// been processed. Dynamic schedules use ranges of `chunkSize` elements, or of
+/// an eighth of each thread's share of the set if it is zero. The set must not
+/// be modified while the loop runs.
+void parallelForEach(const Set& set,
+                     const std::function<void(const Set::ElementRange&)>& body,
+                     Schedule schedule=Schedule::Static,
+                     int chunkSize=0);
+
 
 // Field References
 
@@ -790,12 +908,21 @@ public:
   }
 
   // Return the field's data.  The data is a contigues sequence containing the
-  // tensor of each element in no particular order.  The tensors are currently
-  // laid out in row-major order, but this may change in the future.
+  // tensor of each element in no particular order.  The tensors are laid out
+  // in row-major order, and are interleaved as described by getLayout().
   inline void *getData() {
     return static_cast<void*>(data);
   }
 
+  inline const void *getData() const {
+    return static_cast<const void*>(data);
+  }
+
+  /// Return the memory layout of the field's tensors.
+  inline FieldLayout getLayout() const {
+    return fieldData->layout;
+  }
+
 protected:
   FieldRefBase(void *fieldData)
       : fieldData(static_cast<Set::FieldData*>(fieldData)),
@@ -806,7 +933,13 @@ protected:
   template <typename T>
   inline T *getElemDataPtr(ElementRef element, size_t elementFieldSize) const {
     iassert(sizeof(T) == componentSize(fieldData->type->getComponentType()));
-    return &static_cast<T*>(data)[element.ident * elementFieldSize];
+    size_t offset = fieldData->layout.getOffset(element.ident,elementFieldSize);
+    return &static_cast<T*>(data)[offset];
+  }
+
+  /// The distance between consecutive components of an element's tensor.
+  inline size_t getComponentStride() const {
+    return fieldData->layout.getStride(fieldData->set->capacity);
   }
 
   Set::FieldData *fieldData;
@@ -817,15 +950,137 @@ private:
   friend Set;
 };
 
+/// A view of the tensors of all the elements of a field, for copying them in
+/// and out in bulk or handing them to other libraries. The tensor of element
+/// e starts at getPointer()[e*getElementStride()], and its components are
+/// getComponentStride() apart. Tensors of AoSoA fields are tiled instead, so
+/// they can only be copied. Like field references, views stay valid when the
+/// set grows, and their extent follows the size of the set.
+template <typename T, int... dimensions>
+class FieldView : public FieldRefBase {
+public:
+  /// Return the number of components of each element's tensor.
+  static size_t getBlockSize() {
+    return util::product<dimensions...>::value;
+  }
+
+  /// Return the number of elements in the view.
+  int getExtent() const {
+    return fieldData->set->getSize();
+  }
+
+  T *getPointer() {
+    return static_cast<T*>(getData());
+  }
+
+  const T *getPointer() const {
+    return static_cast<const T*>(getData());
+  }
+
+  /// Return the distance, in components, between the tensors of consecutive
+  /// elements.
+  size_t getElementStride() const {
+    if (getBlockSize() == 1) {
+      return 1;
+    }
+    switch (getLayout().getKind()) {
+      case FieldLayout::AoS:
+        return getBlockSize();
+      case FieldLayout::SoA:
+        return 1;
+      case FieldLayout::AoSoA:
+        uerror << "The tensors of AoSoA field " << fieldData->name
+               << " are tiled, so they have no element stride";
+    }
+    return 0;
+  }
+
+  /// Return the distance, in components, between consecutive components of
+  /// an element's tensor.
+  size_t getComponentStride() const {
+    return FieldRefBase::getComponentStride();
+  }
+
+  /// Return true if the tensors are stored one after another, as they are in
+  /// the buffers of copyTo and copyFrom.
+  bool isContiguous() const {
+    return getBlockSize() == 1 || getLayout().getKind() == FieldLayout::AoS;
+  }
+
+  /// Copy the tensors of all the elements to `dst`, one after another.
+  void copyTo(T *dst) const {
+    const size_t blockSize = getBlockSize();
+    const size_t n = getExtent();
+    const T *src = getPointer();
+    if (isContiguous()) {
+      memcpy(dst, src, n * blockSize * sizeof(T));
+      return;
+    }
+    // Transpose each tile of `width` elements, which are SoA within the tile
+    const size_t width = (getLayout().getKind() == FieldLayout::SoA)
+                         ? n : getLayout().getLaneWidth();
+    const size_t stride = getComponentStride();
+    for (size_t tile = 0; tile < n; tile += width) {
+      const size_t lanes = std::min(width, n - tile);
+      const T *tileSrc = src + getLayout().getOffset(tile, blockSize);
+      T *tileDst = dst + tile*blockSize;
+      for (size_t c = 0; c < blockSize; ++c) {
+        for (size_t e = 0; e < lanes; ++e) {
+          tileDst[e*blockSize + c] = tileSrc[c*stride + e];
+        }
+      }
+    }
+  }
+
+  /// Copy the tensors of all the elements from `src`, where they are stored
+  /// one after another.
+  void copyFrom(const T *src) {
+    const size_t blockSize = getBlockSize();
+    const size_t n = getExtent();
+    T *dst = getPointer();
+    if (isContiguous()) {
+      memcpy(dst, src, n * blockSize * sizeof(T));
+      return;
+    }
+    const size_t width = (getLayout().getKind() == FieldLayout::SoA)
+                         ? n : getLayout().getLaneWidth();
+    const size_t stride = getComponentStride();
+    for (size_t tile = 0; tile < n; tile += width) {
+      const size_t lanes = std::min(width, n - tile);
+      T *tileDst = dst + getLayout().getOffset(tile, blockSize);
+      const T *tileSrc = src + tile*blockSize;
+      for (size_t c = 0; c < blockSize; ++c) {
+        for (size_t e = 0; e < lanes; ++e) {
+          tileDst[c*stride + e] = tileSrc[e*blockSize + c];
+        }
+      }
+    }
+  }
+
+private:
+  FieldView(const FieldRefBase& field) : FieldRefBase(field) {
+    iassert(sizeof(T) == componentSize(fieldData->type->getComponentType()));
+  }
+
+  friend class FieldRefBaseParameterized<T, dimensions...>;
+};
+
 template <typename T, int... dimensions>
 class FieldRefBaseParameterized : public FieldRefBase {
  public:
+  /// Return a view of the tensors of all the elements of the field.
+  FieldView<T, dimensions...> view() const {
+    return FieldView<T, dimensions...>(*this);
+  }
+
   TensorRef<T, dimensions...> get(ElementRef element) {
-    return TensorRef<T, dimensions...>(getElemDataPtr(element));
+    return TensorRef<T, dimensions...>(getElemDataPtr(element),
+                                       this->getComponentStride());
   }
 
   const TensorRef<T, dimensions...> get(ElementRef element) const {
-    return TensorRef<T, dimensions...>(getElemDataPtr(element));
+    return TensorRef<T, dimensions...>(getElemDataPtr(element),
+                                       this->getComponentStride());
   }
 
   TensorRef<T, dimensions...> operator()(ElementRef element) {
@@ -840,9 +1095,10 @@ class FieldRefBaseParameterized : public FieldRefBase {
     iassert(values.size() == (TensorRef<T,dimensions...>::getSize()))
         << "Incorrect number of init values";
     T *elemData = this->getElemDataPtr(element);
+    size_t stride = this->getComponentStride();
     size_t i=0;
     for (T val : values) {
-      elemData[i++] = val;
+      elemData[stride*i++] = val;
     }
   }
 
@@ -852,9 +1108,10 @@ class FieldRefBaseParameterized : public FieldRefBase {
         << "Incorrect number of init values : " << 
         (TensorRef<T,dimensions...>::getSize());
     T *elemData = this->getElemDataPtr(element);
+    size_t stride = this->getComponentStride();
     size_t i=0;
     for (T val : values) {
-      elemData[i++] = val;
+      elemData[stride*i++] = val;
     }
   }
 
@@ -951,7 +1208,7 @@ public:
     iassert(vals.size() == util::product<Dimensions...>::value);
     size_t i=0;
     for (ComponentType val : vals) {
-      data[i++] = val;
+      data[stride*i++] = val;
     }
     return *this;
   }
@@ -960,14 +1217,16 @@ public:
   inline ComponentType& operator()(Indices... index) {
     static_assert(sizeof...(index) == sizeof...(Dimensions),
                   "Incorrect number of indices used to index tensor");
-    return data[util::computeOffset(util::seq<Dimensions...>(), index...)];
+    return data[stride *
+                util::computeOffset(util::seq<Dimensions...>(), index...)];
   }
 
   template <typename... Indices> inline
   const ComponentType& operator()(Indices... index) const {
     static_assert(sizeof...(index) == sizeof...(Dimensions),
                   "Incorrect number of indices used to index tensor");
-    return data[util::computeOffset(util::seq<Dimensions...>(), index...)];
+    return data[stride *
+                util::computeOffset(util::seq<Dimensions...>(), index...)];
   }
 
   friend bool operator==(const TensorRef& l, const TensorRef& r){
@@ -979,8 +1238,10 @@ public:
   }
 
 private:
-  inline TensorRef(ComponentType *data) : data(data) {}
+  inline TensorRef(ComponentType *data, size_t stride)
+      : data(data), stride(stride) {}
   ComponentType *data;
+  size_t stride;    // distance between consecutive components
 
   friend class FieldRefBaseParameterized<ComponentType, Dimensions...>;
 };
@@ -1017,7 +1278,7 @@ public:
   }
 
 private:
-  inline TensorRef(ComponentType *data) : data(data) {}
+  inline TensorRef(ComponentType *data, size_t) : data(data) {}
   ComponentType* data;
 
   friend class FieldRefBaseParameterized<ComponentType>;
@@ -0,0 +1,169 @@
+#include "grid_ops.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ir_rewriter.h"
+#include "ir_visitor.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+/// Returns the dimension `expr` reads if it is a grid dimension, or -1.
+static int getGridDim(Expr expr) {
+  if (!isa<IndexRead>(expr)) {
+    return -1;
+  }
+  const IndexRead* read = to<IndexRead>(expr);
+  return (read->kind == IndexRead::GridDim) ? (int)read->index : -1;
+}
+
+/// Rewrites the periodic wraps ((x+c)%n+n)%n of grid coordinates x into the
+/// dimension of size n to x+c, and records the largest |c| of each dimension.
+class GridWrapRemover : public IRRewriter {
+public:
+  GridWrapRemover(const vector<Var>& gridVars)
+      : gridVars(gridVars), radius(gridVars.size(), 0) {}
+
+  const vector<int>& getRadius() const {return radius;}
+
+private:
+  const vector<Var>& gridVars;
+  vector<int> radius;
+
+  using IRRewriter::visit;
+
+  void visit(const Rem* op) {
+    const int dim = getGridDim(op->b);
+    if (dim >= 0 && isa<Add>(op->a)) {
+      const Add* add = to<Add>(op->a);
+      if (getGridDim(add->b) == dim && isa<Rem>(add->a) &&
+          getGridDim(to<Rem>(add->a)->b) == dim) {
+        Expr coord = to<Rem>(add->a)->a;
+        int offset;
+        if (isOffsetCoord(coord, dim, &offset)) {
+          radius[dim] = max(radius[dim], abs(offset));
+          expr = coord;
+          return;
+        }
+      }
+    }
+    IRRewriter::visit(op);
+  }
+
+  /// Returns true if `expr` is the coordinate of dimension `dim` plus a
+  /// literal offset.
+  bool isOffsetCoord(Expr expr, int dim, int* offset) {
+    if (dim >= (int)gridVars.size()) {
+      return false;
+    }
+    *offset = 0;
+    if (isa<Add>(expr)) {
+      const Add* add = to<Add>(expr);
+      if (!isa<Literal>(add->b) || !isInt(add->b.type())) {
+        return false;
+      }
+      *offset = to<Literal>(add->b)->getIntVal(0);
+      expr = add->a;
+    }
+    return isa<VarExpr>(expr) && to<VarExpr>(expr)->var == gridVars[dim];
+  }
+};
+
+/// Returns true if `stmt` takes any index modulo a grid dimension.
+static bool hasGridWraps(Stmt stmt) {
+  bool wraps = false;
+  match(stmt,
+    function<void(const Rem*)>([&](const Rem* op) {
+      if (getGridDim(op->b) >= 0) {
+        wraps = true;
+      }
+    })
+  );
+  return wraps;
+}
+
+Stmt makeGridLoops(Expr gridSet, const vector<Var>& gridVars, Var pointVar,
+                   Stmt body, bool skipGhosts) {
+  iassert(gridSet.type().isGridSet());
+  const GridSetType* setType = gridSet.type().toGridSet();
+  const int ndims = setType->dimensions;
+  iassert((int)gridVars.size() == ndims);
+
+  GridWrapRemover remover(gridVars);
+  Stmt interiorBody = remover.rewrite(body);
+  const vector<int>& radius = remover.getRadius();
+  const bool affine = !hasGridWraps(interiorBody);
+
+  auto dimSize = [&](int i) {
+    return IndexRead::make(gridSet, IndexRead::GridDim, i);
+  };
+
+  // Maps through ghost grids skip the ghost layer, so their stencils only
+  // reach points inside the grid and never need to wrap
+  if (skipGhosts && setType->boundary == GridSetType::Ghost) {
+    for (int i = 0; i < ndims; ++i) {
+      uassert(radius[i] <= 1)
+          << "Maps through the ghost grid " << gridSet << " may only reach "
+          << "points one point away, since the ghost layer is one point wide";
+    }
+    vector<Expr> coords(gridVars.begin(), gridVars.end());
+    Stmt loop = Block::make(
+        AssignStmt::make(pointVar, getGridPointCoord(coords, gridSet)),
+        affine ? interiorBody : body);
+    for (int i = 0; i < ndims; ++i) {
+      loop = ForRange::make(gridVars[i], 1, dimSize(i) - 1, loop);
+    }
+    return loop;
+  }
+
+  // Points are visited in order, so the point index is advanced by one
+  auto advance = [&](Stmt stmt) {
+    return Block::make(stmt,
+                       AssignStmt::make(pointVar, 1, CompoundOperator::Add));
+  };
+  Stmt boundaryBody = advance(body);
+  Stmt loop = ForRange::make(gridVars[0], 0, dimSize(0), boundaryBody);
+
+  // The innermost loop of the rows whose outer coordinates are interior is
+  // split into boundary, interior and boundary ranges
+  const bool split =
+      affine && any_of(radius.begin(), radius.end(), [](int r){return r>0;});
+  if (split) {
+    Stmt innerBody = advance(interiorBody);
+    const int r = radius[0];
+    Stmt splitLoop;
+    Expr interior;
+    if (r == 0) {
+      splitLoop = ForRange::make(gridVars[0], 0, dimSize(0), innerBody);
+    }
+    else {
+      splitLoop = Block::make({
+          ForRange::make(gridVars[0], 0, r, boundaryBody),
+          ForRange::make(gridVars[0], r, dimSize(0) - r, innerBody),
+          ForRange::make(gridVars[0], dimSize(0) - r, dimSize(0),
+                         boundaryBody)});
+      // The ranges only partition rows that are longer than the boundaries
+      interior = Lt::make(2*r, dimSize(0));
+    }
+    for (int i = 1; i < ndims; ++i) {
+      if (radius[i] == 0) {
+        continue;
+      }
+      Expr inside = And::make(Ge::make(gridVars[i], radius[i]),
+                              Lt::make(gridVars[i], dimSize(i) - radius[i]));
+      interior = interior.defined() ? And::make(interior, inside) : inside;
+    }
+    loop = interior.defined() ? IfThenElse::make(interior, splitLoop, loop)
+                              : splitLoop;
+  }
+
+  for (int i = 1; i < ndims; ++i) {
+    loop = ForRange::make(gridVars[i], 0, dimSize(i), loop);
+  }
+  return Block::make(AssignStmt::make(pointVar, 0), loop);
+}
+
+}}
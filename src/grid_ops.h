@@ -144,6 +144,18 @@ inline vector<Expr> getGridEdgeOffsetIndices(
   return indices;
 }
 
+/// Build the loops of a map through `gridSet`, which runs `body` for the grid
+/// points with the coordinates `gridVars` (innermost first) and linear index
+/// `pointVar`. `body` must offset the coordinates with
+/// getGridPointOffsetIndices and getGridEdgeOffsetIndices.
+///
+/// The loops are split into an interior region, where the offset coordinates
+/// are affine in `gridVars` and need no modulus, and the thin boundary regions
+/// around it. If `skipGhosts` is set and the grid is a Ghost grid, the loops
+/// only visit its interior points.
+Stmt makeGridLoops(Expr gridSet, const vector<Var>& gridVars, Var pointVar,
+                   Stmt body, bool skipGhosts);
+
 }} // namespace simit::ir
 
 #endif // SIMIT_GRID_OPS
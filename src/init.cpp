@@ -2,4 +2,8 @@
 
 namespace simit {
 bool kIndexlessStencils;
+int kNumThreads = 0;
+int kGatherMaxArity = 2;
+std::string kCacheDir;
+size_t kCacheMaxBytes = 256 << 20;
 }
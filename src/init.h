@@ -13,12 +13,30 @@ namespace simit {
 extern const std::vector<std::string> VALID_BACKENDS;
 extern std::string kBackend;
 extern bool kIndexlessStencils;
+extern int kNumThreads;
+extern int kGatherMaxArity;
+extern std::string kCacheDir;
+extern size_t kCacheMaxBytes;
 
 // Settings struct with default values
 struct Settings {
   std::string backend="cpu";
   int floatSize = 8;
   bool indexlessStencils = false;
+  /// Number of threads the "cpu-parallel" backend runs set loops on. Zero
+  /// means one thread per hardware thread.
+  int numThreads = 0;
+  /// The "cpu-parallel" backend lowers vector assemblies over edge sets with at
+  /// most this many endpoints to loops over the endpoint set that gather from
+  /// incident edges, instead of scattering from the edges. Gathering recomputes
+  /// each edge once per endpoint, so it only pays off for low arities.
+  int gatherMaxArity = 2;
+  /// Directory in which the machine code of compiled functions is cached
+  /// across processes. Empty disables the cache.
+  std::string cacheDir = "";
+  /// The size the cache directory is kept within, by evicting the least
+  /// recently used functions.
+  size_t cacheMaxBytes = 256 << 20;
 };
 
 inline void init(const Settings& settings) {
@@ -36,6 +54,20 @@ inline void init(const Settings& settings) {
 
   // indexlessStencils
   kIndexlessStencils = settings.indexlessStencils;
+
+  // numThreads
+  uassert(settings.numThreads >= 0)
+      << "Invalid number of threads: " << settings.numThreads;
+  kNumThreads = settings.numThreads;
+
+  // gatherMaxArity
+  uassert(settings.gatherMaxArity >= 0)
+      << "Invalid gather arity: " << settings.gatherMaxArity;
+  kGatherMaxArity = settings.gatherMaxArity;
+
+  // cache
+  kCacheDir = settings.cacheDir;
+  kCacheMaxBytes = settings.cacheMaxBytes;
 }
 
 inline void init(std::string backend="cpu", int floatSize=8) {
@@ -21,6 +21,8 @@
 using namespace std;
 
 namespace simit {
+extern std::string kBackend;
+
 namespace ir {
 
 bool CallRewriter::shouldInline(const CallStmt *op) {
@@ -506,6 +508,19 @@ static bool isHomogeneous(const std::vector<Expr*>& endpointSets) {
   return true;
 }
 
+/// True iff the locations of `index`'s non-zeros can be read from its
+/// precomputed location table when mapping over `target`. Tables are built by
+/// the CPU backends for indices whose path expression goes through an edge set.
+static bool hasLocationTable(const TensorIndex& index, Expr target) {
+  if (kBackend == "gpu" || index.getKind() != TensorIndex::PExpr ||
+      !isa<VarExpr>(target)) {
+    return false;
+  }
+  pe::Set edgeSet = pe::getEdgeSet(index.getPathExpression());
+  return edgeSet.defined() &&
+         edgeSet.getName() == to<VarExpr>(target)->var.getName();
+}
+
 /// Emit code to gather the locations of the result vv matrices:
 /// ~~~~~~~~~~~~~~~
 ///   % Gather locs from As_index
@@ -518,9 +533,14 @@ static bool isHomogeneous(const std::vector<Expr*>& endpointSets) {
 ///     end
 ///   end
 /// ~~~~~~~~~~~~~~~
+/// or, for homogeneous edge sets with a location table, to read them from it:
+/// ~~~~~~~~~~~~~~~
+///       .As_index_locs(i,j) = As_index.locs[((e * 2) + i) * 2 + j];
+/// ~~~~~~~~~~~~~~~
 /// (Locations for matrices with the same index are only computed once.)
 static Stmt gatherVVLocs(TensorIndex index, const std::vector<Expr*> &endpoints,
-                         const std::vector<IndexSet> &dims, Var eps,
+                         const std::vector<IndexSet> &dims, Expr target,
+                         Var eps, Var lv,
                          std::map<TensorIndex,Var>* indexToLocs) {
   const int cardinality = endpoints.size();
 
@@ -544,6 +564,11 @@ static Stmt gatherVVLocs(TensorIndex index, const std::vector<Expr*> &endpoints,
   Stmt locsInit = Block::make({locStmt, TensorWrite::make(locs,{i,j}, locVar)});
 
   if (isHomogeneous(endpoints)) {
+    if (hasLocationTable(index, target)) {
+      Expr table = index.getLocationsArray();
+      Expr loc = Load::make(table, (lv*cardinality + i)*cardinality + j);
+      locsInit = TensorWrite::make(locs, {i,j}, loc);
+    }
     Stmt locsInitLoop = ForRange::make(j, 0, cardinality, locsInit);
     locsInitLoop      = ForRange::make(i, 0, cardinality, locsInitLoop);
     
@@ -588,9 +613,13 @@ static Stmt gatherVVLocs(TensorIndex index, const std::vector<Expr*> &endpoints,
 ///     ...
 ///   end
 /// ~~~~~~~~~~~~~~~
+/// or, for homogeneous edge sets with a location table, to read them from it:
+/// ~~~~~~~~~~~~~~~
+///       .As_index_locs(i) = As_index.locs[(e * 2) + i];
+/// ~~~~~~~~~~~~~~~
 /// (Locations for matrices with the same index are only computed once.)
 static Stmt gatherVELocs(TensorIndex index, const std::vector<Expr*> &endpoints, 
-                         IndexSet vDim, Var eps, Var lv,
+                         IndexSet vDim, Expr target, Var eps, Var lv,
                          std::map<TensorIndex,Var>* indexToLocs) {
   const int cardinality = endpoints.size();
 
@@ -611,6 +640,11 @@ static Stmt gatherVELocs(TensorIndex index, const std::vector<Expr*> &endpoints,
   Stmt locsInit = Block::make({locStmt, TensorWrite::make(locs,{i}, locVar)});
 
   if (isHomogeneous(endpoints)) {
+    if (hasLocationTable(index, target)) {
+      Expr table = index.getLocationsArray();
+      Expr loc = Load::make(table, lv*cardinality + i);
+      locsInit = TensorWrite::make(locs, {i}, loc);
+    }
     Stmt locsInitLoop = ForRange::make(i, 0, cardinality, locsInit);
 
     return Block::make(locsDecl, locsInitLoop);
@@ -747,11 +781,12 @@ Stmt inlineMapFunction(const Map *map, Var lv, vector<Var> ivs,
         Stmt gatherLocs;
         if (dims[0] != target && dims[1] != target) {
           // vv matrix
-          gatherLocs = gatherVVLocs(index, endpoints, dims, eps, &indexToLocs);
+          gatherLocs = gatherVVLocs(index, endpoints, dims, target, eps, lv,
+                                    &indexToLocs);
         }
         else if (dims[0] != target && dims[1] == target) {
           // ve matrix
-          gatherLocs = gatherVELocs(index, endpoints, dims[0], eps, lv, 
+          gatherLocs = gatherVELocs(index, endpoints, dims[0], target, eps, lv,
                                     &indexToLocs);
         }
         else if (dims[0] == target && dims[1] != target) {
@@ -855,14 +890,8 @@ Stmt inlineMap(const Map *map, MapFunctionRewriter &rewriter,
   }
   else {
     iassert(map->through.type().isGridSet());
-    initializers.push_back(AssignStmt::make(loopVar, 0));
-    int dims = map->through.type().toGridSet()->dimensions;
-    loop = Block::make(inlinedMapFunc, AssignStmt::make(
-        loopVar, 1, CompoundOperator::Add));
-    for (int i = 0; i < dims; ++i) {
-      loop = ForRange::make(gridIndexVars[i], 0, IndexRead::make(
-          map->through, IndexRead::GridDim, i), loop);
-    }
+    loop = makeGridLoops(map->through, gridIndexVars, loopVar, inlinedMapFunc,
+                         true);
   }
   
   if (initializers.size() > 0) {
@@ -877,7 +906,19 @@ Stmt inlineMap(const Map *map, MapFunctionRewriter &rewriter,
     for (auto &var : map->vars) {
       iassert(var.getType().isTensor());
       Stmt init = AssignStmt::make(var, var);
-      init = initializeLhsToZero(init);
+      if (map->reduction.getKind() == ReductionOperator::Sum ||
+          isScalar(var.getType())) {
+        init = initializeLhsToIdentity(init, map->reduction);
+      }
+      else {
+        // Only zero can be memset, so other identities are written by loops
+        if (isSystemTensorType(var.getType()) &&
+            var.getType().toTensor()->order() > 1) {
+          not_supported_yet << "reduce " << map->reduction
+                            << " into system matrices";
+        }
+        init = initializeTensorToIdentity(init, map->reduction);
+      }
       inlinedMap = Block::make(init, inlinedMap);
     }
   }
@@ -1,8 +1,10 @@
 #include "intrinsics.h"
 
 #include <cassert>
+#include <vector>
 #include "var.h"
 #include "func.h"
+#include "util/collections.h"
 
 namespace simit {
 namespace ir {
@@ -511,6 +513,38 @@ const Func& lltmatsolve() {
   return lltmatsolveVar;
 }
 
+static Func pcgVar;
+void pcgInit() {
+  pcgVar = Func("pcg",
+                {Var("A", Type()), Var("b", Type()), Var("x0", Type()),
+                 Var("tol", Float), Var("maxiter", Int)},
+                {Var("x", Type()), Var("iterations", Int),
+                 Var("residual", Float)},
+                Func::External);
+}
+const Func& pcg() {
+  if (!pcgVar.defined()) {
+    pcgInit();
+  }
+  return pcgVar;
+}
+
+static Func iccgVar;
+void iccgInit() {
+  iccgVar = Func("iccg",
+                 {Var("A", Type()), Var("b", Type()), Var("x0", Type()),
+                  Var("tol", Float), Var("maxiter", Int)},
+                 {Var("x", Type()), Var("iterations", Int),
+                  Var("residual", Float)},
+                 Func::External);
+}
+const Func& iccg() {
+  if (!iccgVar.defined()) {
+    iccgInit();
+  }
+  return iccgVar;
+}
+
 static Func strcmpVar;
 void strcmpInit() {
   strcmpVar = Func("strcmp",
@@ -676,6 +710,8 @@ const std::map<std::string,Func> &byNames() {
     cholfreeInit();
     lltsolveInit();
     lltmatsolveInit();
+    pcgInit();
+    iccgInit();
     strcmpInit();
     strlenInit();
     strcpyInit();
@@ -720,6 +756,8 @@ const std::map<std::string,Func> &byNames() {
                       {"cholfree", cholfreeVar},
                       {"lltsolve", lltsolveVar},
                       {"lltmatsolve", lltmatsolveVar},
+                      {"pcg", pcgVar},
+                      {"iccg", iccgVar},
                       {"strcmp", strcmpVar},
                       {"strlen", strlenVar},
                       {"strcpy", strcpyVar},
@@ -733,4 +771,14 @@ const std::map<std::string,Func> &byNames() {
   return byNameMap;
 }
 
+bool isPure(const Func& func) {
+  static const std::vector<Func> pure = {
+    mod(), sin(), cos(), tan(), asin(), acos(), atan2(), sqrt(), cbrt(), log(),
+    exp(), pow(), createComplex(), complexNorm(), complexConj(),
+    complexGetReal(), complexGetImag(), norm(), dot(), det(), det2(), det4(),
+    inv(), inv2(), inv4(), cross(), strcmp(), strlen(), loc()
+  };
+  return util::contains(pure, func);
+}
+
 }}}
@@ -58,6 +58,8 @@ const Func& chol();
 const Func& cholfree();
 const Func& lltsolve();
 const Func& lltmatsolve();
+const Func& pcg();
+const Func& iccg();
 
 // String manipulation
 const Func& strcmp();
@@ -76,5 +78,9 @@ const Func& loc();
 
 const std::map<std::string,Func> &byNames();
 
+/// True iff `func` is an intrinsic without side effects, whose results only
+/// depend on its arguments.
+bool isPure(const Func& func);
+
 }}}
 #endif
@@ -151,6 +151,14 @@ Type getFieldType(Expr elementOrSet, std::string fieldName) {
   return fieldType;
 }
 
+FieldLayout getFieldLayout(Expr elementOrSet, std::string fieldName) {
+  iassert(elementOrSet.type().isElement() || elementOrSet.type().isSet());
+  const ElementType *elemType = elementOrSet.type().isElement()
+      ? elementOrSet.type().toElement()
+      : elementOrSet.type().toSet()->elementType.toElement();
+  return elemType->field(fieldName).layout;
+}
+
 Type getBlockType(Expr tensor) {
   iassert(tensor.type().isTensor());
   return tensor.type().toTensor()->getBlockType();
@@ -182,10 +190,39 @@ std::ostream &operator<<(std::ostream &os, const CompoundOperator &cop) {
       os << "-";
       break;
     }
+    case CompoundOperator::Mul: {
+      os << "*";
+      break;
+    }
+    case CompoundOperator::Max: {
+      os << "max";
+      break;
+    }
+    case CompoundOperator::Min: {
+      os << "min";
+      break;
+    }
   }
   return os;
 }
 
+CompoundOperator getCompoundOperator(const ReductionOperator &rop) {
+  switch (rop.getKind()) {
+    case ReductionOperator::Sum:
+      return CompoundOperator::Add;
+    case ReductionOperator::Product:
+      return CompoundOperator::Mul;
+    case ReductionOperator::Max:
+      return CompoundOperator::Max;
+    case ReductionOperator::Min:
+      return CompoundOperator::Min;
+    case ReductionOperator::Undefined:
+      return CompoundOperator::None;
+  }
+  unreachable;
+  return CompoundOperator::None;
+}
+
 // struct Literal
 void Literal::cast(Type type) {
   iassert(type.isTensor());
@@ -494,10 +531,13 @@ Expr IndexRead::make(Expr edgeSet, Kind kind) {
   iassert(edgeSet.type().isSet());
 
   IndexRead *node = new IndexRead;
-  node->type = TensorType::make(ScalarType(ScalarType::Int),
-                                {IndexDomain(IndexSet(edgeSet))});
+  node->type = (kind == Capacity)
+      ? TensorType::make(ScalarType(ScalarType::Int))
+      : TensorType::make(ScalarType(ScalarType::Int),
+                         {IndexDomain(IndexSet(edgeSet))});
   node->edgeSet = edgeSet;
   node->kind = kind;
+  node->index = 0;
   return node;
 }
 
@@ -134,15 +134,21 @@ inline const S* to(Stmt s) {
 
 // Type compute functions
 Type getFieldType(Expr elementOrSet, std::string fieldName);
+FieldLayout getFieldLayout(Expr elementOrSet, std::string fieldName);
 Type getBlockType(Expr tensor);
 Type getIndexExprType(std::vector<IndexVar> lhsIndexVars, Expr expr, 
                       bool isColumnVector);
 
 
 /// CompoundOperator used with AssignStmt, TensorWrite, FieldWrite and Store.
-enum class CompoundOperator { None, Add, Sub };
+/// Max and Min write the larger/smaller of the old and the new value.
+enum class CompoundOperator { None, Add, Sub, Mul, Max, Min };
 std::ostream &operator<<(std::ostream &os, const CompoundOperator &);
 
+/// Returns the compound operator that combines a value into the result of a
+/// reduction, or None if the reduction operator is undefined.
+CompoundOperator getCompoundOperator(const ReductionOperator &rop);
+
 
 /// Represents a \ref Tensor that is defined as a constant or loaded.  Note
 /// that it is only possible to define dense tensor literals.
@@ -203,9 +209,11 @@ struct Length : public ExprNode {
 };
 
 /// An IndexRead retrieves an index from an edge set.  An example of an index
-/// is the endpoints of the edges in the set.
+/// is the endpoints of the edges in the set. A Capacity read retrieves the
+/// number of elements the set's field arrays have room for, which is the
+/// stride between the component arrays of SoA fields.
 struct IndexRead : public ExprNode {
-  enum Kind { Endpoints, GridDim };
+  enum Kind { Endpoints, GridDim, Capacity };
   Expr edgeSet;
   Kind kind;
   unsigned int index;
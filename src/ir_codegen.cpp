@@ -1,5 +1,6 @@
 #include "ir_codegen.h"
 
+#include <limits>
 #include <vector>
 
 #include "ir_rewriter.h"
@@ -12,44 +13,105 @@ using namespace std;
 namespace simit {
 namespace ir {
 
-Expr getZeroVal(const TensorType *type) {
-  switch (type->getComponentType().kind) {
-    case ScalarType::Int:
-      return Literal::make(0);
-    case ScalarType::Float:
-      return Literal::make(0.0);
-    case ScalarType::Boolean:
-      return Literal::make(false);
-    case ScalarType::Complex:
-      return Literal::make(double_complex(0.0, 0.0));
-    default:
-      unreachable;
-      return Expr();
+Expr getIdentityVal(const TensorType *type, ReductionOperator rop) {
+  const ScalarType::Kind kind = type->getComponentType().kind;
+  switch (rop.getKind()) {
+    case ReductionOperator::Sum:
+      switch (kind) {
+        case ScalarType::Int:
+          return Literal::make(0);
+        case ScalarType::Float:
+          return Literal::make(0.0);
+        case ScalarType::Boolean:
+          return Literal::make(false);
+        case ScalarType::Complex:
+          return Literal::make(double_complex(0.0, 0.0));
+        default:
+          break;
+      }
+      break;
+    case ReductionOperator::Product:
+      switch (kind) {
+        case ScalarType::Int:
+          return Literal::make(1);
+        case ScalarType::Float:
+          return Literal::make(1.0);
+        case ScalarType::Complex:
+          return Literal::make(double_complex(1.0, 0.0));
+        default:
+          break;
+      }
+      break;
+    case ReductionOperator::Max:
+      switch (kind) {
+        case ScalarType::Int:
+          return Literal::make(numeric_limits<int>::min());
+        case ScalarType::Float:
+          return Literal::make(-numeric_limits<double>::infinity());
+        default:
+          break;
+      }
+      break;
+    case ReductionOperator::Min:
+      switch (kind) {
+        case ScalarType::Int:
+          return Literal::make(numeric_limits<int>::max());
+        case ScalarType::Float:
+          return Literal::make(numeric_limits<double>::infinity());
+        default:
+          break;
+      }
+      break;
+    case ReductionOperator::Undefined:
+      break;
   }
+  not_supported_yet << "reduce " << rop << " over "
+                    << type->getComponentType() << " values";
+  return Expr();
 }
 
 Stmt initializeLhsToZero(Stmt stmt) {
-  class ReplaceRhsWithZero : public IRRewriter {
+  return initializeLhsToIdentity(stmt, ReductionOperator::Sum);
+}
+
+Stmt initializeLhsToIdentity(Stmt stmt, ReductionOperator rop) {
+  class ReplaceRhsWithIdentity : public IRRewriter {
+  public:
+    ReplaceRhsWithIdentity(ReductionOperator rop) : rop(rop) {}
+
+  private:
+    ReductionOperator rop;
+
     void visit(const AssignStmt *op) {
-      Expr zeroVal = getZeroVal(op->var.getType().toTensor());
-      stmt = AssignStmt::make(op->var, zeroVal);
+      Expr identityVal = getIdentityVal(op->var.getType().toTensor(), rop);
+      stmt = AssignStmt::make(op->var, identityVal);
     }
 
     void visit(const FieldWrite *op) {
-      Expr zeroVal = getZeroVal(op->value.type().toTensor());
-      stmt = FieldWrite::make(op->elementOrSet, op->fieldName, zeroVal);
+      Expr identityVal = getIdentityVal(op->value.type().toTensor(), rop);
+      stmt = FieldWrite::make(op->elementOrSet, op->fieldName, identityVal);
     }
 
     void visit(const TensorWrite *op) {
-      Expr zeroVal = getZeroVal(op->tensor.type().toTensor());
-      stmt = TensorWrite::make(op->tensor, op->indices, zeroVal);
+      Expr identityVal = getIdentityVal(op->tensor.type().toTensor(), rop);
+      stmt = TensorWrite::make(op->tensor, op->indices, identityVal);
     }
   };
-  return ReplaceRhsWithZero().rewrite(stmt);
+  return ReplaceRhsWithIdentity(rop).rewrite(stmt);
 }
 
 Stmt initializeTensorToZero(Stmt stmt) {
+  return initializeTensorToIdentity(stmt, ReductionOperator::Sum);
+}
+
+Stmt initializeTensorToIdentity(Stmt stmt, ReductionOperator rop) {
   class BuildInitLoopNest : public IRRewriter {
+  public:
+    BuildInitLoopNest(ReductionOperator rop) : rop(rop) {}
+
+  private:
+    ReductionOperator rop;
+
     Stmt makeLoopNest(Expr tensor) {
       const TensorType *ttype = tensor.type().toTensor();
       std::vector<Var> indices;
@@ -67,7 +129,8 @@ Stmt initializeTensorToZero(Stmt stmt) {
         stmt = makeLoopNest(TensorRead::make(tensor, indicesExpr));
       }
       else {
-        stmt = TensorWrite::make(tensor, indicesExpr, getZeroVal(ttype));
+        stmt = TensorWrite::make(tensor, indicesExpr,
+                                 getIdentityVal(ttype, rop));
       }
 
       // Wrap in current level loops
@@ -85,7 +148,7 @@ Stmt initializeTensorToZero(Stmt stmt) {
       stmt = makeLoopNest(FieldRead::make(op->elementOrSet, op->fieldName));
     }
   };
-  return BuildInitLoopNest().rewrite(stmt);
+  return BuildInitLoopNest(rop).rewrite(stmt);
 }
 
 Stmt find(const Var &result, const std::vector<Expr> &exprs, string name,
@@ -14,6 +14,18 @@ Stmt initializeLhsToZero(Stmt stmt);
 /// Build a loop nest to assign all components of lhs to zero
 Stmt initializeTensorToZero(Stmt stmt);
 
+/// Returns the identity of the reduction operator for the component type of
+/// the tensor type (e.g. 1 for products and -inf for float maxima).
+Expr getIdentityVal(const TensorType *type, ReductionOperator rop);
+
+/// Create a simple assign to the identity of the reduction operator
+/// (regardless of lhs dimensions)
+Stmt initializeLhsToIdentity(Stmt stmt, ReductionOperator rop);
+
+/// Build a loop nest to assign all components of lhs to the identity of the
+/// reduction operator
+Stmt initializeTensorToIdentity(Stmt stmt, ReductionOperator rop);
+
 /// Compute the smallest value of the given Exprs and assign the result to var.
 Stmt min(const Var &result, const std::vector<Expr> &exprs);
 
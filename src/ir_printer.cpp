@@ -199,6 +199,9 @@ void IRPrinter::visit(const IndexRead *op) {
     case IndexRead::GridDim:
       os << "griddim[" << op->index << "]";
       break;
+    case IndexRead::Capacity:
+      os << "capacity";
+      break;
     default:
       not_supported_yet;
       break;
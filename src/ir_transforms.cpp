@@ -1,6 +1,7 @@
 #include "ir_transforms.h"
 
 #include "ir_rewriter.h"
+#include "storage.h"
 #include "util/collections.h"
 
 using namespace std;
@@ -75,23 +76,49 @@ Func insertVarDecls(Func func) {
 }
 
 std::pair<Stmt,std::vector<Stmt>> removeVarDecls(Stmt stmt) {
+  return removeVarDecls(stmt, [](const For*) {return false;});
+}
+
+std::pair<Stmt,std::vector<Stmt>>
+removeVarDecls(Stmt stmt, const std::function<bool(const For*)>& keep) {
   class RemoveVarDeclsRewriter : public IRRewriter {
   public:
+    RemoveVarDeclsRewriter(const std::function<bool(const For*)>& keep)
+        : keep(keep) {}
+
     std::vector<Stmt> varDecls;
 
+  private:
+    const std::function<bool(const For*)>& keep;
+
+    using IRRewriter::visit;
+
     void visit(const VarDecl *op) {
       varDecls.push_back(op);
       stmt = Stmt();
     }
+
+    void visit(const For *op) {
+      if (keep(op)) {
+        stmt = op;
+        return;
+      }
+      IRRewriter::visit(op);
+    }
   };
-  RemoveVarDeclsRewriter rewriter;
+  RemoveVarDeclsRewriter rewriter(keep);
 
   Stmt result = rewriter.rewrite(stmt);
   return std::pair<Stmt,vector<Stmt>>(result, rewriter.varDecls);
 }
 
 Stmt moveVarDeclsToFront(Stmt stmt) {
-  std::pair<Stmt,vector<Stmt>> varDecls = removeVarDecls(stmt);
+  return moveVarDeclsToFront(stmt, [](const For*) {return false;});
+}
+
+Stmt moveVarDeclsToFront(Stmt stmt,
+                         const std::function<bool(const For*)>& keep) {
+  std::pair<Stmt,vector<Stmt>> varDecls = removeVarDecls(stmt, keep);
   return (varDecls.second.size() > 0)
       ? Block::make(Block::make(varDecls.second), varDecls.first)
       : varDecls.first;
@@ -127,4 +154,65 @@ Func makeSystemTensorsGlobal(Func func) {
   return MakeSystemTensorsGlobalRewriter().rewrite(func);
 }
 
+Func makeBufferedSystemTensorsGlobal(Func func) {
+  class MakeBufferedSystemTensorsGlobalRewriter : public IRRewriter {
+  public:
+    MakeBufferedSystemTensorsGlobalRewriter()
+        : storage(nullptr), loopDepth(0) {}
+
+  private:
+    Environment environment;
+    const Storage* storage;
+
+    /// Number of enclosing loops.
+    int loopDepth;
+
+    void visit(const Func* f) {
+      environment = f->getEnvironment();
+      storage = &f->getStorage();
+
+      Stmt body = rewrite(f->getBody());
+      if (body != f->getBody()) {
+        func = Func(f->getName(), f->getArguments(), f->getResults(), body,
+                    environment);
+        func.setStorage(f->getStorage());
+      }
+      else {
+        func = *f;
+      }
+    }
+
+    void visit(const VarDecl* op) {
+      const Var& var = op->var;
+      if (!isSystemTensorType(var.getType())) {
+        stmt = op;
+      }
+      else if (environment.hasTensorIndex(var)) {
+        environment.addTemporary(var);
+      }
+      else if (var.getType().toTensor()->order() == 1 && loopDepth == 0 &&
+               storage->hasStorage(var) &&
+               storage->getStorage(var).getKind() == TensorStorage::Dense) {
+        environment.addTemporary(var);
+      }
+      else {
+        stmt = op;
+      }
+    }
+
+    void visit(const For* op) {
+      ++loopDepth;
+      IRRewriter::visit(op);
+      --loopDepth;
+    }
+
+    void visit(const ForRange* op) {
+      ++loopDepth;
+      IRRewriter::visit(op);
+      --loopDepth;
+    }
+  };
+  return MakeBufferedSystemTensorsGlobalRewriter().rewrite(func);
+}
+
 }}
@@ -4,6 +4,7 @@
 #define SIMIT_IR_TRANSFORMS_H
 
 #include "ir.h"
+#include <functional>
 #include <vector>
 
 namespace simit {
@@ -19,13 +20,32 @@ Func insertVarDecls(Func func);
 /// the rewritten statement.
 std::pair<Stmt,std::vector<Stmt>> removeVarDecls(Stmt stmt);
 
+/// Removes the VarDecl statements from `stmt`, except those inside the loops
+/// for which `keep` returns true, and returns them together with the
+/// rewritten statement.
+std::pair<Stmt,std::vector<Stmt>>
+removeVarDecls(Stmt stmt, const std::function<bool(const For*)>& keep);
+
 /// Moves VarDecl statements from within `stmt` to in front of it.
 Stmt moveVarDeclsToFront(Stmt stmt);
 
+/// Moves VarDecl statements from within `stmt` to in front of it, except those
+/// inside the loops for which `keep` returns true, which are left in place.
+Stmt moveVarDeclsToFront(Stmt stmt,
+                         const std::function<bool(const For*)>& keep);
+
 /// Makes all the system tensors declared in the func body global variables.
 /// A system tensor is a tensor whose dimensions include at least one Simit set.
 /// The global variables are added to the resulting Funcs environment.
 Func makeSystemTensorsGlobal(Func func);
 
+/// Makes the system tensors declared in the func body that a backend keeps in
+/// buffers of their own global variables: the tensors with a tensor index,
+/// and the dense vectors declared outside of loops (the iterations of loops
+/// may run in parallel, and then each need their own copy). The global
+/// variables are added to the resulting Funcs environment as temporaries,
+/// whose memory the function can share when they are not live at once.
+Func makeBufferedSystemTensorsGlobal(Func func);
+
 }}
 #endif
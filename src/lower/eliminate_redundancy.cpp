@@ -0,0 +1,840 @@
+#include "eliminate_redundancy.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "intrinsics.h"
+#include "ir_builder.h"
+#include "ir_rewriter.h"
+#include "ir_visitor.h"
+#include "util/collections.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+/// A location is a variable, or a field of the set held by a variable. The
+/// location of a variable without a field name covers all of its fields.
+typedef pair<Var,string> Location;
+
+static bool conflicts(const Location& a, const Location& b) {
+  return a.first == b.first &&
+         (a.second.empty() || b.second.empty() || a.second == b.second);
+}
+
+static bool conflicts(const set<Location>& a, const set<Location>& b) {
+  for (const Location& location : a) {
+    for (const Location& other : b) {
+      if (conflicts(location, other)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// The locations read and written by statements and expressions. Variable
+/// declarations count as writes. The effects of statements that call
+/// functions that may have side effects are unknown.
+class Effects : public IRVisitor {
+public:
+  Effects() : unknown(false) {}
+
+  static Effects of(const Stmt& stmt) {
+    Effects effects;
+    stmt.accept(&effects);
+    return effects;
+  }
+
+  static Effects of(const Expr& expr) {
+    Effects effects;
+    expr.accept(&effects);
+    return effects;
+  }
+
+  bool unknown;
+  set<Location> reads;
+  set<Location> writes;
+
+  /// The number of statements that write each location, not counting
+  /// declarations, and the number of declarations of each variable.
+  map<Location,int> numWrites;
+  map<Var,int> numDecls;
+
+  /// The variables of the loops in the statement.
+  set<Var> loopVars;
+
+private:
+  using IRVisitor::visit;
+
+  void write(const Location& location) {
+    writes.insert(location);
+    ++numWrites[location];
+  }
+
+  /// Record a write to the tensor or field `buffer`, or to a block of it.
+  void writeBuffer(const Expr& buffer) {
+    if (isa<VarExpr>(buffer)) {
+      write(Location(to<VarExpr>(buffer)->var, ""));
+    }
+    else if (isa<FieldRead>(buffer) &&
+             isa<VarExpr>(to<FieldRead>(buffer)->elementOrSet)) {
+      const FieldRead* fieldRead = to<FieldRead>(buffer);
+      write(Location(to<VarExpr>(fieldRead->elementOrSet)->var,
+                     fieldRead->fieldName));
+    }
+    else if (isa<TensorRead>(buffer)) {
+      writeBuffer(to<TensorRead>(buffer)->tensor);
+      for (const Expr& index : to<TensorRead>(buffer)->indices) {
+        index.accept(this);
+      }
+    }
+    else {
+      unknown = true;
+    }
+  }
+
+  void visit(const VarExpr* op) {
+    reads.insert(Location(op->var, ""));
+  }
+
+  void visit(const FieldRead* op) {
+    if (isa<VarExpr>(op->elementOrSet)) {
+      reads.insert(Location(to<VarExpr>(op->elementOrSet)->var,
+                            op->fieldName));
+    }
+    else {
+      unknown = true;
+    }
+  }
+
+  void visit(const VarDecl* op) {
+    writes.insert(Location(op->var, ""));
+    ++numDecls[op->var];
+    IRVisitor::visit(op);
+  }
+
+  void visit(const AssignStmt* op) {
+    op->value.accept(this);
+    if (op->cop != CompoundOperator::None) {
+      reads.insert(Location(op->var, ""));
+    }
+    write(Location(op->var, ""));
+  }
+
+  void visit(const Store* op) {
+    op->index.accept(this);
+    op->value.accept(this);
+    if (op->cop != CompoundOperator::None) {
+      op->buffer.accept(this);
+    }
+    writeBuffer(op->buffer);
+  }
+
+  void visit(const TensorWrite* op) {
+    for (const Expr& index : op->indices) {
+      index.accept(this);
+    }
+    op->value.accept(this);
+    if (op->cop != CompoundOperator::None) {
+      op->tensor.accept(this);
+    }
+    writeBuffer(op->tensor);
+  }
+
+  void visit(const FieldWrite* op) {
+    op->value.accept(this);
+    writeBuffer(FieldRead::make(op->elementOrSet, op->fieldName));
+  }
+
+  void visit(const CallStmt* op) {
+    set<Location> globalReads;
+    if (!hasNoSideEffects(op->callee, &globalReads)) {
+      unknown = true;
+      return;
+    }
+    for (const Expr& actual : op->actuals) {
+      actual.accept(this);
+    }
+    reads.insert(globalReads.begin(), globalReads.end());
+    for (const Var& result : op->results) {
+      write(Location(result, ""));
+    }
+  }
+
+  /// True iff calling `callee` only writes its results. This holds for the
+  /// pure intrinsics, and for internal functions (e.g. element functions that
+  /// are not inlined) that only write their own variables and results, and
+  /// only make such calls themselves. The locations of globals (e.g. extern
+  /// set fields) that the callee reads are added to `globalReads`.
+  static bool hasNoSideEffects(const Func& callee, set<Location>* globalReads) {
+    switch (callee.getKind()) {
+      case Func::Intrinsic:
+        return intrinsics::isPure(callee);
+      case Func::Internal: {
+        Effects effects = Effects::of(callee.getBody());
+        if (effects.unknown) {
+          return false;
+        }
+        auto isLocal = [&](const Var& var) {
+          return util::contains(effects.numDecls, var) ||
+                 util::contains(effects.loopVars, var) ||
+                 util::contains(callee.getResults(), var);
+        };
+        for (const Location& write : effects.writes) {
+          if (!isLocal(write.first)) {
+            return false;
+          }
+        }
+        for (const Location& read : effects.reads) {
+          if (!isLocal(read.first) &&
+              !util::contains(callee.getArguments(), read.first)) {
+            globalReads->insert(read);
+          }
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  void visit(const ForRange* op) {
+    write(Location(op->var, ""));
+    loopVars.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const For* op) {
+    write(Location(op->var, ""));
+    loopVars.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Map* op) {
+    unknown = true;
+  }
+
+  void visit(const Kernel* op) {
+    unknown = true;
+  }
+};
+
+/// The index variables of one index expression that correspond to those of
+/// another.
+typedef map<IndexVar,IndexVar> IndexVarMap;
+
+template <class T>
+static bool isUnary(const Expr& a, const Expr& b, IndexVarMap* indexVars);
+
+template <class T>
+static bool isBinary(const Expr& a, const Expr& b, IndexVarMap* indexVars);
+
+/// True iff index variable `a` of one index expression corresponds to `b` of
+/// the other, given the correspondence of the variables seen so far. Variables
+/// that have not been seen correspond if they iterate over the same domain in
+/// the same way.
+static bool equal(const IndexVar& a, const IndexVar& b,
+                  IndexVarMap* indexVars) {
+  if (a == b) {
+    return true;
+  }
+  if (indexVars == nullptr || a.isFixed() || b.isFixed()) {
+    return false;
+  }
+  auto seen = indexVars->find(a);
+  if (seen != indexVars->end()) {
+    return seen->second == b;
+  }
+  if (a.isFreeVar() != b.isFreeVar() || !(a.getDomain() == b.getDomain()) ||
+      (a.isReductionVar() && !(a.getOperator() == b.getOperator()))) {
+    return false;
+  }
+  indexVars->insert({a, b});
+  return true;
+}
+
+/// True iff `a` and `b` are the same expression of variables, fields, tensor
+/// reads, scalar arithmetic and index expressions, where the index variables
+/// of index expressions may differ. Other expressions are never equal.
+static bool equal(const Expr& a, const Expr& b,
+                  IndexVarMap* indexVars=nullptr) {
+  if (a == b) {
+    return true;
+  }
+  if (!a.defined() || !b.defined() || a.type() != b.type()) {
+    return false;
+  }
+
+  if (isa<Literal>(a) && isa<Literal>(b)) {
+    return a.type().isTensor() && *to<Literal>(a) == *to<Literal>(b);
+  }
+  else if (isa<VarExpr>(a) && isa<VarExpr>(b)) {
+    return to<VarExpr>(a)->var == to<VarExpr>(b)->var;
+  }
+  else if (isa<FieldRead>(a) && isa<FieldRead>(b)) {
+    const FieldRead* aRead = to<FieldRead>(a);
+    const FieldRead* bRead = to<FieldRead>(b);
+    return aRead->fieldName == bRead->fieldName &&
+           equal(aRead->elementOrSet, bRead->elementOrSet, indexVars);
+  }
+  else if (isa<TensorRead>(a) && isa<TensorRead>(b)) {
+    const TensorRead* aRead = to<TensorRead>(a);
+    const TensorRead* bRead = to<TensorRead>(b);
+    if (!equal(aRead->tensor, bRead->tensor, indexVars) ||
+        aRead->indices.size() != bRead->indices.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < aRead->indices.size(); ++i) {
+      if (!equal(aRead->indices[i], bRead->indices[i], indexVars)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  else if (isa<Load>(a) && isa<Load>(b)) {
+    return equal(to<Load>(a)->buffer, to<Load>(b)->buffer, indexVars) &&
+           equal(to<Load>(a)->index, to<Load>(b)->index, indexVars);
+  }
+  else if (isa<IndexRead>(a) && isa<IndexRead>(b)) {
+    return to<IndexRead>(a)->kind == to<IndexRead>(b)->kind &&
+           to<IndexRead>(a)->index == to<IndexRead>(b)->index &&
+           equal(to<IndexRead>(a)->edgeSet, to<IndexRead>(b)->edgeSet,
+                 indexVars);
+  }
+  else if (isa<UnnamedTupleRead>(a) && isa<UnnamedTupleRead>(b)) {
+    return equal(to<UnnamedTupleRead>(a)->tuple,
+                 to<UnnamedTupleRead>(b)->tuple, indexVars) &&
+           equal(to<UnnamedTupleRead>(a)->index,
+                 to<UnnamedTupleRead>(b)->index, indexVars);
+  }
+  else if (isa<NamedTupleRead>(a) && isa<NamedTupleRead>(b)) {
+    return to<NamedTupleRead>(a)->elementName ==
+               to<NamedTupleRead>(b)->elementName &&
+           equal(to<NamedTupleRead>(a)->tuple, to<NamedTupleRead>(b)->tuple,
+                 indexVars);
+  }
+  else if (isa<IndexExpr>(a) && isa<IndexExpr>(b)) {
+    const IndexExpr* aExpr = to<IndexExpr>(a);
+    const IndexExpr* bExpr = to<IndexExpr>(b);
+    if (aExpr->resultVars.size() != bExpr->resultVars.size()) {
+      return false;
+    }
+    IndexVarMap exprIndexVars;
+    if (indexVars == nullptr) {
+      indexVars = &exprIndexVars;
+    }
+    for (size_t i = 0; i < aExpr->resultVars.size(); ++i) {
+      if (!equal(aExpr->resultVars[i], bExpr->resultVars[i], indexVars)) {
+        return false;
+      }
+    }
+    return equal(aExpr->value, bExpr->value, indexVars);
+  }
+  else if (isa<IndexedTensor>(a) && isa<IndexedTensor>(b)) {
+    const IndexedTensor* aTensor = to<IndexedTensor>(a);
+    const IndexedTensor* bTensor = to<IndexedTensor>(b);
+    if (!equal(aTensor->tensor, bTensor->tensor, indexVars) ||
+        aTensor->indexVars.size() != bTensor->indexVars.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < aTensor->indexVars.size(); ++i) {
+      if (!equal(aTensor->indexVars[i], bTensor->indexVars[i], indexVars)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return isUnary<Neg>(a, b, indexVars) || isUnary<Not>(a, b, indexVars) ||
+         isBinary<Add>(a, b, indexVars) || isBinary<Sub>(a, b, indexVars) ||
+         isBinary<Mul>(a, b, indexVars) || isBinary<Div>(a, b, indexVars) ||
+         isBinary<Rem>(a, b, indexVars) || isBinary<Eq>(a, b, indexVars) ||
+         isBinary<Ne>(a, b, indexVars) || isBinary<Gt>(a, b, indexVars) ||
+         isBinary<Lt>(a, b, indexVars) || isBinary<Ge>(a, b, indexVars) ||
+         isBinary<Le>(a, b, indexVars) || isBinary<And>(a, b, indexVars) ||
+         isBinary<Or>(a, b, indexVars) || isBinary<Xor>(a, b, indexVars);
+}
+
+template <class T>
+static bool isUnary(const Expr& a, const Expr& b, IndexVarMap* indexVars) {
+  return isa<T>(a) && isa<T>(b) && equal(to<T>(a)->a, to<T>(b)->a, indexVars);
+}
+
+template <class T>
+static bool isBinary(const Expr& a, const Expr& b, IndexVarMap* indexVars) {
+  return isa<T>(a) && isa<T>(b) &&
+         equal(to<T>(a)->a, to<T>(b)->a, indexVars) &&
+         equal(to<T>(a)->b, to<T>(b)->b, indexVars);
+}
+
+/// True iff `stmt` is an assignment or a pure intrinsic call that may be
+/// replaced or moved given only its effects.
+static bool isCandidate(const Stmt& stmt) {
+  if (isa<AssignStmt>(stmt)) {
+    return to<AssignStmt>(stmt)->cop == CompoundOperator::None;
+  }
+  else if (isa<CallStmt>(stmt)) {
+    const Func& callee = to<CallStmt>(stmt)->callee;
+    return callee.getKind() == Func::Intrinsic && intrinsics::isPure(callee);
+  }
+  return false;
+}
+
+static vector<Var> getDefinedVars(const Stmt& stmt) {
+  if (isa<AssignStmt>(stmt)) {
+    return {to<AssignStmt>(stmt)->var};
+  }
+  iassert(isa<CallStmt>(stmt));
+  return to<CallStmt>(stmt)->results;
+}
+
+/// True iff `index` is a literal in [0, size).
+static bool isLiteralIndex(const Expr& index, size_t size) {
+  if (!isa<Literal>(index) || !isScalar(index.type()) ||
+      !index.type().toTensor()->getComponentType().isInt()) {
+    return false;
+  }
+  int value = to<Literal>(index)->getIntVal(0);
+  return value >= 0 && (size_t)value < size;
+}
+
+/// True iff `buffer` has a size that is known at compile time, and that size
+/// is larger than each of the `indices` into its respective dimension. For a
+/// single index the dimensions are flattened, as for loads.
+static bool isInBounds(const Expr& buffer, const vector<Expr>& indices) {
+  if (!buffer.type().isTensor()) {
+    return false;
+  }
+  const TensorType* type = buffer.type().toTensor();
+  if (type->hasSystemDimensions()) {
+    return false;
+  }
+  if (indices.size() == 1) {
+    return isLiteralIndex(indices[0], type->size());
+  }
+  vector<IndexSet> dimensions = type->getOuterDimensions();
+  if (indices.size() != dimensions.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (!isLiteralIndex(indices[i], dimensions[i].getSize())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// True iff evaluating `stmt` in an iteration that would not have run cannot
+/// fault, since loops may run zero times. Integer division may divide by
+/// zero, and `loc` and the string intrinsics follow pointers. Loads and tensor
+/// reads may read past the end of a buffer, e.g. the field of an empty set,
+/// unless the loop is known to run at least once (`runsOnce`) or they read a
+/// constant index of a buffer with a constant size.
+static bool isSafeToSpeculate(const Stmt& stmt, bool runsOnce) {
+  class FindTraps : public IRVisitor {
+  public:
+    FindTraps(bool runsOnce) : runsOnce(runsOnce) {}
+    bool traps = false;
+  private:
+    bool runsOnce;
+    using IRVisitor::visit;
+    void visit(const Load* op) {
+      traps = traps || !(runsOnce || isInBounds(op->buffer, {op->index}));
+      IRVisitor::visit(op);
+    }
+    void visit(const TensorRead* op) {
+      traps = traps || !(runsOnce || isInBounds(op->tensor, op->indices));
+      IRVisitor::visit(op);
+    }
+    void visit(const Div* op) {
+      traps = traps || !op->type.isTensor() ||
+              !op->type.toTensor()->getComponentType().isFloat();
+      IRVisitor::visit(op);
+    }
+    void visit(const Rem* op) {
+      traps = true;
+    }
+  };
+
+  if (isa<CallStmt>(stmt)) {
+    const Func& callee = to<CallStmt>(stmt)->callee;
+    if (callee == intrinsics::mod() || callee == intrinsics::loc() ||
+        callee == intrinsics::strcmp() || callee == intrinsics::strlen()) {
+      return false;
+    }
+  }
+  FindTraps findTraps(runsOnce);
+  stmt.accept(&findTraps);
+  return !findTraps.traps;
+}
+
+/// Appends the statements of `stmt` that run in order and unconditionally
+/// every time `stmt` runs to `stmts`.
+static void getStraightLineStmts(const Stmt& stmt, vector<Stmt>* stmts) {
+  if (isa<Block>(stmt)) {
+    getStraightLineStmts(to<Block>(stmt)->first, stmts);
+    if (to<Block>(stmt)->rest.defined()) {
+      getStraightLineStmts(to<Block>(stmt)->rest, stmts);
+    }
+  }
+  else if (isa<Comment>(stmt) && to<Comment>(stmt)->commentedStmt.defined()) {
+    getStraightLineStmts(to<Comment>(stmt)->commentedStmt, stmts);
+  }
+  else if (isa<Scope>(stmt)) {
+    getStraightLineStmts(to<Scope>(stmt)->scopedStmt, stmts);
+  }
+  else {
+    stmts->push_back(stmt);
+  }
+}
+
+/// Returns `stmt` without the straight-line statements in `removed`, or an
+/// undefined Stmt if none are left.
+static Stmt removeStmts(const Stmt& stmt, const set<Stmt>& removed) {
+  if (isa<Block>(stmt)) {
+    const Block* block = to<Block>(stmt);
+    Stmt first = removeStmts(block->first, removed);
+    Stmt rest = block->rest.defined() ? removeStmts(block->rest, removed)
+                                      : Stmt();
+    if (first == block->first && rest == block->rest) {
+      return stmt;
+    }
+    return (first.defined() || rest.defined()) ? Block::make(first, rest)
+                                               : Stmt();
+  }
+  else if (isa<Comment>(stmt) && to<Comment>(stmt)->commentedStmt.defined()) {
+    const Comment* comment = to<Comment>(stmt);
+    Stmt commentedStmt = removeStmts(comment->commentedStmt, removed);
+    if (commentedStmt == comment->commentedStmt) {
+      return stmt;
+    }
+    return commentedStmt.defined()
+        ? Comment::make(comment->comment, commentedStmt,
+                        comment->footerSpace, comment->headerSpace)
+        : Stmt();
+  }
+  else if (isa<Scope>(stmt)) {
+    Stmt scopedStmt = removeStmts(to<Scope>(stmt)->scopedStmt, removed);
+    if (scopedStmt == to<Scope>(stmt)->scopedStmt) {
+      return stmt;
+    }
+    return scopedStmt.defined() ? Scope::make(scopedStmt) : Stmt();
+  }
+  return util::contains(removed, stmt) ? Stmt() : stmt;
+}
+
+class HoistLoopInvariants : public IRRewriter {
+public:
+  HoistLoopInvariants() : numHoisted(0) {}
+
+  int getNumHoisted() const {return numHoisted;}
+
+private:
+  int numHoisted;
+
+  using IRRewriter::visit;
+
+  /// For::make and ForRange::make wrap loops in a scope, and the statements
+  /// hoisted out of such loops are placed in front of the scope, so that the
+  /// loops keep the shape later passes (e.g. loop fusion) look for.
+  void visit(const Scope* op) {
+    if (!isa<ForRange>(op->scopedStmt) && !isa<For>(op->scopedStmt)) {
+      IRRewriter::visit(op);
+      return;
+    }
+    vector<Stmt> hoisted;
+    Stmt loop = rewriteLoop(op->scopedStmt, &hoisted);
+    stmt = (loop == op->scopedStmt) ? Stmt(op) : loop;
+    if (hoisted.size() > 0) {
+      hoisted.push_back(stmt);
+      stmt = Block::make(hoisted);
+    }
+  }
+
+  void visit(const ForRange* op) {
+    visitLoop(op);
+  }
+
+  void visit(const For* op) {
+    visitLoop(op);
+  }
+
+  void visitLoop(const Stmt& loop) {
+    vector<Stmt> hoisted;
+    stmt = rewriteLoop(loop, &hoisted);
+    if (hoisted.size() > 0) {
+      hoisted.push_back(stmt);
+      stmt = Block::make(hoisted);
+    }
+  }
+
+  /// Rewrite the body of `loop`, and move its invariant statements to
+  /// `hoisted`. Returns `loop` if it did not change, and otherwise the new
+  /// loop in the scope its make function puts it in.
+  Stmt rewriteLoop(const Stmt& loop, vector<Stmt>* hoisted) {
+    if (isa<ForRange>(loop)) {
+      const ForRange* op = to<ForRange>(loop);
+      Stmt body = rewrite(op->body);
+      bool runsOnce = isa<Literal>(op->start) && isa<Literal>(op->end) &&
+                      to<Literal>(op->start)->getIntVal(0) <
+                      to<Literal>(op->end)->getIntVal(0);
+      *hoisted = hoist(op->var, &body, runsOnce);
+      return (body == op->body)
+          ? loop : ForRange::make(op->var, op->start, op->end, unscope(body));
+    }
+    iassert(isa<For>(loop));
+    const For* op = to<For>(loop);
+    Stmt body = rewrite(op->body);
+    *hoisted = hoist(op->var, &body, false);
+    return (body == op->body)
+        ? loop : For::make(op->var, op->domain, unscope(body));
+  }
+
+  /// Returns `stmt` without the scope the loop make functions add to bodies.
+  static Stmt unscope(const Stmt& stmt) {
+    return isa<Scope>(stmt) ? to<Scope>(stmt)->scopedStmt : stmt;
+  }
+
+  /// Remove the invariant statements of the `body` of the loop over `loopVar`
+  /// and their declarations from it, and return them in order. `runsOnce` is
+  /// true if the loop is known to run at least once.
+  vector<Stmt> hoist(const Var& loopVar, Stmt* body, bool runsOnce) {
+    Effects effects = Effects::of(*body);
+    if (effects.unknown) {
+      return {};
+    }
+
+    // The variables and fields whose values change between iterations
+    set<Location> variant = effects.writes;
+    variant.insert(Location(loopVar, ""));
+
+    vector<Stmt> stmts;
+    getStraightLineStmts(*body, &stmts);
+
+    map<Var,Stmt> decls;
+    set<Stmt> invariant;
+    for (const Stmt& s : stmts) {
+      if (isa<VarDecl>(s)) {
+        decls[to<VarDecl>(s)->var] = s;
+        continue;
+      }
+      if (!isCandidate(s) || !isSafeToSpeculate(s, runsOnce)) {
+        continue;
+      }
+      bool isInvariant = true;
+      for (const Var& var : getDefinedVars(s)) {
+        Location location(var, "");
+        isInvariant = isInvariant && util::contains(decls, var) &&
+                      effects.numDecls[var] == 1 &&
+                      effects.numWrites[location] == 1;
+      }
+      if (!isInvariant || conflicts(Effects::of(s).reads, variant)) {
+        continue;
+      }
+
+      // The variables the statement defines no longer change in the loop
+      for (const Var& var : getDefinedVars(s)) {
+        variant.erase(Location(var, ""));
+        invariant.insert(decls.at(var));
+      }
+      invariant.insert(s);
+    }
+    if (invariant.empty()) {
+      return {};
+    }
+
+    vector<Stmt> hoisted;
+    for (const Stmt& s : stmts) {
+      if (util::contains(invariant, s)) {
+        hoisted.push_back(s);
+        if (!isa<VarDecl>(s)) {
+          ++numHoisted;
+        }
+      }
+    }
+    *body = removeStmts(*body, invariant);
+    if (!body->defined()) {
+      *body = Pass::make();
+    }
+    return hoisted;
+  }
+};
+
+Func hoistLoopInvariants(Func func, int* numHoisted) {
+  HoistLoopInvariants rewriter;
+  func = rewriter.rewrite(func);
+  if (numHoisted != nullptr) {
+    *numHoisted += rewriter.getNumHoisted();
+  }
+  return func;
+}
+
+class EliminateCommonSubexpressions : public IRRewriter {
+public:
+  EliminateCommonSubexpressions() : numEliminated(0) {}
+
+  int getNumEliminated() const {return numEliminated;}
+
+private:
+  int numEliminated;
+
+  /// A value computed by an earlier statement that a variable still holds.
+  struct Definition {
+    Stmt stmt;
+    Var var;
+    set<Location> reads;
+  };
+  vector<Definition> available;
+
+  using IRRewriter::visit;
+
+  /// Forget the definitions that `effects` may overwrite.
+  void invalidate(const Effects& effects) {
+    if (effects.unknown) {
+      available.clear();
+      return;
+    }
+    vector<Definition> remaining;
+    for (const Definition& definition : available) {
+      if (!conflicts(definition.reads, effects.writes) &&
+          !conflicts({Location(definition.var, "")}, effects.writes)) {
+        remaining.push_back(definition);
+      }
+    }
+    available = remaining;
+  }
+
+  /// Returns a variable that holds the value `s` computes, if there is one.
+  Var findAvailable(const Stmt& s) {
+    for (const Definition& definition : available) {
+      if (isa<AssignStmt>(s) && isa<AssignStmt>(definition.stmt)) {
+        const AssignStmt* assign = to<AssignStmt>(s);
+        if (assign->var.getType() == definition.var.getType() &&
+            equal(assign->value, to<AssignStmt>(definition.stmt)->value)) {
+          return definition.var;
+        }
+      }
+      else if (isa<CallStmt>(s) && isa<CallStmt>(definition.stmt)) {
+        const CallStmt* call = to<CallStmt>(s);
+        const CallStmt* other = to<CallStmt>(definition.stmt);
+        if (call->callee != other->callee || call->results.size() != 1 ||
+            other->results.size() != 1 ||
+            call->actuals.size() != other->actuals.size() ||
+            call->results[0].getType() != other->results[0].getType()) {
+          continue;
+        }
+        bool same = true;
+        for (size_t i = 0; i < call->actuals.size(); ++i) {
+          same = same && equal(call->actuals[i], other->actuals[i]);
+        }
+        if (same) {
+          return definition.var;
+        }
+      }
+    }
+    return Var();
+  }
+
+  void define(const Stmt& s, const Var& var) {
+    Stmt original = s;
+    Effects effects = Effects::of(s);
+
+    // Values that are cheaper to recompute than to copy are not reused, and
+    // neither are system tensors, since their storage may alias the
+    // assigned value
+    bool reusable = isCandidate(s) && !effects.unknown &&
+                    !isSystemTensorType(var.getType());
+    if (isa<AssignStmt>(s)) {
+      const Expr& value = to<AssignStmt>(s)->value;
+      reusable = reusable && !isa<VarExpr>(value) && !isa<Literal>(value);
+    }
+    if (reusable) {
+      Var holder = findAvailable(s);
+      if (holder.defined()) {
+        Expr copy = isScalar(var.getType())
+            ? Expr(VarExpr::make(holder))
+            : IRBuilder().unaryElwiseExpr(IRBuilder::Copy, holder);
+        stmt = AssignStmt::make(var, copy);
+        ++numEliminated;
+        reusable = false;
+      }
+    }
+
+    invalidate(effects);
+    if (reusable && !conflicts(effects.reads, effects.writes)) {
+      available.push_back({original, var, effects.reads});
+    }
+  }
+
+  void visit(const AssignStmt* op) {
+    stmt = op;
+    define(op, op->var);
+  }
+
+  void visit(const CallStmt* op) {
+    stmt = op;
+    if (op->results.size() == 1) {
+      define(op, op->results[0]);
+    }
+    else {
+      invalidate(Effects::of(Stmt(op)));
+    }
+  }
+
+  template <class T>
+  void visitLeaf(const T* op) {
+    stmt = op;
+    invalidate(Effects::of(stmt));
+  }
+
+  void visit(const VarDecl* op)     {visitLeaf(op);}
+  void visit(const Store* op)       {visitLeaf(op);}
+  void visit(const TensorWrite* op) {visitLeaf(op);}
+  void visit(const FieldWrite* op)  {visitLeaf(op);}
+  void visit(const Print* op)       {visitLeaf(op);}
+  void visit(const Map* op)         {visitLeaf(op);}
+  void visit(const Kernel* op)      {visitLeaf(op);}
+
+  /// Definitions made in a scope go out of scope with it.
+  void visit(const Scope* op) {
+    vector<Definition> outer = available;
+    IRRewriter::visit(op);
+    available = outer;
+    invalidate(Effects::of(Stmt(op)));
+  }
+
+  void visit(const IfThenElse* op) {
+    vector<Definition> outer = available;
+    IRRewriter::visit(op);
+    available = outer;
+    invalidate(Effects::of(Stmt(op)));
+  }
+
+  /// Only the definitions that no iteration overwrites hold in a loop body.
+  template <class T>
+  void visitLoop(const T* op) {
+    Effects effects = Effects::of(Stmt(op));
+    invalidate(effects);
+    vector<Definition> outer = available;
+    IRRewriter::visit(op);
+    available = outer;
+  }
+
+  void visit(const ForRange* op) {visitLoop(op);}
+  void visit(const For* op)      {visitLoop(op);}
+  void visit(const While* op)    {visitLoop(op);}
+};
+
+Func eliminateCommonSubexpressions(Func func, int* numEliminated) {
+  EliminateCommonSubexpressions rewriter;
+  func = rewriter.rewrite(func);
+  if (numEliminated != nullptr) {
+    *numEliminated += rewriter.getNumEliminated();
+  }
+  return func;
+}
+
+}}
@@ -0,0 +1,29 @@
+#ifndef SIMIT_ELIMINATE_REDUNDANCY_H
+#define SIMIT_ELIMINATE_REDUNDANCY_H
+
+#include "ir.h"
+
+namespace simit {
+namespace ir {
+
+/// Hoist the assignments and pure intrinsic calls (e.g. `det` and `inv`) of
+/// loop bodies that compute the same value in every iteration out of the
+/// loops. A statement is hoisted if it runs unconditionally in every
+/// iteration, is the only write to a variable declared in the loop body, and
+/// only reads variables and set fields the loop does not write. Loads and
+/// tensor reads are only hoisted out of loops that run at least once, unless
+/// their indices are known to be in bounds. The hoisted statements are placed
+/// in front of the loop's scope, so loops keep the shape later passes match.
+/// If `numHoisted` is given, the number of hoisted statements is added to it.
+Func hoistLoopInvariants(Func func, int* numHoisted=nullptr);
+
+/// Replace assignments and pure intrinsic calls that recompute a value that is
+/// still held by a variable in scope by a copy of that variable. Index
+/// expressions are equal if they only differ in the names of their index
+/// variables. Only the whole value of a statement is reused; subexpressions
+/// that two statements have in common are recomputed. If `numEliminated` is
+/// given, the number of replaced statements is added to it.
+Func eliminateCommonSubexpressions(Func func, int* numEliminated=nullptr);
+
+}}
+#endif
@@ -0,0 +1,176 @@
+#include "fuse_loops.h"
+
+#include <vector>
+
+#include "ir_rewriter.h"
+#include "parallel_loops.h"
+#include "var_replace_rewriter.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+/// Returns the set loop in `stmt`, which For::make wraps in a scope, or null
+/// if `stmt` is not a set loop. Loops that rewriters rebuilt may be wrapped in
+/// more than one scope.
+static const For* getSetLoop(const Stmt& stmt) {
+  Stmt scoped = stmt;
+  while (isa<Scope>(scoped) && isa<Scope>(to<Scope>(scoped)->scopedStmt)) {
+    scoped = to<Scope>(scoped)->scopedStmt;
+  }
+  if (!isa<Scope>(scoped) || !isa<For>(to<Scope>(scoped)->scopedStmt)) {
+    return nullptr;
+  }
+  const For* loop = to<For>(to<Scope>(scoped)->scopedStmt);
+  return (loop->domain.kind == ForDomain::IndexSet) ? loop : nullptr;
+}
+
+static bool isSameDomain(const ForDomain& a, const ForDomain& b) {
+  const IndexSet& aSet = a.indexSet;
+  const IndexSet& bSet = b.indexSet;
+  if (aSet.getKind() != bSet.getKind()) {
+    return false;
+  }
+  switch (aSet.getKind()) {
+    case IndexSet::Range:
+      return aSet.getSize() == bSet.getSize();
+    case IndexSet::Set:
+      return isa<VarExpr>(aSet.getSet()) && isa<VarExpr>(bSet.getSet()) &&
+             to<VarExpr>(aSet.getSet())->var == to<VarExpr>(bSet.getSet())->var;
+    case IndexSet::Single:
+    case IndexSet::Dynamic:
+      return false;
+  }
+  unreachable;
+  return false;
+}
+
+/// Statements that may be moved in front of a preceding loop.
+static bool isMovable(const Stmt& stmt) {
+  return isa<VarDecl>(stmt) ||
+         (isa<Comment>(stmt) && !to<Comment>(stmt)->commentedStmt.defined());
+}
+
+class FuseLoops : public IRRewriter {
+public:
+  FuseLoops() : numFused(0) {}
+
+  int getNumFused() const {return numFused;}
+
+private:
+  int numFused;
+
+  using IRRewriter::visit;
+
+  void visit(const Block* op) {
+    vector<Stmt> stmts;
+    flatten(op, &stmts);
+
+    // Fuse every loop into the closest preceding loop, if only movable
+    // statements separate them
+    vector<Stmt> fused;
+    int fusedBefore = numFused;
+    int lastLoop = -1;
+    for (const Stmt& s : stmts) {
+      const For* loop = getSetLoop(s);
+      if (loop != nullptr && lastLoop >= 0) {
+        Stmt fusedLoop = fuse(getSetLoop(fused[lastLoop]), loop);
+        if (fusedLoop.defined()) {
+          // Move the statements between the loops in front of the first loop
+          vector<Stmt> between(fused.begin() + lastLoop + 1, fused.end());
+          fused.resize(lastLoop);
+          fused.insert(fused.end(), between.begin(), between.end());
+          fused.push_back(fusedLoop);
+          lastLoop = fused.size() - 1;
+          ++numFused;
+          continue;
+        }
+      }
+      if (loop != nullptr) {
+        lastLoop = fused.size();
+      }
+      else if (!isMovable(s)) {
+        lastLoop = -1;
+      }
+      fused.push_back(s);
+    }
+
+    // Keep the block structure (and its comments) if nothing was fused
+    if (numFused == fusedBefore) {
+      stmt = rewriteBlock(op);
+      return;
+    }
+    for (Stmt& s : fused) {
+      s = rewrite(s);
+    }
+    stmt = Block::make(fused);
+  }
+
+  /// Rewrite the statements of a block, without fusing its loops.
+  Stmt rewriteBlock(const Block* op) {
+    Stmt first = rewriteBlockStmt(op->first);
+    Stmt rest = op->rest.defined() ? rewriteBlockStmt(op->rest) : Stmt();
+    return Block::make(first, rest);
+  }
+
+  Stmt rewriteBlockStmt(const Stmt& s) {
+    if (isa<Block>(s)) {
+      return rewriteBlock(to<Block>(s));
+    }
+    else if (isa<Comment>(s) && isa<Block>(to<Comment>(s)->commentedStmt)) {
+      const Comment* comment = to<Comment>(s);
+      return Comment::make(comment->comment,
+                           rewriteBlock(to<Block>(comment->commentedStmt)),
+                           comment->footerSpace, comment->headerSpace);
+    }
+    return rewrite(s);
+  }
+
+  /// Flatten nested blocks into `stmts`. Comments on statements are split
+  /// from them, since the statements may be fused with others.
+  static void flatten(const Stmt& s, vector<Stmt>* stmts) {
+    if (isa<Block>(s)) {
+      flatten(to<Block>(s)->first, stmts);
+      if (to<Block>(s)->rest.defined()) {
+        flatten(to<Block>(s)->rest, stmts);
+      }
+    }
+    else if (isa<Comment>(s) && to<Comment>(s)->commentedStmt.defined()) {
+      const Comment* comment = to<Comment>(s);
+      stmts->push_back(Comment::make(comment->comment, Stmt(), false,
+                                     comment->headerSpace));
+      flatten(comment->commentedStmt, stmts);
+    }
+    else {
+      stmts->push_back(s);
+    }
+  }
+
+  /// Returns the fusion of `first` and `second`, or an undefined Stmt if they
+  /// cannot be fused.
+  static Stmt fuse(const For* first, const For* second) {
+    if (!isSameDomain(first->domain, second->domain)) {
+      return Stmt();
+    }
+    Stmt secondBody = replaceVar(second->body, second->var, first->var);
+    Stmt fused = For::make(first->var, first->domain,
+                           Block::make(first->body, secondBody));
+    LoopParallelism parallelism = getLoopParallelism(getSetLoop(fused));
+    if (parallelism.getKind() != LoopParallelism::Independent) {
+      return Stmt();
+    }
+    return fused;
+  }
+};
+
+Func fuseLoops(Func func, int* numFused) {
+  FuseLoops rewriter;
+  func = rewriter.rewrite(func);
+  if (numFused != nullptr) {
+    *numFused += rewriter.getNumFused();
+  }
+  return func;
+}
+
+}}
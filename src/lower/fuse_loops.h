@@ -0,0 +1,19 @@
+#ifndef SIMIT_FUSE_LOOPS_H
+#define SIMIT_FUSE_LOOPS_H
+
+#include "ir.h"
+
+namespace simit {
+namespace ir {
+
+/// Fuse adjacent loops over the same set, so that consecutive maps and vector
+/// index expressions over the set stream its fields from memory once. Two
+/// loops are fused if the iterations of the fused loop are independent (see
+/// LoopParallelism), so that every iteration still sees the values the first
+/// loop computed for its element. Declarations and comments between the loops
+/// are moved in front of them. If `numFused` is given, the number of loops
+/// that were fused into a preceding loop is added to it.
+Func fuseLoops(Func func, int* numFused=nullptr);
+
+}}
+#endif
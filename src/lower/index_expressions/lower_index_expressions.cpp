@@ -8,6 +8,7 @@
 #include "lower_scatter_workspace.h"
 #include "lower_transpose.h"
 #include "lower_matrix_multiply.h"
+#include "lower_spmv.h"
 
 #include "path_expressions.h"
 
@@ -217,7 +218,7 @@ Func lowerIndexExpressions(Func func) {
       const IndexExpr* iexpr = to<IndexExpr>(op->value);
 
       // Dispatch the index expression lowering to the correct lowering pass.
-      enum Kind {Unknown, DenseResult, MatrixScale,
+      enum Kind {Unknown, BlockedSpMV, DenseResult, MatrixScale,
                  MatrixElwiseWithSameStructureOrDiagonal, MatrixElwise,
                  MatrixTranspose, MatrixMultiply};
       Kind kind = Unknown;
@@ -226,8 +227,12 @@ Func lowerIndexExpressions(Func func) {
       const Var& var = op->var;
       const TensorType* type = iexpr->type.toTensor();
 
-      if (type->order()==0 || type->order()==1 ||
-          storage->getStorage(var).getKind() == TensorStorage::Dense) {
+      if (type->order()==1 &&
+          isBlockedSpMV(VarExpr::make(var), iexpr, *storage)) {
+        kind = BlockedSpMV;
+      }
+      else if (type->order()==0 || type->order()==1 ||
+               storage->getStorage(var).getKind() == TensorStorage::Dense) {
         kind = DenseResult;
       }
       else if (isScale(iexpr)) {
@@ -250,6 +255,9 @@ Func lowerIndexExpressions(Func func) {
           << Stmt(op);
 
       switch (kind) {
+        case BlockedSpMV:
+          stmt = lowerBlockedSpMV(VarExpr::make(var), op->cop, iexpr, *storage);
+          break;
         case DenseResult:
         case MatrixScale:
         case MatrixElwiseWithSameStructureOrDiagonal:
@@ -277,7 +285,16 @@ Func lowerIndexExpressions(Func func) {
         IRRewriter::visit(op);
         return;
       }
-      stmt = lowerIndexStatement(op, &environment, *storage);
+
+      Expr field = FieldRead::make(op->elementOrSet, op->fieldName);
+      if (isa<IndexExpr>(op->value) &&
+          isBlockedSpMV(field, to<IndexExpr>(op->value), *storage)) {
+        stmt = lowerBlockedSpMV(field, op->cop, to<IndexExpr>(op->value),
+                                *storage);
+      }
+      else {
+        stmt = lowerIndexStatement(op, &environment, *storage);
+      }
 
       if (isa<IndexExpr>(op->value)) {
         stmt = Comment::make(util::toString(*op), stmt, false, true);
@@ -1,5 +1,6 @@
 #include "lower_indexexprs.h"
 
+#include "grid_ops.h"
 #include "ir.h"
 #include "ir_codegen.h"
 #include "ir_queries.h"
@@ -235,15 +236,8 @@ Stmt reduce(Stmt loopNest, Stmt kernel, ReductionOperator reductionOperator) {
     }
 
     static Stmt compoundAssign(Var var, ReductionOperator op, Expr value) {
-      switch (op.getKind()) {
-        case ReductionOperator::Sum:
-          return AssignStmt::make(var, value, CompoundOperator::Add);
-        case ReductionOperator::Undefined:
-          ierror;
-          return Stmt();
-      }
-      unreachable;
-      return Stmt();
+      iassert(op.getKind() != ReductionOperator::Undefined);
+      return AssignStmt::make(var, value, getCompoundOperator(op));
     }
 
     void visit(const AssignStmt *op) {
@@ -252,8 +246,11 @@ Stmt reduce(Stmt loopNest, Stmt kernel, ReductionOperator reductionOperator) {
         reductionVar = Var(op->var.getName()+"tmp",
                            TensorType::make(ctype));
 
+        // The reduction variable holds the whole reduction, so it is combined
+        // into the result with the statement's own compound operator
         stmt = compoundAssign(reductionVar, rop, op->value);
-        reductionVarWriteBackStmt = compoundAssign(op->var, rop, reductionVar);
+        reductionVarWriteBackStmt = AssignStmt::make(op->var, reductionVar,
+                                                     op->cop);
       }
       else {
         stmt = op;
@@ -312,8 +309,9 @@ Stmt reduce(Stmt loopNest, Stmt kernel, ReductionOperator reductionOperator) {
 
   Type rvarType = rvar.getType();
   Stmt rvarDecl = VarDecl::make(rvar);
-  Stmt rvarInitZero = initializeLhsToZero(AssignStmt::make(rvar,rvar));
-  Stmt rvarInit = Block::make(rvarDecl, rvarInitZero);
+  Stmt rvarInitIdentity =
+      initializeLhsToIdentity(AssignStmt::make(rvar,rvar), reductionOperator);
+  Stmt rvarInit = Block::make(rvarDecl, rvarInitIdentity);
 
   loopNest = Block::make(rvarInit, loopNest);
 
@@ -610,19 +608,11 @@ Stmt lowerIndexStatement(Stmt stmt, Environment* environment, Storage storage) {
       }
     }
     else if (loopVar->getDomain().kind == ForDomain::Grid) {
-      int ndims = loopVar->getDomain().gridVars.size();
-      // Add overall variable advancement
-      loopNest = Block::make(loopNest, AssignStmt::make(
-          loopVar->getDomain().var, 1, CompoundOperator::Add));
-      for (int i = 0; i < ndims; ++i) {
-        Expr dimSize = IndexRead::make(loopVar->getDomain().set,
-                                       IndexRead::GridDim, i);
-        loopNest = ForRange::make(loopVar->getDomain().gridVars[i],
-                                  0, dimSize, loopNest);
-      }
-      // Zero out the overall variable
-      Stmt initVar = AssignStmt::make(loopVar->getDomain().var, 0);
-      loopNest = Block::make(initVar, loopNest);
+      // Stencil matrices have rows for the ghost points too, so every point
+      // is visited
+      loopNest = makeGridLoops(loopVar->getDomain().set,
+                               loopVar->getDomain().gridVars,
+                               loopVar->getDomain().var, loopNest, false);
     }
     else if (loopVar->getDomain().kind == ForDomain::Neighbors ||
              loopVar->getDomain().kind == ForDomain::NeighborsOf) {
@@ -696,7 +686,8 @@ Stmt lowerIndexStatement(Stmt stmt, Environment* environment, Storage storage) {
           Expr totalInd = Literal::make(0);
           for (int d = dims-1; d >= 0; --d) {
             Expr dimSize = IndexRead::make(gridSet, IndexRead::GridDim, d);
-            // Periodic boundary conditions
+            // Periodic boundary conditions, whose modulus makeGridLoops
+            // drops for interior rows
             Expr ind = ((gridVars[d]+offsets[d])%dimSize+dimSize)%dimSize;
             totalInd = totalInd * dimSize + ind;
           }
@@ -740,7 +731,7 @@ Stmt lowerIndexStatement(Stmt stmt, Environment* environment, Storage storage) {
                       (storage.hasStorage(to<AssignStmt>(stmt)->var) &&
                        storage.getStorage(to<AssignStmt>(stmt)->var).getKind()
                        == TensorStorage::Indexed));
-  if (isResultScalar || isVarSparse) {
+  if ((isResultScalar && !isCompoundAssign) || isVarSparse) {
     loopNest = Block::make(initializeLhsToZero(stmt), loopNest);
   }
   else if (sig.isSparse() && !isCompoundAssign) {
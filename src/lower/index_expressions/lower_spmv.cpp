@@ -0,0 +1,198 @@
+#include "lower_spmv.h"
+
+#include <string>
+#include <vector>
+
+#include "storage.h"
+#include "tensor_index.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+/// Blocks with dimensions larger than this are left to the generic index
+/// expression lowering, since the specialized kernel is fully unrolled.
+static const unsigned MAX_BLOCK_DIMENSION = 8;
+
+/// Get the static block dimensions of `type`, which are 1 for unblocked
+/// tensors. Returns false if the tensor has nested blocks or blocks whose
+/// dimensions are not known at compile time.
+static bool getBlockDimensions(const TensorType* type,
+                               vector<unsigned>* dimensions) {
+  Type block = type->getBlockType();
+  const TensorType* blockType = block.toTensor();
+  dimensions->clear();
+  if (blockType->order() == 0) {
+    dimensions->assign(type->order(), 1);
+    return true;
+  }
+  if (blockType->order() != type->order() ||
+      blockType->getBlockType().toTensor()->order() != 0) {
+    return false;
+  }
+  for (const IndexSet& indexSet : blockType->getOuterDimensions()) {
+    if (indexSet.getKind() != IndexSet::Range || indexSet.getSize() == 0 ||
+        indexSet.getSize() > MAX_BLOCK_DIMENSION) {
+      return false;
+    }
+    dimensions->push_back(indexSet.getSize());
+  }
+  return true;
+}
+
+/// Splits `iexpr` into its matrix and vector operands if it has the form
+/// `(i A(i,+j)*x(+j))` or `(i x(+j)*A(i,+j))`.
+static bool getSpMVOperands(const IndexExpr* iexpr,
+                            const IndexedTensor** matrix,
+                            const IndexedTensor** vec) {
+  if (iexpr->resultVars.size() != 1 || !isa<Mul>(iexpr->value)) {
+    return false;
+  }
+  const Mul* mul = to<Mul>(iexpr->value);
+  if (!isa<IndexedTensor>(mul->a) || !isa<IndexedTensor>(mul->b)) {
+    return false;
+  }
+  *matrix = to<IndexedTensor>(mul->a);
+  *vec = to<IndexedTensor>(mul->b);
+  if ((*matrix)->indexVars.size() == 1) {
+    std::swap(*matrix, *vec);
+  }
+  if ((*matrix)->indexVars.size() != 2 || (*vec)->indexVars.size() != 1) {
+    return false;
+  }
+
+  const IndexVar& i = (*matrix)->indexVars[0];
+  const IndexVar& j = (*matrix)->indexVars[1];
+  return i == iexpr->resultVars[0] &&
+         j.isReductionVar() &&
+         j.getOperator() == ReductionOperator::Sum &&
+         (*vec)->indexVars[0] == j;
+}
+
+/// True iff the blocks of the vector `tensor` are stored contiguously, which
+/// is not the case for blocked set fields with an SoA or AoSoA layout.
+static bool hasContiguousBlocks(Expr tensor) {
+  if (!isa<FieldRead>(tensor) ||
+      !to<FieldRead>(tensor)->elementOrSet.type().isSet() ||
+      isScalar(tensor.type().toTensor()->getBlockType())) {
+    return true;
+  }
+  const FieldRead* field = to<FieldRead>(tensor);
+  return getFieldLayout(field->elementOrSet, field->fieldName).getKind() ==
+         FieldLayout::AoS;
+}
+
+bool isBlockedSpMV(Expr target, const IndexExpr* iexpr,
+                   const Storage& storage) {
+  const IndexedTensor* matrix;
+  const IndexedTensor* vec;
+  if (!getSpMVOperands(iexpr, &matrix, &vec)) {
+    return false;
+  }
+
+  if (!isa<VarExpr>(matrix->tensor) ||
+      !(isa<VarExpr>(vec->tensor) || isa<FieldRead>(vec->tensor)) ||
+      !hasContiguousBlocks(vec->tensor) || !hasContiguousBlocks(target)) {
+    return false;
+  }
+  const Var& A = to<VarExpr>(matrix->tensor)->var;
+  if (!storage.hasStorage(A)) {
+    return false;
+  }
+  const TensorStorage& tensorStorage = storage.getStorage(A);
+  if (tensorStorage.getKind() != TensorStorage::Indexed ||
+      !tensorStorage.hasTensorIndex() ||
+      tensorStorage.getTensorIndex().getKind() != TensorIndex::PExpr) {
+    return false;
+  }
+
+  const TensorType* Atype = A.getType().toTensor();
+  const TensorType* xtype = vec->tensor.type().toTensor();
+  const TensorType* ytype = iexpr->type.toTensor();
+  if (Atype->getComponentType() != ScalarType::Float ||
+      xtype->getComponentType() != ScalarType::Float ||
+      ytype->getComponentType() != ScalarType::Float) {
+    return false;
+  }
+
+  vector<unsigned> Ablock, xblock, yblock;
+  return getBlockDimensions(Atype, &Ablock) &&
+         getBlockDimensions(xtype, &xblock) &&
+         getBlockDimensions(ytype, &yblock) &&
+         Ablock[0] == yblock[0] && Ablock[1] == xblock[0];
+}
+
+Stmt lowerBlockedSpMV(Expr target, CompoundOperator cop,
+                      const IndexExpr* iexpr, const Storage& storage) {
+  const IndexedTensor* matrix;
+  const IndexedTensor* vec;
+  bool isSpMV = getSpMVOperands(iexpr, &matrix, &vec);
+  iassert(isSpMV && isBlockedSpMV(target, iexpr, storage))
+      << "not a blocked sparse matrix-vector product: " << Expr(iexpr);
+  UNUSED(isSpMV);
+
+  const Var& A = to<VarExpr>(matrix->tensor)->var;
+  const Expr& x = vec->tensor;
+  const TensorIndex& index = storage.getStorage(A).getTensorIndex();
+
+  const TensorType* Atype = A.getType().toTensor();
+  vector<unsigned> blockDimensions;
+  getBlockDimensions(Atype, &blockDimensions);
+  const int nn = blockDimensions[0];
+  const int mm = blockDimensions[1];
+
+  Var i("i", Int);
+  Var ij("ij", Int);
+  Var j("j", Int);
+
+  // Each block row of the result is accumulated in registers, and each block
+  // of x is loaded once and reused for every row of the block of A it is
+  // multiplied with. The kernel is fully unrolled over the blocks, so the
+  // loads from A are contiguous and independent of the block loop variables.
+  std::vector<Var> rowSums;
+  std::vector<Var> xs;
+  std::vector<Stmt> decls;
+  for (int ii=0; ii < nn; ++ii) {
+    rowSums.push_back(Var(INTERNAL_PREFIX("rowsum")+to_string(ii), Float));
+    decls.push_back(VarDecl::make(rowSums.back()));
+  }
+  for (int jj=0; jj < mm; ++jj) {
+    xs.push_back(Var(INTERNAL_PREFIX("xj")+to_string(jj), Float));
+    decls.push_back(VarDecl::make(xs.back()));
+  }
+
+  std::vector<Stmt> blockStmts;
+  blockStmts.push_back(AssignStmt::make(j, Load::make(index.getColidxArray(),
+                                                      ij)));
+  for (int jj=0; jj < mm; ++jj) {
+    blockStmts.push_back(AssignStmt::make(xs[jj], Load::make(x, j*mm + jj)));
+  }
+  for (int ii=0; ii < nn; ++ii) {
+    Expr rowSum = Load::make(A, ij*(nn*mm) + ii*mm) * xs[0];
+    for (int jj=1; jj < mm; ++jj) {
+      rowSum = rowSum + Load::make(A, ij*(nn*mm) + (ii*mm + jj)) * xs[jj];
+    }
+    blockStmts.push_back(AssignStmt::make(rowSums[ii], rowSum,
+                                          CompoundOperator::Add));
+  }
+
+  Expr start = Load::make(index.getRowptrArray(), i);
+  Expr stop  = Load::make(index.getRowptrArray(), i+1);
+
+  // The temporaries are declared in the row loop, so that they are private to
+  // each thread if the loop runs in parallel
+  std::vector<Stmt> rowStmts = decls;
+  for (int ii=0; ii < nn; ++ii) {
+    rowStmts.push_back(AssignStmt::make(rowSums[ii], Literal::make(0.0)));
+  }
+  rowStmts.push_back(ForRange::make(ij, start, stop, Block::make(blockStmts)));
+  for (int ii=0; ii < nn; ++ii) {
+    rowStmts.push_back(Store::make(target, i*nn + ii, rowSums[ii], cop));
+  }
+
+  IndexSet rows = Atype->getOuterDimensions()[0];
+  return For::make(i, ForDomain(rows), Block::make(rowStmts));
+}
+
+}}
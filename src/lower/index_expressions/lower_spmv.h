@@ -0,0 +1,23 @@
+#ifndef SIMIT_LOWER_SPMV_H
+#define SIMIT_LOWER_SPMV_H
+
+#include "ir.h"
+
+namespace simit {
+namespace ir {
+
+/// True iff `iexpr` is a sparse matrix-vector product `(i A(i,+j)*x(+j))`,
+/// where `A` is stored in a path expression tensor index, the blocks of `A`,
+/// `x` and the result have static sizes, and the blocks of `x` and `target`
+/// are stored contiguously.
+bool isBlockedSpMV(Expr target, const IndexExpr* iexpr,
+                   const Storage& storage);
+
+/// Lower the blocked sparse matrix-vector product `iexpr`, which must satisfy
+/// `isBlockedSpMV` with `target`, into a kernel specialized to its block sizes
+/// that stores (or compound assigns) the result into the dense vector `target`.
+Stmt lowerBlockedSpMV(Expr target, CompoundOperator cop,
+                      const IndexExpr* iexpr, const Storage& storage);
+
+}}
+#endif
@@ -7,6 +7,8 @@
 #include "index_expressions/lower_index_expressions.h"
 
 #include "lower_accesses.h"
+#include "eliminate_redundancy.h"
+#include "fuse_loops.h"
 #include "lower_prints.h"
 #include "lower_string_ops.h"
 #include "lower_stencil_assemblies.h"
@@ -93,9 +95,14 @@ void printCallGraph(string headerText, Func func, ostream* os) {
 }
 
 Func lower(Func func, std::ostream* os, bool time) {
+  return lower(func, kBackend, os, time);
+}
+
+Func lower(Func func, const std::string& backend, std::ostream* os,
+           bool time) {
 #ifdef GPU
   // Rewrite system assignments
-  if (kBackend == "gpu") {
+  if (backend == "gpu") {
     func = rewriteCallGraph(func, rewriteSystemAssigns);
     printCallGraph("Rewrite System Assigns (GPU)", func, os);
   }
@@ -143,12 +150,36 @@ Func lower(Func func, std::ostream* os, bool time) {
   printCallGraph("Normalize Row Indices", func, os);
 
   // Lower maps
-  func = rewriteCallGraph(func, lowerMaps);
+  const bool gather = (backend == "cpu-parallel");
+  func = rewriteCallGraph(func, [gather](Func func) -> Func {
+    return lowerMaps(func, gather);
+  });
   printCallGraph("Lower Maps", func, os);
 
+  // Hoist loop invariants and eliminate common subexpressions. The inlined
+  // map functions recompute per-element values (e.g. scaled material
+  // parameters and transposes) in their inner loops, and LLVM does not move
+  // the tensor temporaries that hold them.
+  if (backend != "gpu") {
+    int numHoisted = 0;
+    func = rewriteCallGraph(func, [&numHoisted](Func func) -> Func {
+      return hoistLoopInvariants(func, &numHoisted);
+    });
+    printCallGraph("Hoist Loop Invariants (" + to_string(numHoisted) +
+                   " statements hoisted)", func, os);
+
+    int numEliminated = 0;
+    func = rewriteCallGraph(func, [&numEliminated](Func func) -> Func {
+      return eliminateCommonSubexpressions(func, &numEliminated);
+    });
+    printCallGraph("Eliminate Common Subexpressions (" +
+                   to_string(numEliminated) + " statements eliminated)",
+                   func, os);
+  }
+
 #ifdef GPU
   // GPU backend wants memsets as loops over set domains
-  if (kBackend == "gpu") {
+  if (backend == "gpu") {
     func = rewriteCallGraph(func, rewriteMemsets);
     printCallGraph("Rewrite Memsets (GPU)", func, os);
   }
@@ -162,6 +193,16 @@ Func lower(Func func, std::ostream* os, bool time) {
   func = rewriteCallGraph(func, lowerTensorAccesses);
   printCallGraph("Lower Tensor Reads and Writes", func, os);
 
+  // Fuse loops (the GPU backend fuses kernels instead)
+  if (backend != "gpu") {
+    int numFused = 0;
+    func = rewriteCallGraph(func, [&numFused](Func func) -> Func {
+      return fuseLoops(func, &numFused);
+    });
+    printCallGraph("Fuse Loops (" + to_string(numFused) + " loops fused)",
+                   func, os);
+  }
+
   // Insert timers
   if (time) {
     printTimedCallGraph("Insert Timers", func, os);
@@ -179,7 +220,7 @@ Func lower(Func func, std::ostream* os, bool time) {
 
   // Lower to GPU Kernels
 #if GPU
-  if (kBackend == "gpu") {
+  if (backend == "gpu") {
     func = rewriteCallGraph(func, rewriteCompoundOps);
     printCallGraph("Rewrite Compound Ops (GPU)", func, os);
     func = rewriteCallGraph(func, shardLoops);
@@ -1,6 +1,8 @@
 #ifndef SIMIT_LOWER_H
 #define SIMIT_LOWER_H
 
+#include <string>
+
 #include "ir.h"
 
 namespace simit {
@@ -11,5 +13,10 @@ namespace ir {
 /// to stdout between each lowering step.
 Func lower(Func func, std::ostream* os=nullptr, bool time=false);
 
+/// Optimize and lower `func` for the given `backend` (e.g. "cpu-parallel"),
+/// which must be the backend that compiles the lowered function.
+Func lower(Func func, const std::string& backend, std::ostream* os=nullptr,
+           bool time=false);
+
 }}
 #endif
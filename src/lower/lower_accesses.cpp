@@ -83,6 +83,20 @@ static Stmt createStoreStmt(Expr tensor, Expr index, Expr value,
   }
 }
 
+/// True iff `tensor` is a set field whose element tensors are not stored
+/// contiguously, because it has blocks and an SoA or AoSoA layout.
+static bool isInterleavedField(Expr tensor) {
+  if (!isa<FieldRead>(tensor) ||
+      !to<FieldRead>(tensor)->elementOrSet.type().isSet()) {
+    return false;
+  }
+  const FieldRead *fieldRead = to<FieldRead>(tensor);
+  FieldLayout layout = getFieldLayout(fieldRead->elementOrSet,
+                                      fieldRead->fieldName);
+  return layout.getKind() != FieldLayout::AoS &&
+         !isScalar(tensor.type().toTensor()->getBlockType());
+}
+
 class LowerTensorAccesses : public IRRewriter {
 public:
   LowerTensorAccesses(const Storage &storage) : storage(storage) {}
@@ -244,8 +258,114 @@ private:
     return index;
   }
 
+  /// The location of component `component` of `element`'s tensor in the
+  /// interleaved set field `field`.
+  static Expr interleavedFieldIndex(const FieldRead *field, Expr element,
+                                    Expr component) {
+    FieldLayout layout = getFieldLayout(field->elementOrSet, field->fieldName);
+    switch (layout.getKind()) {
+      case FieldLayout::SoA: {
+        // Each component is stored in an array with room for every element
+        // the set has capacity for
+        Expr capacity = IndexRead::make(field->elementOrSet,
+                                        IndexRead::Capacity);
+        return Add::make(Mul::make(component, capacity), element);
+      }
+      case FieldLayout::AoSoA: {
+        // Tiles of laneWidth elements store each component contiguously
+        Type blockType = field->type.toTensor()->getBlockType();
+        Expr laneWidth = Literal::make(layout.getLaneWidth());
+        Expr tileSize = Mul::make(laneWidth, createLengthComputation(
+            blockType.toTensor()->getDimensions()));
+        return Add::make(Add::make(Mul::make(Div::make(element, laneWidth),
+                                             tileSize),
+                                   Mul::make(component, laneWidth)),
+                         Rem::make(element, laneWidth));
+      }
+      case FieldLayout::AoS:
+        unreachable;
+        break;
+    }
+    return Expr();
+  }
+
+  /// Flatten the indices of a component of an interleaved set field, which is
+  /// accessed as `field(element)(componentIndices...)`.
+  Expr flattenFieldComponentIndices(const TensorRead *elementRead,
+                                    std::vector<Expr> componentIndices) {
+    iassert(elementRead->indices.size() == 1);
+    Expr element = rewrite(elementRead->indices[0]);
+    Expr component = flattenIndices(elementRead, componentIndices);
+    return interleavedFieldIndex(to<FieldRead>(elementRead->tensor), element,
+                                 component);
+  }
+
+  /// Copy every component of an element's tensor, which is stored contiguously
+  /// in `dense` and interleaved in `field`. The copy goes into the field if
+  /// `toField` is true, and out of it otherwise.
+  static Stmt copyFieldTensor(const FieldRead *field, Expr element, Expr dense,
+                              bool toField, CompoundOperator cop) {
+    Type blockType = field->type.toTensor()->getBlockType();
+    Var component(INTERNAL_PREFIX("component"), Int);
+    Expr fieldIndex = interleavedFieldIndex(field, element, component);
+    Expr value = isScalar(dense.type()) ? dense : Load::make(dense, component);
+    Stmt copy = toField
+        ? Store::make(field, fieldIndex, value, cop)
+        : Store::make(dense, component, Load::make(field, fieldIndex), cop);
+    return ForRange::make(component, 0,
+                          createLengthComputation(
+                              blockType.toTensor()->getDimensions()),
+                          copy);
+  }
+
+  void visit(const FieldRead *op) {
+    tassert(!isInterleavedField(op))
+        << "Only element-wise accesses to the components of "
+        << getFieldLayout(op->elementOrSet, op->fieldName)
+        << " fields are currently supported, but " << quote(Expr(op))
+        << " is accessed as a whole";
+    IRRewriter::visit(op);
+  }
+
+  void visit(const FieldWrite *op) {
+    // SoA fields are contiguous as a whole, so they can still be cleared
+    if (op->elementOrSet.type().isSet()) {
+      Expr field = FieldRead::make(op->elementOrSet, op->fieldName);
+      FieldLayout layout = getFieldLayout(op->elementOrSet, op->fieldName);
+      tassert(!isInterleavedField(field) ||
+              (layout.getKind() == FieldLayout::SoA &&
+               isScalar(op->value.type())))
+          << "Only element-wise writes to " << layout << " fields are "
+          << "currently supported, but " << quote(field)
+          << " is written as a whole";
+    }
+    IRRewriter::visit(op);
+  }
+
+  void visit(const AssignStmt *op) {
+    // Whole tensors of interleaved fields are copied component by component
+    if (isa<TensorRead>(op->value) &&
+        isInterleavedField(to<TensorRead>(op->value)->tensor)) {
+      const TensorRead *elementRead = to<TensorRead>(op->value);
+      iassert(elementRead->indices.size() == 1);
+      stmt = copyFieldTensor(to<FieldRead>(elementRead->tensor),
+                             rewrite(elementRead->indices[0]),
+                             VarExpr::make(op->var), false, op->cop);
+      return;
+    }
+    IRRewriter::visit(op);
+  }
+
   void visit(const TensorRead *op) {
     iassert(op->type.isTensor() && op->tensor.type().toTensor());
+    if (isa<TensorRead>(op->tensor) &&
+        isInterleavedField(to<TensorRead>(op->tensor)->tensor)) {
+      const TensorRead *elementRead = to<TensorRead>(op->tensor);
+      expr = Load::make(elementRead->tensor,
+                        flattenFieldComponentIndices(elementRead, op->indices));
+      return;
+    }
+
     Expr tensor = rewrite(op->tensor);
     Expr index = flattenIndices(op->tensor, op->indices);
     expr = createLoadExpr(tensor, index);
@@ -253,6 +373,25 @@ private:
 
   void visit(const TensorWrite *op) {
     iassert(op->tensor.type().isTensor());
+    if (isa<TensorRead>(op->tensor) &&
+        isInterleavedField(to<TensorRead>(op->tensor)->tensor)) {
+      const TensorRead *elementRead = to<TensorRead>(op->tensor);
+      Expr index = flattenFieldComponentIndices(elementRead, op->indices);
+      stmt = Store::make(elementRead->tensor, index, rewrite(op->value),
+                         op->cop);
+      return;
+    }
+    if (isInterleavedField(op->tensor)) {
+      iassert(op->indices.size() == 1);
+      Expr value = rewrite(op->value);
+      tassert(isScalar(value.type()) || isa<VarExpr>(value))
+          << "Only locals and scalars can currently be written to the tensors "
+          << "of interleaved fields";
+      stmt = copyFieldTensor(to<FieldRead>(op->tensor),
+                             rewrite(op->indices[0]), value, true, op->cop);
+      return;
+    }
+
     Expr tensor = rewrite(op->tensor);
     Expr value = rewrite(op->value);
     Expr index = flattenIndices(op->tensor, op->indices);
@@ -1,8 +1,11 @@
 #include "lower_maps.h"
 
+#include "init.h"
+#include "macros.h"
 #include "storage.h"
 #include "ir_builder.h"
 #include "ir_rewriter.h"
+#include "ir_visitor.h"
 #include "ir_transforms.h"
 #include "inline.h"
 #include "path_expressions.h"
@@ -33,24 +36,38 @@ inline bool hasSameStorage(std::vector<Var> vars, const Storage &storage) {
 }
 
 class LowerMapFunctionRewriter : public MapFunctionRewriter {
+public:
+  LowerMapFunctionRewriter() {}
+
+  /// Create a rewriter for a gather map, where the loop over the target set is
+  /// nested in a loop over the endpoints `owner`. Each iteration then only
+  /// accumulates the results written to its owner.
+  LowerMapFunctionRewriter(Var owner) : owner(owner) {}
+
+private:
+  Var owner;
 
   /// Change assignments to result to compound  assignments, using the map
   /// reduction operator.
   Stmt makeCompoundTensorWrite(Expr tensor, vector<Expr> indices, Expr value) {
-    switch (reduction.getKind()) {
-      case ReductionOperator::Sum: {
-        return TensorWrite::make(tensor, indices, value, CompoundOperator::Add);
-      }
-      case ReductionOperator::Undefined: {
-        return TensorWrite::make(tensor, indices, value);
-      }
-    }
-    unreachable;
-    return Stmt();
+    return TensorWrite::make(tensor, indices, value,
+                             getCompoundOperator(reduction));
   }
 
   using MapFunctionRewriter::visit;
 
+  /// Scalar results are reduced over every element of the target set.
+  void visit(const AssignStmt *op) {
+    if (isResult(op->var) &&
+        reduction.getKind() != ReductionOperator::Undefined) {
+      stmt = AssignStmt::make(getMapVar(op->var), rewrite(op->value),
+                              getCompoundOperator(reduction));
+    }
+    else {
+      MapFunctionRewriter::visit(op);
+    }
+  }
+
   void visit(const TensorWrite *op) {
     // Rewrites the tensor write and assigns the result to stmt
     IRRewriter::visit(op);
@@ -119,6 +136,13 @@ class LowerMapFunctionRewriter : public MapFunctionRewriter {
         stmt = makeCompoundTensorWrite(rewrite(op->tensor), {indexExpr},
                                        rewrite(op->value));
       }
+      else if (owner.defined()) {
+        iassert(tensorWrite->indices.size() == 1);
+        Stmt write = makeCompoundTensorWrite(tensorWrite->tensor, {owner},
+                                             tensorWrite->value);
+        stmt = IfThenElse::make(Eq::make(tensorWrite->indices[0], owner),
+                                write);
+      }
       else {
         stmt = makeCompoundTensorWrite(tensorWrite->tensor,tensorWrite->indices,
                                        tensorWrite->value);
@@ -128,14 +152,196 @@ class LowerMapFunctionRewriter : public MapFunctionRewriter {
   }
 };
 
+inline bool isSameSet(Expr a, Expr b) {
+  return a == b || (isa<VarExpr>(a) && isa<VarExpr>(b) &&
+                    to<VarExpr>(a)->var == to<VarExpr>(b)->var);
+}
+
+/// Returns the endpoint set `V` of the target edge set of `map`, if the map
+/// should be lowered to gather into `V` instead of scattering from the edges.
+/// A map can gather if it sums vectors over `V` that it only writes at the
+/// endpoints of each edge, and the edges have at most `kGatherMaxArity`
+/// endpoints, since the gather loop evaluates the mapped function once for
+/// each endpoint of every edge.
+static Expr getGatherSet(const Map *map, const Storage &storage) {
+  if (map->reduction.getKind() != ReductionOperator::Sum ||
+      map->through.defined() || !isa<VarExpr>(map->target) ||
+      !map->target.type().isUnstructuredSet()) {
+    return Expr();
+  }
+
+  const auto& endpoints = map->target.type().toUnstructuredSet()->endpointSets;
+  const int cardinality = endpoints.size();
+  if (cardinality == 0 || cardinality > kGatherMaxArity ||
+      !isa<VarExpr>(*endpoints[0])) {
+    return Expr();
+  }
+  Expr gatherSet = *endpoints[0];
+  for (auto& endpoint : endpoints) {
+    if (!isSameSet(*endpoint, gatherSet)) return Expr();
+  }
+
+  for (auto& var : map->vars) {
+    if (!var.getType().isTensor() ||
+        storage.getStorage(var).getKind() != TensorStorage::Dense) {
+      return Expr();
+    }
+    const TensorType* type = var.getType().toTensor();
+    if (type->order() != 1 ||
+        type->getOuterDimensions()[0].getKind() != IndexSet::Set ||
+        !isSameSet(type->getOuterDimensions()[0].getSet(), gatherSet)) {
+      return Expr();
+    }
+  }
+
+  // The results must only be written, at endpoints of the target element, and
+  // the target and neighbors must only be read.
+  class GatherableWrites : public IRVisitor {
+  public:
+    GatherableWrites(const Map *map) : gatherable(true) {
+      const Func& kernel = map->function;
+      results.insert(kernel.getResults().begin(), kernel.getResults().end());
+      size_t neighborsLoc = map->partial_actuals.size() + 1;
+      if (kernel.getArguments().size() > neighborsLoc) {
+        neighbors = kernel.getArguments()[neighborsLoc];
+      }
+    }
+
+    bool gatherable;
+
+  private:
+    std::set<Var> results;
+    Var neighbors;
+
+    using IRVisitor::visit;
+
+    bool isResult(Expr tensor) {
+      return isa<VarExpr>(tensor) &&
+             util::contains(results, to<VarExpr>(tensor)->var);
+    }
+
+    bool isEndpoint(Expr index) {
+      Expr tuple;
+      if (isa<UnnamedTupleRead>(index)) {
+        tuple = to<UnnamedTupleRead>(index)->tuple;
+      }
+      else if (isa<NamedTupleRead>(index)) {
+        tuple = to<NamedTupleRead>(index)->tuple;
+      }
+      return tuple.defined() && isa<VarExpr>(tuple) && neighbors.defined() &&
+             to<VarExpr>(tuple)->var == neighbors;
+    }
+
+    void visit(const TensorWrite *op) {
+      if (isResult(op->tensor)) {
+        if (op->indices.size() != 1 || !isEndpoint(op->indices[0])) {
+          gatherable = false;
+        }
+        op->value.accept(this);
+        return;
+      }
+      IRVisitor::visit(op);
+    }
+
+    void visit(const VarExpr *op) {
+      if (util::contains(results, op->var)) {
+        gatherable = false;
+      }
+    }
+
+    void visit(const AssignStmt *op) {
+      if (util::contains(results, op->var)) {
+        gatherable = false;
+      }
+      IRVisitor::visit(op);
+    }
+
+    void visit(const FieldWrite *op) {
+      gatherable = false;
+    }
+
+    void visit(const CallStmt *op) {
+      for (auto& result : op->results) {
+        if (util::contains(results, result)) {
+          gatherable = false;
+        }
+      }
+      IRVisitor::visit(op);
+    }
+  };
+  GatherableWrites gatherableWrites(map);
+  map->function.getBody().accept(&gatherableWrites);
+  return gatherableWrites.gatherable ? gatherSet : Expr();
+}
+
+/// Nest the loop over the target edges of an inlined gather map in a loop over
+/// their endpoints `owner`, that visits the edges incident to each endpoint
+/// through the ve index `index`:
+/// ~~~~~~~~~~~~~~~
+///   for v in V
+///     .prev = -1;
+///     for .k in V_E_index.coords[v]:V_E_index.coords[v+1]
+///       e = V_E_index.sinks[.k];
+///       if e != .prev
+///         ...
+///       end
+///       .prev = e;
+///     end
+///   end
+/// ~~~~~~~~~~~~~~~
+/// Neighbor lists are sorted, so an edge that connects an endpoint to itself
+/// appears as a run of repeated neighbors, of which only the first is visited.
+static Stmt nestInGatherLoop(Stmt inlinedMap, Var owner, Expr gatherSet,
+                             const TensorIndex& index) {
+  class NestInGatherLoop : public IRRewriter {
+  public:
+    NestInGatherLoop(Var owner, Expr gatherSet, const TensorIndex& index)
+        : nested(false), owner(owner), gatherSet(gatherSet), index(index) {}
+
+    bool nested;
+
+  private:
+    Var owner;
+    Expr gatherSet;
+    TensorIndex index;
+
+    using IRRewriter::visit;
+
+    void visit(const For *op) {
+      // The outermost loop is the loop over the target edges
+      iassert(!nested);
+      nested = true;
+
+      Var k(INTERNAL_PREFIX("k"), Int);
+      Var prev(INTERNAL_PREFIX("prev"), Int);
+      Expr coords = index.getRowptrArray();
+      Expr sinks = index.getColidxArray();
+
+      Stmt edge = AssignStmt::make(op->var, Load::make(sinks, k));
+      Stmt visitEdge = IfThenElse::make(Ne::make(op->var, prev), op->body);
+      Stmt incidentEdges = ForRange::make(k, Load::make(coords, owner),
+                                          Load::make(coords, owner+1),
+                                          Block::make({edge, visitEdge,
+                                              AssignStmt::make(prev, op->var)}));
+      stmt = For::make(owner, ForDomain(IndexSet(gatherSet)),
+                       Block::make(AssignStmt::make(prev, -1), incidentEdges));
+    }
+  };
+  NestInGatherLoop rewriter(owner, gatherSet, index);
+  Stmt gatherLoop = rewriter.rewrite(inlinedMap);
+  iassert(rewriter.nested);
+  return gatherLoop;
+}
+
 class LowerMaps : public IRRewriter {
 public:
-  LowerMaps(Storage *storage, Environment *env)
-      : storage(storage), env(env) {}
+  LowerMaps(Storage *storage, Environment *env, bool gather)
+      : storage(storage), env(env), gather(gather) {}
 
 private:
   Storage *storage;
   Environment *env;
+  bool gather;
   
   using IRRewriter::visit;
 
@@ -143,8 +349,28 @@ private:
     iassert(hasStorage(op->vars, *storage))
         << "Every assembled tensor should have a storage descriptor (" << util::join(op->vars) << ")";
 
-    LowerMapFunctionRewriter mapFunctionRewriter;
-    stmt = inlineMap(op, mapFunctionRewriter, storage);
+    Expr gatherSet = gather ? getGatherSet(op, *storage) : Expr();
+    if (gatherSet.defined()) {
+      // Gather the results of the edges incident to each endpoint, so that
+      // every endpoint's results are written by exactly one iteration
+      const Var& edgeSet = to<VarExpr>(op->target)->var;
+      const Var& endpointSet = to<VarExpr>(gatherSet)->var;
+      pe::Var v("v", pe::Set(endpointSet.getName()));
+      pe::Var e("e", pe::Set(edgeSet.getName()));
+      pe::PathExpression ve = pe::Link::make(v, e, pe::Link::ve);
+      env->addTensorIndex(ve, Var(endpointSet.getName() + "_" +
+                                  edgeSet.getName(), Int));
+
+      Var owner("v", Int);
+      LowerMapFunctionRewriter mapFunctionRewriter(owner);
+      stmt = inlineMap(op, mapFunctionRewriter, storage);
+      stmt = nestInGatherLoop(stmt, owner, gatherSet,
+                              env->getTensorIndex(ve));
+    }
+    else {
+      LowerMapFunctionRewriter mapFunctionRewriter;
+      stmt = inlineMap(op, mapFunctionRewriter, storage);
+    }
 
     // Add comment
     stmt = Comment::make(util::toString(*op), stmt, true);
@@ -172,8 +398,8 @@ private:
   }
 };
 
-Func lowerMaps(Func func) {
-  LowerMaps rewriter(&func.getStorage(),&func.getEnvironment());
+Func lowerMaps(Func func, bool gather) {
+  LowerMaps rewriter(&func.getStorage(), &func.getEnvironment(), gather);
   Stmt body = rewriter.rewrite(func.getBody());
   func = Func(func, body);
   func = insertVarDecls(func);
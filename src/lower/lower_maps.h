@@ -7,8 +7,11 @@ namespace simit {
 namespace ir {
 
 /// Lower map statements to loops. Map assemblies are lowered to loops that
-/// store the resulting tensors as specified by Func's Storage descriptor.
-Func lowerMaps(Func func);
+/// store the resulting tensors as specified by Func's Storage descriptor. If
+/// `gather` is true, vector sums over the endpoints of an edge set are lowered
+/// to loops over the endpoints that gather from their incident edges, so that
+/// parallel backends write every result from a single iteration.
+Func lowerMaps(Func func, bool gather=false);
 
 }}
 #endif
@@ -0,0 +1,580 @@
+#include "parallel_loops.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "environment.h"
+#include "intrinsics.h"
+#include "ir_visitor.h"
+#include "path_expressions.h"
+#include "rw_analysis.h"
+#include "tensor_index.h"
+#include "util/collections.h"
+
+using namespace std;
+
+namespace simit {
+namespace ir {
+
+/// An integer index expression of the form `coeff*base + offset`, where `base`
+/// is a value owned by the iteration (e.g. the loop variable) and `offset` is
+/// known to lie in [lo, hi].
+struct AffineIndex {
+  bool valid;
+  long coeff;
+  long lo;
+  long hi;
+
+  AffineIndex() : valid(false), coeff(0), lo(0), hi(0) {}
+  AffineIndex(long coeff, long lo, long hi)
+      : valid(true), coeff(coeff), lo(lo), hi(hi) {}
+
+  bool isConstant() const {return valid && coeff == 0 && lo == hi;}
+
+  /// True iff the index only reaches locations that belong to the base, i.e.
+  /// [coeff*base, coeff*(base+1)).
+  bool isOwned() const {return valid && coeff >= 1 && lo >= 0 && hi < coeff;}
+};
+
+static AffineIndex scale(const AffineIndex& a, long c) {
+  return (c >= 0) ? AffineIndex(a.coeff*c, a.lo*c, a.hi*c)
+                  : AffineIndex(a.coeff*c, a.hi*c, a.lo*c);
+}
+
+static AffineIndex getAffineIndex(const Expr& expr,
+                                  const function<bool(const Expr&)>& isBase,
+                                  const map<Var,pair<long,long>>& ranges) {
+  if (isBase(expr)) {
+    return AffineIndex(1, 0, 0);
+  }
+  else if (isa<Literal>(expr)) {
+    if (!isInt(expr.type())) return AffineIndex();
+    long val = to<Literal>(expr)->getIntVal(0);
+    return AffineIndex(0, val, val);
+  }
+  else if (isa<VarExpr>(expr)) {
+    const Var& var = to<VarExpr>(expr)->var;
+    if (util::contains(ranges, var)) {
+      return AffineIndex(0, ranges.at(var).first, ranges.at(var).second);
+    }
+  }
+  else if (isa<Add>(expr)) {
+    AffineIndex a = getAffineIndex(to<Add>(expr)->a, isBase, ranges);
+    AffineIndex b = getAffineIndex(to<Add>(expr)->b, isBase, ranges);
+    if (a.valid && b.valid) {
+      return AffineIndex(a.coeff+b.coeff, a.lo+b.lo, a.hi+b.hi);
+    }
+  }
+  else if (isa<Sub>(expr)) {
+    AffineIndex a = getAffineIndex(to<Sub>(expr)->a, isBase, ranges);
+    AffineIndex b = getAffineIndex(to<Sub>(expr)->b, isBase, ranges);
+    if (a.valid && b.valid) {
+      return AffineIndex(a.coeff-b.coeff, a.lo-b.hi, a.hi-b.lo);
+    }
+  }
+  else if (isa<Mul>(expr)) {
+    AffineIndex a = getAffineIndex(to<Mul>(expr)->a, isBase, ranges);
+    AffineIndex b = getAffineIndex(to<Mul>(expr)->b, isBase, ranges);
+    if (a.isConstant() && b.valid) {
+      return scale(b, a.lo);
+    }
+    else if (b.isConstant() && a.valid) {
+      return scale(a, b.lo);
+    }
+  }
+  return AffineIndex();
+}
+
+/// A buffer is identified by the tensor variable that holds it, or by the set
+/// variable and field name of a set field.
+typedef pair<Var,string> BufferKey;
+
+static bool getBufferKey(const Expr& buffer, BufferKey* key) {
+  if (isa<VarExpr>(buffer)) {
+    *key = BufferKey(to<VarExpr>(buffer)->var, "");
+    return true;
+  }
+  else if (isa<FieldRead>(buffer) &&
+           isa<VarExpr>(to<FieldRead>(buffer)->elementOrSet)) {
+    const FieldRead* fieldRead = to<FieldRead>(buffer);
+    *key = BufferKey(to<VarExpr>(fieldRead->elementOrSet)->var,
+                     fieldRead->fieldName);
+    return true;
+  }
+  return false;
+}
+
+/// Strip the component offset from an index into an SoA set field, which has
+/// the form `component*capacity + element`, since every component array is
+/// owned by the same elements.
+static Expr getSoAElementIndex(const Expr& buffer, const Expr& index) {
+  if (!isa<FieldRead>(buffer) || !isa<Add>(index) ||
+      !isa<Mul>(to<Add>(index)->a) ||
+      !isa<IndexRead>(to<Mul>(to<Add>(index)->a)->b)) {
+    return index;
+  }
+  const FieldRead* fieldRead = to<FieldRead>(buffer);
+  const IndexRead* capacity = to<IndexRead>(to<Mul>(to<Add>(index)->a)->b);
+  const Expr& set = fieldRead->elementOrSet;
+  if (!set.type().isSet() ||
+      getFieldLayout(set, fieldRead->fieldName).getKind() != FieldLayout::SoA ||
+      capacity->kind != IndexRead::Capacity ||
+      !isa<VarExpr>(set) || !isa<VarExpr>(capacity->edgeSet) ||
+      to<VarExpr>(set)->var != to<VarExpr>(capacity->edgeSet)->var) {
+    return index;
+  }
+  return to<Add>(index)->b;
+}
+
+/// The values the analysis tracks through the loop's private variables. An
+/// element is the current iteration's element, an endpoint is one of its
+/// endpoints, and a loc is a location in a sparse matrix whose row is the
+/// element or one of its endpoints.
+enum ValueKind {Unset, Element, ElementLoc, Endpoint, EndpointLoc, Unknown};
+
+static ValueKind merge(ValueKind a, ValueKind b) {
+  if (a == Unset) return b;
+  if (b == Unset) return a;
+  return (a == b) ? a : Unknown;
+}
+
+/// A shared buffer access, whose index is relative to a value of kind `base`.
+struct Access {
+  ValueKind base;
+  AffineIndex index;
+  Access(ValueKind base, AffineIndex index) : base(base), index(index) {}
+};
+
+/// Returns the reduction operator a compound assignment combines values with,
+/// or the undefined operator if it is not associative and commutative.
+static ReductionOperator getReductionOperator(CompoundOperator cop) {
+  switch (cop) {
+    case CompoundOperator::Add:
+      return ReductionOperator::Sum;
+    case CompoundOperator::Mul:
+      return ReductionOperator::Product;
+    case CompoundOperator::Max:
+      return ReductionOperator::Max;
+    case CompoundOperator::Min:
+      return ReductionOperator::Min;
+    case CompoundOperator::None:
+    case CompoundOperator::Sub:
+      break;
+  }
+  return ReductionOperator();
+}
+
+class LoopParallelismAnalysis : public IRVisitor {
+public:
+  LoopParallelismAnalysis(const For* loop, const Environment* env)
+      : loop(loop), serial(false), conditional(0) {
+    // Location tables hold the locs of the non-zeros each element of their
+    // index's edge set assembles into
+    const Expr& loopSet = loop->domain.indexSet.getSet();
+    if (env != nullptr && isa<VarExpr>(loopSet)) {
+      for (const TensorIndex& index : env->getTensorIndices()) {
+        if (index.getKind() != TensorIndex::PExpr) {
+          continue;
+        }
+        pe::Set edgeSet = pe::getEdgeSet(index.getPathExpression());
+        if (edgeSet.defined() &&
+            edgeSet.getName() == to<VarExpr>(loopSet)->var.getName()) {
+          locationTables.insert(index.getLocationsArray());
+        }
+      }
+    }
+  }
+
+  LoopParallelism::Kind analyze() {
+    // Private variable kinds only grow, so iterate until they are stable
+    map<Var,ValueKind> previous;
+    do {
+      previous = kinds;
+      serial = false;
+      privateVars.clear();
+      privateVars.insert(loop->var);
+      ranges.clear();
+      loads.clear();
+      stores.clear();
+      escaped.clear();
+      reductionVars.clear();
+      sharedReads.clear();
+      loop->body.accept(this);
+    } while (kinds != previous);
+    return getKind();
+  }
+
+  const set<Var>& getPrivateVars() const {return privateVars;}
+
+  const map<Var,ReductionOperator>& getReductionVars() const {
+    return reductionVars;
+  }
+
+private:
+  const For* loop;
+  bool serial;
+  set<Var> privateVars;
+  set<Var> locationTables;
+  map<Var,pair<long,long>> ranges;
+  map<Var,ValueKind> kinds;
+
+  /// Number of enclosing statements that may not execute every iteration.
+  int conditional;
+
+  map<BufferKey,vector<Access>> loads;
+  map<BufferKey,vector<Access>> stores;
+
+  /// Buffers that are referenced other than through loads and stores.
+  set<BufferKey> escaped;
+
+  /// Shared scalars that are only combined into, and the shared scalars that
+  /// are read. A reduction result must not be read inside the loop.
+  map<Var,ReductionOperator> reductionVars;
+  set<Var> sharedReads;
+
+  /// Returns Serial if two iterations may access the same location of a
+  /// shared buffer that one of them writes, Colored if only iterations that
+  /// share an endpoint may do so, and Independent otherwise.
+  LoopParallelism::Kind getKind() const {
+    if (serial) {
+      return LoopParallelism::Serial;
+    }
+    for (auto& reductionVar : reductionVars) {
+      if (util::contains(sharedReads, reductionVar.first)) {
+        return LoopParallelism::Serial;
+      }
+    }
+    LoopParallelism::Kind kind = LoopParallelism::Independent;
+    for (auto& store : stores) {
+      const BufferKey& key = store.first;
+      if (util::contains(escaped, key)) {
+        return LoopParallelism::Serial;
+      }
+      vector<Access> accesses = store.second;
+      if (util::contains(loads, key)) {
+        accesses.insert(accesses.end(), loads.at(key).begin(),
+                        loads.at(key).end());
+      }
+      const Access& first = accesses[0];
+      for (const Access& access : accesses) {
+        if (!access.index.isOwned() || access.base != first.base ||
+            access.index.coeff != first.index.coeff) {
+          return LoopParallelism::Serial;
+        }
+      }
+      if (first.base == Endpoint || first.base == EndpointLoc) {
+        kind = LoopParallelism::Colored;
+      }
+    }
+    return kind;
+  }
+
+  bool isPrivate(const Var& var) const {
+    return util::contains(privateVars, var);
+  }
+
+  ValueKind getValueKind(const Expr& expr) const {
+    if (isa<VarExpr>(expr)) {
+      const Var& var = to<VarExpr>(expr)->var;
+      if (var == loop->var) {
+        return Element;
+      }
+      return util::contains(kinds, var) ? kinds.at(var) : Unknown;
+    }
+    else if (isa<Load>(expr)) {
+      const Load* load = to<Load>(expr);
+      if (isa<VarExpr>(load->buffer)) {
+        const Var& var = to<VarExpr>(load->buffer)->var;
+        if (util::contains(locationTables, var)) {
+          return isLocationTableIndex(load->index) ? EndpointLoc : Unknown;
+        }
+        return util::contains(kinds, var) ? kinds.at(var) : Unknown;
+      }
+      else if (isa<IndexRead>(load->buffer) &&
+               to<IndexRead>(load->buffer)->kind == IndexRead::Endpoints &&
+               isLoopSet(to<IndexRead>(load->buffer)->edgeSet) &&
+               isEndpointIndex(load->index)) {
+        return Endpoint;
+      }
+    }
+    return Unknown;
+  }
+
+  bool isLoopSet(const Expr& set) const {
+    const Expr& loopSet = loop->domain.indexSet.getSet();
+    return isa<VarExpr>(set) && isa<VarExpr>(loopSet) &&
+           to<VarExpr>(set)->var == to<VarExpr>(loopSet)->var;
+  }
+
+  /// True iff `index` reaches one of the current element's endpoints.
+  bool isEndpointIndex(const Expr& index) const {
+    const Type& setType = loop->domain.indexSet.getSet().type();
+    if (!setType.isUnstructuredSet()) {
+      return false;
+    }
+    AffineIndex affine = getAffineIndex(index, [this](const Expr& e) {
+      return getValueKind(e) == Element;
+    }, ranges);
+    return affine.isOwned() &&
+           affine.coeff == (long)setType.toUnstructuredSet()->getCardinality();
+  }
+
+  /// True iff `index` reaches one of the current element's entries in a
+  /// location table, which are laid out as `(e*card + i)*card + j` for vv
+  /// matrices and `e*card + i` for ve matrices. Either way the entry is a loc
+  /// in the row of the element's endpoint `i`.
+  bool isLocationTableIndex(const Expr& index) const {
+    const Type& setType = loop->domain.indexSet.getSet().type();
+    if (!setType.isUnstructuredSet()) {
+      return false;
+    }
+    AffineIndex affine = getAffineIndex(index, [this](const Expr& e) {
+      return getValueKind(e) == Element;
+    }, ranges);
+    long card = setType.toUnstructuredSet()->getCardinality();
+    return affine.isOwned() &&
+           (affine.coeff == card || affine.coeff == card*card);
+  }
+
+  /// Determine what a shared buffer index is relative to.
+  Access getAccess(const Expr& index) const {
+    for (ValueKind base : {Element, ElementLoc, Endpoint, EndpointLoc}) {
+      AffineIndex affine = getAffineIndex(index, [this,base](const Expr& e) {
+        return getValueKind(e) == base;
+      }, ranges);
+      if (affine.valid && affine.coeff != 0) {
+        return Access(base, affine);
+      }
+    }
+    return Access(Unknown, AffineIndex());
+  }
+
+  void define(const Var& var, ValueKind kind) {
+    if (conditional > 0) {
+      kind = Unknown;
+    }
+    kinds[var] = merge(util::contains(kinds, var) ? kinds.at(var) : Unset,
+                       kind);
+  }
+
+  using IRVisitor::visit;
+
+  void visit(const VarExpr* op) {
+    if (op->type.isTensor() && !isPrivate(op->var)) {
+      if (isScalar(op->type)) {
+        sharedReads.insert(op->var);
+      }
+      else {
+        escaped.insert(BufferKey(op->var, ""));
+      }
+    }
+  }
+
+  void visit(const FieldRead* op) {
+    BufferKey key;
+    if (getBufferKey(op, &key)) {
+      escaped.insert(key);
+    }
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Load* op) {
+    BufferKey key;
+    if (getBufferKey(op->buffer, &key)) {
+      if (!isPrivate(key.first)) {
+        loads[key].push_back(getAccess(getSoAElementIndex(op->buffer,
+                                                          op->index)));
+      }
+    }
+    else {
+      op->buffer.accept(this);
+    }
+    op->index.accept(this);
+  }
+
+  void visit(const Store* op) {
+    BufferKey key;
+    if (!getBufferKey(op->buffer, &key)) {
+      serial = true;
+      return;
+    }
+    if (!isPrivate(key.first)) {
+      stores[key].push_back(getAccess(getSoAElementIndex(op->buffer,
+                                                         op->index)));
+    }
+    else if (key.second == "") {
+      define(key.first, (op->cop == CompoundOperator::None)
+                        ? getValueKind(op->value) : Unknown);
+    }
+    op->index.accept(this);
+    op->value.accept(this);
+  }
+
+  void visit(const VarDecl* op) {
+    // Private tensors are allocated per iteration, which we can only afford
+    // for tensors that are not set sized.
+    const Type& type = op->var.getType();
+    if (type.isTensor() && type.toTensor()->hasSystemDimensions()) {
+      serial = true;
+    }
+    privateVars.insert(op->var);
+  }
+
+  void visit(const AssignStmt* op) {
+    if (!isPrivate(op->var)) {
+      // Every thread can combine values into its own partial result of an
+      // associative reduction into a shared scalar
+      ReductionOperator rop = getReductionOperator(op->cop);
+      if (!isScalar(op->var.getType()) ||
+          rop.getKind() == ReductionOperator::Undefined ||
+          (util::contains(reductionVars, op->var) &&
+           reductionVars.at(op->var).getKind() != rop.getKind())) {
+        serial = true;
+        return;
+      }
+      reductionVars[op->var] = rop;
+      op->value.accept(this);
+      return;
+    }
+    define(op->var, (op->cop == CompoundOperator::None)
+                    ? getValueKind(op->value) : Unknown);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const CallStmt* op) {
+    for (const Var& result : op->results) {
+      if (!isPrivate(result)) {
+        serial = true;
+        return;
+      }
+    }
+
+    switch (op->callee.getKind()) {
+      case Func::Intrinsic:
+        if (!intrinsics::isPure(op->callee)) {
+          serial = true;
+          return;
+        }
+        break;
+      case Func::Internal: {
+        // Internal functions may write their arguments
+        ReadWriteAnalysis rwAnalysis(op->callee.getArguments());
+        op->callee.getBody().accept(&rwAnalysis);
+        for (size_t i = 0; i < op->actuals.size(); ++i) {
+          if (util::contains(rwAnalysis.getWrites(),
+                             op->callee.getArguments()[i]) &&
+              !(isa<VarExpr>(op->actuals[i]) &&
+                isPrivate(to<VarExpr>(op->actuals[i])->var))) {
+            serial = true;
+            return;
+          }
+        }
+        break;
+      }
+      case Func::External:
+        serial = true;
+        return;
+    }
+
+    // A loc is owned by the element whose row it is in
+    ValueKind resultKind = Unknown;
+    if (op->callee == intrinsics::loc()) {
+      switch (getValueKind(op->actuals[0])) {
+        case Element:
+          resultKind = ElementLoc;
+          break;
+        case Endpoint:
+          resultKind = EndpointLoc;
+          break;
+        default:
+          break;
+      }
+    }
+    for (const Var& result : op->results) {
+      define(result, resultKind);
+    }
+    IRVisitor::visit(op);
+  }
+
+  void visit(const ForRange* op) {
+    privateVars.insert(op->var);
+    bool literalBounds = isa<Literal>(op->start) && isInt(op->start.type()) &&
+                         isa<Literal>(op->end) && isInt(op->end.type());
+    if (literalBounds) {
+      ranges[op->var] = pair<long,long>(to<Literal>(op->start)->getIntVal(0),
+                                        to<Literal>(op->end)->getIntVal(0)-1);
+    }
+    else {
+      ++conditional;
+    }
+    IRVisitor::visit(op);
+    if (!literalBounds) {
+      --conditional;
+    }
+  }
+
+  void visit(const For* op) {
+    privateVars.insert(op->var);
+    ++conditional;
+    IRVisitor::visit(op);
+    --conditional;
+  }
+
+  void visit(const IfThenElse* op) {
+    ++conditional;
+    IRVisitor::visit(op);
+    --conditional;
+  }
+
+  void visit(const While* op) {
+    ++conditional;
+    IRVisitor::visit(op);
+    --conditional;
+  }
+
+  // Statements that have to execute in program order, or that should have
+  // been lowered away before parallelization.
+  void visit(const FieldWrite*)  {serial = true;}
+  void visit(const TensorWrite*) {serial = true;}
+  void visit(const Print*)       {serial = true;}
+  void visit(const Map*)         {serial = true;}
+  void visit(const Kernel*)      {serial = true;}
+};
+
+LoopParallelism getLoopParallelism(const For* loop, const Environment* env) {
+  LoopParallelism result;
+  if (loop->domain.kind != ForDomain::IndexSet) {
+    return result;
+  }
+
+  LoopParallelismAnalysis analysis(loop, env);
+  LoopParallelism::Kind kind = analysis.analyze();
+
+  if (kind == LoopParallelism::Serial) {
+    return result;
+  }
+
+  result.kind = kind;
+  result.privateVars = analysis.getPrivateVars();
+  result.reductionVars = analysis.getReductionVars();
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const LoopParallelism& p) {
+  switch (p.getKind()) {
+    case LoopParallelism::Serial:
+      os << "serial";
+      break;
+    case LoopParallelism::Independent:
+      os << "independent";
+      break;
+    case LoopParallelism::Colored:
+      os << "colored";
+      break;
+  }
+  return os;
+}
+
+}}
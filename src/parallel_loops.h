@@ -0,0 +1,64 @@
+#ifndef SIMIT_PARALLEL_LOOPS_H
+#define SIMIT_PARALLEL_LOOPS_H
+
+#include <map>
+#include <set>
+#include <ostream>
+
+#include "ir.h"
+
+namespace simit {
+namespace ir {
+class Environment;
+
+/// Describes whether the iterations of a set loop may execute concurrently.
+/// A loop is independent if every variable it assigns is declared in its body,
+/// and every shared buffer it writes is only accessed at locations owned by
+/// the current iteration (e.g. `x[3*i+j]` for `j` in `0:3`), so that no two
+/// iterations touch the same memory. A loop is colored if it also scatters
+/// into locations owned by the endpoints of the current element (e.g. vector
+/// and matrix assembly), so that iterations whose elements do not share an
+/// endpoint can execute concurrently. Shared scalars that the loop only
+/// combines values into with `+=`, `*=`, max or min compound assignments are
+/// reductions, which each thread computes a partial result of.
+class LoopParallelism {
+public:
+  enum Kind {Serial, Independent, Colored};
+
+  LoopParallelism() : kind(Serial) {}
+  LoopParallelism(Kind kind) : kind(kind) {}
+
+  Kind getKind() const {return kind;}
+
+  bool isParallel() const {return kind != Serial;}
+
+  /// The variables declared inside the loop body, including the loop
+  /// variables of nested loops. Each iteration needs its own copy of these.
+  const std::set<Var>& getPrivateVars() const {return privateVars;}
+
+  /// The shared scalar variables the loop reduces into, and their reduction
+  /// operators.
+  const std::map<Var,ReductionOperator>& getReductionVars() const {
+    return reductionVars;
+  }
+
+private:
+  Kind kind;
+  std::set<Var> privateVars;
+  std::map<Var,ReductionOperator> reductionVars;
+
+  friend LoopParallelism getLoopParallelism(const For* loop,
+                                            const Environment* env);
+};
+
+/// Determine whether the iterations of `loop` may run in parallel. If `env` is
+/// given, loads from the location tables of its tensor indices are known to
+/// be locs in the rows of the current element's endpoints.
+LoopParallelism getLoopParallelism(const For* loop,
+                                   const Environment* env=nullptr);
+
+std::ostream& operator<<(std::ostream&, const LoopParallelism&);
+
+}}
+
+#endif
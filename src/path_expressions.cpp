@@ -529,6 +529,32 @@ void PathExpressionPrinter::visit(const Or *pe) {
   os << ")";
 }
 
+Set getEdgeSet(const PathExpression &pe) {
+  class GetEdgeSetVisitor : public PathExpressionVisitor {
+  public:
+    Set edgeSet;
+    bool consistent = true;
+
+  private:
+    using PathExpressionVisitor::visit;
+    void visit(const Link *link) {
+      if (link->getType() == Link::vv) {
+        return;
+      }
+      Set linkEdgeSet = link->getEdgeSet();
+      if (!edgeSet.defined()) {
+        edgeSet = linkEdgeSet;
+      }
+      else if (edgeSet.getName() != linkEdgeSet.getName()) {
+        consistent = false;
+      }
+    }
+  };
+  GetEdgeSetVisitor visitor;
+  pe.accept(&visitor);
+  return visitor.consistent ? visitor.edgeSet : Set();
+}
+
 std::ostream &operator<<(std::ostream& os, const Set& s) {
   os << s.getName();
   return os;
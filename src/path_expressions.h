@@ -402,6 +402,11 @@ protected:
 };
 
 
+/// Returns the edge set that every edge link in `pe` goes through, or an
+/// undefined set if `pe` has no edge links or links through several edge sets.
+Set getEdgeSet(const PathExpression &pe);
+
+
 class PathExpressionPrinter : public PathExpressionVisitor {
 public:
   static const std::string ELEMENTOF;
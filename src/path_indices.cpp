@@ -1,8 +1,10 @@
 #include "path_indices.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stack>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "path_expressions.h"
@@ -127,10 +129,77 @@ SegmentedPathIndex::neighbors(unsigned elemID) const {
     const unsigned *nbrs;
   };
 
-  return new SegmentNeighbors(numNeighbors(elemID),
+  // Merge before reading the segmented vector, which merging replaces
+  merge();
+  iassert(numElems > elemID);
+  return new SegmentNeighbors(coordsData[elemID+1] - coordsData[elemID],
                               &sinksData[coordsData[elemID]]);
 }
 
+void SegmentedPathIndex::append(size_t numElements,
+                                const map<unsigned, vector<unsigned>>& nbrs) {
+  iassert(numElements >= numElems && numElements >= deltaElems)
+      << "path indices can only grow";
+  deltaElems = numElements;
+  for (auto& p : nbrs) {
+    iassert(p.first < numElements);
+    vector<unsigned>& elemNbrs = delta[p.first];
+    if (p.first < numElems && !elemNbrs.empty()) {
+      // Existing elements keep their neighbors sorted
+      vector<unsigned> merged;
+      std::merge(elemNbrs.begin(), elemNbrs.end(),
+                 p.second.begin(), p.second.end(), back_inserter(merged));
+      elemNbrs.swap(merged);
+    }
+    else {
+      elemNbrs.insert(elemNbrs.end(), p.second.begin(), p.second.end());
+    }
+  }
+}
+
+void SegmentedPathIndex::merge() const {
+  if (deltaElems == 0) {
+    return;
+  }
+
+  size_t numNbrs = coordsData[numElems];
+  for (auto& p : delta) {
+    numNbrs += p.second.size();
+  }
+  uint32_t* coords = (uint32_t*)malloc((deltaElems+1)*sizeof(uint32_t));
+  uint32_t* sinks = (uint32_t*)malloc(numNbrs*sizeof(uint32_t));
+
+  auto elemDelta = delta.begin();
+  uint32_t* sink = sinks;
+  for (size_t elem=0; elem < deltaElems; ++elem) {
+    coords[elem] = sink - sinks;
+    const uint32_t* begin = sinksData;
+    const uint32_t* end = sinksData;
+    if (elem < numElems) {
+      begin = &sinksData[coordsData[elem]];
+      end = &sinksData[coordsData[elem+1]];
+    }
+    if (elemDelta != delta.end() && elemDelta->first == elem) {
+      const vector<unsigned>& nbrs = elemDelta->second;
+      sink = std::merge(begin, end, nbrs.begin(), nbrs.end(), sink);
+      ++elemDelta;
+    }
+    else {
+      sink = std::copy(begin, end, sink);
+    }
+  }
+  coords[deltaElems] = sink - sinks;
+  iassert((size_t)(sink - sinks) == numNbrs);
+
+  free(coordsData);
+  free(sinksData);
+  coordsData = coords;
+  sinksData = sinks;
+  numElems = deltaElems;
+  deltaElems = 0;
+  delta.clear();
+}
+
 void SegmentedPathIndex::print(std::ostream &os) const {
   os << "SegmentedPathIndex:";
   os << "\n  ";
@@ -242,6 +311,7 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
           }
 
           pi = new SegmentedPathIndex(n, ptr, idx);;
+          builder->derive(pi, Derivation::EdgesToVertices, link);
           break;
         }
         case Link::ve: {
@@ -271,6 +341,7 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
             }
           }
           pi = pack(pathNeighbors);
+          builder->derive(pi, Derivation::VerticesToEdges, link);
           break;
         }
         case Link::vv: {
@@ -364,6 +435,8 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
       PathExpression rhs = f->getRhs();
 
       map<unsigned, set<unsigned>> pathNeighbors;
+      Derivation composition;
+      composition.kind = Derivation::Composition;
       if (!f->isQuantified()) {
         // Build indices from first to second free variable through lhs and rhs
         PathIndex lhsIndex = buildIndex(lhs, freeVars[0], freeVars[1]);
@@ -417,6 +490,8 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
             }
           }
         }
+        composition.sourceToQuantified = sourceToQuantified;
+        composition.quantifiedToSink = quantifiedToSink;
       }
       // Convert path neighbors to vector values
       map<unsigned, vector<unsigned>> pathNeighborsVec;
@@ -425,6 +500,9 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
             vector<unsigned>(kv.second.begin(), kv.second.end());
       }
       pi = pack(pathNeighborsVec);
+      if (composition.sourceToQuantified.defined()) {
+        builder->derivations[pi.ptr] = composition;
+      }
     }
 
     void visit(const Or *f) {
@@ -529,8 +607,171 @@ PathIndex PathIndexBuilder::buildSegmented(const PathExpression &pe,
   return pi;
 }
 
+void PathIndexBuilder::extend(const std::map<std::string,int>& oldSizes) {
+  /// Computes the elements and neighbors each memoized index gains from the
+  /// appended set elements. All deltas are computed before any index is
+  /// extended, since the deltas of compositions are computed from the old
+  /// neighbors of their operands.
+  class DeltaBuilder {
+  public:
+    struct Delta {
+      size_t numElements;
+      map<unsigned, vector<unsigned>> nbrs;
+    };
+    map<const PathIndexImpl*, Delta> deltas;
+
+    DeltaBuilder(PathIndexBuilder* builder, const map<string,int>& oldSizes)
+        : builder(builder), oldSizes(oldSizes) {}
+
+    /// Compute the delta of `pi`, and return false if it cannot be extended.
+    bool build(const PathIndexImpl* pi) {
+      if (util::contains(deltas, pi)) {
+        return true;
+      }
+      if (util::contains(failed, pi) ||
+          !util::contains(builder->derivations, pi)) {
+        return false;
+      }
+
+      const Derivation& derivation = builder->derivations.at(pi);
+      Delta delta;
+      switch (derivation.kind) {
+        case Derivation::EdgesToVertices:
+        case Derivation::VerticesToEdges: {
+          const simit::Set& edgeSet = *builder->bindings.at(derivation.edgeSet);
+          const simit::Set& vertexSet =
+              *builder->bindings.at(derivation.vertexSet);
+          const int cardinality = edgeSet.getCardinality();
+          const int* endpoints = edgeSet.getEndpointsData();
+          const bool toVertices =
+              (derivation.kind == Derivation::EdgesToVertices);
+          delta.numElements = toVertices ? edgeSet.getSize()
+                                         : vertexSet.getSize();
+          for (int e=getOldSize(derivation.edgeSet); e < edgeSet.getSize();
+               ++e) {
+            if (toVertices) {
+              delta.nbrs[e];
+            }
+            for (int i=0; i < cardinality; ++i) {
+              if (&vertexSet != edgeSet.getEndpointSet(i)) {
+                continue;
+              }
+              unsigned ep = endpoints[e*cardinality + i];
+              if (toVertices) {
+                delta.nbrs[e].push_back(ep);
+              }
+              else {
+                delta.nbrs[ep].push_back(e);
+              }
+            }
+          }
+          break;
+        }
+        case Derivation::Composition: {
+          const PathIndex& sourceToQuantified = derivation.sourceToQuantified;
+          const PathIndex& quantifiedToSink = derivation.quantifiedToSink;
+          if (!build(sourceToQuantified.ptr) || !build(quantifiedToSink.ptr)) {
+            failed.insert(pi);
+            return false;
+          }
+          const Delta& sourceDelta = deltas.at(sourceToQuantified.ptr);
+          const Delta& quantifiedDelta = deltas.at(quantifiedToSink.ptr);
+          const unsigned numQuantified = quantifiedToSink.numElements();
+
+          // Sources reach the sinks of the quantified elements they gained
+          map<unsigned, set<unsigned>> pathNeighbors;
+          for (auto& p : sourceDelta.nbrs) {
+            set<unsigned>& sinks = pathNeighbors[p.first];
+            for (unsigned q : p.second) {
+              if (q < numQuantified) {
+                for (unsigned sink : quantifiedToSink.neighbors(q)) {
+                  sinks.insert(sink);
+                }
+              }
+              if (util::contains(quantifiedDelta.nbrs, q)) {
+                const vector<unsigned>& qSinks = quantifiedDelta.nbrs.at(q);
+                sinks.insert(qSinks.begin(), qSinks.end());
+              }
+            }
+          }
+
+          // and the new sinks of the quantified elements they had
+          bool quantifiedGrew = false;
+          for (auto& p : quantifiedDelta.nbrs) {
+            quantifiedGrew |= (p.first < numQuantified && !p.second.empty());
+          }
+          if (quantifiedGrew) {
+            for (unsigned source : sourceToQuantified) {
+              for (unsigned q : sourceToQuantified.neighbors(source)) {
+                if (util::contains(quantifiedDelta.nbrs, q)) {
+                  const vector<unsigned>& qSinks = quantifiedDelta.nbrs.at(q);
+                  pathNeighbors[source].insert(qSinks.begin(), qSinks.end());
+                }
+              }
+            }
+          }
+
+          delta.numElements = sourceDelta.numElements;
+          const unsigned numSources = pi->numElements();
+          for (auto& p : pathNeighbors) {
+            if (p.first < numSources) {
+              for (unsigned sink : pi->neighbors(p.first)) {
+                p.second.erase(sink);
+              }
+            }
+            delta.nbrs[p.first] = vector<unsigned>(p.second.begin(),
+                                                   p.second.end());
+          }
+          break;
+        }
+      }
+      deltas.insert({pi, delta});
+      return true;
+    }
+
+  private:
+    PathIndexBuilder* builder;
+    const map<string,int>& oldSizes;
+    std::set<const PathIndexImpl*> failed;
+
+    int getOldSize(const string& setName) const {
+      return util::contains(oldSizes, setName)
+             ? oldSizes.at(setName) : builder->bindings.at(setName)->getSize();
+    }
+  };
+
+  DeltaBuilder deltaBuilder(this, oldSizes);
+  for (auto& p : pathIndices) {
+    deltaBuilder.build(p.second.ptr);
+  }
+
+  for (auto it = pathIndices.begin(); it != pathIndices.end();) {
+    const PathIndexImpl* pi = it->second.ptr;
+    if (!util::contains(deltaBuilder.deltas, pi)) {
+      derivations.erase(pi);
+      it = pathIndices.erase(it);
+      continue;
+    }
+    const auto& delta = deltaBuilder.deltas.at(pi);
+    iassert(isa<SegmentedPathIndex>(it->second));
+    static_cast<SegmentedPathIndex*>(it->second.ptr)->append(delta.numElements,
+                                                             delta.nbrs);
+    deltaBuilder.deltas.erase(pi);
+    ++it;
+  }
+}
+
+void PathIndexBuilder::derive(PathIndex pi, Derivation::Kind kind,
+                              const Link* link) {
+  Derivation derivation;
+  derivation.kind = kind;
+  derivation.edgeSet = link->getEdgeSet().getName();
+  derivation.vertexSet = link->getVertexSet().getName();
+  derivations[pi.ptr] = derivation;
+}
+
 void PathIndexBuilder::bind(std::string name, const simit::Set* set) {
-  bindings.insert({name,set});
+  bindings[name] = set;
 }
 
 const simit::Set* PathIndexBuilder::getBinding(pe::Set pset) const {
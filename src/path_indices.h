@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <typeinfo>
+#include <vector>
 
 #include "graph.h"
 #include "path_expressions.h"
@@ -172,6 +173,10 @@ private:
 
 /// In a SegmentedPathIndex the path neighbors are packed into a segmented
 /// vector with no holes. This is equivalent to CSR indices.
+///
+/// Neighbors added to an index that has been built are kept in a delta segment
+/// and merged into the segmented vector when the index is next read, so that
+/// several updates cost a single merge.
 class SegmentedPathIndex : public PathIndexImpl {
 public:
   ~SegmentedPathIndex() {
@@ -179,25 +184,41 @@ public:
     free(sinksData);
   }
 
-  unsigned numElements() const {return numElems;}
-  unsigned numNeighbors() const {return coordsData[numElems];}
+  unsigned numElements() const {merge(); return numElems;}
+  unsigned numNeighbors() const {merge(); return coordsData[numElems];}
 
-  const unsigned* getCoordData() const {return coordsData;}
-  const unsigned* getSinkData() const {return sinksData;}
+  const unsigned* getCoordData() const {merge(); return coordsData;}
+  const unsigned* getSinkData() const {merge(); return sinksData;}
 
   unsigned numNeighbors(unsigned elemID) const {
+    merge();
     iassert(numElems > elemID);
     return coordsData[elemID+1]-coordsData[elemID];
   }
 
   Neighbors neighbors(unsigned elemID) const;
 
+  /// Grow the index to `numElements` elements and add the neighbors in
+  /// `nbrs`. The new neighbors of an existing element must be sorted and must
+  /// not be neighbors of it already, since they are merged into its sorted
+  /// neighbors; those of new elements are kept in the given order.
+  void append(size_t numElements,
+              const std::map<unsigned, std::vector<unsigned>>& nbrs);
+
 private:
   /// Segmented vector, where `coordsData[i]:coordsData[i+1]` is the range of
   /// locations of neighbors of `i` in `sinksData`.
-  size_t numElems;
-  uint32_t* coordsData;
-  uint32_t* sinksData;
+  mutable size_t numElems;
+  mutable uint32_t* coordsData;
+  mutable uint32_t* sinksData;
+
+  /// The delta segment: the number of elements of the index, and the neighbors
+  /// that have been appended but not merged into the segmented vector yet.
+  mutable size_t deltaElems = 0;
+  mutable std::map<unsigned, std::vector<unsigned>> delta;
+
+  /// Merge the delta segment into the segmented vector.
+  void merge() const;
 
   void print(std::ostream &os) const;
 
@@ -237,13 +258,42 @@ public:
   // Build a Segmented path index by evaluating the `pe` over the given graph.
   PathIndex buildSegmented(const PathExpression &pe, unsigned sourceEndpoint);
 
+  /// Extend the path indices built so far with the elements that have since
+  /// been appended to the bound sets, whose sizes when the indices were built
+  /// are given by `oldSizes`. The elements the sets had then, and their
+  /// endpoints, must not have changed. Edge-vertex links, and their
+  /// compositions through a quantified variable, are extended in place, while
+  /// other indices are dropped so that buildSegmented rebuilds them.
+  void extend(const std::map<std::string,int>& oldSizes);
+
+  /// Bind `set` to `name`, replacing the set bound to it, if any.
   void bind(std::string name, const simit::Set* set);
 
   const simit::Set* getBinding(pe::Set pset) const;
   const simit::Set* getBinding(ir::Var var) const;
 
 private:
+  /// How a memoized path index was computed from the bound sets, so that it
+  /// can be extended when elements are appended to them.
+  struct Derivation {
+    enum Kind {EdgesToVertices, VerticesToEdges, Composition};
+    Kind kind;
+
+    /// The edge and vertex sets of links
+    std::string edgeSet;
+    std::string vertexSet;
+
+    /// The indices a composition is computed from, that map its sources to
+    /// the quantified variable, and the quantified variable to its sinks.
+    PathIndex sourceToQuantified;
+    PathIndex quantifiedToSink;
+  };
+
   std::map<std::pair<PathExpression,unsigned>, PathIndex> pathIndices;
+  std::map<const PathIndexImpl*, Derivation> derivations;
+
+  /// Record that `pi` was built from the sets of `link`.
+  void derive(PathIndex pi, Derivation::Kind kind, const Link* link);
   std::map<std::string, const simit::Set*> bindings;
 };
 
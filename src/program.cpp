@@ -20,6 +20,7 @@ namespace simit {
 
 const std::vector<std::string> VALID_BACKENDS = {
   "cpu",
+  "cpu-parallel",
 #ifdef GPU
   "gpu",
 #endif
@@ -27,17 +28,19 @@ const std::vector<std::string> VALID_BACKENDS = {
 std::string kBackend;
 
 static
-Function compile(ir::Func func, backend::Backend *backend, bool addTimers) {
+Function compile(ir::Func func, backend::Backend *backend,
+                 const std::string &backendType, bool addTimers) {
   ir::Storage storage;
   // Fill in storage path expressions, etc.
   /// map<Var,pe::PathExpressions> pes = assignPathExpressions(func);
   /// storage.addPathExpressions(pes);
-  func = lower(func, nullptr, addTimers);
+  func = lower(func, backendType, nullptr, addTimers);
   return Function(backend->compile(func, storage));
 }
 
-static Function compile(ir::Func func, backend::Backend *backend) {
-  return simit::compile(func, backend, false);
+static Function compile(ir::Func func, backend::Backend *backend,
+                        const std::string &backendType) {
+  return simit::compile(func, backend, backendType, false);
 }
 
 // class ProgramContent
@@ -45,6 +48,7 @@ struct Program::ProgramContent {
   internal::ProgramContext ctx;
   internal::Frontend *frontend;
   backend::Backend   *backend;
+  std::string backendType;
   Diagnostics diags;
 };
 
@@ -52,6 +56,7 @@ struct Program::ProgramContent {
 Program::Program() : content(new ProgramContent) {
   content->frontend = new internal::Frontend();
   content->backend =  new backend::Backend(kBackend);
+  content->backendType = kBackend;
 }
 
 Program::~Program() {
@@ -101,14 +106,15 @@ Function Program::compile(const std::string &function) {
   ir::Func simitFunc = content->ctx.getFunction(function);
   uassert(simitFunc.defined()) << "Attempting to compile an unknown function "
                                << "(" << function << ")";
-  return simit::compile(simitFunc, content->backend);
+  return simit::compile(simitFunc, content->backend, content->backendType);
 }
 
 Function Program::compileWithTimers(const std::string &function) {
   ir::Func simitFunc = content->ctx.getFunction(function);
   uassert(simitFunc.defined()) << "Attempting to compile an unknown function "
                                << "(" << function << ")";
-  return simit::compile(simitFunc, content->backend, true);
+  return simit::compile(simitFunc, content->backend, content->backendType,
+                        true);
 }
 
 int Program::verify() {
@@ -125,7 +131,8 @@ int Program::verify() {
       return 1;
     }
     ir::Func func = functions.at(test->getCallee());
-    Function compiledFunc = simit::compile(func, content->backend);
+    Function compiledFunc = simit::compile(func, content->backend,
+                                           content->backendType);
 
     bool evaluates = test->evaluate(func, compiledFunc, &content->diags);
     if (!evaluates) {
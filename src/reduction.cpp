@@ -9,6 +9,12 @@ std::string ReductionOperator::getName() {
   switch (kind) {
     case Sum:
       return "sum";
+    case Product:
+      return "product";
+    case Max:
+      return "max";
+    case Min:
+      return "min";
     case Undefined:
       return "";
   }
@@ -29,6 +35,15 @@ std::ostream &operator<<(std::ostream &os, const ReductionOperator &rop) {
     case ReductionOperator::Sum:
       os << "+";
       break;
+    case ReductionOperator::Product:
+      os << "*";
+      break;
+    case ReductionOperator::Max:
+      os << "max";
+      break;
+    case ReductionOperator::Min:
+      os << "min";
+      break;
     case ReductionOperator::Undefined:
       break;
   }
@@ -11,10 +11,13 @@ namespace ir {
 /// Since reductions happen over unordered sets, the reduction operators must
 /// be both associative and commutative. Supported reduction operators are:
 /// - Sum
+/// - Product
+/// - Max
+/// - Min
 class ReductionOperator {
 public:
-  // TODO: Add Poduct, Max, Min, and user-defined functions
-  enum Kind { Sum, Undefined };
+  // TODO: Add user-defined functions
+  enum Kind { Sum, Product, Max, Min, Undefined };
 
   // Construct an undefiend reduction operator.
   ReductionOperator() : kind(Undefined) {}
@@ -168,6 +168,10 @@ namespace simit {
   void reorderFields(vector<Set::FieldData*>& fields, const vector<int>& 
       ordering) {
     for (auto f : fields) {
+      tassert(f->layout.getKind() == FieldLayout::AoS ||
+              f->type->getSize() == 1)
+          << "Only AoS fields can currently be reordered, but " << f->name
+          << " is " << f->layout;
       switch (f->type->getComponentType()) {
         case ComponentType::Float: {
           float* data = static_cast<float *>(f->data);
@@ -3,9 +3,16 @@
 #include <cmath>
 #include <time.h>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "coloring.h"
+#include "factorizations.h"
+#include "graph.h"
 #include "timers.h"
+#include "util/memory_arena.h"
+#include "util/thread_pool.h"
 #include "stdio.h"
 
 #ifdef EIGEN
@@ -275,8 +282,63 @@ double simitClock() {
   time_point<high_resolution_clock,microseconds> usec = time_point_cast<microseconds>(t);
   return (double)(usec.time_since_epoch().count());
 }
+
+/// Runs the iterations [0, n) of an outlined parallel loop on the thread pool.
+/// `loop` executes the iterations [begin, end) using the values in `env`.
+void simitParallelFor(int n, void (*loop)(void* env, int begin, int end),
+                      void* env) {
+  simit::util::ThreadPool::getInstance().parallelFor(n,
+      [loop,env](int begin, int end) {loop(env, begin, end);});
+}
+
+/// Runs an outlined parallel loop over the elements of `set`, one color of
+/// the set's coloring at a time. `loop` executes the iterations
+/// elements[begin:end] using the values in `env`.
+void simitParallelForColored(void* set,
+                             void (*loop)(void* env, const int* elements,
+                                          int begin, int end),
+                             void* env) {
+  const simit::SetColoring& coloring = ((simit::Set*)set)->getColoring();
+  simit::util::ThreadPool& pool = simit::util::ThreadPool::getInstance();
+  for (int color = 0; color < coloring.getNumColors(); ++color) {
+    const int* elements = coloring.getColor(color);
+    pool.parallelFor(coloring.getColorSize(color),
+        [loop,env,elements](int begin, int end) {
+          loop(env, elements, begin, end);
+        });
+  }
+}
+
+static std::mutex reductionMutex;
+
+/// Serialize the threads of a parallel loop that combine their partial
+/// results of the loop's reductions with the shared result.
+void simitReductionLock() {
+  reductionMutex.lock();
+}
+
+void simitReductionUnlock() {
+  reductionMutex.unlock();
+}
 } // extern "C"
 
+namespace simit {
+namespace ffi {
+extern "C"
+void* simit_malloc(std::size_t size) {
+  util::MemoryArena* arena = util::MemoryArena::getActive();
+  return (arena != nullptr) ? arena->allocate(size) : malloc(size);
+}
+
+extern "C"
+void simit_free(void* ptr) {
+  util::MemoryArena* arena = util::MemoryArena::getActive();
+  if (arena == nullptr || !arena->release(ptr)) {
+    free(ptr);
+  }
+}
+}}
+
 
 /// Temporary external spmm implementation until Simit supports assembling
 /// matrix indices during computation.
@@ -288,11 +350,22 @@ int spmm(int Bn,  int Bm,  int* Browptr, int* Bcolidx,
          int An,  int Am,  int** Arowptr, int** Acolidx,
          int Ann, int Amm, Float** Avals) {
 #ifdef EIGEN
-  auto B = csr2eigen<Float,RowMajor>(Bn, Bm, Browptr, Bcolidx, Bnn, Bmm, Bvals);
-  auto C = csr2eigen<Float,RowMajor>(Cn, Cm, Crowptr, Ccolidx, Cnn, Cmm, Cvals);
-
   SparseMatrix<Float,RowMajor> A(An, Am);
-  A = B*C;
+  if (Bnn == 1 && Bmm == 1 && Cnn == 1 && Cmm == 1 &&
+      hasSortedRows(Bn, Browptr, Bcolidx) &&
+      hasSortedRows(Cn, Crowptr, Ccolidx)) {
+    // Unblocked CSR matrices are already compressed row-major Eigen matrices
+    Map<SparseMatrix<Float,RowMajor>> B(Bn, Bm, Browptr[Bn],
+                                        Browptr, Bcolidx, Bvals);
+    Map<SparseMatrix<Float,RowMajor>> C(Cn, Cm, Crowptr[Cn],
+                                        Crowptr, Ccolidx, Cvals);
+    A = B*C;
+  }
+  else {
+    auto B = csr2eigen<Float,RowMajor>(Bn,Bm, Browptr,Bcolidx, Bnn,Bmm, Bvals);
+    auto C = csr2eigen<Float,RowMajor>(Cn,Cm, Crowptr,Ccolidx, Cnn,Cmm, Cvals);
+    A = B*C;
+  }
   eigen2csr(A, An, Am, Arowptr, Acolidx, Ann, Amm, Avals);
 #else
   ierror << "extern spmm requires Eigen";
@@ -327,17 +400,31 @@ do {                                                            \
   ierror << "Solvers require that Simit was built with Eigen."; \
 } while (false)
 
+#ifdef EIGEN
+/// Solve for `x` in place of the Simit vector `xvals`, reading `b` directly
+/// from `bvals`.
+template <typename Solver, typename Float>
+void solveInto(const Solver& solver, int nb, const Float* bvals,
+               int nx, Float* xvals) {
+  Map<const Matrix<Float,Dynamic,1>> b(bvals, nb);
+  Map<Matrix<Float,Dynamic,1>> x(xvals, nx);
+  if (bvals == xvals) {
+    x = Matrix<Float,Dynamic,1>(solver.solve(b));
+  }
+  else {
+    x = solver.solve(b);
+  }
+}
+#endif
+
 template <typename Float>
 void solve(int n,  int m,  int* rowptr, int* colidx,
            int nn, int mm, Float* Avals, Float* bvals, Float* xvals) {
 #ifdef EIGEN
   auto A = csr2eigen<Float,ColMajor>(n, m, rowptr, colidx, nn, mm, Avals);
-  auto x = new Map<Matrix<Float,Dynamic,1>>(xvals, m);
-  auto b = new Map<Matrix<Float,Dynamic,1>>(bvals, n);
-
   SparseLU<SparseMatrix<Float, ColMajor>> solver;
   solver.compute(A);
-  *x = solver.solve(*b);
+  solveInto(solver, n, bvals, m, xvals);
 #else
   SOLVER_ERROR;
 #endif
@@ -353,16 +440,16 @@ extern "C" void cMatSolve_f32(int n,  int m,  int* rowptr, int* colidx,
 
 /// LU factorization. Returns a solver object that can be used with
 /// `lusolve` and `lumatsolve`. The solver object must be freed using
-/// `lufree`.
+/// `lufree`. The symbolic analysis of the matrix is reused from the last
+/// factorization of a matrix with the same index (see FactorizationCache).
 template <typename Float>
 int lu(int An,  int Am,  int* Arowptr, int* Acolidx,
        int Ann, int Amm, Float* Avals,
        void** solverPtr) {
 #ifdef EIGEN
-  auto A = csr2eigen<Float,Eigen::ColMajor>(An, Am, Arowptr, Acolidx,
-                                            Ann, Amm, Avals);
-  auto solver = new SparseLU<SparseMatrix<Float,ColMajor>>();
-  solver->compute(A);
+  typedef SparseLU<SparseMatrix<Float,ColMajor>> Solver;
+  auto solver = simit::FactorizationCache::getInstance().factorize<Solver>(
+      An, Am, Arowptr, Acolidx, Ann, Amm, Avals);
   *solverPtr = static_cast<void*>(solver);
 #else
   SOLVER_ERROR;
@@ -385,8 +472,9 @@ extern "C" int dlu(int An,  int Am,  int* Arowptr, int* Acolidx,
 template <typename Float>
 int lufree(void** solverPtr) {
 #ifdef EIGEN
-  auto solver=static_cast<SparseLU<SparseMatrix<Float,ColMajor>>*>(*solverPtr);
-  delete solver;
+  if (!simit::FactorizationCache::getInstance().release(*solverPtr)) {
+    delete static_cast<SparseLU<SparseMatrix<Float,ColMajor>>*>(*solverPtr);
+  }
 #else
   SOLVER_ERROR;
 #endif
@@ -405,12 +493,7 @@ template <typename Float>
 int lusolve(void** solverPtr, int nb, Float *bvals, int nx, Float *xvals) {
 #ifdef EIGEN
   auto solver=static_cast<SparseLU<SparseMatrix<Float,ColMajor>>*>(*solverPtr);
-  auto b = dense2eigen(nb, bvals);
-  auto x = Eigen::Matrix<Float,Eigen::Dynamic,1>(nx);
-  x = solver->solve(b);
-  for (int i=0; i<nx; ++i) {
-    xvals[i] = x(i);
-  }
+  solveInto(*solver, nb, bvals, nx, xvals);
 #else
   SOLVER_ERROR;
 #endif
@@ -467,16 +550,16 @@ extern "C" int dlumatsolve(void** solverPtr,
 
 /// Cholesky factorization. Returns a solver object that can be used with
 /// `lltsolve` and `lltmatsolve`. The solver object must be freed using
-/// `cholfree`.
+/// `cholfree`. The symbolic analysis of the matrix is reused from the last
+/// factorization of a matrix with the same index (see FactorizationCache).
 template <typename Float>
 int chol(int An,  int Am,  int* Arowptr, int* Acolidx,
          int Ann, int Amm, Float* Avals,
          void** solverPtr) {
 #ifdef EIGEN
-  auto A = csr2eigen<Float,Eigen::ColMajor>(An, Am, Arowptr, Acolidx,
-                                            Ann, Amm, Avals);
-  auto solver = new SimplicialCholesky<SparseMatrix<Float>>();
-  solver->compute(A);
+  typedef SimplicialCholesky<SparseMatrix<Float>> Solver;
+  auto solver = simit::FactorizationCache::getInstance().factorize<Solver>(
+      An, Am, Arowptr, Acolidx, Ann, Amm, Avals);
   *solverPtr = static_cast<void*>(solver);
 #else
   SOLVER_ERROR;
@@ -498,8 +581,9 @@ extern "C" int dchol(int An,  int Am,  int* Arowptr, int* Acolidx,
 template <typename Float>
 int cholfree(void** solverPtr) {
 #ifdef EIGEN
-  auto solver=static_cast<SimplicialCholesky<SparseMatrix<Float>>*>(*solverPtr);
-  delete solver;
+  if (!simit::FactorizationCache::getInstance().release(*solverPtr)) {
+    delete static_cast<SimplicialCholesky<SparseMatrix<Float>>*>(*solverPtr);
+  }
 #else
   SOLVER_ERROR;
 #endif
@@ -518,12 +602,7 @@ template <typename Float>
 int lltsolve(void** solverPtr, int nb, Float *bvals, int nx, Float *xvals) {
 #ifdef EIGEN
   auto solver=static_cast<SimplicialCholesky<SparseMatrix<Float>>*>(*solverPtr);
-  auto b = dense2eigen(nb, bvals);
-  auto x = Eigen::Matrix<Float,Eigen::Dynamic,1>(nx);
-  x = solver->solve(b);
-  for (int i=0; i<nx; ++i) {
-    xvals[i] = x(i);
-  }
+  solveInto(*solver, nb, bvals, nx, xvals);
 #else
   SOLVER_ERROR;
 #endif
@@ -577,6 +656,381 @@ extern "C" int dlltmatsolve(void** solverPtr,
                       Xn, Xm, Xrowptr, Xcolidx, Xnn, Xmm, Xvals);
 }
 
+/// Preconditioners of the conjugate gradient intrinsics, which operate
+/// directly on the blocks of Simit's BCSR matrices.
+namespace {
+
+/// Inverts the bs x bs row-major block `a` into `inv` by Gauss-Jordan
+/// elimination with partial pivoting. Returns false if the block is singular.
+template <typename Float>
+bool invertBlock(int bs, const Float* a, Float* inv) {
+  std::vector<Float> lu(a, a + bs*bs);
+  std::fill(inv, inv + bs*bs, Float(0));
+  for (int i=0; i<bs; ++i) {
+    inv[i*bs+i] = 1;
+  }
+  for (int k=0; k<bs; ++k) {
+    int pivot = k;
+    for (int i=k+1; i<bs; ++i) {
+      if (std::abs(lu[i*bs+k]) > std::abs(lu[pivot*bs+k])) {
+        pivot = i;
+      }
+    }
+    if (lu[pivot*bs+k] == Float(0)) {
+      return false;
+    }
+    if (pivot != k) {
+      std::swap_ranges(&lu[k*bs], &lu[k*bs]+bs, &lu[pivot*bs]);
+      std::swap_ranges(inv+k*bs, inv+k*bs+bs, inv+pivot*bs);
+    }
+    const Float d = 1 / lu[k*bs+k];
+    for (int j=0; j<bs; ++j) {
+      lu[k*bs+j] *= d;
+      inv[k*bs+j] *= d;
+    }
+    for (int i=0; i<bs; ++i) {
+      const Float f = lu[i*bs+k];
+      if (i == k || f == Float(0)) continue;
+      for (int j=0; j<bs; ++j) {
+        lu[i*bs+j] -= f*lu[k*bs+j];
+        inv[i*bs+j] -= f*inv[k*bs+j];
+      }
+    }
+  }
+  return true;
+}
+
+/// Block-Jacobi preconditioner: the inverses of the diagonal blocks of a BCSR
+/// matrix. Singular or missing diagonal blocks are left unpreconditioned.
+template <typename Float>
+class BlockJacobi {
+public:
+  BlockJacobi(int rows, const int* rowptr, const int* colidx, int bs,
+              const Float* vals) : bs(bs), inverses(rows*bs*bs) {
+    for (int i=0; i<rows; ++i) {
+      Float* inv = &inverses[i*bs*bs];
+      const int* diag = std::find(colidx+rowptr[i], colidx+rowptr[i+1], i);
+      if (diag == colidx+rowptr[i+1] ||
+          !invertBlock(bs, vals + (diag-colidx)*bs*bs, inv)) {
+        std::fill(inv, inv + bs*bs, Float(0));
+        for (int k=0; k<bs; ++k) {
+          inv[k*bs+k] = 1;
+        }
+      }
+    }
+  }
+
+  /// Computes `z = D_i^{-1} r` for the entries of block row `i`, and returns
+  /// their contribution to `r.z`.
+  Float apply(int i, const Float* r, Float* z) const {
+    const Float* inv = &inverses[i*bs*bs];
+    Float rz = 0;
+    for (int bi=0; bi<bs; ++bi) {
+      Float zi = 0;
+      for (int bj=0; bj<bs; ++bj) {
+        zi += inv[bi*bs+bj] * r[bj];
+      }
+      z[bi] = zi;
+      rz += r[bi]*zi;
+    }
+    return rz;
+  }
+
+private:
+  int bs;
+  std::vector<Float> inverses;
+};
+
+/// Zero fill-in incomplete Cholesky preconditioner `M = LL'`, where `L` has
+/// the pattern of the lower triangle of the matrix, with its blocks expanded.
+template <typename Float>
+class IncompleteCholesky {
+public:
+  IncompleteCholesky(int rows, const int* rowptr, const int* colidx, int bs,
+                     const Float* vals) {
+    const int n = rows*bs;
+    Lrowptr.reserve(n+1);
+    Lrowptr.push_back(0);
+
+    // Gather the lower triangle of each scalar row, ordered by column and
+    // ending with the diagonal
+    std::vector<std::pair<int,Float>> row;
+    std::vector<Float> diagonal(n);
+    for (int i=0; i<rows; ++i) {
+      for (int bi=0; bi<bs; ++bi) {
+        const int I = i*bs + bi;
+        row.clear();
+        for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+          for (int bj=0; bj<bs; ++bj) {
+            const int J = colidx[ij]*bs + bj;
+            if (J <= I) {
+              row.push_back(std::make_pair(J, vals[(ij*bs+bi)*bs+bj]));
+            }
+          }
+        }
+        std::sort(row.begin(), row.end(),
+                  [](const std::pair<int,Float>& a,
+                     const std::pair<int,Float>& b) {
+                    return a.first < b.first;
+                  });
+        if (row.empty() || row.back().first != I) {
+          row.push_back(std::make_pair(I, Float(0)));
+        }
+        diagonal[I] = row.back().second;
+        for (auto& entry : row) {
+          Lcolidx.push_back(entry.first);
+          Lvals.push_back(entry.second);
+        }
+        Lrowptr.push_back(Lcolidx.size());
+      }
+    }
+
+    // Factorize row by row: L_IK = (A_IK - sum_J L_IJ*L_KJ) / L_KK, over the
+    // columns J < K that are in the patterns of both rows
+    for (int I=0; I<n; ++I) {
+      const int diag = Lrowptr[I+1]-1;
+      for (int IK=Lrowptr[I]; IK<diag; ++IK) {
+        const int K = Lcolidx[IK];
+        Float s = Lvals[IK];
+        int IJ = Lrowptr[I];
+        int KJ = Lrowptr[K];
+        const int KK = Lrowptr[K+1]-1;
+        while (IJ < IK && KJ < KK) {
+          if (Lcolidx[IJ] < Lcolidx[KJ]) {
+            ++IJ;
+          }
+          else if (Lcolidx[IJ] > Lcolidx[KJ]) {
+            ++KJ;
+          }
+          else {
+            s -= Lvals[IJ++] * Lvals[KJ++];
+          }
+        }
+        Lvals[IK] = s / Lvals[KK];
+      }
+
+      Float d = Lvals[diag];
+      for (int IJ=Lrowptr[I]; IJ<diag; ++IJ) {
+        d -= Lvals[IJ]*Lvals[IJ];
+      }
+      // Incomplete factorizations can break down on matrices that are not
+      // M-matrices; fall back to the diagonal of A for such pivots
+      if (!(d > Float(0))) {
+        d = (diagonal[I] > Float(0)) ? diagonal[I] : Float(1);
+      }
+      Lvals[diag] = std::sqrt(d);
+    }
+  }
+
+  /// Solves `LL'z = r` and returns `r.z`.
+  Float solve(const Float* r, Float* z) const {
+    const int n = Lrowptr.size()-1;
+    for (int I=0; I<n; ++I) {
+      const int diag = Lrowptr[I+1]-1;
+      Float s = r[I];
+      for (int IJ=Lrowptr[I]; IJ<diag; ++IJ) {
+        s -= Lvals[IJ] * z[Lcolidx[IJ]];
+      }
+      z[I] = s / Lvals[diag];
+    }
+
+    // The backward substitution finishes z_I before any z_J with J < I, so
+    // the dot product is accumulated as it goes
+    Float rz = 0;
+    for (int I=n-1; I>=0; --I) {
+      const int diag = Lrowptr[I+1]-1;
+      const Float zI = z[I] / Lvals[diag];
+      z[I] = zI;
+      rz += r[I]*zI;
+      for (int IJ=Lrowptr[I]; IJ<diag; ++IJ) {
+        z[Lcolidx[IJ]] -= Lvals[IJ] * zI;
+      }
+    }
+    return rz;
+  }
+
+private:
+  std::vector<int> Lrowptr;
+  std::vector<int> Lcolidx;
+  std::vector<Float> Lvals;
+};
+
+/// Computes `q = A*p` for the BCSR matrix `A` with bs x bs blocks, and returns
+/// `p.q`, in one pass over `A`.
+template <typename Float>
+Float spmvDot(int rows, const int* rowptr, const int* colidx, int bs,
+              const Float* vals, const Float* p, Float* q) {
+  Float pq = 0;
+  for (int i=0; i<rows; ++i) {
+    for (int bi=0; bi<bs; ++bi) {
+      Float qi = 0;
+      for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+        const Float* block = vals + (ij*bs+bi)*bs;
+        const Float* pj = p + colidx[ij]*bs;
+        for (int bj=0; bj<bs; ++bj) {
+          qi += block[bj] * pj[bj];
+        }
+      }
+      q[i*bs+bi] = qi;
+      pq += p[i*bs+bi] * qi;
+    }
+  }
+  return pq;
+}
+
+enum class Preconditioner {BlockJacobi, IncompleteCholesky};
+
+/// Preconditioned conjugate gradient solve of `Ax=b`, starting from `x0`,
+/// until `|b-Ax| <= tol*|b|`, `maxiter` iterations, or breakdown (`p.Ap = 0`,
+/// which only happens if `A` is not positive definite). Each iteration makes
+/// one pass over `A` (the SpMV, fused with `p.Ap`), one over the vectors (the
+/// updates of `x` and `r`, fused with `r.r`, and with the block-Jacobi solve
+/// and `r.z`), plus the triangular solves for IC(0), and the update of `p`.
+template <typename Float>
+int pcg(Preconditioner preconditioner,
+        int An, int Am, int* Arowptr, int* Acolidx, int Ann, int Amm,
+        Float* Avals, int bn, Float* bvals, int x0n, Float* x0vals,
+        Float tol, int maxiter,
+        int xn, Float* xvals, int* iterations, Float* residual) {
+  iassert(An == Am && Ann == Amm) << "pcg requires a square matrix";
+  iassert(bn == An && x0n == An && xn == An);
+  const int n = An;
+  const int bs = Ann;
+  const int rows = n/bs;
+
+  if (xvals != x0vals) {
+    std::copy(x0vals, x0vals+n, xvals);
+  }
+
+  Float bb = 0;
+  for (int i=0; i<n; ++i) {
+    bb += bvals[i]*bvals[i];
+  }
+  if (bb == Float(0)) {
+    std::fill(xvals, xvals+n, Float(0));
+    *iterations = 0;
+    *residual = 0;
+    return 0;
+  }
+  const Float threshold = tol*tol*bb;
+
+  std::unique_ptr<BlockJacobi<Float>> jacobi;
+  std::unique_ptr<IncompleteCholesky<Float>> ic;
+  if (preconditioner == Preconditioner::BlockJacobi) {
+    jacobi.reset(new BlockJacobi<Float>(rows, Arowptr, Acolidx, bs, Avals));
+  }
+  else {
+    ic.reset(new IncompleteCholesky<Float>(rows, Arowptr, Acolidx, bs, Avals));
+  }
+
+  std::vector<Float> r(n), z(n), p(n), q(n);
+
+  // r = b - Ax and z = M^{-1}r
+  spmvDot(rows, Arowptr, Acolidx, bs, Avals, xvals, r.data());
+  Float rr = 0;
+  Float rz = 0;
+  for (int i=0; i<n; ++i) {
+    r[i] = bvals[i] - r[i];
+    rr += r[i]*r[i];
+  }
+  if (jacobi) {
+    for (int i=0; i<rows; ++i) {
+      rz += jacobi->apply(i, &r[i*bs], &z[i*bs]);
+    }
+  }
+  else {
+    rz = ic->solve(r.data(), z.data());
+  }
+  p = z;
+
+  int k = 0;
+  while (k < maxiter && rr > threshold) {
+    const Float pq = spmvDot(rows, Arowptr, Acolidx, bs, Avals,
+                             p.data(), q.data());
+    // The search direction is in the null space of a singular or indefinite
+    // A, so the method breaks down. Return the current iterate and residual.
+    if (pq == Float(0)) {
+      break;
+    }
+    const Float alpha = rz / pq;
+    ++k;
+
+    Float rzNew = 0;
+    rr = 0;
+    for (int i=0; i<rows; ++i) {
+      for (int bi=i*bs; bi<(i+1)*bs; ++bi) {
+        xvals[bi] += alpha*p[bi];
+        r[bi] -= alpha*q[bi];
+        rr += r[bi]*r[bi];
+      }
+      if (jacobi) {
+        rzNew += jacobi->apply(i, &r[i*bs], &z[i*bs]);
+      }
+    }
+    if (rr <= threshold) {
+      break;
+    }
+    if (ic) {
+      rzNew = ic->solve(r.data(), z.data());
+    }
+
+    const Float beta = rzNew / rz;
+    rz = rzNew;
+    for (int i=0; i<n; ++i) {
+      p[i] = z[i] + beta*p[i];
+    }
+  }
+
+  *iterations = k;
+  *residual = std::sqrt(rr/bb);
+  return 0;
+}
+
+}
+
+/// Solve `Ax=b` with the conjugate gradient method, preconditioned with the
+/// inverses of the diagonal blocks of `A`, starting from `x0`. Also returns
+/// the number of iterations and the relative residual `|b-Ax|/|b|`.
+extern "C" int spcg(int An,  int Am,  int* Arowptr, int* Acolidx,
+                    int Ann, int Amm, float* Avals,
+                    int bn, float* bvals, int x0n, float* x0vals,
+                    float tol, int maxiter,
+                    int xn, float* xvals, int* iterations, float* residual) {
+  return pcg(Preconditioner::BlockJacobi,
+             An, Am, Arowptr, Acolidx, Ann, Amm, Avals, bn, bvals, x0n, x0vals,
+             tol, maxiter, xn, xvals, iterations, residual);
+}
+extern "C" int dpcg(int An,  int Am,  int* Arowptr, int* Acolidx,
+                    int Ann, int Amm, double* Avals,
+                    int bn, double* bvals, int x0n, double* x0vals,
+                    double tol, int maxiter,
+                    int xn, double* xvals, int* iterations, double* residual) {
+  return pcg(Preconditioner::BlockJacobi,
+             An, Am, Arowptr, Acolidx, Ann, Amm, Avals, bn, bvals, x0n, x0vals,
+             tol, maxiter, xn, xvals, iterations, residual);
+}
+
+/// Solve `Ax=b` like `pcg`, but preconditioned with the zero fill-in
+/// incomplete Cholesky factorization of `A`.
+extern "C" int siccg(int An,  int Am,  int* Arowptr, int* Acolidx,
+                     int Ann, int Amm, float* Avals,
+                     int bn, float* bvals, int x0n, float* x0vals,
+                     float tol, int maxiter,
+                     int xn, float* xvals, int* iterations, float* residual) {
+  return pcg(Preconditioner::IncompleteCholesky,
+             An, Am, Arowptr, Acolidx, Ann, Amm, Avals, bn, bvals, x0n, x0vals,
+             tol, maxiter, xn, xvals, iterations, residual);
+}
+extern "C" int diccg(int An,  int Am,  int* Arowptr, int* Acolidx,
+                     int Ann, int Amm, double* Avals,
+                     int bn, double* bvals, int x0n, double* x0vals,
+                     double tol, int maxiter,
+                     int xn, double* xvals, int* iterations, double* residual) {
+  return pcg(Preconditioner::IncompleteCholesky,
+             An, Am, Arowptr, Acolidx, Ann, Amm, Avals, bn, bvals, x0n, x0vals,
+             tol, maxiter, xn, xvals, iterations, residual);
+}
+
 /// cross product between 2 vectors3D
 template <typename Float>
 void cross(int an, Float* a, int bn, Float* b, int cn, Float* c){
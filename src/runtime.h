@@ -2,7 +2,9 @@
 #define SIMIT_RUNTIME_H
 
 #include "ffi.h"
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 template <typename Float>
 void mallocMatrix(int n,  int m,  int** rowptr, int** colidx,
@@ -18,33 +20,77 @@ void mallocMatrix(int n,  int m,  int** rowptr, int** colidx,
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 
+/// True iff the column indices of every row of the CSR index are sorted, as
+/// Eigen requires of the inner indices of compressed matrices.
+inline bool hasSortedRows(int rows, const int* rowptr, const int* colidx) {
+  for (int i=0; i<rows; ++i) {
+    if (!std::is_sorted(colidx+rowptr[i], colidx+rowptr[i+1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Expand a BCSR matrix with nn x mm blocks into a compressed Eigen matrix.
+/// The Eigen arrays are filled directly, with a counting sort over the outer
+/// dimension, so that no triplets are built or sorted.
 template <typename Float, int Major=Eigen::RowMajor>
 Eigen::SparseMatrix<Float,Major>
-csr2eigen(int n, int m, int* rowptr, int* colidx, int nn, int mm, Float* vals) {
-  int nnz = rowptr[n/nn];
+csr2eigen(int n, int m, const int* rowptr, const int* colidx,
+          int nn, int mm, const Float* vals) {
+  const int rows = n/nn;
+  const bool rowMajor = (Major == Eigen::RowMajor);
 
-  std::vector<Eigen::Triplet<Float>> tripletList;
-  tripletList.reserve(nnz*nn*mm);
-  for (int i=0; i<n/(nn); ++i) {
+  // The columns of a row-major matrix are only ordered if the block columns
+  // are, and otherwise get ordered by the column-major expansion
+  if (rowMajor && !hasSortedRows(rows, rowptr, colidx)) {
+    return Eigen::SparseMatrix<Float,Major>(
+        csr2eigen<Float,Eigen::ColMajor>(n, m, rowptr, colidx, nn, mm, vals));
+  }
+
+  Eigen::SparseMatrix<Float,Major> mat(n, m);
+  mat.resizeNonZeros(rowptr[rows]*nn*mm);
+  int* outer = mat.outerIndexPtr();
+  int* inner = mat.innerIndexPtr();
+  Float* values = mat.valuePtr();
+
+  // Count the non-zeros of each outer vector
+  std::fill(outer, outer + mat.outerSize() + 1, 0);
+  for (int i=0; i<rows; ++i) {
     for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
-      int j = colidx[ij];
-      for (int bi=0; bi<nn; bi++) {
-        for (int bj=0; bj<mm; bj++) {
-          tripletList.push_back(Eigen::Triplet<Float>(i*nn+bi, j*mm+bj,
-                                                      vals[ij*nn*mm+bi*nn+bj]));
+      for (int bi=0; bi<nn; ++bi) {
+        for (int bj=0; bj<mm; ++bj) {
+          ++outer[(rowMajor ? i*nn+bi : colidx[ij]*mm+bj) + 1];
+        }
+      }
+    }
+  }
+  for (int o=0; o<mat.outerSize(); ++o) {
+    outer[o+1] += outer[o];
+  }
+
+  // Scatter the non-zeros. Rows are visited in order, so the rows of each
+  // column come out sorted.
+  std::vector<int> next(outer, outer + mat.outerSize());
+  for (int i=0; i<rows; ++i) {
+    for (int ij=rowptr[i]; ij<rowptr[i+1]; ++ij) {
+      for (int bi=0; bi<nn; ++bi) {
+        for (int bj=0; bj<mm; ++bj) {
+          int row = i*nn+bi;
+          int col = colidx[ij]*mm+bj;
+          int loc = next[rowMajor ? row : col]++;
+          inner[loc] = rowMajor ? col : row;
+          values[loc] = vals[ij*nn*mm + bi*mm + bj];
         }
       }
     }
   }
-  
-  Eigen::SparseMatrix<Float> mat(n, m);
-  mat.setFromTriplets(tripletList.begin(), tripletList.end());
-  mat.makeCompressed();
   return mat;
 }
 
+/// Allocate a CSR matrix and copy `mat` into it.
 template<typename Float,int Major>
-void eigen2csr(Eigen::SparseMatrix<Float,Major> mat,
+void eigen2csr(Eigen::SparseMatrix<Float,Major>& mat,
                int n, int m, int** rowptr, int** colidx,
                int nn, int mm, Float** vals) {
   mat.makeCompressed();
@@ -52,19 +98,9 @@ void eigen2csr(Eigen::SparseMatrix<Float,Major> mat,
   auto nnz = mat.nonZeros();
   mallocMatrix(n, m, rowptr, colidx, nn, mm, vals, nnz);
 
-  // copy rowptr
-  auto matrowptr = mat.outerIndexPtr();
-  for (int i=0; i<n+1; ++i) {
-    (*rowptr)[i] = matrowptr[i];
-  }
-
-  // copy data and colidx
-  auto data = mat.data();
-  auto matcolidx = mat.innerIndexPtr();
-  for (int i=0; i<nnz; ++i) {
-    (*colidx)[i] = matcolidx[i];
-    (*vals)[i] = data.value(i);
-  }
+  std::copy(mat.outerIndexPtr(), mat.outerIndexPtr() + n+1, *rowptr);
+  std::copy(mat.innerIndexPtr(), mat.innerIndexPtr() + nnz, *colidx);
+  std::copy(mat.valuePtr(), mat.valuePtr() + nnz, *vals);
 }
 
 template<typename Float> Eigen::Matrix<Float,Eigen::Dynamic,1>
@@ -0,0 +1,421 @@
+#include "set_snapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "error.h"
+
+using namespace std;
+
+namespace simit {
+
+static const char SNAPSHOT_MAGIC[8] = {'S','I','M','I','T','S','E','T'};
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+static const uint64_t SNAPSHOT_ALIGNMENT = 64;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t numSets;
+  uint64_t descriptionSize;
+};
+
+static uint64_t align(uint64_t offset) {
+  return (offset + SNAPSHOT_ALIGNMENT-1) / SNAPSHOT_ALIGNMENT *
+         SNAPSHOT_ALIGNMENT;
+}
+
+/// Appends the fixed-width values of the set descriptions to a buffer.
+class DescriptionWriter {
+public:
+  template <typename T>
+  void write(T value) {
+    const char* bytes = (const char*)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write(const string& str) {
+    write<uint32_t>(str.size());
+    buffer.insert(buffer.end(), str.begin(), str.end());
+  }
+
+  const vector<char>& getBuffer() const {return buffer;}
+
+private:
+  vector<char> buffer;
+};
+
+/// Reads the values written by a DescriptionWriter, checking that they are
+/// within the description.
+class DescriptionReader {
+public:
+  DescriptionReader(const char* begin, const char* end, const string& path)
+      : pos(begin), end(end), path(path) {}
+
+  template <typename T>
+  T read() {
+    check(sizeof(T));
+    T value;
+    memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  string readString() {
+    uint32_t size = read<uint32_t>();
+    check(size);
+    string str(pos, size);
+    pos += size;
+    return str;
+  }
+
+  /// Check that `count` values of at least `bytes` bytes each fit in the rest
+  /// of the description, before memory is allocated for them.
+  void checkCount(uint64_t count, size_t bytes) {
+    if (count > (size_t)(end - pos) / bytes) {
+      uerror << "Corrupt snapshot " << path << ": truncated set description";
+    }
+  }
+
+private:
+  const char* pos;
+  const char* end;
+  string path;
+
+  void check(size_t size) {
+    if ((size_t)(end - pos) < size) {
+      uerror << "Corrupt snapshot " << path << ": truncated set description";
+    }
+  }
+};
+
+/// The fewest bytes a set takes in a description: the sizes of its name and
+/// spatial field name, its kind, size, cardinality, number of dimensions and
+/// number of fields, and the offset of its endpoints.
+static const size_t MIN_SET_DESCRIPTION_BYTES =
+    7*sizeof(uint32_t) + sizeof(uint64_t);
+
+/// The bytes of a field's data in a snapshot of a set with `size` elements.
+static uint64_t getFieldBytes(const Set::FieldData* field, int size) {
+  return field->getNumSlots(size) * field->sizeOfType;
+}
+
+void writeSnapshot(const string& path, const map<string,const Set*>& sets) {
+  map<const Set*,uint32_t> setIndices;
+  uint32_t index = 0;
+  for (auto& set : sets) {
+    setIndices[set.second] = index++;
+  }
+
+  // The descriptions have the same size whatever the data offsets are, so
+  // they are built twice: once to find where the data starts, and once with
+  // the offsets of the data.
+  vector<char> description;
+  uint64_t dataBegin = 0;
+  for (int pass=0; pass < 2; ++pass) {
+    DescriptionWriter writer;
+    uint64_t offset = dataBegin;
+    for (auto& namedSet : sets) {
+      const Set* set = namedSet.second;
+      writer.write(namedSet.first);
+      writer.write<uint32_t>(set->getKind());
+      writer.write<int32_t>(set->getSize());
+      writer.write<uint32_t>(set->getCardinality());
+      for (int i=0; i < set->getCardinality(); ++i) {
+        const Set* endpointSet = set->getEndpointSet(i);
+        uassert(setIndices.find(endpointSet) != setIndices.end())
+            << "The endpoint sets of " << namedSet.first
+            << " must be in the snapshot";
+        writer.write<uint32_t>(setIndices.at(endpointSet));
+      }
+      const vector<int>& dimensions = set->dimensions;
+      writer.write<uint32_t>(dimensions.size());
+      for (int dimension : dimensions) {
+        writer.write<int32_t>(dimension);
+      }
+      writer.write(set->getSpatialFieldName());
+
+      // Implicit grid edge sets have no endpoints, which is recorded as a
+      // zero offset since data never starts at the beginning of the file
+      if (set->hasImplicitEdges()) {
+        writer.write<uint64_t>(0);
+      }
+      else {
+        uint64_t endpointsBytes =
+            (uint64_t)set->getSize() * set->getCardinality() * sizeof(int);
+        writer.write<uint64_t>(offset);
+        offset = align(offset + endpointsBytes);
+      }
+
+      writer.write<uint32_t>(set->fields.size());
+      for (const Set::FieldData* field : set->fields) {
+        writer.write(field->name);
+        writer.write<uint32_t>((uint32_t)field->type->getComponentType());
+        writer.write<uint32_t>(field->type->getOrder());
+        for (size_t i=0; i < field->type->getOrder(); ++i) {
+          writer.write<int32_t>(field->type->getDimension(i));
+        }
+        writer.write<uint32_t>(field->layout.getKind());
+        writer.write<int32_t>(field->layout.getLaneWidth());
+        writer.write<uint64_t>(offset);
+        offset = align(offset + getFieldBytes(field, set->getSize()));
+      }
+    }
+    description = writer.getBuffer();
+    dataBegin = align(sizeof(SnapshotHeader) + description.size());
+  }
+
+  ofstream file(path, ios::binary | ios::trunc);
+  uassert(file.good()) << "Could not open " << path << " for writing";
+
+  SnapshotHeader header;
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.byteOrder = SNAPSHOT_BYTE_ORDER;
+  header.numSets = sets.size();
+  header.descriptionSize = description.size();
+  file.write((const char*)&header, sizeof(header));
+  file.write(description.data(), description.size());
+
+  uint64_t offset = sizeof(header) + description.size();
+  auto writeData = [&](const void* data, uint64_t bytes) {
+    file.write((const char*)data, bytes);
+    offset += bytes;
+  };
+  auto pad = [&]() {
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {0};
+    file.write(zeros, align(offset) - offset);
+    offset = align(offset);
+  };
+
+  pad();
+  for (auto& namedSet : sets) {
+    const Set* set = namedSet.second;
+    const int size = set->getSize();
+    if (!set->hasImplicitEdges()) {
+      writeData(set->getEndpointsData(),
+                (uint64_t)size * set->getCardinality() * sizeof(int));
+      pad();
+    }
+    for (const Set::FieldData* field : set->fields) {
+      // The component arrays of SoA fields are as long as the set's capacity,
+      // so only the part of each that holds elements is written
+      if (field->layout.getKind() == FieldLayout::SoA &&
+          field->type->getSize() > 1) {
+        size_t componentBytes = componentSize(field->type->getComponentType());
+        for (size_t c=0; c < field->type->getSize(); ++c) {
+          writeData((const char*)field->data +
+                        c * set->getCapacity() * componentBytes,
+                    size * componentBytes);
+        }
+      }
+      else {
+        writeData(field->data, getFieldBytes(field, size));
+      }
+      pad();
+    }
+  }
+
+  file.flush();
+  uassert(file.good()) << "Could not write the snapshot " << path;
+}
+
+void SetSnapshot::Unmapper::operator()(void* mapping) const {
+  munmap(mapping, size);
+}
+
+SetSnapshot::SetSnapshot(const string& path)
+    : path(path), mappingSize(0), mapping(nullptr, Unmapper{0}) {
+  int fd = open(path.c_str(), O_RDONLY);
+  uassert(fd >= 0) << "Could not open the snapshot " << path;
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      (size_t)status.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    uerror << path << " is not a Simit snapshot";
+  }
+  mappingSize = status.st_size;
+
+  // Private, writable pages let programs update the fields in place without
+  // changing the file
+  void* data = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  close(fd);
+  uassert(data != MAP_FAILED) << "Could not map the snapshot " << path;
+  mapping = unique_ptr<void,Unmapper>(data, Unmapper{mappingSize});
+  readSets();
+}
+
+// Defined where Set is complete, so that the sets can be deleted
+SetSnapshot::~SetSnapshot() {}
+
+vector<string> SetSnapshot::getSetNames() const {
+  vector<string> names;
+  for (auto& set : sets) {
+    names.push_back(set.first);
+  }
+  return names;
+}
+
+bool SetSnapshot::hasSet(const string& name) const {
+  return sets.find(name) != sets.end();
+}
+
+Set* SetSnapshot::getSet(const string& name) const {
+  uassert(hasSet(name)) << "The snapshot " << path << " has no set " << name;
+  return sets.at(name).get();
+}
+
+void SetSnapshot::readSets() {
+  const char* base = (const char*)mapping.get();
+  SnapshotHeader header;
+  memcpy(&header, base, sizeof(header));
+  uassert(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0)
+      << path << " is not a Simit snapshot";
+  uassert(header.version == SNAPSHOT_VERSION)
+      << "The snapshot " << path << " has version " << header.version
+      << ", but only version " << SNAPSHOT_VERSION << " is supported";
+  uassert(header.byteOrder == SNAPSHOT_BYTE_ORDER)
+      << "The snapshot " << path << " was written on a machine with another "
+      << "byte order";
+  uassert(header.descriptionSize <= mappingSize - sizeof(header))
+      << "Corrupt snapshot " << path << ": truncated set description";
+
+  const char* descriptionBegin = base + sizeof(header);
+  DescriptionReader reader(descriptionBegin,
+                           descriptionBegin + header.descriptionSize, path);
+
+  // Get a pointer to `bytes` bytes of data at `offset`
+  auto getData = [&](uint64_t offset, uint64_t bytes) {
+    uassert(offset % SNAPSHOT_ALIGNMENT == 0 && offset <= mappingSize &&
+            bytes <= mappingSize - offset)
+        << "Corrupt snapshot " << path << ": data out of bounds";
+    return (void*)(base + offset);
+  };
+
+  // Create the sets before reading them, since edge sets refer to their
+  // endpoint sets by index
+  reader.checkCount(header.numSets, MIN_SET_DESCRIPTION_BYTES);
+  vector<Set*> setsByIndex;
+  vector<vector<uint32_t>> endpointSetIndices(header.numSets);
+  for (uint64_t i=0; i < header.numSets; ++i) {
+    string name = reader.readString();
+    uint32_t kind = reader.read<uint32_t>();
+    uassert(kind == Set::Unstructured || kind == Set::Grid)
+        << "Corrupt snapshot " << path << ": unknown kind of set " << name;
+    uassert(!hasSet(name))
+        << "Corrupt snapshot " << path << ": duplicate set " << name;
+    Set* set = new Set(name, (Set::Kind)kind);
+    sets[name] = unique_ptr<Set>(set);
+    setsByIndex.push_back(set);
+
+    int32_t size = reader.read<int32_t>();
+    uassert(size >= 0) << "Corrupt snapshot " << path << ": negative size";
+    set->numElements = size;
+    set->capacity = size;
+
+    uint32_t cardinality = reader.read<uint32_t>();
+    for (uint32_t j=0; j < cardinality; ++j) {
+      uint32_t endpointSet = reader.read<uint32_t>();
+      uassert(endpointSet < header.numSets)
+          << "Corrupt snapshot " << path << ": unknown endpoint set";
+      endpointSetIndices[i].push_back(endpointSet);
+    }
+
+    uint32_t numDimensions = reader.read<uint32_t>();
+    for (uint32_t j=0; j < numDimensions; ++j) {
+      set->dimensions.push_back(reader.read<int32_t>());
+    }
+    set->spatialFieldName = reader.readString();
+
+    uint64_t endpointsOffset = reader.read<uint64_t>();
+    uassert(endpointsOffset != 0 || kind == Set::Grid)
+        << "Corrupt snapshot " << path << ": missing endpoints of " << name;
+    if (endpointsOffset != 0) {
+      uint64_t endpointsBytes = (uint64_t)size * cardinality * sizeof(int);
+      void* endpoints = getData(endpointsOffset, endpointsBytes);
+      if (cardinality > 0) {
+        set->endpoints = (int*)endpoints;
+        set->ownsEndpoints = false;
+      }
+    }
+
+    uint32_t numFields = reader.read<uint32_t>();
+    for (uint32_t j=0; j < numFields; ++j) {
+      string fieldName = reader.readString();
+      uint32_t componentType = reader.read<uint32_t>();
+      uassert(componentType <= (uint32_t)ComponentType::DoubleComplex)
+          << "Corrupt snapshot " << path << ": unknown component type of "
+          << name << "." << fieldName;
+      uint32_t numFieldDimensions = reader.read<uint32_t>();
+      reader.checkCount(numFieldDimensions, sizeof(int32_t));
+      vector<int> fieldDimensions(numFieldDimensions);
+      for (int& dimension : fieldDimensions) {
+        dimension = reader.read<int32_t>();
+      }
+      uint32_t layoutKind = reader.read<uint32_t>();
+      int32_t laneWidth = reader.read<int32_t>();
+      FieldLayout layout;
+      switch (layoutKind) {
+        case FieldLayout::AoS:
+          layout = FieldLayout::aos();
+          break;
+        case FieldLayout::SoA:
+          layout = FieldLayout::soa();
+          break;
+        case FieldLayout::AoSoA:
+          layout = FieldLayout::aosoa(laneWidth);
+          break;
+        default:
+          uerror << "Corrupt snapshot " << path << ": unknown layout of "
+                 << name << "." << fieldName;
+      }
+
+      auto type = new Set::FieldData::TensorType(
+          (ComponentType)componentType, fieldDimensions);
+      auto field = new Set::FieldData(fieldName, type, layout, set);
+      field->ownsData = false;
+      set->fields.push_back(field);
+      set->fieldNames[fieldName] = set->fields.size()-1;
+      field->data = getData(reader.read<uint64_t>(),
+                            getFieldBytes(field, size));
+    }
+  }
+
+  for (size_t i=0; i < setsByIndex.size(); ++i) {
+    Set* set = setsByIndex[i];
+    for (uint32_t endpointSet : endpointSetIndices[i]) {
+      set->endpointSets.push_back(setsByIndex[endpointSet]);
+    }
+    if (set->endpoints != nullptr) {
+      set->checkEndpoints(set->getSize(), set->endpoints);
+    }
+
+    // The grid points and edges of grid edge sets are in canonical order, so
+    // the sizes must match the dimensions for their endpoints to be computed
+    if (set->getKind() == Set::Grid) {
+      int64_t totalPoints = set->dimensions.empty() ? 0 : 1;
+      for (int dimension : set->dimensions) {
+        totalPoints *= (dimension > 0) ? dimension : 0;
+      }
+      const Set* points = set->getCardinality() == 2 ? set->endpointSets[0]
+                                                     : nullptr;
+      uassert(points != nullptr && totalPoints > 0 &&
+              points->getSize() == totalPoints &&
+              set->getSize() == totalPoints * (int64_t)set->dimensions.size())
+          << "Corrupt snapshot " << path << ": malformed grid edge set "
+          << set->getName();
+      set->underlyingPointSet = points;
+    }
+  }
+}
+
+}
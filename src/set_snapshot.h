@@ -0,0 +1,77 @@
+#ifndef SIMIT_SET_SNAPSHOT_H
+#define SIMIT_SET_SNAPSHOT_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace simit {
+class Set;
+
+/// Version of the snapshot format written by writeSnapshot. Snapshots of other
+/// versions are rejected when they are opened.
+const unsigned SNAPSHOT_VERSION = 1;
+
+/// Write the named sets, with their endpoints, grid dimensions and fields, to
+/// a binary snapshot at `path`. The file is written sequentially, so this is
+/// also how simulations are checkpointed. The endpoint sets of every edge set
+/// must also be in `sets`.
+///
+/// A snapshot holds a header, the descriptions of the sets and then their
+/// endpoint and field arrays, each aligned to 64 bytes and laid out as in the
+/// sets, except that SoA component arrays are as long as the set. The arrays
+/// are stored in the byte order of the machine that wrote them.
+void writeSnapshot(const std::string& path,
+                   const std::map<std::string, const Set*>& sets);
+
+/// The sets of a snapshot written by writeSnapshot. The snapshot file is
+/// mapped into memory and the sets are built on top of the mapping without
+/// copying their endpoints or fields, so opening a snapshot only costs the
+/// page faults of the data that is used. The sets can be bound to Functions
+/// like any other set.
+///
+/// The mapping is private: writes to the sets' fields do not change the file,
+/// and sets that grow copy their data out of the mapping. The sets are owned
+/// by the snapshot and must not outlive it.
+class SetSnapshot {
+public:
+  /// Open the snapshot at `path`.
+  explicit SetSnapshot(const std::string& path);
+  ~SetSnapshot();
+
+  /// Get the names of the snapshot's sets.
+  std::vector<std::string> getSetNames() const;
+
+  bool hasSet(const std::string& name) const;
+
+  /// Get the set called `name`.
+  Set* getSet(const std::string& name) const;
+
+private:
+  /// Unmaps the snapshot file.
+  struct Unmapper {
+    size_t size;
+    void operator()(void* mapping) const;
+  };
+
+  std::string path;
+  size_t mappingSize;
+
+  /// The mapping and sets are owned by members as soon as they are created,
+  /// so that they are released if reading the snapshot fails. The sets are
+  /// declared last, since they must be destroyed before the mapping.
+  std::unique_ptr<void, Unmapper> mapping;
+  std::map<std::string, std::unique_ptr<Set>> sets;
+
+  /// Build the snapshot's sets from its descriptions.
+  void readSets();
+
+  /// disable copy
+  SetSnapshot(const SetSnapshot&);
+  SetSnapshot& operator=(const SetSnapshot&);
+};
+
+}
+#endif
@@ -288,7 +288,7 @@ private:
     // Classify the result of extern functions.
     if (op->callee.getKind() == Func::External) {
       for (auto& result : op->results) {
-        if (result.getType().isTensor()) {
+        if (result.getType().isTensor() && !isScalar(result.getType())) {
           auto type = result.getType().toTensor();
           if (type->order() == 1 || !type->hasSystemDimensions()) {
             storage->add(result, TensorStorage(TensorStorage::Dense));
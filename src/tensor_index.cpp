@@ -19,6 +19,7 @@ struct TensorIndex::Content {
   StencilLayout stencil;
   Var coordArray;
   Var sinkArray;
+  Var locsArray;
 };
 
 TensorIndex::TensorIndex(std::string name, pe::PathExpression pexpr)
@@ -30,6 +31,7 @@ TensorIndex::TensorIndex(std::string name, pe::PathExpression pexpr)
   string prefix = (name == "") ? name : name + ".";
   content->coordArray = Var(prefix + "coords", ArrayType::make(ScalarType::Int));
   content->sinkArray  = Var(prefix + "sinks",  ArrayType::make(ScalarType::Int));
+  content->locsArray  = Var(prefix + "locs",   ArrayType::make(ScalarType::Int));
 }
 
 TensorIndex::TensorIndex(std::string name, StencilLayout stencil)
@@ -80,6 +82,11 @@ const Var& TensorIndex::getColidxArray() const {
   return content->sinkArray;
 }
 
+const Var& TensorIndex::getLocationsArray() const {
+  iassert(!isComputed());
+  return content->locsArray;
+}
+
 const Expr TensorIndex::computeRowptr(Expr source) const {
   iassert(isComputed());
   if (getKind() == Sten) {
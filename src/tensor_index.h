@@ -69,6 +69,13 @@ public:
   /// Note: only sparse matrix CSR indices are supported for now.
   const Var& getColidxArray() const;
 
+  /// Return the tensor index's assembly location table.  For every edge of the
+  /// edge set the index's path expression goes through, the table contains the
+  /// colidx locations of the non-zeros the edge assembles into, so that
+  /// assembly loops can look them up instead of searching the colidx array.
+  /// Like the other arrays it is pre-assembled on function initialization.
+  const Var& getLocationsArray() const;
+
   /// Compute the tensor index's rowptr value for a given source.
   const Expr computeRowptr(Expr base) const;
 
@@ -182,7 +182,7 @@ UnstructuredSetType::~UnstructuredSetType() {
 
 // struct GridSetType
 Type GridSetType::make(Type elementType, IndexSet underlyingPointSet,
-                       size_t dimensions) {
+                       size_t dimensions, Boundary boundary) {
   iassert(elementType.isElement());
   iassert(underlyingPointSet.getKind() == IndexSet::Kind::Set);
   iassert(underlyingPointSet.getSet().type().isUnstructuredSet());
@@ -192,6 +192,7 @@ Type GridSetType::make(Type elementType, IndexSet underlyingPointSet,
   type->elementType = elementType;
   type->underlyingPointSet = underlyingPointSet;
   type->dimensions = dimensions;
+  type->boundary = boundary;
   return type;
 }
 
@@ -292,7 +293,7 @@ bool operator==(const UnstructuredSetType& l, const UnstructuredSetType& r) {
 bool operator==(const GridSetType& l, const GridSetType& r) {
   return l.elementType == r.elementType &&
       l.underlyingPointSet == r.underlyingPointSet &&
-      l.dimensions == r.dimensions;
+      l.dimensions == r.dimensions && l.boundary == r.boundary;
 }
 
 bool operator==(const UnnamedTupleType& l, const UnnamedTupleType& r) {
@@ -438,6 +439,9 @@ std::ostream& operator<<(std::ostream& os, const GridSetType& type) {
   os << "grid[" << type.dimensions << "]{"
      << type.elementType.toElement()->name << "}("
      << type.underlyingPointSet << ")";
+  if (type.boundary == GridSetType::Ghost) {
+    os << " ghost";
+  }
 
   return os;
 }
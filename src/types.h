@@ -10,6 +10,7 @@
 
 #include "complex_types.h"
 #include "domain.h"
+#include "field_layout.h"
 
 // TODO: Refactor the type system:
 //       - Make the Type class work similar to Expr
@@ -223,10 +224,14 @@ private:
 };
 
 struct Field {
-  Field(std::string name, Type type) : name(name), type(type) {}
+  Field(std::string name, Type type, FieldLayout layout=FieldLayout())
+      : name(name), type(type), layout(layout) {}
 
   std::string name;
   Type type;
+
+  /// The memory layout of the field in the sets of the element type.
+  FieldLayout layout;
 };
 
 struct ElementType : TypeNode {
@@ -299,14 +304,22 @@ struct GridSetType : SetType {
   /// in the underlying set at coordinate (... i_j, ...) neighbors points as
   /// coordinates (... i_j-1, ...) and (... i_j+1 ...), for all possible j. The
   /// determination of boundary conditions is also delegated to the grid edge
-  /// set definition, though we assume periodic for now.
+  /// set definition.
   size_t dimensions;
   /// Underlying point set of the grid. Elements of this edge set connect
   /// neighboring grid points in the grid.
   IndexSet underlyingPointSet;
 
+  /// Boundary conditions of the grid. The neighbors of the points on the
+  /// boundary of Periodic grids wrap around to the opposite boundary. The
+  /// outermost layer of points of Ghost grids holds boundary values instead:
+  /// maps through the grid only visit the interior points, so their stencils
+  /// never reach beyond the grid.
+  enum Boundary {Periodic, Ghost};
+  Boundary boundary;
+
   static Type make(Type elementType, IndexSet underlyingPointSet,
-                   size_t dimensions);
+                   size_t dimensions, Boundary boundary=Periodic);
 };
 
 struct UnnamedTupleType : TypeNode {
@@ -0,0 +1,103 @@
+#include "memory_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace simit {
+namespace util {
+
+// Each thread has its own active arena, so that functions that run at the
+// same time on different threads allocate from their own arenas. The workers
+// of the thread pool take on the arena of the thread that starts a loop.
+static thread_local MemoryArena* activeArena = nullptr;
+
+// class MemoryArena
+MemoryArena::MemoryArena()
+    : currentUsage(0), peakUsage(0), pooledBytes(0), numReused(0) {
+}
+
+MemoryArena::~MemoryArena() {
+  trim();
+}
+
+void* MemoryArena::allocate(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  requestedSizes.insert(size);
+  void* ptr = nullptr;
+  auto released = releasedBlocks.find(size);
+  if (released != releasedBlocks.end() && !released->second.empty()) {
+    ptr = released->second.back();
+    released->second.pop_back();
+    pooledBytes -= size;
+    ++numReused;
+  }
+  else {
+    ptr = malloc(size);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+  }
+  heldBlocks[ptr] = size;
+  currentUsage += size;
+  peakUsage = std::max(peakUsage, currentUsage);
+  return ptr;
+}
+
+bool MemoryArena::release(void* ptr) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto held = heldBlocks.find(ptr);
+  if (held == heldBlocks.end()) {
+    return false;
+  }
+  size_t size = held->second;
+  heldBlocks.erase(held);
+  releasedBlocks[size].push_back(ptr);
+  currentUsage -= size;
+  pooledBytes += size;
+  return true;
+}
+
+void MemoryArena::trim() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto& released : releasedBlocks) {
+    for (void* ptr : released.second) {
+      free(ptr);
+    }
+  }
+  releasedBlocks.clear();
+  pooledBytes = 0;
+}
+
+void MemoryArena::trimUnused() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto released = releasedBlocks.begin();
+       released != releasedBlocks.end();) {
+    size_t size = released->first;
+    if (requestedSizes.find(size) != requestedSizes.end()) {
+      ++released;
+      continue;
+    }
+    for (void* ptr : released->second) {
+      free(ptr);
+    }
+    pooledBytes -= size * released->second.size();
+    released = releasedBlocks.erase(released);
+  }
+  requestedSizes.clear();
+}
+
+MemoryArena* MemoryArena::getActive() {
+  return activeArena;
+}
+
+// class MemoryArena::Activation
+MemoryArena::Activation::Activation(MemoryArena* arena)
+    : previous(activeArena) {
+  activeArena = arena;
+}
+
+MemoryArena::Activation::~Activation() {
+  activeArena = previous;
+}
+
+}}
@@ -0,0 +1,92 @@
+#ifndef SIMIT_MEMORY_ARENA_H
+#define SIMIT_MEMORY_ARENA_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace simit {
+namespace util {
+
+/// An allocator that keeps the blocks it hands out, so that blocks that are
+/// released can be handed out again for later requests of the same size. This
+/// turns the allocations of a compiled function that recur every time it runs
+/// (e.g. the sparse results of matrix multiplies and solves) into reuse.
+/// Released blocks of sizes that stop recurring are freed by `trimUnused`.
+///
+/// While an arena is active on a thread (see `Activation`), `simit_malloc` and
+/// `simit_free` called from the thread allocate from it and release to it.
+/// Blocks that are still held when the arena is destroyed are left to their
+/// holders, since they may have been handed to code that frees them with
+/// `free`.
+class MemoryArena {
+public:
+  MemoryArena();
+  ~MemoryArena();
+
+  /// Returns a block of at least `size` bytes, reusing a released block of
+  /// the same size if there is one.
+  void* allocate(size_t size);
+
+  /// Return a block to the arena. Returns false, and does nothing, if the
+  /// block was not allocated by the arena.
+  bool release(void* ptr);
+
+  /// Returns the number of bytes in blocks that are currently held.
+  size_t getCurrentUsage() const {return currentUsage;}
+
+  /// Returns the largest number of bytes ever held at the same time.
+  size_t getPeakUsage() const {return peakUsage;}
+
+  /// Returns the number of bytes in released blocks that are kept for reuse.
+  size_t getPooledBytes() const {return pooledBytes;}
+
+  /// Returns the number of allocations that reused a released block.
+  size_t getNumReused() const {return numReused;}
+
+  /// Free the released blocks that are kept for reuse.
+  void trim();
+
+  /// Free the released blocks of sizes that have not been requested since the
+  /// last call, such as the results of a sparse matrix multiply whose number
+  /// of non-zeros has changed.
+  void trimUnused();
+
+  /// Returns the arena that is active on the calling thread, or null if no
+  /// arena is active on it.
+  static MemoryArena* getActive();
+
+  /// Makes an arena the active arena of the calling thread for as long as the
+  /// activation lives, and then restores the previously active arena.
+  class Activation {
+  public:
+    explicit Activation(MemoryArena* arena);
+    ~Activation();
+  private:
+    MemoryArena* previous;
+    Activation(const Activation&) = delete;
+    Activation& operator=(const Activation&) = delete;
+  };
+
+private:
+  /// Serializes the allocations and releases of parallel loop bodies.
+  std::mutex mutex;
+
+  std::map<void*, size_t> heldBlocks;
+  std::map<size_t, std::vector<void*>> releasedBlocks;
+  std::set<size_t> requestedSizes;
+
+  size_t currentUsage;
+  size_t peakUsage;
+  size_t pooledBytes;
+  size_t numReused;
+
+  MemoryArena(const MemoryArena&) = delete;
+  MemoryArena& operator=(const MemoryArena&) = delete;
+};
+
+}}
+
+#endif
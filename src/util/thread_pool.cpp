@@ -0,0 +1,139 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#include "memory_arena.h"
+
+namespace simit {
+extern int kNumThreads;
+
+namespace util {
+
+static thread_local bool parallelRegion = false;
+
+static void runChunks(const std::function<void(int,int)>& body, int n,
+                      int chunks, std::atomic<int>* nextChunk) {
+  bool wasParallelRegion = parallelRegion;
+  parallelRegion = true;
+  int chunk;
+  while ((chunk = (*nextChunk)++) < chunks) {
+    int begin = (int)(((long long)n * chunk) / chunks);
+    int end   = (int)(((long long)n * (chunk+1)) / chunks);
+    body(begin, end);
+  }
+  parallelRegion = wasParallelRegion;
+}
+
+// class ThreadPool
+ThreadPool::ThreadPool(unsigned numThreads)
+    : numThreads(numThreads), job(nullptr), jobArena(nullptr), jobSize(0),
+      jobChunks(0), generation(0), activeWorkers(0), shutdown(false),
+      nextChunk(0) {
+  if (this->numThreads == 0) {
+    this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned i = 1; i < this->numThreads; ++i) {
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    shutdown = true;
+  }
+  jobReady.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+ThreadPool& ThreadPool::getInstance() {
+  static ThreadPool pool(kNumThreads);
+  return pool;
+}
+
+bool ThreadPool::inParallelRegion() {
+  return parallelRegion;
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int,int)>& body) {
+  run(n, std::min(n, (int)numThreads), body);
+}
+
+void ThreadPool::parallelFor(int n, int chunkSize,
+                             const std::function<void(int,int)>& body) {
+  chunkSize = std::max(chunkSize, 1);
+  run(n, (int)(((long long)n + chunkSize-1) / chunkSize), body);
+}
+
+void ThreadPool::run(int n, int chunks,
+                     const std::function<void(int,int)>& body) {
+  if (n <= 0) {
+    return;
+  }
+
+  // Nested loops, and loops too small to split, run on the calling thread
+  if (workers.size() == 0 || chunks == 1 || parallelRegion) {
+    body(0, n);
+    return;
+  }
+
+  std::lock_guard<std::mutex> dispatch(dispatchMutex);
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    job = &body;
+    jobArena = MemoryArena::getActive();
+    jobSize = n;
+    jobChunks = chunks;
+    nextChunk = 0;
+    ++generation;
+  }
+  jobReady.notify_all();
+
+  runChunks(body, n, chunks, &nextChunk);
+
+  // Every chunk has been claimed, so the loop is done once the workers that
+  // claimed them have returned. Clearing the job keeps workers that wake up
+  // late from touching it after we return.
+  std::unique_lock<std::mutex> lock(jobMutex);
+  jobDone.wait(lock, [this]{return activeWorkers == 0;});
+  job = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+  unsigned long seen = 0;
+  while (true) {
+    const std::function<void(int,int)>* body;
+    MemoryArena* arena;
+    int n, chunks;
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      jobReady.wait(lock, [this,seen]{
+        return shutdown || (job != nullptr && generation != seen);
+      });
+      if (shutdown) {
+        return;
+      }
+      seen = generation;
+      body = job;
+      arena = jobArena;
+      n = jobSize;
+      chunks = jobChunks;
+      ++activeWorkers;
+    }
+
+    {
+      MemoryArena::Activation activation(arena);
+      runChunks(*body, n, chunks, &nextChunk);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      --activeWorkers;
+    }
+    jobDone.notify_all();
+  }
+}
+
+}}
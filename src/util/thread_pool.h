@@ -0,0 +1,82 @@
+#ifndef SIMIT_THREAD_POOL_H
+#define SIMIT_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace simit {
+namespace util {
+class MemoryArena;
+
+/// A fixed-size pool of worker threads that executes data-parallel loops.
+/// The thread that calls `parallelFor` participates in the loop, so a pool
+/// with n threads spawns n-1 workers. Loops issued from inside a running loop
+/// body execute serially on the calling thread. Workers run loop bodies with
+/// the memory arena of the calling thread active (see MemoryArena).
+class ThreadPool {
+public:
+  /// Create a pool with `numThreads` threads. Zero means one thread per
+  /// hardware thread.
+  explicit ThreadPool(unsigned numThreads=0);
+  ~ThreadPool();
+
+  /// Returns the pool shared by compiled code and the host-side APIs. It is
+  /// created on first use with the thread count given to `simit::init`.
+  static ThreadPool& getInstance();
+
+  /// Returns the number of threads that execute loop iterations, including
+  /// the calling thread.
+  unsigned getNumThreads() const {return numThreads;}
+
+  /// Execute `body(begin, end)` over disjoint, contiguous ranges that cover
+  /// [0, n), and block until all ranges have finished. The iteration space is
+  /// split into one range per thread.
+  void parallelFor(int n, const std::function<void(int,int)>& body);
+
+  /// Execute `body(begin, end)` like `parallelFor`, but split the iteration
+  /// space into ranges of about `chunkSize` iterations that threads claim as
+  /// they finish earlier ones, which balances loops whose iterations differ
+  /// in cost.
+  void parallelFor(int n, int chunkSize,
+                   const std::function<void(int,int)>& body);
+
+  /// True iff the calling thread is currently executing a loop body.
+  static bool inParallelRegion();
+
+private:
+  unsigned numThreads;
+  std::vector<std::thread> workers;
+
+  // Serializes loops issued concurrently by different host threads.
+  std::mutex dispatchMutex;
+
+  // Protects the job description below and wakes up the workers.
+  std::mutex jobMutex;
+  std::condition_variable jobReady;
+  std::condition_variable jobDone;
+
+  const std::function<void(int,int)>* job;
+  MemoryArena* jobArena;
+  int jobSize;
+  int jobChunks;
+  unsigned long generation;
+  unsigned activeWorkers;
+  bool shutdown;
+
+  // The next chunk of the current loop that has not been claimed by a thread.
+  std::atomic<int> nextChunk;
+
+  void run(int n, int chunks, const std::function<void(int,int)>& body);
+  void workerLoop();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+}}
+
+#endif
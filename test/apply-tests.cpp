@@ -78,3 +78,52 @@ TEST(apply, edges_binary_gather) {
   ASSERT_EQ(3.0, (int)b(e0));
   ASSERT_EQ(5.0, (int)b(e1));
 }
+
+TEST(apply, field_layouts) {
+  Set V;
+  FieldRef<simit_float,3> x = V.addField<simit_float,3>("x",FieldLayout::soa());
+  FieldRef<simit_float,3> v = V.addField<simit_float,3>("v",FieldLayout::soa());
+  vector<ElementRef> vertices;
+  for (int i=0; i<6; ++i) {
+    ElementRef vertex = V.add();
+    x.set(vertex, {(simit_float)i, (simit_float)(i*i), 1.0});
+    v.set(vertex, {1.0, 0.0, (simit_float)i});
+    vertices.push_back(vertex);
+  }
+
+  Set E(V,V);
+  FieldRef<simit_float,3> d =
+      E.addField<simit_float,3>("d", FieldLayout::aosoa(4));
+  vector<ElementRef> edges;
+  for (int i=0; i<5; ++i) {
+    edges.push_back(E.add(vertices[i], vertices[i+1]));
+  }
+
+  // The sets have room for more elements than they have, so the generated
+  // code must stride the SoA components by the capacity, and binding must
+  // leave the field arrays where they are
+  ASSERT_LT(V.getSize(), V.getCapacity());
+  const void* xData = V.getFieldData("x");
+  const void* vData = V.getFieldData("v");
+
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.runSafe();
+  ASSERT_EQ(xData, V.getFieldData("x"));
+  ASSERT_EQ(vData, V.getFieldData("v"));
+
+  for (int i=0; i<6; ++i) {
+    TensorRef<simit_float,3> xi = x.get(vertices[i]);
+    SIMIT_ASSERT_FLOAT_EQ(i+2.0, xi(0));
+    SIMIT_ASSERT_FLOAT_EQ(i*i, xi(1));
+    SIMIT_ASSERT_FLOAT_EQ(1.0+2.0*i, xi(2));
+  }
+  for (int i=0; i<5; ++i) {
+    TensorRef<simit_float,3> di = d.get(edges[i]);
+    SIMIT_ASSERT_FLOAT_EQ(1.0, di(0));
+    SIMIT_ASSERT_FLOAT_EQ(2.0*i+1.0, di(1));
+    SIMIT_ASSERT_FLOAT_EQ(2.0, di(2));
+  }
+}
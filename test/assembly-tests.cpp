@@ -163,6 +163,54 @@ TEST(assembly, edges_binary) {
   ASSERT_EQ((int)a(v2), 1);
 }
 
+TEST(assembly, edges_reduce_max) {
+  Set V;
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  FieldRef<int> a = V.addField<int>("a");
+
+  Set E(V,V);
+  FieldRef<int> b = E.addField<int>("b");
+  ElementRef e0 = E.add(v0,v1);
+  ElementRef e1 = E.add(v1,v2);
+  b(e0) = 3;
+  b(e1) = 5;
+
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.runSafe();
+
+  ASSERT_EQ(3, (int)a(v0));
+  ASSERT_EQ(5, (int)a(v1));
+  ASSERT_EQ(5, (int)a(v2));
+}
+
+TEST(assembly, edges_degenerate) {
+  Set V;
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  FieldRef<int> a = V.addField<int>("a");
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v1);
+  E.add(v1,v2);
+
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.runSafe();
+
+  ASSERT_EQ((int)a(v0), 1);
+  ASSERT_EQ((int)a(v1), 4);
+  ASSERT_EQ((int)a(v2), 1);
+}
+
 TEST(assembly, edges_tertiary) {
   Set V;
   ElementRef v0 = V.add();
@@ -291,6 +339,33 @@ TEST(assembly, matrix_vv) {
   ASSERT_EQ(2, (int)b(v2));
 }
 
+TEST(assembly, matrix_vv_degenerate) {
+  Set V;
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  FieldRef<int> a = V.addField<int>("a");
+  FieldRef<int> b = V.addField<int>("b");
+  a(v0) = 1;
+  a(v1) = 1;
+  a(v2) = 1;
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v1);
+  E.add(v1,v2);
+
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.runSafe();
+
+  ASSERT_EQ(2, (int)b(v0));
+  ASSERT_EQ(8, (int)b(v1));
+  ASSERT_EQ(2, (int)b(v2));
+}
+
 TEST(assembly, matrix_ve_heterogeneous) {
   Set V0;
   FieldRef<int> b0 = V0.addField<int>("b");
@@ -0,0 +1,134 @@
+#include "simit-test.h"
+
+#include "buffer_assignment.h"
+#include "frontend/frontend.h"
+#include "ir.h"
+#include "ir_transforms.h"
+#include "lower/lower.h"
+#include "program_context.h"
+
+using namespace std;
+using namespace simit::ir;
+
+static Type vecType(int n) {
+  return TensorType::make(ScalarType::Float, {IndexDomain(n)});
+}
+
+TEST(BufferAssignment, SequentialTemporariesDoNotOverlap) {
+  Var a("a", vecType(4));
+  Var b("b", vecType(4));
+  Var c("c", vecType(4));
+  Var r("r", vecType(4));
+  Stmt body = Block::make({
+    AssignStmt::make(a, r),
+    AssignStmt::make(r, a),
+    AssignStmt::make(b, r),
+    AssignStmt::make(r, b),
+    AssignStmt::make(r, c)
+  });
+
+  map<Var,LiveRange> liveRanges = getLiveRanges(body, {a, b, c});
+  ASSERT_TRUE(simit::util::contains(liveRanges, a));
+  ASSERT_TRUE(simit::util::contains(liveRanges, b));
+  ASSERT_FALSE(liveRanges.at(a).overlaps(liveRanges.at(b)));
+
+  // c is read before it is written, so it must keep its own buffer
+  ASSERT_FALSE(simit::util::contains(liveRanges, c));
+}
+
+TEST(BufferAssignment, LoopExtendsLiveRange) {
+  Var a("a", vecType(4));
+  Var b("b", vecType(4));
+  Var r("r", vecType(4));
+  Var i("i", Int);
+  Stmt body = Block::make({
+    AssignStmt::make(a, r),
+    ForRange::make(i, 0, 10, Block::make(AssignStmt::make(b, a),
+                                         AssignStmt::make(a, b)))
+  });
+
+  map<Var,LiveRange> liveRanges = getLiveRanges(body, {a, b});
+  ASSERT_TRUE(liveRanges.at(a).overlaps(liveRanges.at(b)));
+}
+
+TEST(BufferAssignment, StoreLoopDefinesVector) {
+  Type pointType = ElementType::make("Point", {Field("b", Float)});
+  Var points("points", UnstructuredSetType::make(pointType, {}));
+  Type pointsVecType = TensorType::make(ScalarType::Float,
+                                        {IndexDomain(IndexSet(points))});
+  Var a("a", pointsVecType);
+  Var b("b", pointsVecType);
+  Var c("c", pointsVecType);
+  Var d("d", pointsVecType);
+  Var e("e", pointsVecType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Var k("k", Int);
+  Expr pb = FieldRead::make(points, "b");
+  ForDomain domain = ForDomain(IndexSet(points));
+  Stmt body = Block::make({
+    AssignStmt::make(e, 0.0),
+    For::make(i, domain, Store::make(a, i, Load::make(pb, i))),
+    For::make(j, domain, Block::make({
+      Store::make(b, j, Load::make(a, j)),
+      Store::make(c, j, Add::make(Load::make(c, j), Load::make(b, j))),
+    })),
+    For::make(k, domain, Block::make({
+      Store::make(d, k, Load::make(a, k)),
+      Store::make(e, k, Load::make(d, k+1))
+    }))
+  });
+
+  // c reads its old values and d reads elements it has not stored yet, so
+  // only the memset of e and the loops that store a and b define them
+  map<Var,LiveRange> liveRanges = getLiveRanges(body, {a, b, c, d, e});
+  ASSERT_TRUE(simit::util::contains(liveRanges, a));
+  ASSERT_TRUE(simit::util::contains(liveRanges, b));
+  ASSERT_FALSE(simit::util::contains(liveRanges, c));
+  ASSERT_FALSE(simit::util::contains(liveRanges, d));
+  ASSERT_TRUE(simit::util::contains(liveRanges, e));
+}
+
+TEST(BufferAssignment, ConjugateGradientSharesBuffers) {
+  simit::internal::ProgramContext ctx;
+  simit::internal::Frontend frontend;
+  vector<simit::ParseError> errors;
+  ASSERT_EQ(0, frontend.parseFile(string(TEST_INPUT_DIR) + "/program/cg.sim",
+                                  &ctx, &errors));
+  Func func = makeBufferedSystemTensorsGlobal(lower(ctx.getFunction("main")));
+  map<string,Var> temporaries;
+  for (const Var& tmp : func.getEnvironment().getTemporaries()) {
+    temporaries[tmp.getName()] = tmp;
+  }
+
+  // The residual and search direction vectors are temporaries, which are
+  // defined by the loops that store them, and vectors that are not live at
+  // the same time share slabs
+  ASSERT_TRUE(simit::util::contains(temporaries, string("r")));
+  ASSERT_TRUE(simit::util::contains(temporaries, string("p")));
+  map<Var,LiveRange> liveRanges =
+      getLiveRanges(func.getBody(), func.getEnvironment().getTemporaries());
+  ASSERT_TRUE(simit::util::contains(liveRanges, temporaries.at("r")));
+  ASSERT_TRUE(simit::util::contains(liveRanges, temporaries.at("p")));
+  map<Var,size_t> sizes;
+  for (auto& liveRange : liveRanges) {
+    sizes[liveRange.first] = 64;
+  }
+  ASSERT_GT(assignBuffers(liveRanges, sizes).getBytesSaved(), 0u);
+}
+
+TEST(BufferAssignment, DisjointTemporariesShareSlab) {
+  Var a("a", vecType(16));
+  Var b("b", vecType(8));
+  Var c("c", vecType(8));
+  map<Var,LiveRange> liveRanges = {{a, LiveRange(0, 1)},
+                                   {b, LiveRange(2, 3)},
+                                   {c, LiveRange(1, 2)}};
+  map<Var,size_t> sizes = {{a, 128}, {b, 64}, {c, 64}};
+
+  BufferAssignment assignment = assignBuffers(liveRanges, sizes);
+  ASSERT_EQ(assignment.offsets.at(a), assignment.offsets.at(b));
+  ASSERT_NE(assignment.offsets.at(a), assignment.offsets.at(c));
+  ASSERT_EQ(192u, assignment.arenaSize);
+  ASSERT_EQ(64u, assignment.getBytesSaved());
+}
@@ -0,0 +1,256 @@
+#include "simit-test.h"
+
+#include "intrinsics.h"
+#include "ir.h"
+#include "ir_visitor.h"
+#include "lower/eliminate_redundancy.h"
+#include "lower/fuse_loops.h"
+
+using namespace std;
+using namespace simit::ir;
+
+static const Type VertsType =
+    UnstructuredSetType::make(ElementType::make("Vertex",
+                                                {Field("x", Float),
+                                                 Field("v", Float)}), {});
+
+/// Counts the calls made in loop bodies.
+class CountCallsInLoops : public IRVisitor {
+public:
+  int count = 0;
+private:
+  int depth = 0;
+  using IRVisitor::visit;
+  void visit(const ForRange* op) {
+    ++depth;
+    IRVisitor::visit(op);
+    --depth;
+  }
+  void visit(const CallStmt* op) {
+    count += (depth > 0) ? 1 : 0;
+  }
+};
+
+static int countCallsInLoops(const Func& func) {
+  CountCallsInLoops counter;
+  func.getBody().accept(&counter);
+  return counter.count;
+}
+
+TEST(HoistLoopInvariants, PureCall) {
+  Var x("x", Float);
+  Var s("s", Float);
+  Var d("d", Float);
+  Var i("i", Int);
+  Stmt loop = ForRange::make(i, 0, 10, Block::make({
+    VarDecl::make(d),
+    CallStmt::make({d}, intrinsics::sqrt(), {x}),
+    AssignStmt::make(s, d, CompoundOperator::Add)
+  }));
+  Func func("sum", {x}, {s}, Block::make(AssignStmt::make(s, 0.0), loop));
+
+  int numHoisted = 0;
+  func = hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(1, numHoisted);
+  ASSERT_EQ(0, countCallsInLoops(func));
+}
+
+TEST(HoistLoopInvariants, VariantArgumentIsNotHoisted) {
+  Var x("x", Float);
+  Var s("s", Float);
+  Var d("d", Float);
+  Var i("i", Int);
+  Stmt loop = ForRange::make(i, 0, 10, Block::make({
+    VarDecl::make(d),
+    CallStmt::make({d}, intrinsics::sqrt(), {x}),
+    AssignStmt::make(x, d, CompoundOperator::Add)
+  }));
+  Func func("iterate", {}, {x}, loop);
+
+  int numHoisted = 0;
+  func = hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(0, numHoisted);
+  ASSERT_EQ(1, countCallsInLoops(func));
+}
+
+TEST(HoistLoopInvariants, FieldDependencies) {
+  Var V("V", VertsType);
+  Var a("a", Float);
+  Var b("b", Float);
+  Var i("i", Int);
+  Expr x = FieldRead::make(V, "x");
+  Expr v = FieldRead::make(V, "v");
+
+  // The loop writes V.x, so only the read of V.v is invariant
+  Stmt loop = ForRange::make(i, 0, 10, Block::make({
+    VarDecl::make(a),
+    AssignStmt::make(a, Load::make(x, 0)),
+    VarDecl::make(b),
+    AssignStmt::make(b, Load::make(v, 0)),
+    Store::make(x, i, Add::make(a, b))
+  }));
+  Func func("scan", {V}, {}, loop);
+
+  int numHoisted = 0;
+  hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(1, numHoisted);
+}
+
+TEST(HoistLoopInvariants, LoadIsNotSpeculated) {
+  Var V("V", VertsType);
+  Var n("n", Int);
+  Var a("a", Float);
+  Var b("b", Float);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr x = FieldRead::make(V, "x");
+  Expr v = FieldRead::make(V, "v");
+
+  // The loops may not run, and V.v may then have no element 0 to load
+  Stmt body = Block::make(
+    For::make(i, ForDomain(IndexSet(V)), Block::make({
+      VarDecl::make(a),
+      AssignStmt::make(a, Load::make(v, 0)),
+      Store::make(x, i, a)
+    })),
+    ForRange::make(j, 0, n, Block::make({
+      VarDecl::make(b),
+      AssignStmt::make(b, Load::make(v, 0)),
+      Store::make(x, j, b)
+    })));
+  Func func("spread", {V, n}, {}, body);
+
+  int numHoisted = 0;
+  hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(0, numHoisted);
+}
+
+TEST(HoistLoopInvariants, HoistedLoopIsFused) {
+  Var V("V", VertsType);
+  Var c("c", Float);
+  Var d("d", Float);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr x = FieldRead::make(V, "x");
+  Expr v = FieldRead::make(V, "v");
+  Stmt body = Block::make(
+    For::make(i, ForDomain(IndexSet(V)), Block::make({
+      VarDecl::make(d),
+      CallStmt::make({d}, intrinsics::sqrt(), {c}),
+      Store::make(x, i, d)
+    })),
+    For::make(j, ForDomain(IndexSet(V)), Store::make(v, j, Load::make(x, j))));
+  Func func("fill", {V, c}, {}, body);
+
+  // The hoisted call goes in front of the first loop, which stays fusable
+  int numHoisted = 0;
+  func = hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(1, numHoisted);
+  int numFused = 0;
+  fuseLoops(func, &numFused);
+  ASSERT_EQ(1, numFused);
+}
+
+TEST(HoistLoopInvariants, InternalCallWithoutSideEffects) {
+  Var a("a", Float);
+  Var r("r", Float);
+  Func scale("scale", {a}, {r}, AssignStmt::make(r, Mul::make(a, 2.0)));
+
+  // The call to scale does not stop the hoisting of the invariant root
+  Var x("x", Float);
+  Var s("s", Float);
+  Var d("d", Float);
+  Var e("e", Float);
+  Var i("i", Int);
+  Stmt loop = ForRange::make(i, 0, 10, Block::make({
+    VarDecl::make(d),
+    CallStmt::make({d}, intrinsics::sqrt(), {x}),
+    VarDecl::make(e),
+    CallStmt::make({e}, scale, {s}),
+    AssignStmt::make(s, Add::make(d, e))
+  }));
+  Func func("iterate", {x}, {s}, Block::make(AssignStmt::make(s, 0.0), loop));
+
+  int numHoisted = 0;
+  func = hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(1, numHoisted);
+  ASSERT_EQ(1, countCallsInLoops(func));
+}
+
+TEST(EliminateCommonSubexpressions, PureCall) {
+  Var x("x", Float);
+  Var a("a", Float);
+  Var b("b", Float);
+  Var c("c", Float);
+  Stmt body = Block::make({
+    CallStmt::make({a}, intrinsics::sqrt(), {x}),
+    CallStmt::make({b}, intrinsics::sqrt(), {x}),
+    AssignStmt::make(x, 2.0),
+    CallStmt::make({c}, intrinsics::sqrt(), {x})
+  });
+  Func func("roots", {x}, {a, b, c}, body);
+
+  // The third call reads a new value of x
+  int numEliminated = 0;
+  eliminateCommonSubexpressions(func, &numEliminated);
+  ASSERT_EQ(1, numEliminated);
+}
+
+TEST(EliminateCommonSubexpressions, IndexExpr) {
+  Type vectorType = TensorType::make(ScalarType::Float, {IndexDomain(3)});
+  Var a("a", vectorType);
+  Var b("b", vectorType);
+  Var c("c", vectorType);
+  Var d("d", vectorType);
+  Var e("e", vectorType);
+  IndexVar i("i", IndexDomain(3));
+  IndexVar j("j", IndexDomain(3));
+  Expr ai = IndexedTensor::make(a, {i});
+  Expr bi = IndexedTensor::make(b, {i});
+  Expr aj = IndexedTensor::make(a, {j});
+  Expr bj = IndexedTensor::make(b, {j});
+  Stmt body = Block::make({
+    AssignStmt::make(c, IndexExpr::make({i}, Add::make(ai, bi))),
+    AssignStmt::make(d, IndexExpr::make({j}, Add::make(aj, bj))),
+    AssignStmt::make(e, IndexExpr::make({j}, Add::make(bj, aj)))
+  });
+  Func func("sums", {a, b}, {c, d, e}, body);
+
+  // The index expressions of c and d only differ in their index variables
+  int numEliminated = 0;
+  eliminateCommonSubexpressions(func, &numEliminated);
+  ASSERT_EQ(1, numEliminated);
+}
+
+TEST(EliminateCommonSubexpressions, InternalCallWritesExternField) {
+  // force writes the field of an extern set that it does not take as argument
+  Var verts("verts", VertsType);
+  Expr v = FieldRead::make(verts, "v");
+  Func force("force", {}, {}, Store::make(v, 0, 1.0));
+
+  Var a("a", Float);
+  Var b("b", Float);
+  Var c("c", Float);
+  Var i("i", Int);
+  Stmt body = Block::make({
+    AssignStmt::make(a, Load::make(v, 0)),
+    CallStmt::make({}, force, {}),
+    AssignStmt::make(b, Load::make(v, 0)),
+    ForRange::make(i, 0, 10, Block::make({
+      VarDecl::make(c),
+      AssignStmt::make(c, Load::make(v, 0)),
+      CallStmt::make({}, force, {}),
+      AssignStmt::make(a, c, CompoundOperator::Add)
+    }))
+  });
+  Func func("step", {}, {a, b}, body);
+
+  // The loads of verts.v before and after the call read different values,
+  // and the load in the loop reads the value the previous iteration wrote
+  int numEliminated = 0;
+  eliminateCommonSubexpressions(func, &numEliminated);
+  ASSERT_EQ(0, numEliminated);
+  int numHoisted = 0;
+  hoistLoopInvariants(func, &numHoisted);
+  ASSERT_EQ(0, numHoisted);
+}
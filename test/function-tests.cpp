@@ -1,5 +1,16 @@
 #include "simit-test.h"
 
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "backend/llvm/llvm_object_cache.h"
 #include "tensor.h"
 #include "tensor_data.h"
 #include "graph.h"
@@ -7,6 +18,13 @@
 #include "lower/index_expressions/lower_scatter_workspace.h"
 
 using namespace simit::ir;
+using simit::backend::LLVMObjectCache;
+
+namespace simit {
+extern std::string kBackend;
+extern std::string kCacheDir;
+extern size_t kCacheMaxBytes;
+}
 
 TEST(Function, bindSet) {
   Type vertexType = ElementType::make("Vertex", {Field("field", Int)});
@@ -137,3 +155,362 @@ TEST(Function, bindSparseTensor) {
   ASSERT_EQ(-3, A_vals[2]);
   ASSERT_EQ(-4, A_vals[3]);
 }
+
+TEST(Function, rebindArguments) {
+  Type vertexType = ElementType::make("Vertex", {Field("field", Int)});
+  Type vertexSetType = UnstructuredSetType::make(vertexType, {});
+  Var V("V", vertexSetType);
+  Var s("s", Int);
+  Var i("i", Int);
+  Expr field = FieldRead::make(V, "field");
+  Stmt add = ForRange::make(i, 0, Length::make(IndexSet(V)),
+                            Store::make(field, i, Load::make(field, i) + s));
+  Func func("add", {V, s}, {}, add);
+  simit::Function function = getTestBackend()->compile(func);
+
+  simit::Set V0, V1;
+  auto field0 = V0.addField<int>("field");
+  auto field1 = V1.addField<int>("field");
+  std::vector<simit::ElementRef> elems0, elems1;
+  for (int n = 0; n < 3; ++n) {
+    elems0.push_back(V0.add());
+    elems1.push_back(V1.add());
+    field0(elems0[n]) = n;
+    field1(elems1[n]) = 10*n;
+  }
+  simit::Tensor<int> s0 = 1;
+  simit::Tensor<int> s1 = 2;
+
+  function.bind("V", &V0);
+  function.bind("s", &s0);
+  function.init();
+  function.runSafe();
+
+  // Swap in actuals of the same shape without re-initializing
+  function.bind("V", &V1);
+  function.bind("s", &s1);
+  ASSERT_TRUE(function.isInitialized());
+  function.runSafe();
+  for (int n = 0; n < 3; ++n) {
+    ASSERT_EQ(n + 1, field0(elems0[n]));
+    ASSERT_EQ(10*n + 2, field1(elems1[n]));
+  }
+
+  // A set with a different size requires re-initialization
+  simit::Set V2;
+  V2.addField<int>("field");
+  V2.add();
+  function.bind("V", &V2);
+  ASSERT_FALSE(function.isInitialized());
+}
+
+TEST(Function, rebindEdgeSets) {
+  Type vertexType = ElementType::make("Vertex", {Field("a", Int)});
+  Type vertexSetType = UnstructuredSetType::make(vertexType, {});
+  Var V("V", vertexSetType);
+  Type edgeType = ElementType::make("Edge", {Field("b", Int)});
+  Type edgeSetType = UnstructuredSetType::make(edgeType, {V,V});
+  Var E("E", edgeSetType);
+  Var i("i", Int);
+  Expr endpoints = IndexRead::make(E, IndexRead::Endpoints);
+  Stmt gather = ForRange::make(i, 0, Length::make(IndexSet(E)),
+                               Store::make(FieldRead::make(E, "b"), i,
+                                           Load::make(FieldRead::make(V, "a"),
+                                                      Load::make(endpoints,
+                                                                 i*2+1))));
+  Func func("gather", {V, E}, {}, gather);
+  simit::Function function = getTestBackend()->compile(func);
+
+  simit::Set verts;
+  auto a = verts.addField<int>("a");
+  std::vector<simit::ElementRef> vertRefs;
+  for (int n = 0; n < 3; ++n) {
+    vertRefs.push_back(verts.add());
+    a(vertRefs[n]) = 10*n;
+  }
+
+  // Sets that adopt the same endpoints share a topology
+  int eps[] = {0,1, 1,2};
+  simit::Set E0(verts,verts), E1(verts,verts);
+  auto b0 = E0.addField<int>("b");
+  auto b1 = E1.addField<int>("b");
+  E0.adopt(2, eps);
+  E1.adopt(2, eps);
+  function.bind("V", &verts);
+  function.bind("E", &E0);
+  function.init();
+  function.runSafe();
+  function.bind("E", &E1);
+  ASSERT_TRUE(function.isInitialized());
+  function.runSafe();
+  std::vector<int> expected = {10, 20};
+  for (auto e : E1) {
+    ASSERT_EQ(expected[e.getIdent()], (int)b0(e));
+    ASSERT_EQ(expected[e.getIdent()], (int)b1(e));
+  }
+
+  // Sets with the same size but other endpoints require re-initialization
+  simit::Set E2(verts,verts);
+  auto b2 = E2.addField<int>("b");
+  E2.add(vertRefs[1], vertRefs[0]);
+  E2.add(vertRefs[2], vertRefs[2]);
+  function.bind("E", &E2);
+  ASSERT_FALSE(function.isInitialized());
+  function.runSafe();
+  expected = {0, 20};
+  for (auto e : E2) {
+    ASSERT_EQ(expected[e.getIdent()], (int)b2(e));
+  }
+}
+
+TEST(Function, memoryArenaReusesRuntimeResults) {
+  simit::Set points;
+  simit::FieldRef<simit_float> b = points.addField<simit_float>("b");
+  points.addField<simit_float>("c");
+  std::vector<simit::ElementRef> pointRefs;
+  for (int i = 0; i < 3; ++i) {
+    pointRefs.push_back(points.add());
+    b.set(pointRefs[i], i+1.0);
+  }
+  simit::Set springs(points,points);
+  simit::FieldRef<simit_float> a = springs.addField<simit_float>("a");
+  a.set(springs.add(pointRefs[0], pointRefs[1]), 1.0);
+  a.set(springs.add(pointRefs[1], pointRefs[2]), 2.0);
+
+  // The program multiplies two sparse matrices with the external spmm, whose
+  // result is freed at the end of every run
+  simit::Function func = loadFunction(std::string(TEST_INPUT_DIR) +
+                               "/system/gemm.sim");
+  if (!func.defined()) FAIL();
+  func.bind("points", &points);
+  func.bind("springs", &springs);
+
+  func.runSafe();
+  size_t peakUsage = func.getPeakMemoryUsage();
+  ASSERT_GT(peakUsage, 0u);
+
+  // The second run reuses the blocks of the first rather than growing
+  func.runSafe();
+  ASSERT_GT(func.getNumReused(), 0u);
+  ASSERT_EQ(peakUsage, func.getPeakMemoryUsage());
+}
+
+TEST(Function, temporariesShareArena) {
+  simit::Set points;
+  simit::FieldRef<simit_float> b = points.addField<simit_float>("b");
+  simit::FieldRef<simit_float> c = points.addField<simit_float>("c");
+  points.addField<int>("id");
+  simit::ElementRef p0 = points.add();
+  simit::ElementRef p1 = points.add();
+  simit::ElementRef p2 = points.add();
+  b.set(p0, 1.0);
+  b.set(p1, 2.0);
+  b.set(p2, 3.0);
+  simit::Set springs(points,points);
+  simit::FieldRef<simit_float> a = springs.addField<simit_float>("a");
+  a.set(springs.add(p0,p1), 4.0);
+  a.set(springs.add(p1,p2), 5.0);
+
+  // The conjugate gradient solve assembles matrices and computes vectors
+  // whose live ranges do not all overlap
+  simit::Function func = loadFunction(std::string(TEST_INPUT_DIR) +
+                                      "/program/cg.sim");
+  if (!func.defined()) FAIL();
+  func.bind("points", &points);
+  func.bind("springs", &springs);
+
+  std::stringstream report;
+  func.runSafe();
+  func.printMemoryReport(report);
+  std::string line;
+  size_t bytesSaved = 0;
+  while (std::getline(report, line)) {
+    std::string::size_type pos = line.find("bytes saved:");
+    if (pos != std::string::npos) {
+      bytesSaved = std::stoul(line.substr(pos + strlen("bytes saved:")));
+    }
+  }
+  ASSERT_GT(bytesSaved, 0u) << report.str();
+
+  // Temporaries that share slabs still compute the solution of Program.cg,
+  // also when the slabs hold the values of the previous run
+  for (int run = 0; run < 2; ++run) {
+    if (run > 0) {
+      func.runSafe();
+    }
+    SIMIT_ASSERT_FLOAT_EQ(0.95883777239709455653, (simit_float)c.get(p0));
+    SIMIT_ASSERT_FLOAT_EQ(1.98789346246973352983, (simit_float)c.get(p1));
+    SIMIT_ASSERT_FLOAT_EQ(3.05326876513317202466, (simit_float)c.get(p2));
+  }
+}
+
+/// Returns the names of the objects in the cache directory `dir`.
+static std::vector<std::string> getCachedObjects(const std::string& dir) {
+  std::vector<std::string> objects;
+  DIR* d = opendir(dir.c_str());
+  while (struct dirent* ent = readdir(d)) {
+    std::string name = ent->d_name;
+    if (name != "." && name != "..") {
+      objects.push_back(name);
+    }
+  }
+  closedir(d);
+  std::sort(objects.begin(), objects.end());
+  return objects;
+}
+
+static void removeCache(const std::string& dir) {
+  for (const std::string& name : getCachedObjects(dir)) {
+    remove((dir + "/" + name).c_str());
+  }
+  rmdir(dir.c_str());
+}
+
+/// Compiles and runs `a = b + c`, where `c` is read from a tensor literal.
+static void runAddLiteral(int c) {
+  Var a("a", Int);
+  Var b("b", Int);
+  Expr literal = Literal::make(TensorType::make(ScalarType::Int,
+                                                {IndexDomain(2)}),
+                               std::vector<int>({c, 0}));
+  Stmt add = AssignStmt::make(a, Add::make(b, Load::make(literal, 0)));
+  Environment env;
+  env.addExtern(a);
+  env.addExtern(b);
+
+  simit::Function function = getTestBackend()->compile(add, env);
+  simit::Tensor<int> aArg = 0;
+  simit::Tensor<int> bArg = 42;
+  function.bind("a", &aArg);
+  function.bind("b", &bArg);
+  function.runSafe();
+  ASSERT_EQ(42 + c, (int)aArg);
+}
+
+TEST(Function, objectCache) {
+  if (simit::kBackend == "gpu") return;
+
+  char dirTemplate[] = "/tmp/simit-cache-XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(dirTemplate));
+  std::string oldCacheDir = simit::kCacheDir;
+  simit::kCacheDir = dirTemplate;
+  LLVMObjectCache& cache = LLVMObjectCache::getInstance();
+  cache.resetStats();
+
+  // The second compilation loads the machine code cached by the first, even
+  // though its literal is a different object
+  runAddLiteral(1);
+  ASSERT_EQ(0u, cache.getStats().hits);
+  ASSERT_EQ(1u, cache.getStats().misses);
+  runAddLiteral(1);
+  ASSERT_EQ(1u, cache.getStats().hits);
+  ASSERT_EQ(1u, cache.getStats().misses);
+
+  size_t numObjects = getCachedObjects(dirTemplate).size();
+  removeCache(dirTemplate);
+  simit::kCacheDir = oldCacheDir;
+
+  ASSERT_EQ(1u, numObjects);
+}
+
+TEST(Function, objectCacheKeyMaterial) {
+  if (simit::kBackend == "gpu") return;
+
+  char dirTemplate[] = "/tmp/simit-cache-XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(dirTemplate));
+  const std::string dir = dirTemplate;
+  std::string oldCacheDir = simit::kCacheDir;
+  simit::kCacheDir = dir;
+  LLVMObjectCache& cache = LLVMObjectCache::getInstance();
+  cache.resetStats();
+
+  // Change the key material stored with the object, as if a different module
+  // had the same key. The object must then not be loaded.
+  runAddLiteral(1);
+  std::vector<std::string> objects = getCachedObjects(dir);
+  ASSERT_EQ(1u, objects.size());
+  const std::string path = dir + "/" + objects[0];
+  std::string contents;
+  {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+  }
+  size_t materialStart = contents.find('\n') + 1;
+  ASSERT_LT(materialStart, contents.size());
+  contents[materialStart] ^= 1;
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+  }
+
+  runAddLiteral(1);
+  ASSERT_EQ(0u, cache.getStats().hits);
+  ASSERT_EQ(2u, cache.getStats().misses);
+
+  // The miss stored the object again, with the right key material
+  runAddLiteral(1);
+  ASSERT_EQ(1u, cache.getStats().hits);
+
+  removeCache(dir);
+  simit::kCacheDir = oldCacheDir;
+}
+
+TEST(Function, objectCacheEviction) {
+  if (simit::kBackend == "gpu") return;
+
+  char dirTemplate[] = "/tmp/simit-cache-XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(dirTemplate));
+  const std::string dir = dirTemplate;
+  std::string oldCacheDir = simit::kCacheDir;
+  size_t oldCacheMaxBytes = simit::kCacheMaxBytes;
+  simit::kCacheDir = dir;
+  LLVMObjectCache& cache = LLVMObjectCache::getInstance();
+  cache.resetStats();
+
+  // Cache two functions, and make the first the least recently used
+  runAddLiteral(1);
+  std::vector<std::string> objects = getCachedObjects(dir);
+  ASSERT_EQ(1u, objects.size());
+  const std::string first = objects[0];
+  runAddLiteral(2);
+  objects = getCachedObjects(dir);
+  ASSERT_EQ(2u, objects.size());
+  const std::string second = (objects[0] == first) ? objects[1] : objects[0];
+
+  struct utimbuf oldTime = {1000, 1000};
+  struct utimbuf newTime = {2000, 2000};
+  utime((dir + "/" + first).c_str(), &oldTime);
+  utime((dir + "/" + second).c_str(), &newTime);
+
+  // A third object of about the same size does not fit within a budget of two
+  // and a half, so the least recently used object is evicted
+  struct stat st;
+  size_t budget = 0;
+  for (const std::string& name : objects) {
+    ASSERT_EQ(0, stat((dir + "/" + name).c_str(), &st));
+    budget += st.st_size;
+  }
+  simit::kCacheMaxBytes = budget + budget/4;
+  runAddLiteral(3);
+  objects = getCachedObjects(dir);
+  ASSERT_EQ(1u, cache.getStats().evictions);
+  ASSERT_EQ(2u, objects.size());
+  ASSERT_FALSE(std::find(objects.begin(), objects.end(), first) !=
+               objects.end());
+  ASSERT_TRUE(std::find(objects.begin(), objects.end(), second) !=
+              objects.end());
+
+  // The evicted function is compiled again, the others are loaded
+  simit::kCacheMaxBytes = oldCacheMaxBytes;
+  cache.resetStats();
+  runAddLiteral(1);
+  runAddLiteral(2);
+  ASSERT_EQ(1u, cache.getStats().hits);
+  ASSERT_EQ(1u, cache.getStats().misses);
+
+  removeCache(dir);
+  simit::kCacheDir = oldCacheDir;
+  simit::kCacheMaxBytes = oldCacheMaxBytes;
+}
@@ -1,8 +1,18 @@
 #include "simit-test.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "coloring.h"
 #include "graph.h"
+#include "set_snapshot.h"
+
+#ifdef EIGEN
+#include "field_eigen.h"
+#endif
 
 using namespace std;
 using namespace simit;
@@ -61,6 +71,545 @@ TEST(Set, IncreaseCapacity) {
   ASSERT_EQ(count, 1029);
 }
 
+TEST(Set, Reserve) {
+  Set myset;
+  auto fld = myset.addField<int>("foo");
+  myset.reserve(5000);
+  void* data = myset.getFieldData("foo");
+
+  for (int i=0; i<5000; i++) {
+    ElementRef item = myset.add();
+    fld.set(item, i);
+  }
+
+  ASSERT_EQ(5000, myset.getSize());
+  ASSERT_EQ(data, myset.getFieldData("foo"));
+  for (int i=0; i<5000; i++) {
+    ASSERT_EQ(i, ((int*)data)[i]);
+  }
+}
+
+TEST(Set, AddMany) {
+  Set points;
+  auto x = points.addField<int>("x");
+  ElementRef p0 = points.add();
+  ElementRef p1 = points.addMany(3000);
+  ASSERT_EQ(1, p1.getIdent());
+  ASSERT_EQ(3001, points.getSize());
+  for (auto p : points) {
+    ASSERT_EQ(0, x.get(p));
+  }
+
+  vector<int> endpoints;
+  for (int i=1; i<=3000; i++) {
+    endpoints.push_back(i-1);
+    endpoints.push_back(i);
+  }
+  Set edges(points, points);
+  auto y = edges.addField<int>("y");
+  ElementRef e0 = edges.add(p0, p1);
+  ElementRef e1 = edges.addMany(3000, endpoints.data());
+  ASSERT_EQ(1, e1.getIdent());
+  ASSERT_EQ(3001, edges.getSize());
+
+  y.set(e1, 7);
+  ASSERT_EQ(7, y.get(e1));
+  ASSERT_EQ(0, y.get(e0));
+  for (auto e : edges) {
+    if (e == e0) continue;
+    ASSERT_EQ(e.getIdent()-1, edges.getEndpoint(e,0).getIdent());
+    ASSERT_EQ(e.getIdent(), edges.getEndpoint(e,1).getIdent());
+  }
+}
+
+TEST(Set, Adopt) {
+  const int n = 2000;
+  vector<simit_float> xs(n*3);
+  for (int i=0; i<n*3; i++) {
+    xs[i] = i;
+  }
+  vector<int> endpoints;
+  for (int i=1; i<n; i++) {
+    endpoints.push_back(i-1);
+    endpoints.push_back(i);
+  }
+
+  Set points;
+  points.adopt(n);
+  FieldRef<simit_float,3> x = points.adoptField<simit_float,3>("x", xs.data());
+  ASSERT_EQ(n, points.getSize());
+  ASSERT_EQ(xs.data(), points.getFieldData("x"));
+
+  Set edges(points, points);
+  FieldRef<int> w = edges.addField<int>("w");
+  edges.adopt(n-1, endpoints.data());
+  ASSERT_EQ(n-1, edges.getSize());
+  ASSERT_EQ(endpoints.data(), edges.getEndpointsData());
+
+  // Writes go to the adopted buffers
+  ElementRef e0 = *edges.begin();
+  ElementRef p1 = edges.getEndpoint(e0, 1);
+  x.set(p1, {-1.0, -2.0, -3.0});
+  SIMIT_ASSERT_FLOAT_EQ(-2.0, xs[4]);
+  w.set(e0, 1);
+  ASSERT_EQ(1, w.get(e0));
+
+  // Growing the sets copies the adopted buffers
+  ElementRef p = points.add();
+  ASSERT_EQ(n+1, points.getSize());
+  ASSERT_NE(xs.data(), points.getFieldData("x"));
+  TensorRef<simit_float,3> xp = x.get(p);
+  SIMIT_ASSERT_FLOAT_EQ(0.0, xp(0));
+  TensorRef<simit_float,3> x1 = x.get(p1);
+  SIMIT_ASSERT_FLOAT_EQ(-3.0, x1(2));
+
+  edges.add(p1, p);
+  ASSERT_EQ(n, edges.getSize());
+  ASSERT_NE(endpoints.data(), edges.getEndpointsData());
+  ASSERT_EQ(n-1, edges.getEndpointsData()[(n-2)*2+1]);
+  ASSERT_EQ(n, edges.getEndpointsData()[(n-1)*2+1]);
+  ASSERT_EQ(1, w.get(e0));
+}
+
+TEST(Set, FieldLayouts) {
+  Set myset;
+  auto aos = myset.addField<int,2>("aos");
+  auto soa = myset.addField<int,2>("soa", FieldLayout::soa());
+  auto aosoa = myset.addField<int,2>("aosoa", FieldLayout::aosoa(4));
+  ASSERT_EQ(FieldLayout::aosoa(4), aosoa.getLayout());
+
+  vector<ElementRef> elems;
+  for (int i=0; i<6; i++) {
+    ElementRef elem = myset.add();
+    aos.set(elem, {i, -i});
+    soa.set(elem, {i, -i});
+    aosoa(elem) = {i, -i};
+    elems.push_back(elem);
+  }
+
+  // Growing and shrinking the set keeps the tensors
+  myset.reserve(3000);
+  myset.shrinkToFit();
+  ASSERT_EQ(6, myset.getCapacity());
+
+  int* soaData = (int*)myset.getFieldData("soa");
+  int* aosoaData = (int*)myset.getFieldData("aosoa");
+  for (int i=0; i<6; i++) {
+    ASSERT_EQ(i, aos(elems[i])(0));
+    ASSERT_EQ(-i, aos(elems[i])(1));
+    ASSERT_EQ(i, soa(elems[i])(0));
+    ASSERT_EQ(-i, soa(elems[i])(1));
+    ASSERT_EQ(i, aosoa(elems[i])(0));
+    ASSERT_EQ(-i, aosoa(elems[i])(1));
+
+    ASSERT_EQ(i, soaData[i]);
+    ASSERT_EQ(-i, soaData[6+i]);
+    ASSERT_EQ(i, aosoaData[i/4*8 + i%4]);
+    ASSERT_EQ(-i, aosoaData[i/4*8 + 4 + i%4]);
+  }
+}
+
+TEST(Set, FieldViews) {
+  Set myset;
+  auto aos = myset.addField<int,2>("aos");
+  auto soa = myset.addField<int,2>("soa", FieldLayout::soa());
+  auto aosoa = myset.addField<int,2>("aosoa", FieldLayout::aosoa(4));
+  auto scalar = myset.addField<int>("scalar", FieldLayout::soa());
+
+  // Views taken before the set grows stay valid and follow its size
+  FieldView<int,2> aosView = aos.view();
+  FieldView<int,2> soaView = soa.view();
+  FieldView<int,2> aosoaView = aosoa.view();
+  FieldView<int> scalarView = scalar.view();
+  ASSERT_EQ(0, aosView.getExtent());
+  myset.addMany(6);
+  ASSERT_EQ(6, soaView.getExtent());
+  ASSERT_EQ(2u, soaView.getBlockSize());
+
+  ASSERT_TRUE(aosView.isContiguous());
+  ASSERT_EQ(2u, aosView.getElementStride());
+  ASSERT_EQ(1u, aosView.getComponentStride());
+  ASSERT_FALSE(soaView.isContiguous());
+  ASSERT_EQ(1u, soaView.getElementStride());
+  ASSERT_EQ((size_t)myset.getCapacity(), soaView.getComponentStride());
+  ASSERT_FALSE(aosoaView.isContiguous());
+  ASSERT_TRUE(scalarView.isContiguous());
+
+  vector<int> values;
+  for (int i=0; i<6; i++) {
+    values.push_back(i);
+    values.push_back(-i);
+  }
+  aosView.copyFrom(values.data());
+  soaView.copyFrom(values.data());
+  aosoaView.copyFrom(values.data());
+  scalarView.copyFrom(values.data());
+
+  int i = 0;
+  for (ElementRef elem : myset) {
+    ASSERT_EQ(i, aos(elem)(0));
+    ASSERT_EQ(-i, aos(elem)(1));
+    ASSERT_EQ(i, soa(elem)(0));
+    ASSERT_EQ(-i, soa(elem)(1));
+    ASSERT_EQ(i, aosoa(elem)(0));
+    ASSERT_EQ(-i, aosoa(elem)(1));
+    ASSERT_EQ(values[i], (int)scalar(elem));
+    ASSERT_EQ(soaView.getPointer() + i, &soa(elem)(0));
+    i++;
+  }
+
+  myset.reserve(3000);
+  ASSERT_EQ((int*)soa.getData(), soaView.getPointer());
+  ASSERT_EQ(3000u, soaView.getComponentStride());
+  for (FieldView<int,2>* view : {&aosView, &soaView, &aosoaView}) {
+    vector<int> copy(12);
+    view->copyTo(copy.data());
+    ASSERT_EQ(values, copy);
+  }
+}
+
+#ifdef EIGEN
+TEST(Set, FieldEigenMaps) {
+  Set myset;
+  auto aos = myset.addField<double,3>("aos");
+  auto soa = myset.addField<double,3>("soa", FieldLayout::soa());
+  auto scalar = myset.addField<double>("scalar");
+  myset.addMany(4);
+  myset.reserve(10);
+
+  FieldView<double,3> aosView = aos.view();
+  FieldView<double,3> soaView = soa.view();
+  FieldView<double> scalarView = scalar.view();
+  FieldMap<double,3> aosMap = eigenMap(aosView);
+  FieldMap<double,3> soaMap = eigenMap(soaView);
+  FieldMap<double> scalarMap = eigenMap(scalarView);
+  ASSERT_EQ(4, soaMap.rows());
+  ASSERT_EQ(3, soaMap.cols());
+
+  Eigen::Matrix<double,4,3> values;
+  values << 1, 2, 3,  4, 5, 6,  7, 8, 9,  10, 11, 12;
+  aosMap = values;
+  soaMap = values;
+  scalarMap = values.col(1);
+
+  int i = 0;
+  for (ElementRef elem : myset) {
+    for (int j=0; j<3; j++) {
+      ASSERT_EQ(values(i,j), aos(elem)(j));
+      ASSERT_EQ(values(i,j), soa(elem)(j));
+    }
+    ASSERT_EQ(values(i,1), (double)scalar(elem));
+    i++;
+  }
+
+  const FieldView<double,3>& constView = soaView;
+  ASSERT_EQ(values.colwise().sum(), eigenMap(constView).colwise().sum());
+}
+#endif
+
+TEST(Set, Snapshot) {
+  Set points;
+  Set grid(points, {3,2});
+  FieldRef<double> p = points.addField<double>("p");
+  for (ElementRef point : points) {
+    p(point) = point.getIdent() * 0.5;
+  }
+
+  Set verts;
+  Set edges(verts,verts);
+  FieldRef<double,3> x = verts.addField<double,3>("x");
+  FieldRef<double,3> v = verts.addField<double,3>("v", FieldLayout::soa());
+  FieldRef<int,2> d = edges.addField<int,2>("d", FieldLayout::aosoa(4));
+  vector<ElementRef> vertRefs;
+  for (int i=0; i<6; i++) {
+    ElementRef vert = verts.add();
+    x.set(vert, {(double)i, 2.0*i, 3.0*i});
+    v.set(vert, {-1.0*i, -2.0*i, -3.0*i});
+    vertRefs.push_back(vert);
+  }
+  for (int i=0; i<5; i++) {
+    d(edges.add(vertRefs[i], vertRefs[i+1])) = {i, i*i};
+  }
+
+  char path[] = "/tmp/simit-snapshot-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  writeSnapshot(path, {{"points",&points}, {"grid",&grid},
+                       {"verts",&verts}, {"edges",&edges}});
+
+  {
+    SetSnapshot snapshot(path);
+    ASSERT_EQ(vector<string>({"edges","grid","points","verts"}),
+              snapshot.getSetNames());
+
+    Set* sgrid = snapshot.getSet("grid");
+    Set* spoints = snapshot.getSet("points");
+    ASSERT_EQ(Set::Grid, sgrid->getKind());
+    ASSERT_EQ(vector<int>({3,2}), sgrid->getDimensions());
+    ASSERT_EQ(spoints, sgrid->getEndpointSet(0));
+    ASSERT_EQ(grid.getSize(), sgrid->getSize());
+    for (ElementRef edge : grid) {
+      ASSERT_EQ(grid.getEndpoint(edge, 1), sgrid->getEndpoint(edge, 1));
+    }
+    ASSERT_EQ(sgrid->getGridEdge({2,1},0), grid.getGridEdge({2,1},0));
+    FieldRef<double> sp = spoints->getField<double>("p");
+    for (ElementRef point : points) {
+      ASSERT_EQ((double)p(point), (double)sp(point));
+    }
+
+    Set* sverts = snapshot.getSet("verts");
+    Set* sedges = snapshot.getSet("edges");
+    ASSERT_EQ(FieldLayout::soa(), sverts->getFieldLayout("v"));
+    ASSERT_EQ(sverts, sedges->getEndpointSet(1));
+    FieldRef<double,3> sx = sverts->getField<double,3>("x");
+    FieldRef<double,3> sv = sverts->getField<double,3>("v");
+    FieldRef<int,2> sd = sedges->getField<int,2>("d");
+    for (ElementRef vert : verts) {
+      for (int i=0; i<3; i++) {
+        ASSERT_EQ(x(vert)(i), sx(vert)(i));
+        ASSERT_EQ(v(vert)(i), sv(vert)(i));
+      }
+    }
+    for (ElementRef edge : edges) {
+      ASSERT_EQ(d(edge)(0), sd(edge)(0));
+      ASSERT_EQ(d(edge)(1), sd(edge)(1));
+      ASSERT_EQ(edges.getEndpoint(edge,0), sedges->getEndpoint(edge,0));
+    }
+
+    // Snapshot sets copy their data out of the mapping when they grow
+    ElementRef vert = sverts->add();
+    sx.set(vert, {1.0, 2.0, 3.0});
+    ASSERT_EQ(3.0, sx(vert)(2));
+    ASSERT_EQ(15.0, sx(vertRefs[5])(2));
+    ASSERT_EQ(-15.0, sv(vertRefs[5])(2));
+  }
+  remove(path);
+}
+
+TEST(Set, TruncatedSnapshot) {
+  Set verts;
+  Set edges(verts,verts);
+  FieldRef<double> x = verts.addField<double>("x");
+  ElementRef v0 = verts.add();
+  ElementRef v1 = verts.add();
+  x(v1) = 1.0;
+  edges.add(v0, v1);
+
+  char path[] = "/tmp/simit-snapshot-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  writeSnapshot(path, {{"verts",&verts}, {"edges",&edges}});
+
+  // The last field, which is padded to 64 bytes, is cut off, so opening the
+  // snapshot fails after the sets have been created, which releases them and
+  // the mapping
+  struct stat status;
+  ASSERT_EQ(0, stat(path, &status));
+  ASSERT_EQ(0, truncate(path, status.st_size - 60));
+  ASSERT_THROW(SetSnapshot snapshot(path), SimitException);
+  remove(path);
+}
+
+TEST(Set, CorruptSnapshotSetCount) {
+  Set verts;
+  verts.add();
+
+  char path[] = "/tmp/simit-snapshot-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  writeSnapshot(path, {{"verts",&verts}});
+
+  // A set count that cannot fit in the description is rejected before memory
+  // is allocated for the sets. The count follows the 8-byte magic, the
+  // version and the byte order.
+  uint64_t numSets = (uint64_t)1 << 62;
+  FILE* file = fopen(path, "r+b");
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(0, fseek(file, 16, SEEK_SET));
+  ASSERT_EQ(1u, fwrite(&numSets, sizeof(numSets), 1, file));
+  fclose(file);
+  ASSERT_THROW(SetSnapshot snapshot(path), SimitException);
+  remove(path);
+}
+
+TEST(Set, ImplicitGrid) {
+  Set points;
+  Set grid(points, {3,2});
+  Set ipoints;
+  Set igrid(ipoints, {3,2}, Set::Implicit);
+  ASSERT_FALSE(grid.hasImplicitEdges());
+  ASSERT_TRUE(igrid.hasImplicitEdges());
+  ASSERT_EQ(nullptr, igrid.getEndpointsData());
+  ASSERT_EQ(6, ipoints.getSize());
+  ASSERT_EQ(grid.getSize(), igrid.getSize());
+
+  for (ElementRef edge : grid) {
+    ASSERT_EQ(grid.getEndpoint(edge,0), igrid.getEndpoint(edge,0));
+    ASSERT_EQ(grid.getEndpoint(edge,1), igrid.getEndpoint(edge,1));
+    vector<ElementRef> endpoints;
+    for (ElementRef endpoint : igrid.getEndpoints(edge)) {
+      endpoints.push_back(endpoint);
+    }
+    ASSERT_EQ(vector<ElementRef>({grid.getEndpoint(edge,0),
+                                  grid.getEndpoint(edge,1)}), endpoints);
+  }
+
+  // Edges link each point to the next point in their direction, periodically
+  ElementRef edge = igrid.getGridEdge({1,0},1);
+  ASSERT_EQ(igrid.getGridPoint({1,0}), igrid.getEndpoint(edge,0));
+  ASSERT_EQ(igrid.getGridPoint({1,1}), igrid.getEndpoint(edge,1));
+  edge = igrid.getGridEdge({2,1},0);
+  ASSERT_EQ(igrid.getGridPoint({2,1}), igrid.getEndpoint(edge,0));
+  ASSERT_EQ(igrid.getGridPoint({0,1}), igrid.getEndpoint(edge,1));
+  edge = igrid.getGridEdge({1,1},1);
+  ASSERT_EQ(igrid.getGridPoint({1,0}), igrid.getEndpoint(edge,1));
+
+  FieldRef<double> w = igrid.addField<double>("w");
+  w(edge) = 2.0;
+  ASSERT_EQ(2.0, (double)w(edge));
+  ASSERT_EQ(grid.getColoring().getNumColors(),
+            igrid.getColoring().getNumColors());
+
+  char path[] = "/tmp/simit-snapshot-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  writeSnapshot(path, {{"points",&ipoints}, {"grid",&igrid}});
+  {
+    SetSnapshot snapshot(path);
+    Set* sgrid = snapshot.getSet("grid");
+    ASSERT_TRUE(sgrid->hasImplicitEdges());
+    ASSERT_EQ(igrid.getSize(), sgrid->getSize());
+    for (ElementRef edge : igrid) {
+      ASSERT_EQ(igrid.getEndpoint(edge,1), sgrid->getEndpoint(edge,1));
+    }
+    ASSERT_EQ(2.0, (double)sgrid->getField<double>("w")(edge));
+  }
+  remove(path);
+}
+
+TEST(Set, Remove) {
+  Set verts;
+  Set edges(verts,verts);
+  FieldRef<int,2> x = verts.addField<int,2>("x");
+  FieldRef<int,2> y = edges.addField<int,2>("y", FieldLayout::soa());
+  vector<ElementRef> vertRefs;
+  for (int i=0; i<4; i++) {
+    ElementRef vert = verts.add();
+    x(vert) = {i, 10*i};
+    vertRefs.push_back(vert);
+  }
+  vector<ElementRef> edgeRefs;
+  for (int i=0; i<3; i++) {
+    ElementRef edge = edges.add(vertRefs[i], vertRefs[i+1]);
+    y(edge) = {i, -i};
+    edgeRefs.push_back(edge);
+  }
+
+  // The last element moves into the removed element's place
+  verts.remove(vertRefs[1]);
+  ASSERT_EQ(3, verts.getSize());
+  ASSERT_EQ(3, x(vertRefs[1])(0));
+  ASSERT_EQ(30, x(vertRefs[1])(1));
+
+  edges.remove(edgeRefs[0]);
+  ASSERT_EQ(2, edges.getSize());
+  ASSERT_EQ(2, y(edgeRefs[0])(0));
+  ASSERT_EQ(-2, y(edgeRefs[0])(1));
+  ASSERT_EQ(vertRefs[2], edges.getEndpoint(edgeRefs[0], 0));
+  ASSERT_EQ(vertRefs[3], edges.getEndpoint(edgeRefs[0], 1));
+}
+
+TEST(Set, Compact) {
+  Set verts;
+  Set edges(verts,verts);
+  FieldRef<double,3> x = verts.addField<double,3>("x", FieldLayout::aosoa(4));
+  FieldRef<int> w = verts.addField<int>("w");
+  FieldRef<int,2> y = edges.addField<int,2>("y");
+  vector<ElementRef> vertRefs;
+  for (int i=0; i<10; i++) {
+    ElementRef vert = verts.add();
+    x(vert) = {(double)i, 2.0*i, 3.0*i};
+    w(vert) = i;
+    vertRefs.push_back(vert);
+  }
+  vector<ElementRef> edgeRefs;
+  for (int i=0; i<9; i++) {
+    ElementRef edge = edges.add(vertRefs[i], vertRefs[i+1]);
+    y(edge) = {i, i+1};
+    edgeRefs.push_back(edge);
+  }
+
+  // Edges that refer to removed vertices must be removed first
+  verts.markRemoved(vertRefs[0]);
+  verts.markRemoved(vertRefs[4]);
+  verts.markRemoved(vertRefs[5]);
+  ASSERT_TRUE(verts.isMarkedRemoved(vertRefs[4]));
+  ASSERT_FALSE(verts.isMarkedRemoved(vertRefs[6]));
+  ASSERT_THROW(verts.compact({&edges}), SimitException);
+  ASSERT_EQ(10, verts.getSize());
+
+  for (int i : {0, 3, 4, 5}) {
+    edges.markRemoved(edgeRefs[i]);
+  }
+  vector<int> edgeRemap = edges.compact();
+  ASSERT_EQ(vector<int>({-1,0,1,-1,-1,-1,2,3,4}), edgeRemap);
+  ASSERT_EQ(5, edges.getSize());
+
+  vector<int> vertRemap = verts.compact({&edges});
+  ASSERT_EQ(vector<int>({-1,0,1,2,-1,-1,3,4,5,6}), vertRemap);
+  ASSERT_EQ(7, verts.getSize());
+  ASSERT_FALSE(verts.isMarkedRemoved(vertRefs[4]));
+
+  for (int i=0; i<10; i++) {
+    if (vertRemap[i] < 0) {
+      continue;
+    }
+    ElementRef vert = vertRefs[vertRemap[i]];
+    ASSERT_EQ((double)i, x(vert)(0));
+    ASSERT_EQ(3.0*i, x(vert)(2));
+    ASSERT_EQ(i, (int)w(vert));
+  }
+  for (int i=0; i<9; i++) {
+    if (edgeRemap[i] < 0) {
+      continue;
+    }
+    ElementRef edge = edgeRefs[edgeRemap[i]];
+    ASSERT_EQ(i, y(edge)(0));
+    ASSERT_EQ(vertRefs[vertRemap[i]], edges.getEndpoint(edge, 0));
+    ASSERT_EQ(vertRefs[vertRemap[i+1]], edges.getEndpoint(edge, 1));
+  }
+}
+
+TEST(Set, TopologyVersion) {
+  Set verts;
+  Set edges(verts,verts);
+  Set other(verts,verts);
+  ASSERT_NE(edges.getTopologyVersion(), other.getTopologyVersion());
+  vector<ElementRef> vertRefs;
+  for (int i=0; i<4; i++) {
+    vertRefs.push_back(verts.add());
+  }
+
+  // Appends keep the version
+  unsigned long version = edges.getTopologyVersion();
+  ElementRef edge = edges.add(vertRefs[0], vertRefs[1]);
+  edges.add(vertRefs[1], vertRefs[2]);
+  ASSERT_EQ(version, edges.getTopologyVersion());
+
+  // Other changes take a version no set has had
+  edges.remove(edge);
+  ASSERT_NE(version, edges.getTopologyVersion());
+  ASSERT_NE(other.getTopologyVersion(), edges.getTopologyVersion());
+  version = edges.getTopologyVersion();
+  verts.markRemoved(vertRefs[0]);
+  verts.compact({&edges});
+  ASSERT_NE(version, edges.getTopologyVersion());
+}
+
 TEST(Set, FieldAccessByName) {
   Set myset;
   
@@ -0,0 +1,101 @@
+#include "simit-test.h"
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ffi.h"
+#include "util/memory_arena.h"
+#include "util/thread_pool.h"
+
+using namespace std;
+using simit::util::MemoryArena;
+using simit::util::ThreadPool;
+
+TEST(MemoryArena, ReusesReleasedBlocks) {
+  MemoryArena arena;
+  void* a = arena.allocate(1024);
+  void* b = arena.allocate(512);
+  ASSERT_EQ(1536u, arena.getCurrentUsage());
+
+  ASSERT_TRUE(arena.release(a));
+  ASSERT_EQ(512u, arena.getCurrentUsage());
+  ASSERT_EQ(1024u, arena.getPooledBytes());
+
+  // Only a request of the same size reuses the block
+  void* c = arena.allocate(2048);
+  ASSERT_NE(a, c);
+  void* d = arena.allocate(1024);
+  ASSERT_EQ(a, d);
+  ASSERT_EQ(1u, arena.getNumReused());
+  ASSERT_EQ(0u, arena.getPooledBytes());
+  ASSERT_EQ(3584u, arena.getPeakUsage());
+
+  arena.release(b);
+  arena.release(c);
+  arena.release(d);
+  ASSERT_EQ(0u, arena.getCurrentUsage());
+  ASSERT_EQ(3584u, arena.getPeakUsage());
+}
+
+TEST(MemoryArena, ForeignBlocksAreNotReleased) {
+  MemoryArena arena;
+  void* ptr = malloc(64);
+  ASSERT_FALSE(arena.release(ptr));
+  ASSERT_EQ(0u, arena.getPooledBytes());
+  free(ptr);
+}
+
+TEST(MemoryArena, ActiveArenaServesRuntimeAllocations) {
+  MemoryArena arena;
+  ASSERT_EQ(nullptr, MemoryArena::getActive());
+  {
+    MemoryArena::Activation activation(&arena);
+    ASSERT_EQ(&arena, MemoryArena::getActive());
+    void* ptr = simit::ffi::simit_malloc(256);
+    ASSERT_EQ(256u, arena.getCurrentUsage());
+    simit::ffi::simit_free(ptr);
+    ASSERT_EQ(0u, arena.getCurrentUsage());
+    ASSERT_EQ(ptr, simit::ffi::simit_malloc(256));
+    simit::ffi::simit_free(ptr);
+  }
+  ASSERT_EQ(nullptr, MemoryArena::getActive());
+}
+
+TEST(MemoryArena, TrimUnusedFreesSizesThatStopRecurring) {
+  MemoryArena arena;
+  arena.release(arena.allocate(1024));
+  arena.release(arena.allocate(512));
+  arena.trimUnused();
+  ASSERT_EQ(1536u, arena.getPooledBytes());
+
+  // Only the 1024 byte block is asked for again before the next trim
+  arena.release(arena.allocate(1024));
+  arena.trimUnused();
+  ASSERT_EQ(1024u, arena.getPooledBytes());
+  arena.trimUnused();
+  ASSERT_EQ(0u, arena.getPooledBytes());
+}
+
+TEST(MemoryArena, ActivationIsPerThread) {
+  MemoryArena arena;
+  MemoryArena::Activation activation(&arena);
+  MemoryArena* otherActive = &arena;
+  std::thread other([&otherActive]() {
+    otherActive = MemoryArena::getActive();
+  });
+  other.join();
+  ASSERT_EQ(nullptr, otherActive);
+
+  // Loop bodies run on pool workers with the arena of the calling thread
+  ThreadPool pool(4);
+  std::vector<MemoryArena*> bodyActive(64, nullptr);
+  pool.parallelFor(64, 1, [&bodyActive](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      bodyActive[i] = MemoryArena::getActive();
+    }
+  });
+  for (MemoryArena* active : bodyActive) {
+    ASSERT_EQ(&arena, active);
+  }
+}
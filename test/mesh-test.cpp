@@ -8,6 +8,7 @@
 #include <dirent.h>
 
 #include "mesh.h"
+#include "flat_mesh.h"
 
 using namespace std;
 using namespace simit;
@@ -309,3 +310,90 @@ const string inputEdge = R"(24  1
   
 }
 
+
+TEST(FlatMesh, TetgenMatchesMeshVol) {
+  for (const string& mesh : {string(APPS_DIR) + "/data/tet-bunny/bunny.1",
+                             string(APPS_DIR) + "/data/tet-dragon/dragon40k"}) {
+    MeshVol m;
+    ASSERT_EQ(0, m.loadTet(mesh + ".node", mesh + ".ele"));
+    FlatMesh flat;
+    ASSERT_EQ(0, flat.loadTet(mesh + ".node", mesh + ".ele"));
+
+    ASSERT_EQ(m.v.size(), (size_t)flat.numVertices);
+    ASSERT_EQ(m.e.size(), (size_t)flat.numElements);
+    ASSERT_EQ(4, flat.verticesPerElement);
+    for (size_t i=0; i < m.v.size(); ++i) {
+      for (int j=0; j < 3; ++j) {
+        ASSERT_EQ(m.v[i][j], flat.vertices[i*3+j]);
+      }
+    }
+    for (size_t i=0; i < m.e.size(); ++i) {
+      for (int j=0; j < 4; ++j) {
+        ASSERT_EQ(m.e[i][j], flat.elements[i*4+j]);
+      }
+    }
+  }
+
+  const string bunny = string(APPS_DIR) + "/data/tet-bunny/bunny.1";
+  MeshVol m;
+  m.loadTet(bunny + ".node", bunny + ".ele");
+  m.loadTetEdge(bunny + ".edge");
+  FlatMesh flat;
+  flat.loadTet(bunny + ".node", bunny + ".ele");
+  ASSERT_EQ(0, flat.loadTetEdge(bunny + ".edge"));
+  ASSERT_EQ(m.edges.size(), (size_t)flat.numEdges);
+  for (size_t i=0; i < m.edges.size(); ++i) {
+    ASSERT_EQ(m.edges[i][0], flat.edges[i*2]);
+    ASSERT_EQ(m.edges[i][1], flat.edges[i*2+1]);
+  }
+}
+
+TEST(FlatMesh, TetgenOneBased) {
+  const string node = R"(# Nodes numbered from one
+3  3  0  0
+1  0.5  1e-3  -2.5E+2
+2  1    2     3
+
+# A comment between records
+3  -0.125  .5  7.
+)";
+  const string ele = R"(1  3  0
+1  3  1  2
+)";
+  FlatMesh flat;
+  ASSERT_EQ(0, flat.loadTet(node.data(), node.size(), ele.data(), ele.size()));
+  ASSERT_EQ(3, flat.numVertices);
+  ASSERT_EQ(vector<double>({0.5, 1e-3, -2.5e2, 1, 2, 3, -0.125, 0.5, 7}),
+            flat.vertices);
+  ASSERT_EQ(vector<int>({2, 0, 1}), flat.elements);
+
+  const string badEle = "1 3 0\n1 3 1 4\n";
+  ASSERT_EQ(-1, flat.loadTet(node.data(), node.size(),
+                             badEle.data(), badEle.size()));
+  const string shortEle = "2 3 0\n1 3 1 2\n";
+  ASSERT_EQ(-1, flat.loadTet(node.data(), node.size(),
+                             shortEle.data(), shortEle.size()));
+}
+
+TEST(FlatMesh, Obj) {
+  const string obj = R"(# Texture coordinates, normals and polygons
+v 0 0 0
+v 1 0 0
+v 1 1 0
+v 0 1 0
+vt 0.5 0.5
+vn 0 0 1
+f 1/1/1 2/1/1 3/1/1 4/1/1
+v 0 0 1
+f -1//1 1//1 2//1
+f 1 2
+)";
+  FlatMesh flat;
+  ASSERT_EQ(0, flat.loadObj(obj.data(), obj.size()));
+  ASSERT_EQ(5, flat.numVertices);
+  ASSERT_EQ(3, flat.numElements);
+  ASSERT_EQ(3, flat.verticesPerElement);
+  ASSERT_EQ(1.0, flat.vertices[3*2+1]);
+  ASSERT_EQ(1.0, flat.vertices[3*4+2]);
+  ASSERT_EQ(vector<int>({0,1,2, 0,2,3, 4,0,1}), flat.elements);
+}
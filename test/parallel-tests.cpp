@@ -0,0 +1,718 @@
+#include "simit-test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "coloring.h"
+#include "environment.h"
+#include "frontend/frontend.h"
+#include "graph.h"
+#include "ir.h"
+#include "ir_visitor.h"
+#include "lower/fuse_loops.h"
+#include "lower/lower.h"
+#include "parallel_loops.h"
+#include "program_context.h"
+#include "util/thread_pool.h"
+
+using namespace std;
+using namespace simit::ir;
+using simit::util::ThreadPool;
+
+TEST(ThreadPool, CoversRange) {
+  ThreadPool pool(4);
+  ASSERT_EQ(4u, pool.getNumThreads());
+
+  vector<atomic<int>> visits(1001);
+  for (auto& visit : visits) {
+    visit = 0;
+  }
+  pool.parallelFor(visits.size(), [&visits](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      visits[i]++;
+    }
+  });
+  for (auto& visit : visits) {
+    ASSERT_EQ(1, visit);
+  }
+}
+
+TEST(ThreadPool, NestedLoopsRunSerially) {
+  ThreadPool pool(4);
+  atomic<int> count(0);
+  pool.parallelFor(8, [&pool,&count](int begin, int end) {
+    ASSERT_TRUE(ThreadPool::inParallelRegion());
+    for (int i = begin; i < end; ++i) {
+      pool.parallelFor(10, [&count](int begin, int end) {
+        count += end - begin;
+      });
+    }
+  });
+  ASSERT_FALSE(ThreadPool::inParallelRegion());
+  ASSERT_EQ(80, count);
+}
+
+TEST(ThreadPool, DynamicChunks) {
+  ThreadPool pool(4);
+  vector<atomic<int>> visits(1001);
+  for (auto& visit : visits) {
+    visit = 0;
+  }
+  atomic<int> chunks(0);
+  pool.parallelFor(visits.size(), 10, [&visits,&chunks](int begin, int end) {
+    ASSERT_LE(end - begin, 10);
+    chunks++;
+    for (int i = begin; i < end; ++i) {
+      visits[i]++;
+    }
+  });
+  ASSERT_EQ(101, chunks);
+  for (auto& visit : visits) {
+    ASSERT_EQ(1, visit);
+  }
+}
+
+TEST(ThreadPool, ParallelForEach) {
+  simit::Set points;
+  simit::Set springs(points,points);
+  simit::createBox(&points, &springs, 10, 10, 10);
+  auto degree = points.addField<int>("degree");
+  vector<atomic<int>> degrees(points.getSize());
+  for (auto& d : degrees) {
+    d = 0;
+  }
+
+  for (simit::Schedule schedule : {simit::Schedule::Static,
+                                   simit::Schedule::Dynamic}) {
+    simit::parallelForEach(points, [&degree](const simit::Set::ElementRange& r) {
+      ASSERT_EQ(nullptr, r.getEndpointsData());
+      for (simit::ElementRef point : r) {
+        degree(point) = 0;
+      }
+    }, schedule);
+
+    simit::parallelForEach(springs, [&](const simit::Set::ElementRange& r) {
+      const int* endpoints = r.getEndpointsData();
+      for (simit::ElementRef spring : r) {
+        ASSERT_EQ(springs.getEndpoint(spring, 0).getIdent(), endpoints[0]);
+        ASSERT_EQ(springs.getEndpoint(spring, 1).getIdent(), endpoints[1]);
+        degrees[endpoints[0]]++;
+        degrees[endpoints[1]]++;
+        endpoints += 2;
+      }
+    }, schedule, 7);
+  }
+
+  for (simit::ElementRef point : points) {
+    ASSERT_EQ(0, degree(point));
+  }
+  vector<int> expected(points.getSize(), 0);
+  for (simit::ElementRef spring : springs) {
+    for (simit::ElementRef point : springs.getEndpoints(spring)) {
+      expected[point.getIdent()] += 2;
+    }
+  }
+  for (int i = 0; i < points.getSize(); ++i) {
+    ASSERT_EQ(expected[i], degrees[i]);
+  }
+}
+
+static const Type VType = UnstructuredSetType::make(
+    ElementType::make("Vertex", {Field("x", Float)}), {});
+
+// For::make wraps the loop in a scope
+static const For* getLoop(Stmt loop) {
+  return to<For>(to<Scope>(loop)->scopedStmt);
+}
+
+TEST(LoopParallelism, Independent) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr x = FieldRead::make(V, "x");
+  Stmt body = ForRange::make(j, 0, 3, Store::make(x, i*3 + j,
+                                                  Load::make(x, i*3 + j)*2.0));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  ASSERT_EQ(LoopParallelism::Independent,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, OverlappingWritesAreSerial) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr x = FieldRead::make(V, "x");
+  Stmt body = ForRange::make(j, 0, 4, Store::make(x, i*3 + j, 1.0));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  ASSERT_EQ(LoopParallelism::Serial,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, NeighborReadsAreSerial) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Expr x = FieldRead::make(V, "x");
+  Stmt body = Store::make(x, i, Load::make(x, i+1));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  ASSERT_EQ(LoopParallelism::Serial,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, ScatterIsColored) {
+  Var V("V", VType);
+  Type EType = UnstructuredSetType::make(ElementType::make("Edge", {}), {V,V});
+  Var E("E", EType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Var eps("eps", TensorType::make(ScalarType::Int, {IndexDomain(2)}));
+  Expr endpoints = IndexRead::make(E, IndexRead::Endpoints);
+  Stmt body = Block::make({
+    VarDecl::make(eps),
+    ForRange::make(j, 0, 2, Store::make(eps, j, Load::make(endpoints, i*2+j))),
+    ForRange::make(j, 0, 2, Store::make(FieldRead::make(V, "x"),
+                                        Load::make(eps, j), 1.0,
+                                        CompoundOperator::Add))
+  });
+  Stmt loop = For::make(i, ForDomain(IndexSet(E)), body);
+  ASSERT_EQ(LoopParallelism::Colored,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, NeighborScatterIsSerial) {
+  Var V("V", VType);
+  Type EType = UnstructuredSetType::make(ElementType::make("Edge", {}), {V,V});
+  Var E("E", EType);
+  Var i("i", Int);
+  Expr endpoint = Load::make(IndexRead::make(E, IndexRead::Endpoints),
+                             (i+1)*2);
+  Stmt body = Store::make(FieldRead::make(V, "x"), endpoint, 1.0,
+                          CompoundOperator::Add);
+  Stmt loop = For::make(i, ForDomain(IndexSet(E)), body);
+  ASSERT_EQ(LoopParallelism::Serial,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, SharedAssignmentIsSerial) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Var last("last", Float);
+  Stmt body = AssignStmt::make(last, Load::make(FieldRead::make(V, "x"), i));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  ASSERT_EQ(LoopParallelism::Serial,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+TEST(LoopParallelism, ReductionIsIndependent) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Var sum("sum", Float);
+  Var max("max", Float);
+  Expr x = Load::make(FieldRead::make(V, "x"), i);
+  Stmt body = Block::make(AssignStmt::make(sum, x, CompoundOperator::Add),
+                          AssignStmt::make(max, x, CompoundOperator::Max));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  LoopParallelism parallelism = getLoopParallelism(getLoop(loop));
+  ASSERT_EQ(LoopParallelism::Independent, parallelism.getKind());
+  ASSERT_EQ(2u, parallelism.getReductionVars().size());
+  ASSERT_EQ(ReductionOperator::Sum,
+            parallelism.getReductionVars().at(sum).getKind());
+  ASSERT_EQ(ReductionOperator::Max,
+            parallelism.getReductionVars().at(max).getKind());
+}
+
+TEST(LoopParallelism, ReadReductionIsSerial) {
+  Var V("V", VType);
+  Var i("i", Int);
+  Var max("max", Float);
+  Expr x = FieldRead::make(V, "x");
+  Stmt body = Block::make(AssignStmt::make(max, Load::make(x, i),
+                                           CompoundOperator::Max),
+                          Store::make(x, i, max));
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+  ASSERT_EQ(LoopParallelism::Serial,
+            getLoopParallelism(getLoop(loop)).getKind());
+}
+
+static const Type VVType = UnstructuredSetType::make(
+    ElementType::make("Vertex", {Field("x", Float), Field("v", Float),
+                                 Field("f", Float)}), {});
+
+TEST(FuseLoops, Integrate) {
+  Var V("V", VVType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Var k("k", Int);
+  Expr x = FieldRead::make(V, "x");
+  Expr v = FieldRead::make(V, "v");
+  Expr f = FieldRead::make(V, "f");
+  Var tmp("tmp", Float);
+  Stmt body = Block::make({
+    For::make(i, ForDomain(IndexSet(V)), Store::make(f, i, Load::make(x, i))),
+    VarDecl::make(tmp),
+    For::make(j, ForDomain(IndexSet(V)),
+              Store::make(v, j, Load::make(f, j), CompoundOperator::Add)),
+    For::make(k, ForDomain(IndexSet(V)),
+              Store::make(x, k, Load::make(v, k), CompoundOperator::Add))
+  });
+  Func func("integrate", {V}, {}, body);
+
+  int numFused = 0;
+  func = fuseLoops(func, &numFused);
+  ASSERT_EQ(2, numFused);
+  ASSERT_TRUE(isa<Block>(func.getBody()));
+  ASSERT_TRUE(isa<VarDecl>(to<Block>(func.getBody())->first));
+}
+
+TEST(FuseLoops, NeighborReadIsNotFused) {
+  Var V("V", VVType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr x = FieldRead::make(V, "x");
+  Expr v = FieldRead::make(V, "v");
+  Stmt body = Block::make(
+    For::make(i, ForDomain(IndexSet(V)), Store::make(v, i, Load::make(x, i))),
+    For::make(j, ForDomain(IndexSet(V)), Store::make(x, j,
+                                                     Load::make(v, j+1))));
+  Func func("shift", {V}, {}, body);
+
+  int numFused = 0;
+  fuseLoops(func, &numFused);
+  ASSERT_EQ(0, numFused);
+}
+
+TEST(FuseLoops, IntegrateMatchesUnfused) {
+  const string source = R"(
+element Vertex
+  x : float;
+  v : float;
+  f : float;
+end
+extern verts : set{Vertex};
+export func force()
+  verts.f = -4.0 * verts.x;
+end
+export func velocity()
+  verts.v = verts.v + 0.1 * verts.f;
+end
+export func position()
+  verts.x = verts.x + 0.1 * verts.v;
+end
+export func step()
+  verts.f = -4.0 * verts.x;
+  verts.v = verts.v + 0.1 * verts.f;
+  verts.x = verts.x + 0.1 * verts.v;
+end
+)";
+  simit::internal::ProgramContext ctx;
+  simit::internal::Frontend frontend;
+  vector<simit::ParseError> errors;
+  ASSERT_EQ(0, frontend.parseString(source, &ctx, &errors));
+
+  // The loops of step are fused, while the functions that compute one step
+  // of the chain each keep their loop
+  class CountSetLoops : public IRVisitor {
+  public:
+    int count = 0;
+  private:
+    using IRVisitor::visit;
+    void visit(const For* op) {
+      count += (op->domain.kind == ForDomain::IndexSet) ? 1 : 0;
+      IRVisitor::visit(op);
+    }
+  };
+  simit::backend::Backend backend("cpu");
+  map<string,simit::Function> functions;
+  for (string name : {"force", "velocity", "position", "step"}) {
+    Func func = lower(ctx.getFunction(name));
+    CountSetLoops countSetLoops;
+    func.getBody().accept(&countSetLoops);
+    ASSERT_EQ(1, countSetLoops.count) << name;
+    functions[name] = backend.compile(func);
+  }
+
+  simit::Set fusedVerts;
+  simit::Set unfusedVerts;
+  vector<simit::FieldRef<simit_float>> xs, vs, fs;
+  for (simit::Set* verts : {&fusedVerts, &unfusedVerts}) {
+    xs.push_back(verts->addField<simit_float>("x"));
+    vs.push_back(verts->addField<simit_float>("v"));
+    fs.push_back(verts->addField<simit_float>("f"));
+    for (int i = 0; i < 100; ++i) {
+      simit::ElementRef vert = verts->add();
+      xs.back().set(vert, i % 7 - 3.0);
+      vs.back().set(vert, i % 3);
+      fs.back().set(vert, 0.0);
+    }
+  }
+  functions["step"].bind("verts", &fusedVerts);
+  for (string name : {"force", "velocity", "position"}) {
+    functions[name].bind("verts", &unfusedVerts);
+  }
+
+  // Every element of the fused loop sees the force and velocity computed for
+  // it, so the results match those of the separate loops
+  for (int step = 0; step < 10; ++step) {
+    functions["step"].runSafe();
+    functions["force"].runSafe();
+    functions["velocity"].runSafe();
+    functions["position"].runSafe();
+  }
+  vector<simit::ElementRef> fusedRefs;
+  for (auto vert : fusedVerts) {
+    fusedRefs.push_back(vert);
+  }
+  vector<simit::ElementRef> unfusedRefs;
+  for (auto vert : unfusedVerts) {
+    unfusedRefs.push_back(vert);
+  }
+  for (size_t i = 0; i < fusedRefs.size(); ++i) {
+    ASSERT_NEAR((double)xs[1](unfusedRefs[i]), (double)xs[0](fusedRefs[i]),
+                1e-9);
+    ASSERT_NEAR((double)vs[1](unfusedRefs[i]), (double)vs[0](fusedRefs[i]),
+                1e-9);
+    ASSERT_NEAR((double)fs[1](unfusedRefs[i]), (double)fs[0](fusedRefs[i]),
+                1e-9);
+  }
+}
+
+TEST(SetColoring, NoSharedEndpoints) {
+  simit::Set points;
+  simit::Set springs(points,points);
+  simit::createBox(&points, &springs, 5, 5, 5);
+  vector<simit::ElementRef> pointRefs;
+  for (auto point : points) {
+    pointRefs.push_back(point);
+  }
+  vector<simit::ElementRef> springRefs;
+  for (auto spring : springs) {
+    springRefs.push_back(spring);
+  }
+
+  const simit::SetColoring& coloring = springs.getColoring();
+  vector<int> seen(springs.getSize(), 0);
+  for (int color = 0; color < coloring.getNumColors(); ++color) {
+    vector<bool> taken(points.getSize(), false);
+    for (int n = 0; n < coloring.getColorSize(color); ++n) {
+      simit::ElementRef spring = springRefs[coloring.getColor(color)[n]];
+      seen[spring.getIdent()]++;
+      for (simit::ElementRef point : springs.getEndpoints(spring)) {
+        ASSERT_FALSE(taken[point.getIdent()]);
+        taken[point.getIdent()] = true;
+      }
+    }
+  }
+  for (int count : seen) {
+    ASSERT_EQ(1, count);
+  }
+
+  // Adding an edge changes the topology
+  springs.add(pointRefs[0], pointRefs[1]);
+  const simit::SetColoring& recoloring = springs.getColoring();
+  int numColored = 0;
+  for (int color = 0; color < recoloring.getNumColors(); ++color) {
+    numColored += recoloring.getColorSize(color);
+  }
+  ASSERT_EQ(springs.getSize(), numColored);
+}
+
+TEST(LoopParallelism, run) {
+  Type vertexType = ElementType::make("Vertex", {Field("field", Int)});
+  Type vertexSetType = UnstructuredSetType::make(vertexType, {});
+  Var V("V", vertexSetType);
+  Var i("i", Int);
+  Var tmp("tmp", Int);
+  Stmt body = Block::make({
+    VarDecl::make(tmp),
+    AssignStmt::make(tmp, Load::make(FieldRead::make(V, "field"), i)),
+    Store::make(FieldRead::make(V, "field"), i, -tmp)
+  });
+  Stmt loop = For::make(i, ForDomain(IndexSet(V)), body);
+
+  Environment env;
+  env.addExtern(V);
+  simit::backend::Backend backend("cpu-parallel");
+  simit::Function function = backend.compile(loop, env);
+
+  simit::Set VArg;
+  auto field = VArg.addField<int>("field");
+  vector<simit::ElementRef> elems;
+  for (int n = 0; n < 10000; ++n) {
+    elems.push_back(VArg.add());
+    field(elems.back()) = n;
+  }
+  function.bind("V", &VArg);
+
+  function.runSafe();
+  for (int n = 0; n < 10000; ++n) {
+    ASSERT_EQ(-n, field(elems[n]));
+  }
+}
+
+TEST(LoopParallelism, runReduction) {
+  Type vertexType = ElementType::make("Vertex", {Field("field", Int)});
+  Type vertexSetType = UnstructuredSetType::make(vertexType, {});
+  Var V("V", vertexSetType);
+  Var i("i", Int);
+  Var sum("sum", Int);
+  Var max("max", Int);
+  Expr field = FieldRead::make(V, "field");
+  Stmt body = Block::make(
+      AssignStmt::make(sum, Load::make(field, i), CompoundOperator::Add),
+      AssignStmt::make(max, Load::make(field, i), CompoundOperator::Max));
+  Stmt loop = Block::make({
+    VarDecl::make(sum),
+    VarDecl::make(max),
+    AssignStmt::make(sum, 0),
+    AssignStmt::make(max, 0),
+    For::make(i, ForDomain(IndexSet(V)), body),
+    Store::make(field, 0, sum),
+    Store::make(field, 1, max)
+  });
+
+  Environment env;
+  env.addExtern(V);
+  simit::backend::Backend backend("cpu-parallel");
+  simit::Function function = backend.compile(loop, env);
+
+  simit::Set VArg;
+  auto fieldArg = VArg.addField<int>("field");
+  vector<simit::ElementRef> elems;
+  int expectedSum = 0;
+  int expectedMax = 0;
+  for (int n = 0; n < 10000; ++n) {
+    elems.push_back(VArg.add());
+    fieldArg(elems.back()) = (n*7919) % 10007;
+    expectedSum += (n*7919) % 10007;
+    expectedMax = std::max(expectedMax, (n*7919) % 10007);
+  }
+  function.bind("V", &VArg);
+
+  function.runSafe();
+  ASSERT_EQ(expectedSum, fieldArg(elems[0]));
+  ASSERT_EQ(expectedMax, fieldArg(elems[1]));
+}
+
+TEST(LoopParallelism, runColored) {
+  Type pointType = ElementType::make("Point", {Field("degree", Int)});
+  Type pointSetType = UnstructuredSetType::make(pointType, {});
+  Var P("P", pointSetType);
+  Type springType = ElementType::make("Spring", {});
+  Type springSetType = UnstructuredSetType::make(springType, {P,P});
+  Var S("S", springSetType);
+  Var i("i", Int);
+  Var j("j", Int);
+  Expr endpoints = IndexRead::make(S, IndexRead::Endpoints);
+  Stmt body = ForRange::make(j, 0, 2,
+                             Store::make(FieldRead::make(P, "degree"),
+                                         Load::make(endpoints, i*2+j), 1,
+                                         CompoundOperator::Add));
+  Stmt loop = For::make(i, ForDomain(IndexSet(S)), body);
+
+  Environment env;
+  env.addExtern(P);
+  env.addExtern(S);
+  simit::backend::Backend backend("cpu-parallel");
+  simit::Function function = backend.compile(loop, env);
+
+  simit::Set points;
+  auto degree = points.addField<int>("degree");
+  simit::Set springs(points,points);
+  simit::createBox(&points, &springs, 10, 10, 10);
+  for (auto point : points) {
+    degree(point) = 0;
+  }
+  function.bind("P", &points);
+  function.bind("S", &springs);
+
+  function.runSafe();
+  for (auto point : points) {
+    int expected = 0;
+    for (auto spring : springs) {
+      for (auto endpoint : springs.getEndpoints(spring)) {
+        if (endpoint == point) {
+          ++expected;
+        }
+      }
+    }
+    ASSERT_EQ(expected, degree(point));
+  }
+}
+
+TEST(LoopParallelism, runMatrixAssembly) {
+  const string source = R"(
+element Point
+  b : float;
+  c : float;
+end
+element Spring
+  a : float;
+end
+extern points  : set{Point};
+extern springs : set{Spring}(points,points);
+func dist_a(s : Spring, p : (Point*2))
+    -> (A : tensor[points,points](float))
+  A(p(0),p(0)) = s.a;
+  A(p(0),p(1)) = s.a;
+  A(p(1),p(0)) = s.a;
+  A(p(1),p(1)) = s.a;
+end
+export func main()
+  A = map dist_a to springs reduce +;
+  points.c = A * points.b;
+end
+)";
+  simit::internal::ProgramContext ctx;
+  simit::internal::Frontend frontend;
+  vector<simit::ParseError> errors;
+  ASSERT_EQ(0, frontend.parseString(source, &ctx, &errors));
+  Func func = lower(ctx.getFunction("main"), "cpu-parallel");
+
+  // The matrix is assembled in a loop over springs, whose iterations only
+  // conflict if their springs share a point
+  class FindSetLoops : public IRVisitor {
+  public:
+    vector<const For*> loops;
+  private:
+    using IRVisitor::visit;
+    void visit(const For* op) {
+      if (op->domain.kind == ForDomain::IndexSet &&
+          op->domain.indexSet.getKind() == IndexSet::Set &&
+          isa<VarExpr>(op->domain.indexSet.getSet()) &&
+          to<VarExpr>(op->domain.indexSet.getSet())->var.getName() ==
+              "springs") {
+        loops.push_back(op);
+      }
+      IRVisitor::visit(op);
+    }
+  };
+  FindSetLoops findSetLoops;
+  func.getBody().accept(&findSetLoops);
+  ASSERT_EQ(1u, findSetLoops.loops.size());
+  ASSERT_EQ(LoopParallelism::Colored,
+            getLoopParallelism(findSetLoops.loops[0],
+                               &func.getEnvironment()).getKind());
+
+  simit::backend::Backend backend("cpu-parallel");
+  simit::Function function = backend.compile(func);
+
+  simit::Set points;
+  auto b = points.addField<simit_float>("b");
+  auto c = points.addField<simit_float>("c");
+  simit::Set springs(points,points);
+  auto a = springs.addField<simit_float>("a");
+  simit::createBox(&points, &springs, 10, 10, 10);
+  for (auto point : points) {
+    b(point) = point.getIdent() % 7;
+    c(point) = 0.0;
+  }
+  for (auto spring : springs) {
+    a(spring) = spring.getIdent() % 5 + 1;
+  }
+  function.bind("points", &points);
+  function.bind("springs", &springs);
+
+  function.runSafe();
+  vector<simit_float> expected(points.getSize(), 0.0);
+  for (auto spring : springs) {
+    simit::ElementRef p0 = springs.getEndpoint(spring, 0);
+    simit::ElementRef p1 = springs.getEndpoint(spring, 1);
+    simit_float sum = b(p0) + b(p1);
+    expected[p0.getIdent()] += a(spring) * sum;
+    expected[p1.getIdent()] += a(spring) * sum;
+  }
+  for (auto point : points) {
+    ASSERT_NEAR(expected[point.getIdent()], (double)c(point), 1e-9);
+  }
+}
+
+TEST(LoopParallelism, runGatherAssembly) {
+  const string source = R"(
+element Point
+  b : float;
+  c : float;
+end
+element Spring
+  a : float;
+end
+extern points  : set{Point};
+extern springs : set{Spring}(points,points);
+func dist_b(s : Spring, p : (Point*2)) -> (f : vector[points](float))
+  f(p(0)) = s.a * p(1).b;
+  f(p(1)) = s.a + p(0).b;
+end
+export func main()
+  f = map dist_b to springs reduce +;
+  points.c = f;
+end
+)";
+  simit::internal::ProgramContext ctx;
+  simit::internal::Frontend frontend;
+  vector<simit::ParseError> errors;
+  ASSERT_EQ(0, frontend.parseString(source, &ctx, &errors));
+
+  // On cpu-parallel the vector is gathered in an independent loop over points,
+  // while other backends scatter from the springs
+  class FindSetLoops : public IRVisitor {
+  public:
+    map<string, vector<const For*>> loops;
+  private:
+    using IRVisitor::visit;
+    void visit(const For* op) {
+      if (op->domain.kind == ForDomain::IndexSet &&
+          op->domain.indexSet.getKind() == IndexSet::Set &&
+          isa<VarExpr>(op->domain.indexSet.getSet())) {
+        const Var& set = to<VarExpr>(op->domain.indexSet.getSet())->var;
+        loops[set.getName()].push_back(op);
+      }
+      IRVisitor::visit(op);
+    }
+  };
+  FindSetLoops scatterLoops;
+  lower(ctx.getFunction("main"), "cpu").getBody().accept(&scatterLoops);
+  ASSERT_EQ(1u, scatterLoops.loops["springs"].size());
+
+  Func func = lower(ctx.getFunction("main"), "cpu-parallel");
+  FindSetLoops gatherLoops;
+  func.getBody().accept(&gatherLoops);
+  ASSERT_EQ(0u, gatherLoops.loops["springs"].size());
+  ASSERT_LE(1u, gatherLoops.loops["points"].size());
+  ASSERT_EQ(LoopParallelism::Independent,
+            getLoopParallelism(gatherLoops.loops["points"][0],
+                               &func.getEnvironment()).getKind());
+
+  simit::backend::Backend backend("cpu-parallel");
+  simit::Function function = backend.compile(func);
+
+  simit::Set points;
+  auto b = points.addField<simit_float>("b");
+  auto c = points.addField<simit_float>("c");
+  simit::Set springs(points,points);
+  auto a = springs.addField<simit_float>("a");
+  simit::createBox(&points, &springs, 10, 10, 10);
+  // A degenerate spring contributes to its point through both endpoints
+  simit::ElementRef p0 = *points.begin();
+  springs.add(p0, p0);
+  for (auto point : points) {
+    b(point) = point.getIdent() % 7;
+    c(point) = 0.0;
+  }
+  for (auto spring : springs) {
+    a(spring) = spring.getIdent() % 5 + 1;
+  }
+  function.bind("points", &points);
+  function.bind("springs", &springs);
+
+  function.runSafe();
+  vector<simit_float> expected(points.getSize(), 0.0);
+  for (auto spring : springs) {
+    simit::ElementRef p0 = springs.getEndpoint(spring, 0);
+    simit::ElementRef p1 = springs.getEndpoint(spring, 1);
+    expected[p0.getIdent()] += a(spring) * b(p1);
+    expected[p1.getIdent()] += a(spring) + b(p0);
+  }
+  for (auto point : points) {
+    ASSERT_NEAR(expected[point.getIdent()], (double)c(point), 1e-9);
+  }
+}
@@ -367,3 +367,85 @@ TEST(pathindex, hypergraph) {
   PathIndex pidx = builder.buildSegmented(vevORvfv, 0);
   VERIFY_INDEX(pidx, nbrs({{0,1,2}, {0,1,2,3}, {0,1,2,3}, {1,2,3}}));
 }
+
+TEST(pathindex, extend) {
+  simit::Set V;
+  simit::Set E(V,V);
+  Box box = createBox(&V, &E, 3, 1, 1);  // v-e-v-e-v
+
+  PathExpression ve = makeVE();
+  PathExpression ev = makeEV();
+  Var vi("vi");
+  Var e("e");
+  Var vj("vj");
+  Var vk("vk");
+  PathExpression vev = And::make({vi,vj}, {{QuantifiedVar::Exist,e}},
+                                 ve(vi, e), ev(e, vj));
+  PathExpression vevev = And::make({vi,vj}, {{QuantifiedVar::Exist,vk}},
+                                   vev(vi,vk), vev(vk, vj));
+  PathExpression veOrEv = Or::make({vi,vj}, {}, vev(vi,vj), vev(vi,vj));
+
+  PathIndexBuilder builder;
+  builder.bind("V", &V);
+  builder.bind("E", &E);
+  PathIndex evIndex = builder.buildSegmented(ev, 0);
+  PathIndex vevIndex = builder.buildSegmented(vev, 0);
+  PathIndex vevevIndex = builder.buildSegmented(vevev, 0);
+  PathIndex orIndex = builder.buildSegmented(veOrEv, 0);
+
+  // Append a vertex and edges that link it, and two old vertices, to the mesh:
+  // v-e-v-e-v-e-v
+  //  -----e-----
+  ElementRef v3 = V.add();
+  E.add(box(2,0,0), v3);
+  E.add(box(0,0,0), box(2,0,0));
+  builder.extend({{"V",3}, {"E",2}});
+
+  // Links and their compositions are extended in place
+  ASSERT_EQ(evIndex, builder.buildSegmented(ev, 0));
+  ASSERT_EQ(vevIndex, builder.buildSegmented(vev, 0));
+  ASSERT_EQ(vevevIndex, builder.buildSegmented(vevev, 0));
+  VERIFY_INDEX(evIndex, nbrs({{0,1}, {1,2}, {2,3}, {0,2}}));
+  VERIFY_INDEX(vevIndex, nbrs({{0,1,2}, {0,1,2}, {0,1,2,3}, {2,3}}));
+  VERIFY_INDEX(vevevIndex, nbrs({{0,1,2,3}, {0,1,2,3}, {0,1,2,3},
+                                 {0,1,2,3}}));
+
+  // Other indices are rebuilt
+  PathIndex rebuiltOrIndex = builder.buildSegmented(veOrEv, 0);
+  ASSERT_NE(orIndex, rebuiltOrIndex);
+  VERIFY_INDEX(rebuiltOrIndex, nbrs({{0,1,2}, {0,1,2}, {0,1,2,3}, {2,3}}));
+
+  // Extensions that are not read in between are merged together
+  E.add(v3, box(1,0,0));
+  builder.extend({{"E",4}});
+  E.add(v3, v3);
+  builder.extend({{"E",5}});
+  PathIndexBuilder fresh;
+  fresh.bind("V", &V);
+  fresh.bind("E", &E);
+  for (PathExpression pexpr : {ev, ve, vev, vevev}) {
+    PathIndex extended = builder.buildSegmented(pexpr, 0);
+    PathIndex rebuilt = fresh.buildSegmented(pexpr, 0);
+    ASSERT_EQ(rebuilt.numElements(), extended.numElements());
+    ASSERT_EQ(rebuilt.numNeighbors(), extended.numNeighbors());
+    for (unsigned elem : rebuilt) {
+      vector<unsigned> expected, actual;
+      for (unsigned nbr : rebuilt.neighbors(elem)) {
+        expected.push_back(nbr);
+      }
+      for (unsigned nbr : extended.neighbors(elem)) {
+        actual.push_back(nbr);
+      }
+      ASSERT_EQ(expected, actual) << pexpr << " element " << elem;
+    }
+  }
+
+  // Reading the neighbors of an appended element merges the delta first
+  E.add(box(1,0,0), box(2,0,0));
+  builder.extend({{"E",6}});
+  vector<unsigned> appended;
+  for (unsigned nbr : evIndex.neighbors(6)) {
+    appended.push_back(nbr);
+  }
+  ASSERT_EQ(vector<unsigned>({1,2}), appended);
+}
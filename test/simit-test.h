@@ -1,5 +1,5 @@
-#ifndef SIMIT_TEST_H
-#define SIMIT_TEST_H
+#ifndef SIMIT_SIMIT_TEST_H
+#define SIMIT_SIMIT_TEST_H
 
 #include "gtest/gtest.h"
 #include <iostream>
@@ -13,6 +13,7 @@
 #include "types.h"
 
 #include "runtime.h"
+#include "factorizations.h"
 
 using namespace std;
 using namespace simit;
@@ -197,6 +198,88 @@ TEST(solver, chol) {
   SIMIT_ASSERT_FLOAT_EQ( 60.0, x(v2));
 }
 
+TEST(solver, chol_reuse) {
+  Set V;
+  FieldRef<simit_float> b = V.addField<simit_float>("b");
+  FieldRef<simit_float> x = V.addField<simit_float>("x");
+  FieldRef<bool> fixed = V.addField<bool>("fixed");
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  b(v0) = 10.0;
+  b(v1) = 20.0;
+  b(v2) = 30.0;
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v2);
+
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+
+  FactorizationCache& cache = FactorizationCache::getInstance();
+  cache.resetStats();
+
+  // The second factorization reuses the analysis of the first, even though
+  // the values of the matrix have changed
+  fixed(v2) = true;
+  func.runSafe();
+  SIMIT_ASSERT_FLOAT_EQ( 20.0, x(v0));
+  SIMIT_ASSERT_FLOAT_EQ(-10.0, x(v1));
+  SIMIT_ASSERT_FLOAT_EQ( 20.0, x(v2));
+
+  fixed(v2) = false;
+  fixed(v0) = true;
+  func.runSafe();
+
+  ASSERT_EQ(1u, cache.getStats().analyzed);
+  ASSERT_EQ(1u, cache.getStats().reused);
+  SIMIT_ASSERT_FLOAT_EQ( 20.0, x(v0));
+  SIMIT_ASSERT_FLOAT_EQ(-30.0, x(v1));
+  SIMIT_ASSERT_FLOAT_EQ( 60.0, x(v2));
+}
+
+TEST(solver, chol_reuse_reinit) {
+  Set V;
+  FieldRef<simit_float> b = V.addField<simit_float>("b");
+  FieldRef<simit_float> x = V.addField<simit_float>("x");
+  FieldRef<bool> fixed = V.addField<bool>("fixed");
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  b(v0) = 10.0;
+  b(v1) = 20.0;
+  b(v2) = 30.0;
+  fixed(v0) = true;
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v2);
+
+  Function func = loadFunction(string(TEST_INPUT_DIR) +
+                               "/solver/chol_reuse.sim", "main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+
+  FactorizationCache& cache = FactorizationCache::getInstance();
+  cache.resetStats();
+
+  // Initializing the function again with unchanged sets keeps its indices, so
+  // the analysis of the first factorization is still reused
+  func.runSafe();
+  func.init();
+  func.runSafe();
+
+  ASSERT_EQ(1u, cache.getStats().analyzed);
+  ASSERT_EQ(1u, cache.getStats().reused);
+  SIMIT_ASSERT_FLOAT_EQ( 20.0, x(v0));
+  SIMIT_ASSERT_FLOAT_EQ(-30.0, x(v1));
+  SIMIT_ASSERT_FLOAT_EQ( 60.0, x(v2));
+}
+
 TEST(solver, cholmat) {
   Set V;
   FieldRef<simit_float> x = V.addField<simit_float>("x");
@@ -306,4 +389,102 @@ TEST(DISABLED_solver, schur_blocked) {
   SIMIT_ASSERT_FLOAT_EQ(-100.0,       x(v2)(1));
 }
 
+/// An iterative solver function in solver/pcg.sim, and the most iterations it
+/// may take to solve the test system.
+struct IterativeSolver {
+  string function;
+  int maxIterations;
+};
+
+std::ostream& operator<<(std::ostream& os, const IterativeSolver& solver) {
+  return os << solver.function;
+}
+
+class IterativeSolverTest : public ::testing::TestWithParam<IterativeSolver> {
+};
+
+static const string PCG_FILE_NAME = string(TEST_INPUT_DIR) + "/solver/pcg.sim";
+
+TEST_P(IterativeSolverTest, solve) {
+  Set V;
+  FieldRef<simit_float> b = V.addField<simit_float>("b");
+  FieldRef<simit_float> x = V.addField<simit_float>("x");
+  FieldRef<bool> fixed = V.addField<bool>("fixed");
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+  b(v0) = 10.0;
+  b(v1) = 20.0;
+  b(v2) = 30.0;
+  fixed(v0) = true;
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v2);
+
+  Set S;
+  FieldRef<int> iterations = S.addField<int>("iterations");
+  FieldRef<simit_float> residual = S.addField<simit_float>("residual");
+  ElementRef s = S.add();
+
+  Function func = loadFunction(PCG_FILE_NAME, GetParam().function);
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.bind("S", &S);
+  func.runSafe();
+
+  SIMIT_ASSERT_FLOAT_EQ( 20.0, x(v0));
+  SIMIT_ASSERT_FLOAT_EQ(-30.0, x(v1));
+  SIMIT_ASSERT_FLOAT_EQ( 60.0, x(v2));
+  ASSERT_GE(GetParam().maxIterations, iterations(s));
+  ASSERT_LE(residual(s), 1e-6);
+}
+
+// The incomplete factorization of a tridiagonal matrix is exact, so IC(0)
+// preconditioned CG converges in one iteration
+INSTANTIATE_TEST_CASE_P(solver, IterativeSolverTest,
+                        testing::Values(IterativeSolver{"pcg_main", 3},
+                                        IterativeSolver{"iccg_main", 1}));
+
+TEST(solver, pcg_breakdown) {
+  Set V;
+  FieldRef<simit_float> b = V.addField<simit_float>("b");
+  FieldRef<simit_float> x = V.addField<simit_float>("x");
+  V.addField<bool>("fixed");
+  ElementRef v0 = V.add();
+  ElementRef v1 = V.add();
+  ElementRef v2 = V.add();
+
+  // Without fixed vertices the matrix [[1,1,0],[1,2,1],[0,1,1]] is singular,
+  // and the first block-Jacobi preconditioned direction D^{-1}b = [1,-1,1] is
+  // in its null space
+  b(v0) = 1.0;
+  b(v1) = -2.0;
+  b(v2) = 1.0;
+
+  Set E(V,V);
+  E.add(v0,v1);
+  E.add(v1,v2);
+
+  Set S;
+  FieldRef<int> iterations = S.addField<int>("iterations");
+  FieldRef<simit_float> residual = S.addField<simit_float>("residual");
+  ElementRef s = S.add();
+
+  Function func = loadFunction(PCG_FILE_NAME, "pcg_main");
+  if (!func.defined()) FAIL();
+  func.bind("V", &V);
+  func.bind("E", &E);
+  func.bind("S", &S);
+  func.runSafe();
+
+  // The solver stops at the initial guess instead of iterating on NaNs
+  ASSERT_EQ(0, iterations(s));
+  SIMIT_ASSERT_FLOAT_EQ(1.0, residual(s));
+  SIMIT_ASSERT_FLOAT_EQ(0.0, x(v0));
+  SIMIT_ASSERT_FLOAT_EQ(0.0, x(v1));
+  SIMIT_ASSERT_FLOAT_EQ(0.0, x(v2));
+}
+
 #endif
@@ -168,6 +168,94 @@ TEST(system, gemv_stencil_indexless) {
   kIndexlessStencils = false;
 }
 
+TEST(system, gemv_stencil_implicit) {
+  // Points
+  Set points;
+  FieldRef<simit_float> b = points.addField<simit_float>("b");
+  FieldRef<simit_float> c = points.addField<simit_float>("c");
+
+  // Springs, whose endpoints are computed rather than stored
+  Set springs(points,{3},Set::Implicit);
+  FieldRef<simit_float> a = springs.addField<simit_float>("a");
+
+  // Build points
+  ElementRef p0 = springs.getGridPoint({0});
+  ElementRef p1 = springs.getGridPoint({1});
+  ElementRef p2 = springs.getGridPoint({2});
+
+  b.set(p0, 1.0);
+  b.set(p1, 2.0);
+  b.set(p2, 3.0);
+
+  // Taint c
+  c.set(p0, 42.0);
+  c.set(p2, 42.0);
+
+
+  // Build springs
+  ElementRef s0 = springs.getGridEdge({0},0);
+  ElementRef s1 = springs.getGridEdge({1},0);
+  ElementRef s2 = springs.getGridEdge({2},0);
+
+  a.set(s0, 1.0);
+  a.set(s1, 2.0);
+  a.set(s2, 0.0);
+
+  // Compile program and bind arguments
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+
+  func.bind("points", &points);
+  func.bind("springs", &springs);
+
+  func.runSafe();
+
+  // Check that inputs are preserved
+  ASSERT_EQ(1.0, b.get(p0));
+  ASSERT_EQ(2.0, b.get(p1));
+  ASSERT_EQ(3.0, b.get(p2));
+
+  // Check that outputs are correct
+  ASSERT_EQ(3.0, c.get(p0));
+  ASSERT_EQ(13.0, c.get(p1));
+  ASSERT_EQ(10.0, c.get(p2));
+}
+
+TEST(system, gemv_stencil_ghost) {
+  // Points
+  Set points;
+  FieldRef<simit_float> b = points.addField<simit_float>("b");
+  FieldRef<simit_float> c = points.addField<simit_float>("c");
+
+  // Springs, whose first and last points are ghosts
+  Set springs(points,{5});
+  FieldRef<simit_float> a = springs.addField<simit_float>("a");
+
+  vector<ElementRef> p;
+  for (int i = 0; i < 5; ++i) {
+    p.push_back(springs.getGridPoint({i}));
+    b.set(p[i], i+1.0);
+    c.set(p[i], 42.0);
+    a.set(springs.getGridEdge({i},0), i+1.0);
+  }
+
+  // Compile program and bind arguments
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+
+  func.bind("points", &points);
+  func.bind("springs", &springs);
+
+  func.runSafe();
+
+  // Check that outputs are correct, and that the ghost rows are empty
+  ASSERT_EQ(0.0, c.get(p[0]));
+  ASSERT_EQ(13.0, c.get(p[1]));
+  ASSERT_EQ(31.0, c.get(p[2]));
+  ASSERT_EQ(57.0, c.get(p[3]));
+  ASSERT_EQ(0.0, c.get(p[4]));
+}
+
 TEST(system, gemv_stencil_2d) {
   // Points
   Set points;
@@ -903,6 +991,57 @@ TEST(system, gemv_blocked) {
   ASSERT_EQ(136.0, c2(1));
 }
 
+TEST(system, gemv_blocked_rectangular) {
+  // Points
+  Set points;
+  FieldRef<simit_float,3> b = points.addField<simit_float,3>("b");
+  FieldRef<simit_float,2> c = points.addField<simit_float,2>("c");
+
+  ElementRef p0 = points.add();
+  ElementRef p1 = points.add();
+  ElementRef p2 = points.add();
+
+  b.set(p0, {1.0, 2.0, 3.0});
+  b.set(p1, {4.0, 5.0, 6.0});
+  b.set(p2, {7.0, 8.0, 9.0});
+
+  // Taint c
+  c.set(p0, {42.0, 42.0});
+  c.set(p2, {42.0, 42.0});
+
+  // Springs
+  Set springs(points,points);
+  FieldRef<simit_float,2,3> a = springs.addField<simit_float,2,3>("a");
+
+  ElementRef s0 = springs.add(p0,p1);
+  ElementRef s1 = springs.add(p1,p2);
+
+  a.set(s0, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+  a.set(s1, {1.0, 0.0, 1.0, 0.0, 1.0, 0.0});
+
+  // Compile program and bind arguments
+  Function func = loadFunction(TEST_FILE_NAME, "main");
+  if (!func.defined()) FAIL();
+
+  func.bind("points", &points);
+  func.bind("springs", &springs);
+
+  func.runSafe();
+
+  // Check that outputs are correct
+  TensorRef<simit_float,2> c0 = c.get(p0);
+  ASSERT_EQ(46.0, c0(0));
+  ASSERT_EQ(109.0, c0(1));
+
+  TensorRef<simit_float,2> c1 = c.get(p1);
+  ASSERT_EQ(72.0, c1(0));
+  ASSERT_EQ(122.0, c1(1));
+
+  TensorRef<simit_float,2> c2 = c.get(p2);
+  ASSERT_EQ(26.0, c2(0));
+  ASSERT_EQ(13.0, c2(1));
+}
+
 TEST(system, gemv_blocked_nw) {
   // Points
   Set points;